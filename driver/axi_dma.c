@@ -19,6 +19,10 @@
 // Local dependencies
 #include "axidma.h"                 // Internal definitions
 
+// Create the tracepoints for the module, only in this file
+#define CREATE_TRACE_POINTS
+#include "axidma_trace.h"           // Tracepoint definitions
+
 /*----------------------------------------------------------------------------
  * Module Parameters
  *----------------------------------------------------------------------------*/
@@ -41,7 +45,7 @@ static int axidma_probe(struct platform_device *pdev)
     struct axidma_device *axidma_dev;
 
     // Allocate a AXI DMA device structure to hold metadata about the DMA
-    axidma_dev = kmalloc(sizeof(*axidma_dev), GFP_KERNEL);
+    axidma_dev = kzalloc(sizeof(*axidma_dev), GFP_KERNEL);
     if (axidma_dev == NULL) {
         axidma_err("Unable to allocate the AXI DMA device structure.\n");
         return -ENOMEM;
@@ -54,6 +58,12 @@ static int axidma_probe(struct platform_device *pdev)
         goto free_axidma_dev;
     }
 
+    // Initialize the statistics for each channel
+    rc = axidma_stats_init(axidma_dev);
+    if (rc < 0) {
+        goto destroy_dma_dev;
+    }
+
     // Assign the character device name, minor number, and number of devices
     axidma_dev->chrdev_name = chrdev_name;
     axidma_dev->minor_num = minor_num;
@@ -62,13 +72,15 @@ static int axidma_probe(struct platform_device *pdev)
     // Initialize the character device for the module.
     rc = axidma_chrdev_init(axidma_dev);
     if (rc < 0) {
-        goto destroy_dma_dev;
+        goto destroy_stats;
     }
 
     // Set the private data in the device to the AXI DMA device structure
     dev_set_drvdata(&pdev->dev, axidma_dev);
     return 0;
 
+destroy_stats:
+    axidma_stats_exit(axidma_dev);
 destroy_dma_dev:
     axidma_dma_exit(axidma_dev);
 free_axidma_dev:
@@ -86,8 +98,9 @@ static int axidma_remove(struct platform_device *pdev)
     // Cleanup the character device structures
     axidma_chrdev_exit(axidma_dev);
 
-    // Cleanup the DMA structures
+    // Cleanup the DMA structures, then the statistics the callbacks update
     axidma_dma_exit(axidma_dev);
+    axidma_stats_exit(axidma_dev);
 
     // Free the device structure
     kfree(axidma_dev);
@@ -14,12 +14,19 @@
 
 // Kernel dependencies
 #include <linux/list.h>         // Linked list definitions and functions
+#include <linux/rbtree.h>           // Red-black tree definitions
+#include <linux/idr.h>              // ID allocation definitions
 #include <linux/kernel.h>           // Contains the definition for printk
 #include <linux/device.h>           // Definitions for class and device structs
 #include <linux/cdev.h>             // Definitions for character device structs
+#include <linux/spinlock.h>         // Definitions for spinlocks
 #include <linux/signal.h>           // Definition of signal numbers
 #include <linux/dmaengine.h>        // Definitions for DMA structures and types
 #include <linux/platform_device.h>  // Defintions for a platform device
+#include <linux/fs.h>               // Definitions for file structures
+#include <linux/poll.h>             // Definitions for poll tables
+#include <linux/mutex.h>            // Definitions for mutexes
+#include <linux/cpumask.h>          // Definitions for CPU masks
 
 // Local dependencies
 #include "axidma_ioctl.h"           // IOCTL argument structures
@@ -41,9 +48,30 @@
 #define axidma_info(fmt, ...) \
     printk(KERN_INFO MODULE_NAME ": %s: %s: %d: " fmt, __FILENAME__, __func__, \
             __LINE__, ## __VA_ARGS__)
+#define axidma_err_ratelimited(fmt, ...) \
+    printk_ratelimited(KERN_ERR MODULE_NAME ": %s: %s: %d: " fmt, \
+           __FILENAME__, __func__, __LINE__, ## __VA_ARGS__)
 
-// Forward declaration of the callback data structure for DMA
-struct axidma_cb_data;
+// Forward declaration of the shared submission/completion rings structure
+struct axidma_ring;
+
+// Forward declaration of the completion event queue structure
+struct axidma_event_queue;
+
+// Forward declaration of the video transfer structure
+struct axidma_video_stream;
+
+// Forward declaration of the kernel's memory pool structure
+struct gen_pool;
+
+// Forward declaration of the per-channel statistics structure
+struct axidma_chan_stats;
+
+// Forward declaration of the kernel's debugfs entry structure
+struct dentry;
+
+// Forward declaration of the userspace BD ring structure
+struct axidma_bdring;
 
 // All of the meta-data needed for an axidma device
 struct axidma_device {
@@ -60,12 +88,44 @@ struct axidma_device {
     int num_vdma_tx_chans;          // The number of transmit VDMA channels
     int num_vdma_rx_chans;          // The number of receive  VDMA channels
     int num_chans;                  // The total number of DMA channels
-    int notify_signal;              // Signal used to notify transfer completion
     struct platform_device *pdev;   // The platofrm device from the device tree
-    struct axidma_cb_data *cb_data; // The callback data for each channel
     struct axidma_chan *channels;   // All available channels
-    struct list_head dmabuf_list;   // List of allocated DMA buffers
-    struct list_head external_dmabufs;  // Buffers allocated in other drivers
+    struct axidma_file **chan_owners;   // The file that owns each channel
+    unsigned int *poll_budgets;     // Each channel's busy-poll budget (us)
+    struct axidma_coalesce *coalesce;   // Each channel's interrupt coalescing
+    unsigned int *residues;         // Residue of each channel's last transfer
+    phys_addr_t *chan_regs;         // Each channel's registers, 0 if not SG
+    unsigned int *chan_irqs;        // Each channel's interrupt, 0 if unknown
+    struct cpumask *irq_masks;      // Each channel's interrupt affinity hint
+    int *notify_cpus;               // CPU to deliver each channel's wakeups
+    struct axidma_bdring **bdrings; // Each channel's userspace BD ring, if any
+    struct mutex bdring_lock;       // Serializes setting up the BD rings
+    struct gen_pool *mem_pool;      // Pool for the reserved memory region
+    struct axidma_chan_stats *chan_stats;   // The statistics for each channel
+    struct dentry *debugfs_dir;     // The device's debugfs directory, if any
+};
+
+/* The state for each open file of the AXI DMA device. Each file has its own
+ * buffers and notification settings, and owns the channels it transfers on, so
+ * that separate processes can use different channels at the same time. */
+struct axidma_file {
+    struct axidma_device *dev;      // The device the file belongs to
+    int notify_signal;              // Signal used to notify transfer completion
+    void *notify_data;              // User data sent along with the signal
+    struct list_head async_transfers;   // In-flight asynchronous transfers
+    spinlock_t async_lock;          // Protects the async transfers list
+    rwlock_t dmabuf_lock;           // Protects the tree of buffers
+    struct rb_root dmabuf_tree;     // Tree of allocated and external buffers
+    unsigned int dmabuf_gen;        // Incremented when a buffer is removed
+    struct idr prepared;            // The file's prepared transfers by handle
+    spinlock_t prepared_lock;       // Protects the prepared transfers
+    struct axidma_ring *ring;       // The shared submission/completion rings
+    struct axidma_event_queue *events;  // The completion event queue
+    struct axidma_cyclic_status *cyclic_status; // Each channel's cyclic status
+    size_t cyclic_size;             // The size of the cyclic status region
+    unsigned long *cyclic_active;   // Channels with a cyclic transfer running
+    struct axidma_video_stream **video_streams; // Each channel's video transfer
+    struct mutex video_lock;        // Protects the video transfers array
 };
 
 /*----------------------------------------------------------------------------
@@ -98,19 +158,134 @@ void axidma_get_num_channels(struct axidma_device *dev,
                              struct axidma_num_channels *num_chans);
 void axidma_get_channel_info(struct axidma_device *dev,
                              struct axidma_channel_info *chan_info);
-int axidma_set_signal(struct axidma_device *dev, int signal);
-int axidma_read_transfer(struct axidma_device *dev,
+int axidma_set_signal(struct axidma_file *file,
+                      struct axidma_signal_info *sig_info);
+int axidma_read_transfer(struct axidma_file *file,
                           struct axidma_transaction *trans);
-int axidma_write_transfer(struct axidma_device *dev,
+int axidma_write_transfer(struct axidma_file *file,
                           struct axidma_transaction *trans);
-int axidma_rw_transfer(struct axidma_device *dev,
+int axidma_rw_transfer(struct axidma_file *file,
                        struct axidma_inout_transaction *trans);
-int axidma_video_transfer(struct axidma_device *dev,
+int axidma_vec_transfer(struct axidma_file *file,
+                        struct axidma_vec_transaction *trans,
+                        enum axidma_dir dir);
+int axidma_batch_transfer(struct axidma_file *file,
+                          struct axidma_batch_transaction *trans);
+int axidma_video_transfer(struct axidma_file *file,
                           struct axidma_video_transaction *trans,
                           enum axidma_dir dir);
-int axidma_stop_channel(struct axidma_device *dev, struct axidma_chan *chan);
-dma_addr_t axidma_uservirt_to_dma(struct axidma_device *dev, void *user_addr,
+int axidma_video_park(struct axidma_file *file, struct axidma_video_park *park);
+int axidma_cyclic_transfer(struct axidma_file *file,
+                           struct axidma_cyclic_transaction *trans);
+int axidma_cyclic_mmap(struct axidma_file *file, struct vm_area_struct *vma);
+int axidma_cyclic_init(struct axidma_file *file);
+void axidma_cyclic_exit(struct axidma_file *file);
+int axidma_stop_channel(struct axidma_file *file, struct axidma_chan *chan);
+int axidma_claim_channel(struct axidma_file *file, int channel_id);
+int axidma_release_channel(struct axidma_file *file, int channel_id);
+bool axidma_chan_pending(struct axidma_file *file, struct axidma_chan *chan);
+int axidma_reset_chan(struct axidma_device *dev, struct axidma_chan *chan);
+int axidma_set_poll_budget(struct axidma_file *file,
+                           struct axidma_poll_budget *poll);
+int axidma_set_coalesce(struct axidma_file *file,
+                        struct axidma_coalesce *coalesce);
+int axidma_get_affinity(struct axidma_device *dev,
+                        struct axidma_affinity *affinity);
+int axidma_set_affinity(struct axidma_file *file,
+                        struct axidma_affinity *affinity);
+void axidma_set_residue(struct axidma_device *dev, struct axidma_chan *chan,
+                        size_t residue);
+int axidma_get_residue(struct axidma_device *dev, struct axidma_residue *res);
+int axidma_prepare_transfer(struct axidma_file *file,
+                            struct axidma_prepared_transfer *prepared);
+int axidma_submit_prepared(struct axidma_file *file,
+                           struct axidma_prepared_submit *submit);
+int axidma_unprepare_transfer(struct axidma_file *file, int handle);
+void axidma_prepared_exit(struct axidma_file *file);
+void axidma_release_channels(struct axidma_file *file);
+struct axidma_chan *axidma_get_chan(struct axidma_device *dev, int channel_id);
+int axidma_queue_transfer(struct axidma_file *file, int channel_id, void *buf,
+        size_t buf_len, dma_async_tx_callback_result callback,
+        void *callback_param, dma_cookie_t *cookie);
+dma_addr_t axidma_uservirt_to_dma(struct axidma_file *file, void *user_addr,
                                   size_t size);
+int axidma_get_dma_addr(struct axidma_file *file,
+                        struct axidma_dma_addr *dma_addr);
+int axidma_uservirt_to_sg(struct axidma_file *file, void *user_addr,
+                          size_t size, struct scatterlist *sg_list,
+                          int max_nents);
+
+/*----------------------------------------------------------------------------
+ * Submission/Completion Ring Definitions
+ *----------------------------------------------------------------------------*/
+
+// Function Prototypes
+int axidma_ring_setup(struct axidma_file *file,
+                      struct axidma_ring_setup *setup);
+int axidma_ring_enter(struct axidma_file *file,
+                      struct axidma_ring_enter *enter);
+int axidma_ring_mmap(struct axidma_file *file, struct vm_area_struct *vma);
+void axidma_ring_cancel(struct axidma_file *file, int channel_id);
+void axidma_ring_wake(struct axidma_file *file);
+unsigned int axidma_ring_ready(struct axidma_file *file);
+void axidma_ring_stop(struct axidma_file *file);
+void axidma_ring_destroy(struct axidma_file *file);
+
+/*----------------------------------------------------------------------------
+ * Userspace BD Ring Definitions
+ *----------------------------------------------------------------------------*/
+
+// Function Prototypes
+int axidma_bdring_setup(struct axidma_file *file,
+                        struct axidma_bdring_setup *setup);
+int axidma_bdring_destroy(struct axidma_file *file, int channel_id);
+int axidma_bdring_kick(struct axidma_file *file,
+                       struct axidma_bdring_kick *kick);
+bool axidma_bdring_engine_used(struct axidma_device *dev, int index);
+int axidma_bdring_release(struct axidma_file *file, struct axidma_chan *chan);
+void axidma_bdring_exit(struct axidma_file *file);
+int axidma_bdring_mmap(struct axidma_file *file, struct vm_area_struct *vma);
+
+/*----------------------------------------------------------------------------
+ * Completion Event Definitions
+ *----------------------------------------------------------------------------*/
+
+// Function Prototypes
+int axidma_event_init(struct axidma_file *file);
+void axidma_event_exit(struct axidma_file *file);
+int axidma_set_notify(struct axidma_file *file, struct axidma_notify *notify);
+bool axidma_notify_signal(struct axidma_file *file);
+void axidma_event_notify(struct axidma_file *file);
+void axidma_event_complete(struct axidma_file *file, struct axidma_chan *chan);
+void axidma_event_post(struct axidma_file *file, struct axidma_cqe *event);
+unsigned int axidma_event_poll(struct axidma_file *file, struct file *filp,
+                               poll_table *wait);
+ssize_t axidma_event_read(struct axidma_file *file, char __user *buf,
+                          size_t count, bool nonblock);
+
+/*----------------------------------------------------------------------------
+ * Statistics Definitions
+ *----------------------------------------------------------------------------*/
+
+// The errors on a channel that are counted separately from failed transfers
+enum axidma_stats_error {
+    AXIDMA_STATS_TIMEOUT,           // A synchronous transfer timed out
+    AXIDMA_STATS_PREP_FAILURE,      // The engine couldn't prepare a transfer
+    AXIDMA_STATS_LOOKUP_MISS,       // The address isn't in any DMA buffer
+    AXIDMA_STATS_SUBMIT_FAILURE,    // The engine couldn't submit a transfer
+};
+
+// Function Prototypes
+int axidma_stats_init(struct axidma_device *dev);
+void axidma_stats_exit(struct axidma_device *dev);
+void axidma_stats_submit(struct axidma_device *dev, struct axidma_chan *chan);
+void axidma_stats_complete(struct axidma_device *dev, struct axidma_chan *chan,
+                           size_t bytes, int status);
+void axidma_stats_stop(struct axidma_device *dev, struct axidma_chan *chan);
+int axidma_stats_inflight(struct axidma_device *dev, struct axidma_chan *chan);
+void axidma_stats_error(struct axidma_device *dev, struct axidma_chan *chan,
+                        enum axidma_stats_error error);
+int axidma_read_stats(struct axidma_device *dev, struct axidma_stats *info);
 
 /*----------------------------------------------------------------------------
  * Device Tree Definitions
@@ -120,6 +295,9 @@ dma_addr_t axidma_uservirt_to_dma(struct axidma_device *dev, void *user_addr,
 #define axidma_node_err(node, fmt, ...) \
     axidma_err("Device tree node %s: " fmt, node->name, ##__VA_ARGS__)
 
+// The offset of an AXI DMA's receive channel registers from its transmit ones
+#define AXIDMA_S2MM_REG_OFFSET      0x30
+
 // Function Prototypes
 int axidma_of_num_channels(struct platform_device *pdev);
 int axidma_of_parse_dma_nodes(struct platform_device *pdev,
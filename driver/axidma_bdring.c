@@ -0,0 +1,590 @@
+/**
+ * @file axidma_bdring.c
+ * @date Wednesday, October 14, 2026 at 11:36:48 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the implementation of the userspace BD rings. A BD ring
+ * dedicates an AXI DMA channel to a single open file, and hands the channel's
+ * scatter-gather descriptors over to userspace, so that transfers can be
+ * started and completed without going through the kernel's DMA engine
+ * framework. Userspace only starts the engine through the driver, which writes
+ * the tail register for it, so it never has access to the engine's registers.
+ *
+ * The two channels of an AXI DMA engine share their registers, and a reset of
+ * the engine resets both, so a BD ring claims the whole engine. None of its
+ * channels can be used through the DMA engine until the engine's last ring is
+ * torn down, at which point the engine is reset through the DMA engine
+ * framework, so that its state matches what the Xilinx driver expects.
+ *
+ * @bug No known bugs.
+ **/
+
+// Kernel dependencies
+#include <linux/kernel.h>           // Container and min/max macros
+#include <linux/log2.h>             // Power of two helpers
+#include <linux/mm.h>               // Memory types and remapping functions
+#include <linux/io.h>               // Register access and remapping functions
+#include <linux/iopoll.h>           // Register polling functions
+#include <linux/dma-mapping.h>      // DMA allocation and mapping functions
+#include <linux/slab.h>             // Allocation functions
+#include <linux/mutex.h>            // Mutex definitions and functions
+#include <linux/errno.h>            // Linux error codes
+
+// Local dependencies
+#include "axidma.h"                 // Internal definitions
+#include "axidma_ioctl.h"           // IOCTL interface definition and types
+
+/*----------------------------------------------------------------------------
+ * Internal Definitions
+ *----------------------------------------------------------------------------*/
+
+// The offsets of the channel's registers used to drive the BD ring
+#define AXIDMA_REG_CONTROL          0x00        // The channel's control
+#define AXIDMA_REG_STATUS           0x04        // The channel's status
+#define AXIDMA_REG_CUR_DESC         0x08        // The BD the engine is on
+#define AXIDMA_REG_CUR_DESC_MSB     0x0C        // Upper 32 bits of the BD
+#define AXIDMA_REG_TAIL             0x10        // Tail BD, starts the engine
+#define AXIDMA_REG_TAIL_MSB         0x14        // Upper 32 bits of the tail BD
+
+// The fields of the channel's control register
+#define AXIDMA_CR_RUN_STOP          (1 << 0)    // Starts or stops the channel
+#define AXIDMA_CR_IRQ_MASK          (0x7 << 12) // The interrupt enables
+
+// The fields of the channel's status register
+#define AXIDMA_SR_HALTED            (1 << 0)    // The channel has stopped
+#define AXIDMA_SR_ERRORS            0x00000770  // Any transfer or BD error
+#define AXIDMA_SR_IRQ_MASK          (0x7 << 12) // Interrupts, cleared with 1
+
+// How long to wait for the channel to halt, in microseconds
+#define AXIDMA_HALT_TIMEOUT         1000
+
+// A channel dedicated to a BD ring driven from userspace
+struct axidma_bdring {
+    struct axidma_file *file;       // The file the ring belongs to
+    struct axidma_chan *chan;       // The channel dedicated to the ring
+    void __iomem *regs_page;        // The mapped page of engine's registers
+    void __iomem *regs;             // The channel's registers in the page
+    struct axidma_bd *bds;          // The BDs, in coherent memory
+    dma_addr_t bds_dma;             // The bus address of the first BD
+    size_t bds_size;                // The size of the BDs' allocation
+    unsigned int num_bds;           // The number of BDs in the ring
+    int num_maps;                   // Mappings of the BDs that are open
+};
+
+/*----------------------------------------------------------------------------
+ * Channel Control Functions
+ *----------------------------------------------------------------------------*/
+
+/* Checks if the channel is on the same engine as the given one, which is the
+ * case when their registers are in the same page. */
+static bool axidma_bdring_same_engine(struct axidma_device *dev, int index,
+                                      int other)
+{
+    return other == index || (dev->chan_regs[other] != 0 &&
+           (dev->chan_regs[other] & PAGE_MASK) ==
+           (dev->chan_regs[index] & PAGE_MASK));
+}
+
+/* Claims every channel of the given channel's engine for the file, since the
+ * BD ring takes over the whole engine. This fails if another file owns any of
+ * them, or if the DMA engine still has transfers pending on any of them. This
+ * must be called with the device's BD ring lock held. */
+static int axidma_bdring_claim_engine(struct axidma_file *file, int index)
+{
+    int i, rc;
+    struct axidma_device *dev;
+    struct axidma_bdring *bdring;
+
+    /* If the engine already has a BD ring, then it was claimed when that ring
+     * was set up, and its channels can't have been used since. */
+    dev = file->dev;
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        bdring = dev->bdrings[i];
+        if (bdring != NULL && axidma_bdring_same_engine(dev, index, i)) {
+            return (bdring->file == file) ? 0 : -EBUSY;
+        }
+    }
+
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        if (!axidma_bdring_same_engine(dev, index, i)) {
+            continue;
+        }
+
+        rc = axidma_claim_channel(file, dev->channels[i].channel_id);
+        if (rc < 0) {
+            axidma_err("Channel %d is on the same engine as channel %d, "
+                       "which is used by another open file.\n",
+                       dev->channels[index].channel_id,
+                       dev->channels[i].channel_id);
+            return rc;
+        } else if (axidma_chan_pending(file, &dev->channels[i])) {
+            axidma_err("Channel %d still has transfers pending, so its engine "
+                       "can't be used for a BD ring.\n",
+                       dev->channels[i].channel_id);
+            return -EBUSY;
+        }
+    }
+
+    return 0;
+}
+
+/* Resets the engine through the DMA engine framework, when the last of its BD
+ * rings, the given channel's, is torn down, so that its channels can be used
+ * for normal transfers. The reset discards anything left by the rings, and
+ * enables the interrupts that were disabled for them. If force is specified,
+ * the engine is reset even if it has another ring, which then halts. This
+ * must be called with the device's BD ring lock held. */
+static void axidma_bdring_restore_engine(struct axidma_device *dev, int index,
+                                         bool force)
+{
+    int i;
+
+    for (i = 0; i < dev->num_chans && !force; i++)
+    {
+        if (i != index && axidma_bdring_same_engine(dev, index, i) &&
+                dev->bdrings[i] != NULL) {
+            return;
+        }
+    }
+
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        if (axidma_bdring_same_engine(dev, index, i)) {
+            axidma_reset_chan(dev, &dev->channels[i]);
+        }
+    }
+}
+
+// Stops the channel, and waits for it to finish its current BD and halt
+static int axidma_bdring_halt(struct axidma_bdring *bdring)
+{
+    u32 control, status;
+
+    control = readl(bdring->regs + AXIDMA_REG_CONTROL);
+    writel(control & ~AXIDMA_CR_RUN_STOP, bdring->regs + AXIDMA_REG_CONTROL);
+    return readl_poll_timeout(bdring->regs + AXIDMA_REG_STATUS, status,
+            status & AXIDMA_SR_HALTED, 1, AXIDMA_HALT_TIMEOUT);
+}
+
+/* Halts the channel, and then frees the ring. If this is the last ring on the
+ * engine, the engine is restored for the DMA engine first. The ring must not be
+ * mapped anymore. This must be called with the device's BD ring lock held. */
+static void axidma_bdring_free(struct axidma_device *dev,
+                               struct axidma_bdring *bdring)
+{
+    int index;
+    bool halted;
+    struct axidma_chan *chan;
+
+    /* If the channel won't halt, such as after an error, the engine must be
+     * reset right away, since the BDs are about to be freed. */
+    chan = bdring->chan;
+    index = chan - dev->channels;
+    halted = axidma_bdring_halt(bdring) == 0;
+    if (!halted) {
+        axidma_err("Channel %d did not halt, resetting its engine.\n",
+                   chan->channel_id);
+    }
+
+    // The channels can only be used again once the engine has been restored
+    axidma_bdring_restore_engine(dev, index, !halted);
+    WRITE_ONCE(dev->bdrings[index], NULL);
+    iounmap(bdring->regs_page);
+    dma_free_coherent(&dev->pdev->dev, bdring->bds_size, bdring->bds,
+                      bdring->bds_dma);
+    kfree(bdring);
+}
+
+/*----------------------------------------------------------------------------
+ * VMA Operations
+ *----------------------------------------------------------------------------*/
+
+// Counts each copy of a mapping of the BDs, such as on a split
+static void axidma_bdring_vma_open(struct vm_area_struct *vma)
+{
+    struct axidma_bdring *bdring;
+    struct axidma_device *dev;
+
+    bdring = vma->vm_private_data;
+    dev = bdring->file->dev;
+    mutex_lock(&dev->bdring_lock);
+    bdring->num_maps += 1;
+    mutex_unlock(&dev->bdring_lock);
+}
+
+// Counts the mappings closed, so the ring is only torn down once unmapped
+static void axidma_bdring_vma_close(struct vm_area_struct *vma)
+{
+    struct axidma_bdring *bdring;
+    struct axidma_device *dev;
+
+    bdring = vma->vm_private_data;
+    dev = bdring->file->dev;
+    mutex_lock(&dev->bdring_lock);
+    bdring->num_maps -= 1;
+    mutex_unlock(&dev->bdring_lock);
+}
+
+// The VMA operations for the mappings of the BDs
+static const struct vm_operations_struct axidma_bdring_vm_ops = {
+    .open = axidma_bdring_vma_open,
+    .close = axidma_bdring_vma_close,
+};
+
+/*----------------------------------------------------------------------------
+ * BD Ring Operations (Public Interface)
+ *----------------------------------------------------------------------------*/
+
+int axidma_bdring_setup(struct axidma_file *file,
+                        struct axidma_bdring_setup *setup)
+{
+    int rc, i, index;
+    u32 control;
+    dma_addr_t next_desc;
+    phys_addr_t regs_phys;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct axidma_bdring *bdring;
+
+    // Verify that the channel supports BD rings, and the size is valid
+    dev = file->dev;
+    chan = axidma_get_chan(dev, setup->channel_id);
+    if (chan == NULL || chan->type != AXIDMA_DMA) {
+        axidma_err("Invalid device id %d for DMA channel.\n",
+                   setup->channel_id);
+        return -ENODEV;
+    }
+    index = chan - dev->channels;
+    if (dev->chan_regs[index] == 0) {
+        axidma_err("Channel %d does not have scatter-gather enabled.\n",
+                   chan->channel_id);
+        return -ENODEV;
+    } else if (setup->num_bds < 2 || !is_power_of_2(setup->num_bds) ||
+               setup->num_bds > AXIDMA_MAX_BDRING_BDS) {
+        axidma_err("Invalid number of BDs %u for the BD ring.\n",
+                   setup->num_bds);
+        return -EINVAL;
+    }
+
+    mutex_lock(&dev->bdring_lock);
+    if (dev->bdrings[index] != NULL) {
+        axidma_err("Channel %d already has a BD ring.\n", chan->channel_id);
+        rc = -EBUSY;
+        goto unlock;
+    }
+
+    /* Claim the channel's whole engine, which must be idle, so that the DMA
+     * engine has nothing left to do on it while the ring drives it. */
+    rc = axidma_bdring_claim_engine(file, index);
+    if (rc < 0) {
+        goto unlock;
+    }
+
+    bdring = kzalloc(sizeof(*bdring), GFP_KERNEL);
+    if (bdring == NULL) {
+        axidma_err("Unable to allocate the BD ring structure.\n");
+        rc = -ENOMEM;
+        goto unlock;
+    }
+    bdring->file = file;
+    bdring->chan = chan;
+    bdring->num_bds = setup->num_bds;
+
+    // Allocate the BDs, and link them together in a circle
+    bdring->bds_size = PAGE_ALIGN(bdring->num_bds * sizeof(bdring->bds[0]));
+    bdring->bds = dma_alloc_coherent(&dev->pdev->dev, bdring->bds_size,
+                                     &bdring->bds_dma, GFP_KERNEL);
+    if (bdring->bds == NULL) {
+        axidma_err("Unable to allocate %u BDs for the BD ring.\n",
+                   bdring->num_bds);
+        rc = -ENOMEM;
+        goto free_bdring;
+    }
+    memset(bdring->bds, 0, bdring->bds_size);
+    for (i = 0; i < bdring->num_bds; i++)
+    {
+        next_desc = bdring->bds_dma + ((i + 1) % bdring->num_bds) *
+                    sizeof(bdring->bds[0]);
+        bdring->bds[i].next_desc = lower_32_bits(next_desc);
+        bdring->bds[i].next_desc_msb = upper_32_bits(next_desc);
+    }
+
+    // Map the page with the channel's registers, which only the driver uses
+    regs_phys = dev->chan_regs[index] & PAGE_MASK;
+    bdring->regs_page = ioremap(regs_phys, PAGE_SIZE);
+    if (bdring->regs_page == NULL) {
+        axidma_err("Unable to map the registers of channel %d.\n",
+                   chan->channel_id);
+        rc = -ENOMEM;
+        goto free_bds;
+    }
+    bdring->regs = bdring->regs_page + offset_in_page(dev->chan_regs[index]);
+
+    /* Halt the channel, point it at the first BD, and start it again with its
+     * interrupts disabled. The engine then waits for the tail to be written. */
+    control = readl(bdring->regs + AXIDMA_REG_CONTROL);
+    rc = axidma_bdring_halt(bdring);
+    if (rc < 0) {
+        axidma_err("Channel %d did not halt for the BD ring.\n",
+                   chan->channel_id);
+        goto unmap_regs;
+    }
+    writel(AXIDMA_SR_IRQ_MASK, bdring->regs + AXIDMA_REG_STATUS);
+    writel(lower_32_bits(bdring->bds_dma),
+           bdring->regs + AXIDMA_REG_CUR_DESC);
+    writel(upper_32_bits(bdring->bds_dma),
+           bdring->regs + AXIDMA_REG_CUR_DESC_MSB);
+    writel((control & ~AXIDMA_CR_IRQ_MASK) | AXIDMA_CR_RUN_STOP,
+           bdring->regs + AXIDMA_REG_CONTROL);
+
+    // Each channel has its own mmap offset for its BDs
+    setup->bds_dma = bdring->bds_dma;
+    setup->bds_offset = AXIDMA_MMAP_BDRING_OFFSET + index * PAGE_SIZE;
+    setup->bds_size = bdring->bds_size;
+
+    WRITE_ONCE(dev->bdrings[index], bdring);
+    mutex_unlock(&dev->bdring_lock);
+    return 0;
+
+unmap_regs:
+    iounmap(bdring->regs_page);
+free_bds:
+    dma_free_coherent(&dev->pdev->dev, bdring->bds_size, bdring->bds,
+                      bdring->bds_dma);
+free_bdring:
+    kfree(bdring);
+unlock:
+    mutex_unlock(&dev->bdring_lock);
+    return rc;
+}
+
+/* Tears down the channel's BD ring, if the file has one on it, so that the
+ * channel can be used for normal transfers. This fails if the ring is still
+ * mapped, since userspace could otherwise keep driving the channel. This must
+ * be called with the device's BD ring lock held. */
+static int axidma_bdring_put(struct axidma_file *file, struct axidma_chan *chan)
+{
+    struct axidma_device *dev;
+    struct axidma_bdring *bdring;
+
+    dev = file->dev;
+    bdring = dev->bdrings[chan - dev->channels];
+    if (bdring == NULL || bdring->file != file) {
+        return 0;
+    } else if (bdring->num_maps > 0) {
+        axidma_err("The BD ring of channel %d is still mapped.\n",
+                   chan->channel_id);
+        return -EBUSY;
+    }
+
+    axidma_bdring_free(dev, bdring);
+    return 0;
+}
+
+/* Tears down the channel's BD ring, if the file has one on it, before the
+ * channel is released. The channel can't be released while another channel on
+ * its engine has a BD ring, since the ring has claimed the whole engine. */
+int axidma_bdring_release(struct axidma_file *file, struct axidma_chan *chan)
+{
+    int rc, i, index;
+    struct axidma_device *dev;
+    struct axidma_bdring *bdring;
+
+    dev = file->dev;
+    index = chan - dev->channels;
+    mutex_lock(&dev->bdring_lock);
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        bdring = dev->bdrings[i];
+        if (bdring != NULL && bdring->file == file && i != index &&
+                axidma_bdring_same_engine(dev, index, i)) {
+            axidma_err("Channel %d is on the same engine as the BD ring of "
+                       "channel %d.\n", chan->channel_id,
+                       dev->channels[i].channel_id);
+            rc = -EBUSY;
+            goto unlock;
+        }
+    }
+    rc = axidma_bdring_put(file, chan);
+
+unlock:
+    mutex_unlock(&dev->bdring_lock);
+    return rc;
+}
+
+int axidma_bdring_destroy(struct axidma_file *file, int channel_id)
+{
+    int rc;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct axidma_bdring *bdring;
+
+    dev = file->dev;
+    chan = axidma_get_chan(dev, channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", channel_id);
+        return -ENODEV;
+    }
+
+    bdring = READ_ONCE(dev->bdrings[chan - dev->channels]);
+    if (bdring == NULL || bdring->file != file) {
+        axidma_err("Channel %d does not have a BD ring for this open file.\n",
+                   channel_id);
+        return -EINVAL;
+    }
+
+    mutex_lock(&dev->bdring_lock);
+    rc = axidma_bdring_put(file, chan);
+    mutex_unlock(&dev->bdring_lock);
+    return rc;
+}
+
+/* Writes the tail register of the channel's BD ring, which starts the engine
+ * on the BDs up to the tail. The tail is checked to be one of the ring's BDs,
+ * since the engine would otherwise fetch BDs from anywhere. */
+int axidma_bdring_kick(struct axidma_file *file,
+                       struct axidma_bdring_kick *kick)
+{
+    int rc;
+    u64 tail_offset;
+    u32 status;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct axidma_bdring *bdring;
+
+    dev = file->dev;
+    chan = axidma_get_chan(dev, kick->channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", kick->channel_id);
+        return -ENODEV;
+    }
+
+    // Hold the lock, so that the ring can't be torn down during the write
+    mutex_lock(&dev->bdring_lock);
+    bdring = dev->bdrings[chan - dev->channels];
+    if (bdring == NULL || bdring->file != file) {
+        axidma_err("Channel %d does not have a BD ring for this open file.\n",
+                   kick->channel_id);
+        rc = -EINVAL;
+        goto unlock;
+    }
+
+    tail_offset = kick->tail_dma - bdring->bds_dma;
+    if (kick->tail_dma < bdring->bds_dma ||
+            tail_offset >= bdring->num_bds * sizeof(bdring->bds[0]) ||
+            tail_offset % sizeof(bdring->bds[0]) != 0) {
+        axidma_err("The tail 0x%llx is not a BD of the ring of channel %d.\n",
+                   kick->tail_dma, kick->channel_id);
+        rc = -EINVAL;
+        goto unlock;
+    }
+
+    // An error, or a reset of the engine, halts the channel for good
+    status = readl(bdring->regs + AXIDMA_REG_STATUS);
+    if (status & (AXIDMA_SR_HALTED | AXIDMA_SR_ERRORS)) {
+        axidma_err("The BD ring of channel %d has halted, with status "
+                   "0x%08x.\n", kick->channel_id, status);
+        rc = -EIO;
+        goto unlock;
+    }
+
+    // The engine starts on the write of the lower half, so it must be last
+    writel(upper_32_bits(kick->tail_dma), bdring->regs + AXIDMA_REG_TAIL_MSB);
+    writel(lower_32_bits(kick->tail_dma), bdring->regs + AXIDMA_REG_TAIL);
+    rc = 0;
+
+unlock:
+    mutex_unlock(&dev->bdring_lock);
+    return rc;
+}
+
+/* Checks if any channel on the same engine as the given channel, including
+ * itself, has a BD ring, in which case none of them can be used through the
+ * DMA engine. */
+bool axidma_bdring_engine_used(struct axidma_device *dev, int index)
+{
+    int i;
+
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        if (READ_ONCE(dev->bdrings[i]) != NULL &&
+                axidma_bdring_same_engine(dev, index, i)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Tears down all of the file's BD rings. This is called when the file is
+ * closed, once all of its mappings are gone, and before its channels are
+ * released. */
+void axidma_bdring_exit(struct axidma_file *file)
+{
+    int i;
+    struct axidma_device *dev;
+
+    dev = file->dev;
+    mutex_lock(&dev->bdring_lock);
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        axidma_bdring_put(file, &dev->channels[i]);
+    }
+    mutex_unlock(&dev->bdring_lock);
+}
+
+int axidma_bdring_mmap(struct axidma_file *file, struct vm_area_struct *vma)
+{
+    int rc;
+    unsigned long index, size;
+    struct axidma_device *dev;
+    struct axidma_bdring *bdring;
+
+    // The offset gives the channel whose BDs are mapped
+    dev = file->dev;
+    index = vma->vm_pgoff - (AXIDMA_MMAP_BDRING_OFFSET >> PAGE_SHIFT);
+    size = vma->vm_end - vma->vm_start;
+    if (index >= dev->num_chans) {
+        axidma_err("Invalid mmap offset for a BD ring.\n");
+        return -EINVAL;
+    }
+
+    mutex_lock(&dev->bdring_lock);
+    bdring = dev->bdrings[index];
+    if (bdring == NULL || bdring->file != file) {
+        axidma_err("Channel %d does not have a BD ring for this open file.\n",
+                   dev->channels[index].channel_id);
+        rc = -EINVAL;
+        goto unlock;
+    }
+
+    if (size != bdring->bds_size) {
+        axidma_err("The BD mapping must be exactly %zu bytes.\n",
+                   bdring->bds_size);
+        rc = -EINVAL;
+        goto unlock;
+    }
+
+    // The offset only selects the ring, the BDs are mapped from the start
+    vma->vm_pgoff = 0;
+    rc = dma_mmap_coherent(&dev->pdev->dev, vma, bdring->bds,
+                           bdring->bds_dma, bdring->bds_size);
+    if (rc < 0) {
+        axidma_err("Unable to map the BD ring of channel %d into userspace.\n",
+                   bdring->chan->channel_id);
+        goto unlock;
+    }
+
+    // Count the mapping, so that the ring isn't torn down while it is mapped
+    vma->vm_flags |= VM_DONTCOPY | VM_DONTEXPAND;
+    vma->vm_ops = &axidma_bdring_vm_ops;
+    vma->vm_private_data = bdring;
+    bdring->num_maps += 1;
+
+unlock:
+    mutex_unlock(&dev->bdring_lock);
+    return rc;
+}
@@ -12,54 +12,71 @@
 
 // Kernel dependencies
 #include <linux/list.h>         // Linked list definitions and functions
+#include <linux/rbtree.h>       // Red-black tree definitions and functions
 #include <linux/sched.h>        // `Current` global variable for current task
 #include <linux/device.h>       // Device and class creation functions
 #include <linux/cdev.h>         // Character device functions
 #include <linux/ioctl.h>        // IOCTL macros and definitions
 #include <linux/fs.h>           // File operations and file types
 #include <linux/mm.h>           // Memory types and remapping functions
+#include <linux/gfp.h>          // Page allocation functions
+#include <linux/dma-mapping.h>  // DMA allocation and mapping functions
+#include <linux/genalloc.h>     // Memory pool allocator functions
 #include <linux/uaccess.h>      // Userspace memory access functions
 #include <linux/slab.h>         // Kernel allocation functions
 #include <linux/errno.h>        // Linux error codes
 #include <linux/of_device.h>    // Device tree device related functions
+#include <linux/poll.h>         // Poll table definitions and functions
 
 #include <linux/dma-buf.h>      // DMA shared buffers interface
 #include <linux/scatterlist.h>  // Scatter-gather table definitions
+#include <linux/uio.h>          // I/O vector definitions
+#include <linux/kref.h>         // Reference counting functions
+#include <linux/version.h>      // Linux kernel version definitions
 
 // Local dependencies
 #include "axidma.h"             // Local definitions
 #include "axidma_ioctl.h"       // IOCTL interface for the device
+#include "axidma_trace.h"       // Tracepoint definitions
 
 /*----------------------------------------------------------------------------
  * Internal Definitions
  *----------------------------------------------------------------------------*/
 
-// TODO: Maybe this can be improved?
-static struct axidma_device *axidma_dev;
+/* The user virtual address range of a DMA buffer. Every buffer usable for DMA
+ * has one, and they are kept in a tree sorted by their address, so that the
+ * buffer for an address can be found quickly. The ranges never overlap. */
+struct axidma_region {
+    void *user_addr;            // User virtual address of the buffer
+    size_t size;                // Size of the buffer
+    bool external;              // Indicates the buffer is from another driver
+    struct rb_node node;        // Node in the device's tree of buffers
+};
 
-// A structure that represents a DMA buffer allocation
+/* A structure that represents a DMA buffer allocation. It is referenced by
+ * its mapping, and by the DMA buffer it was exported as, if any. */
 struct axidma_dma_allocation {
-    size_t size;                // Size of the buffer
-    void *user_addr;            // User virtual address of the buffer
+    struct axidma_region region;    // User address range of the buffer
+    bool cached;                // Indicates the buffer is mapped cached
+    bool reserved;              // Indicates the buffer is from reserved memory
     void *kern_addr;            // Kernel virtual address of the buffer
     dma_addr_t dma_addr;        // DMA bus address of the buffer
-    struct list_head list;      // List node pointers for allocation list
+    struct axidma_device *dev;  // The device the buffer was allocated from
+    struct kref ref;            // References to the allocation
 };
 
 /* A structure that represents a DMA buffer allocation imported from another
  * driver in the kernel, through the DMA buffer sharing interface. */
 struct axidma_external_allocation {
+    struct axidma_region region;            // User address range of the buffer
     int fd;                                 // File descritpor for buffer share
     struct dma_buf *dma_buf;                // Structure representing the buffer
     struct dma_buf_attachment *dma_attach;  // Structre represnting attachment
-    size_t size;                            // Total size of the buffer
-    void *user_addr;                        // Buffer's user virtual address
     struct sg_table *sg_table;              // DMA scatter-gather table
-    struct list_head list;                  // Node pointers for the list
 };
 
 /*----------------------------------------------------------------------------
- * VMA Operations
+ * DMA Buffer Tree Operations
  *----------------------------------------------------------------------------*/
 
 static bool valid_dma_request(void *dma_start, size_t dma_size, void *user_addr,
@@ -69,47 +86,278 @@ static bool valid_dma_request(void *dma_start, size_t dma_size, void *user_addr,
            (char *)user_addr + user_size <= (char *)dma_start + dma_size;
 }
 
+/* Adds the buffer's region to the file's tree. Fails if the region overlaps
+ * with that of a buffer already in the tree. */
+static int axidma_insert_region(struct axidma_file *file,
+                                struct axidma_region *region)
+{
+    char *start, *end;
+    struct rb_node **link, *parent;
+    struct axidma_region *entry;
+
+    // Find the leaf where the region belongs, checking for any overlap
+    start = region->user_addr;
+    end = start + region->size;
+    write_lock(&file->dmabuf_lock);
+    link = &file->dmabuf_tree.rb_node;
+    parent = NULL;
+    while (*link != NULL)
+    {
+        parent = *link;
+        entry = rb_entry(parent, struct axidma_region, node);
+        if (end <= (char *)entry->user_addr) {
+            link = &parent->rb_left;
+        } else if (start >= (char *)entry->user_addr + entry->size) {
+            link = &parent->rb_right;
+        } else {
+            write_unlock(&file->dmabuf_lock);
+            return -EEXIST;
+        }
+    }
+
+    rb_link_node(&region->node, parent, link);
+    rb_insert_color(&region->node, &file->dmabuf_tree);
+    write_unlock(&file->dmabuf_lock);
+    return 0;
+}
+
+static void axidma_remove_region(struct axidma_file *file,
+                                 struct axidma_region *region)
+{
+    // Bump the generation, so prepared transfers look up their buffers again
+    write_lock(&file->dmabuf_lock);
+    rb_erase(&region->node, &file->dmabuf_tree);
+    WRITE_ONCE(file->dmabuf_gen, file->dmabuf_gen + 1);
+    write_unlock(&file->dmabuf_lock);
+}
+
+/* Finds the buffer's region that contains the given user address range. If
+ * there is none, then NULL is returned. The caller must hold the file's buffer
+ * lock, and the region is only valid for as long as it is held. */
+static struct axidma_region *axidma_find_region(struct axidma_file *file,
+                                                void *user_addr, size_t size)
+{
+    struct rb_node *node;
+    struct axidma_region *region;
+
+    // Since regions never overlap, only one can contain the start address
+    node = file->dmabuf_tree.rb_node;
+    while (node != NULL)
+    {
+        region = rb_entry(node, struct axidma_region, node);
+        if ((char *)user_addr < (char *)region->user_addr) {
+            node = node->rb_left;
+        } else if ((char *)user_addr >=
+                   (char *)region->user_addr + region->size) {
+            node = node->rb_right;
+        } else if (valid_dma_request(region->user_addr, region->size,
+                                     user_addr, size)) {
+            return region;
+        } else {
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * VMA Operations
+ *----------------------------------------------------------------------------*/
+
+/* Converts the given user space virtual address range within the buffer's
+ * region to a DMA address. If the range is not physically contiguous, then
+ * (dma_addr_t)NULL is returned. */
+static dma_addr_t axidma_region_to_dma(struct axidma_region *region,
+                                       void *user_addr, size_t size)
+{
+    int i;
+    dma_addr_t offset;
+    struct sg_table *sg_table;
+    struct scatterlist *sg;
+    struct axidma_dma_allocation *dma_alloc;
+    struct axidma_external_allocation *dma_ext_alloc;
+
+    offset = (dma_addr_t)(user_addr - region->user_addr);
+
+    // Buffers allocated by this driver are contiguous
+    if (!region->external) {
+        dma_alloc = container_of(region, struct axidma_dma_allocation, region);
+        return dma_alloc->dma_addr + offset;
+    }
+
+    // For buffers from other drivers, the region must be in a single segment
+    dma_ext_alloc = container_of(region, struct axidma_external_allocation,
+                                 region);
+    sg_table = dma_ext_alloc->sg_table;
+    for_each_sg(sg_table->sgl, sg, sg_table->nents, i)
+    {
+        if (offset < sg_dma_len(sg)) {
+            break;
+        }
+        offset -= sg_dma_len(sg);
+    }
+    if (i == sg_table->nents || offset + size > sg_dma_len(sg)) {
+        return (dma_addr_t)NULL;
+    }
+    return sg_dma_address(sg) + offset;
+}
+
 /* Converts the given user space virtual address to a DMA address. If the
  * conversion is unsuccessful, then (dma_addr_t)NULL is returned. */
-dma_addr_t axidma_uservirt_to_dma(struct axidma_device *dev, void *user_addr,
+dma_addr_t axidma_uservirt_to_dma(struct axidma_file *file, void *user_addr,
                                   size_t size)
 {
-    bool valid;
-    dma_addr_t offset;
-    struct list_head *iter;
+    dma_addr_t dma_addr;
+    struct axidma_region *region;
+
+    // Find the DMA buffer that contains the given region
+    read_lock(&file->dmabuf_lock);
+    region = axidma_find_region(file, user_addr, size);
+    dma_addr = (region == NULL) ? (dma_addr_t)NULL :
+               axidma_region_to_dma(region, user_addr, size);
+    read_unlock(&file->dmabuf_lock);
+
+    return dma_addr;
+}
+
+/* Translates the user space virtual address to the bus address of the
+ * physically contiguous segment of the DMA buffer that contains it, along with
+ * the segment's bounds, so that userspace can fill in BDs itself. */
+int axidma_get_dma_addr(struct axidma_file *file,
+                        struct axidma_dma_addr *dma_addr)
+{
+    int i, rc;
+    size_t offset;
+    struct sg_table *sg_table;
+    struct scatterlist *sg;
+    struct axidma_region *region;
     struct axidma_dma_allocation *dma_alloc;
     struct axidma_external_allocation *dma_ext_alloc;
 
-    // First iterate over DMA buffers allocated by this driver
-    list_for_each(iter, &dev->dmabuf_list)
+    // Find the DMA buffer that contains the given address
+    read_lock(&file->dmabuf_lock);
+    region = axidma_find_region(file, dma_addr->user_addr, 0);
+    if (region == NULL) {
+        axidma_err("Address %p does not fall within a previously allocated "
+                   "DMA buffer.\n", dma_addr->user_addr);
+        rc = -EFAULT;
+        goto unlock;
+    }
+
+    // Buffers allocated by this driver are a single segment
+    rc = 0;
+    if (!region->external) {
+        dma_alloc = container_of(region, struct axidma_dma_allocation, region);
+        dma_addr->seg_addr = region->user_addr;
+        dma_addr->seg_size = region->size;
+        dma_addr->dma_addr = dma_alloc->dma_addr;
+        goto unlock;
+    }
+
+    // For buffers from other drivers, find the segment with the address
+    dma_ext_alloc = container_of(region, struct axidma_external_allocation,
+                                 region);
+    sg_table = dma_ext_alloc->sg_table;
+    offset = (char *)dma_addr->user_addr - (char *)region->user_addr;
+    dma_addr->seg_addr = region->user_addr;
+    for_each_sg(sg_table->sgl, sg, sg_table->nents, i)
     {
-        dma_alloc = container_of(iter, struct axidma_dma_allocation, list);
-        valid = valid_dma_request(dma_alloc->user_addr, dma_alloc->size,
-                                  user_addr, size);
-        if (valid) {
-            offset = (dma_addr_t)(user_addr - dma_alloc->user_addr);
-            return dma_alloc->dma_addr + offset;
+        if (offset < sg_dma_len(sg)) {
+            break;
+        }
+        offset -= sg_dma_len(sg);
+        dma_addr->seg_addr = (char *)dma_addr->seg_addr + sg_dma_len(sg);
+    }
+    if (i == sg_table->nents) {
+        rc = -EFAULT;
+        goto unlock;
+    }
+    dma_addr->seg_size = sg_dma_len(sg);
+    dma_addr->dma_addr = sg_dma_address(sg);
+
+unlock:
+    read_unlock(&file->dmabuf_lock);
+    return rc;
+}
+
+/* Converts the given user space virtual address range to entries in the
+ * scatter-gather list, splitting it at the boundaries between the segments of
+ * an external buffer. If the list is NULL, the entries are only counted, and
+ * otherwise at most max_nents are filled in. Returns the number of entries, or
+ * a negative error code on failure. */
+int axidma_uservirt_to_sg(struct axidma_file *file, void *user_addr,
+                          size_t size, struct scatterlist *sg_list,
+                          int max_nents)
+{
+    int i, nents;
+    size_t offset, len;
+    dma_addr_t dma_addr;
+    struct sg_table *sg_table;
+    struct scatterlist *sg;
+    struct axidma_region *region;
+    struct axidma_external_allocation *dma_ext_alloc;
+
+    // Find the DMA buffer that contains the given region
+    read_lock(&file->dmabuf_lock);
+    region = axidma_find_region(file, user_addr, size);
+    if (region == NULL) {
+        nents = -EFAULT;
+        goto unlock;
+    }
+
+    // If the region is physically contiguous, then it needs only one entry
+    dma_addr = axidma_region_to_dma(region, user_addr, size);
+    if (dma_addr != (dma_addr_t)NULL) {
+        if (sg_list != NULL && max_nents < 1) {
+            nents = -ENOSPC;
+            goto unlock;
+        } else if (sg_list != NULL) {
+            sg_dma_address(&sg_list[0]) = dma_addr;
+            sg_dma_len(&sg_list[0]) = size;
         }
+        nents = 1;
+        goto unlock;
     }
 
-    // Otherwise, iterate over the DMA buffers allocated by other drivers
-    list_for_each(iter, &dev->external_dmabufs)
+    // Otherwise, split the region at the segments of the external buffer
+    dma_ext_alloc = container_of(region, struct axidma_external_allocation,
+                                 region);
+    nents = 0;
+    offset = (char *)user_addr - (char *)region->user_addr;
+    sg_table = dma_ext_alloc->sg_table;
+    for_each_sg(sg_table->sgl, sg, sg_table->nents, i)
     {
-        dma_ext_alloc = container_of(iter, struct axidma_external_allocation,
-                                     list);
-        valid = valid_dma_request(dma_ext_alloc->user_addr, dma_ext_alloc->size,
-                                  user_addr, size);
-        if (valid) {
-            offset = (dma_addr_t)(user_addr - dma_ext_alloc->user_addr);
-            return sg_dma_address(&dma_ext_alloc->sg_table->sgl[0]) + offset;
+        if (offset >= sg_dma_len(sg)) {
+            offset -= sg_dma_len(sg);
+            continue;
+        }
+
+        len = min_t(size_t, sg_dma_len(sg) - offset, size);
+        if (sg_list != NULL && nents >= max_nents) {
+            nents = -ENOSPC;
+            goto unlock;
+        } else if (sg_list != NULL) {
+            sg_dma_address(&sg_list[nents]) = sg_dma_address(sg) + offset;
+            sg_dma_len(&sg_list[nents]) = len;
+        }
+        nents += 1;
+        size -= len;
+        offset = 0;
+        if (size == 0) {
+            goto unlock;
         }
     }
 
-    // No matching allocation was found
-    return (dma_addr_t)NULL;
+    // The buffer's segments are smaller than the size it was registered as
+    nents = -EFAULT;
+
+unlock:
+    read_unlock(&file->dmabuf_lock);
+    return nents;
 }
 
-static int axidma_get_external(struct axidma_device *dev,
+static int axidma_get_external(struct axidma_file *file,
                                struct axidma_register_buffer *ext_buf)
 {
     int rc;
@@ -132,7 +380,8 @@ static int axidma_get_external(struct axidma_device *dev,
     }
 
     // Attach ourselves to the DMA buffer, indicating usage
-    dma_alloc->dma_attach = dma_buf_attach(dma_alloc->dma_buf, dev->device);
+    dma_alloc->dma_attach = dma_buf_attach(dma_alloc->dma_buf,
+                                           file->dev->device);
     if (IS_ERR(dma_alloc->dma_attach)) {
         axidma_err("Unable to attach to the external DMA buffer.\n");
         rc = PTR_ERR(dma_alloc->dma_attach);
@@ -149,18 +398,17 @@ static int axidma_get_external(struct axidma_device *dev,
         goto detach_ext_dma;
     }
 
-    // The allocation is expected to be one contiguous memory region
-    if (dma_alloc->sg_table->nents != 1) {
-        axidma_err("External DMA allocations must a single contiguous region "
-                   "of physical memory.\n");
-        rc = -EINVAL;
+    // Add ourselves the file's tree of DMA buffers
+    dma_alloc->region.user_addr = ext_buf->user_addr;
+    dma_alloc->region.size = ext_buf->size;
+    dma_alloc->region.external = true;
+    rc = axidma_insert_region(file, &dma_alloc->region);
+    if (rc < 0) {
+        axidma_err("External DMA buffer at address %p, size %zu overlaps a "
+                   "previously registered DMA buffer.\n", ext_buf->user_addr,
+                   ext_buf->size);
         goto unmap_ext_dma;
     }
-
-    // Add ourselves the driver's list of external allocations
-    dma_alloc->size = ext_buf->size;
-    dma_alloc->user_addr = ext_buf->user_addr;
-    list_add(&dma_alloc->list, &dev->external_dmabufs);
     return 0;
 
 unmap_ext_dma:
@@ -175,48 +423,306 @@ free_ext_alloc:
     return rc;
 }
 
-static int axidma_put_external(struct axidma_device *dev, void *user_addr)
+/* Releases an external buffer that has already been removed from the tree.
+ * This may sleep, so it can't be done with the buffer lock held. */
+static void axidma_free_external(struct axidma_external_allocation *dma_alloc)
 {
-    void *end_user_addr;
-    struct list_head *iter;
-    struct axidma_external_allocation *dma_alloc;
+    // Unmap the buffer, and detach ourselves from it
+    dma_buf_unmap_attachment(dma_alloc->dma_attach, dma_alloc->sg_table,
+                             DMA_BIDIRECTIONAL);
+    dma_buf_detach(dma_alloc->dma_buf, dma_alloc->dma_attach);
+    dma_buf_put(dma_alloc->dma_buf);
+    kfree(dma_alloc);
+}
 
-    // Find the allocation corresponding to the user address
-    list_for_each(iter, &dev->external_dmabufs)
+static int axidma_put_external(struct axidma_file *file, void *user_addr)
+{
+    struct axidma_region *region;
+
+    /* Find the allocation corresponding to the user address, and remove it
+     * from the tree, so no new transfers can use it. */
+    write_lock(&file->dmabuf_lock);
+    region = axidma_find_region(file, user_addr, 0);
+    if (region == NULL || !region->external) {
+        write_unlock(&file->dmabuf_lock);
+        return -ENOENT;
+    }
+
+    // Bump the generation, so prepared transfers can't use the buffer anymore
+    rb_erase(&region->node, &file->dmabuf_tree);
+    WRITE_ONCE(file->dmabuf_gen, file->dmabuf_gen + 1);
+    write_unlock(&file->dmabuf_lock);
+
+    axidma_free_external(container_of(region,
+            struct axidma_external_allocation, region));
+    return 0;
+}
+
+/* Unregisters all of the external buffers that are still registered with the
+ * file. The buffers allocated by the driver are freed when they are unmapped,
+ * which always happens before the file is released. */
+static void axidma_put_all_external(struct axidma_file *file)
+{
+    struct rb_node *node, *next;
+    struct axidma_region *region;
+
+    // No other thread can be using the file when it is released
+    for (node = rb_first(&file->dmabuf_tree); node != NULL; node = next)
     {
-        dma_alloc = container_of(iter, struct axidma_external_allocation, list);
-        end_user_addr = (char *)dma_alloc->user_addr + dma_alloc->size;
-
-        if (dma_alloc->user_addr <= user_addr && user_addr <= end_user_addr) {
-            // Unmap the buffer, and detach ourselves from it
-            dma_buf_unmap_attachment(dma_alloc->dma_attach,
-                    dma_alloc->sg_table, DMA_BIDIRECTIONAL);
-            dma_buf_detach(dma_alloc->dma_buf, dma_alloc->dma_attach);
-            dma_buf_put(dma_alloc->dma_buf);
-
-            // Free the allocation structure
-            kfree(dma_alloc);
-            return 0;
+        next = rb_next(node);
+        region = rb_entry(node, struct axidma_region, node);
+        if (region->external) {
+            rb_erase(node, &file->dmabuf_tree);
+            WRITE_ONCE(file->dmabuf_gen, file->dmabuf_gen + 1);
+            axidma_free_external(container_of(region,
+                    struct axidma_external_allocation, region));
         }
     }
+}
+
+/* Allocates a coherent DMA buffer, and maps it into userspace. On systems
+ * without a cache-coherent interconnect, the mapping is uncached. */
+static int axidma_alloc_coherent(struct axidma_device *dev,
+        struct axidma_dma_allocation *dma_alloc, struct vm_area_struct *vma)
+{
+    int rc;
+
+    // Allocate the requested region a contiguous and uncached for DMA
+    dma_alloc->kern_addr = dma_alloc_coherent(&dev->pdev->dev,
+            dma_alloc->region.size, &dma_alloc->dma_addr, GFP_KERNEL);
+    if (dma_alloc->kern_addr == NULL) {
+        axidma_err("Unable to allocate contiguous DMA memory region of size "
+                   "%zu.\n", dma_alloc->region.size);
+        axidma_err("Please make sure that you specified cma=<size> on the "
+                   "kernel command line, and the size is large enough.\n");
+        return -ENOMEM;
+    }
+
+    // Map the region into userspace
+    rc = dma_mmap_coherent(&dev->pdev->dev, vma, dma_alloc->kern_addr,
+                           dma_alloc->dma_addr, dma_alloc->region.size);
+    if (rc < 0) {
+        axidma_err("Unable to remap address %p to userspace address %p, size "
+                   "%zu.\n", dma_alloc->kern_addr,
+                   dma_alloc->region.user_addr, dma_alloc->region.size);
+        dma_free_coherent(&dev->pdev->dev, dma_alloc->region.size,
+                          dma_alloc->kern_addr, dma_alloc->dma_addr);
+        return rc;
+    }
 
-    return -ENOENT;
+    return 0;
 }
 
-static void axidma_vma_close(struct vm_area_struct *vma)
+/* Allocates a DMA buffer from the reserved memory region, and maps it into
+ * userspace. The region is physically contiguous, so large buffers don't fail
+ * due to fragmentation. Like coherent buffers, the mapping is uncached. */
+static int axidma_alloc_reserved(struct axidma_device *dev,
+        struct axidma_dma_allocation *dma_alloc, struct vm_area_struct *vma)
 {
+    int rc;
+    unsigned long phys_addr;
+    pgprot_t prot;
+
+    phys_addr = gen_pool_alloc(dev->mem_pool, dma_alloc->region.size);
+    if (phys_addr == 0) {
+        axidma_err("Unable to allocate a DMA buffer of size %zu from the "
+                   "reserved memory region, %zu bytes are available.\n",
+                   dma_alloc->region.size, gen_pool_avail(dev->mem_pool));
+        return -ENOMEM;
+    }
+
+    // The reserved region is only accessed by the DMA engines, not by an IOMMU
+    dma_alloc->kern_addr = NULL;
+    dma_alloc->dma_addr = (dma_addr_t)phys_addr;
+
+    // Map the region into userspace, with the same attributes as coherent ones
+    prot = pgprot_writecombine(vma->vm_page_prot);
+    rc = remap_pfn_range(vma, vma->vm_start, phys_addr >> PAGE_SHIFT,
+                         dma_alloc->region.size, prot);
+    if (rc < 0) {
+        axidma_err("Unable to remap reserved memory at 0x%lx to userspace "
+                   "address %p, size %zu.\n", phys_addr,
+                   dma_alloc->region.user_addr, dma_alloc->region.size);
+        gen_pool_free(dev->mem_pool, phys_addr, dma_alloc->region.size);
+        return rc;
+    }
+
+    return 0;
+}
+
+/* Maps the pages of a cached DMA buffer into userspace. The pages are inserted
+ * individually, rather than remapped by their PFN, so that they can be pinned
+ * by other drivers, such as for O_DIRECT I/O, splice, or io_uring. */
+static int axidma_insert_pages(struct axidma_dma_allocation *dma_alloc,
+                               struct vm_area_struct *vma)
+{
+    int rc;
+    unsigned long offset;
+    struct page *page;
+
+    page = virt_to_page(dma_alloc->kern_addr);
+    for (offset = 0; offset < vma->vm_end - vma->vm_start; offset += PAGE_SIZE)
+    {
+        rc = vm_insert_page(vma, vma->vm_start + offset, page);
+        if (rc < 0) {
+            return rc;
+        }
+        page += 1;
+    }
+
+    return 0;
+}
+
+/* Allocates a cached DMA buffer, maps it for streaming DMA, and maps it into
+ * userspace cached. The user is responsible for synchronizing the buffer around
+ * each transfer. Since these come from the page allocator, rather than CMA,
+ * their size is limited to the kernel's maximum page allocation order. */
+static int axidma_alloc_cached(struct axidma_device *dev,
+        struct axidma_dma_allocation *dma_alloc, struct vm_area_struct *vma)
+{
+    int rc;
+
+    // Allocate the requested region as contiguous pages
+    dma_alloc->kern_addr = alloc_pages_exact(dma_alloc->region.size,
+                                             GFP_KERNEL | __GFP_NOWARN);
+    if (dma_alloc->kern_addr == NULL) {
+        axidma_err("Unable to allocate contiguous cached memory region of "
+                   "size %zu.\n", dma_alloc->region.size);
+        return -ENOMEM;
+    }
+
+    // Map the region for streaming DMA, which does the initial cache flush
+    dma_alloc->dma_addr = dma_map_single(&dev->pdev->dev, dma_alloc->kern_addr,
+            dma_alloc->region.size, DMA_BIDIRECTIONAL);
+    if (dma_mapping_error(&dev->pdev->dev, dma_alloc->dma_addr)) {
+        axidma_err("Unable to map cached memory region at %p for DMA.\n",
+                   dma_alloc->kern_addr);
+        rc = -ENOMEM;
+        goto free_pages;
+    }
+
+    // Map the region into userspace, keeping the default cached protection
+    rc = axidma_insert_pages(dma_alloc, vma);
+    if (rc < 0) {
+        axidma_err("Unable to remap address %p to userspace address %p, size "
+                   "%zu.\n", dma_alloc->kern_addr,
+                   dma_alloc->region.user_addr, dma_alloc->region.size);
+        goto unmap_dma;
+    }
+
+    return 0;
+
+unmap_dma:
+    dma_unmap_single(&dev->pdev->dev, dma_alloc->dma_addr,
+                     dma_alloc->region.size, DMA_BIDIRECTIONAL);
+free_pages:
+    free_pages_exact(dma_alloc->kern_addr, dma_alloc->region.size);
+    return rc;
+}
+
+// Frees the memory for a DMA buffer allocated by the driver
+static void axidma_free_buffer(struct axidma_device *dev,
+                               struct axidma_dma_allocation *dma_alloc)
+{
+    if (dma_alloc->cached) {
+        dma_unmap_single(&dev->pdev->dev, dma_alloc->dma_addr,
+                         dma_alloc->region.size, DMA_BIDIRECTIONAL);
+        free_pages_exact(dma_alloc->kern_addr, dma_alloc->region.size);
+    } else if (dma_alloc->reserved) {
+        gen_pool_free(dev->mem_pool, (unsigned long)dma_alloc->dma_addr,
+                      dma_alloc->region.size);
+    } else {
+        dma_free_coherent(&dev->pdev->dev, dma_alloc->region.size,
+                          dma_alloc->kern_addr, dma_alloc->dma_addr);
+    }
+}
+
+/* Synchronizes the given range of a cached DMA buffer, for the CPU or the
+ * device. Coherent and external buffers need no synchronization. */
+static int axidma_sync_buffer(struct axidma_file *file,
+                              struct axidma_sync *sync, bool for_cpu)
+{
+    bool cached;
+    unsigned long offset;
+    dma_addr_t dma_addr;
     struct axidma_device *dev;
+    struct axidma_region *region;
     struct axidma_dma_allocation *dma_alloc;
 
-    // Get the AXI DMA allocation data and free the DMA buffer
-    dev = axidma_dev;
-    dma_alloc = vma->vm_private_data;
-    dma_free_coherent(&dev->pdev->dev, dma_alloc->size, dma_alloc->kern_addr,
-                      dma_alloc->dma_addr);
+    // Find the DMA buffer that contains the given range
+    dev = file->dev;
+    read_lock(&file->dmabuf_lock);
+    region = axidma_find_region(file, sync->user_addr, sync->size);
+    if (region == NULL) {
+        read_unlock(&file->dmabuf_lock);
+        axidma_err("Address range %p, size %zu is not within a DMA buffer.\n",
+                   sync->user_addr, sync->size);
+        return -EFAULT;
+    }
 
-    // Remove the allocation from the list, and free the structure
-    list_del(&dma_alloc->list);
+    /* Buffers allocated by the driver are only freed when unmapped, which
+     * can't happen while the sync is in progress, so the values are copied. */
+    dma_alloc = container_of(region, struct axidma_dma_allocation, region);
+    cached = !region->external && dma_alloc->cached;
+    dma_addr = cached ? dma_alloc->dma_addr : 0;
+    offset = (char *)sync->user_addr - (char *)region->user_addr;
+    read_unlock(&file->dmabuf_lock);
+
+    if (!cached) {
+        return 0;
+    }
+
+    // The direction must match the one the buffer was mapped with
+    if (for_cpu) {
+        dma_sync_single_range_for_cpu(&dev->pdev->dev, dma_addr, offset,
+                sync->size, DMA_BIDIRECTIONAL);
+    } else {
+        dma_sync_single_range_for_device(&dev->pdev->dev, dma_addr, offset,
+                sync->size, DMA_BIDIRECTIONAL);
+    }
+
+    return 0;
+}
+
+/* Gets the size of the reserved memory region, and how much of it is not yet
+ * allocated. If there is no reserved region, then both are zero. */
+static void axidma_get_mem_info(struct axidma_device *dev,
+                                struct axidma_mem_info *mem_info)
+{
+    if (dev->mem_pool == NULL) {
+        mem_info->total_size = 0;
+        mem_info->avail_size = 0;
+    } else {
+        mem_info->total_size = gen_pool_size(dev->mem_pool);
+        mem_info->avail_size = gen_pool_avail(dev->mem_pool);
+    }
+}
+
+// Frees the allocation once its mapping and exported buffer are both gone
+static void axidma_release_alloc(struct kref *ref)
+{
+    struct axidma_dma_allocation *dma_alloc;
+
+    dma_alloc = container_of(ref, struct axidma_dma_allocation, ref);
+    axidma_free_buffer(dma_alloc->dev, dma_alloc);
     kfree(dma_alloc);
+}
+
+static void axidma_vma_close(struct vm_area_struct *vma)
+{
+    struct axidma_file *file;
+    struct axidma_dma_allocation *dma_alloc;
+
+    /* Get the AXI DMA allocation data and free the DMA buffer. The mapping
+     * holds a reference to the file, so it has not been released yet. */
+    file = vma->vm_file->private_data;
+    dma_alloc = vma->vm_private_data;
+
+    /* Remove the allocation from the tree before freeing the DMA buffer, so
+     * that a concurrent transfer can't find it. If the buffer was exported,
+     * then it is only freed once the exported buffer is released. */
+    axidma_remove_region(file, &dma_alloc->region);
+    kref_put(&dma_alloc->ref, axidma_release_alloc);
 
     return;
 }
@@ -226,40 +732,296 @@ static const struct vm_operations_struct axidma_vm_ops = {
     .close = axidma_vma_close,
 };
 
+/*----------------------------------------------------------------------------
+ * DMA Buffer Exporting
+ *----------------------------------------------------------------------------*/
+
+/* Maps the exported buffer for DMA by the device of another driver. Each
+ * attachment gets its own scatter-gather table, built from the buffer's pages,
+ * since it is mapped for a different device. */
+static struct sg_table *axidma_dmabuf_map(struct dma_buf_attachment *attach,
+                                          enum dma_data_direction dir)
+{
+    int rc;
+    struct sg_table *sg_table;
+    struct axidma_dma_allocation *dma_alloc;
+
+    dma_alloc = attach->dmabuf->priv;
+    sg_table = kzalloc(sizeof(*sg_table), GFP_KERNEL);
+    if (sg_table == NULL) {
+        axidma_err("Unable to allocate the exported scatter-gather table.\n");
+        return ERR_PTR(-ENOMEM);
+    }
+
+    // Cached buffers are from the page allocator, coherent ones from CMA
+    if (dma_alloc->cached) {
+        rc = sg_alloc_table(sg_table, 1, GFP_KERNEL);
+        if (rc == 0) {
+            sg_set_page(sg_table->sgl, virt_to_page(dma_alloc->kern_addr),
+                        dma_alloc->region.size, 0);
+        }
+    } else {
+        rc = dma_get_sgtable(&dma_alloc->dev->pdev->dev, sg_table,
+                dma_alloc->kern_addr, dma_alloc->dma_addr,
+                dma_alloc->region.size);
+    }
+    if (rc < 0) {
+        axidma_err("Unable to build the exported scatter-gather table.\n");
+        goto free_sg_table;
+    }
+
+    if (dma_map_sg(attach->dev, sg_table->sgl, sg_table->orig_nents,
+                   dir) == 0) {
+        axidma_err("Unable to map the exported buffer for DMA.\n");
+        rc = -ENOMEM;
+        goto free_sg_entries;
+    }
+
+    return sg_table;
+
+free_sg_entries:
+    sg_free_table(sg_table);
+free_sg_table:
+    kfree(sg_table);
+    return ERR_PTR(rc);
+}
+
+static void axidma_dmabuf_unmap(struct dma_buf_attachment *attach,
+                                struct sg_table *sg_table,
+                                enum dma_data_direction dir)
+{
+    dma_unmap_sg(attach->dev, sg_table->sgl, sg_table->orig_nents, dir);
+    sg_free_table(sg_table);
+    kfree(sg_table);
+}
+
+// Drops the exported buffer's reference to the allocation
+static void axidma_dmabuf_release(struct dma_buf *dma_buf)
+{
+    struct axidma_dma_allocation *dma_alloc;
+
+    dma_alloc = dma_buf->priv;
+    kref_put(&dma_alloc->ref, axidma_release_alloc);
+}
+
+// Returns the kernel virtual address of the given page of the buffer
+static void *axidma_dmabuf_kmap(struct dma_buf *dma_buf, unsigned long page)
+{
+    struct axidma_dma_allocation *dma_alloc;
+
+    dma_alloc = dma_buf->priv;
+    return (char *)dma_alloc->kern_addr + page * PAGE_SIZE;
+}
+
+// Maps the exported buffer into the address space of another process
+static int axidma_dmabuf_mmap(struct dma_buf *dma_buf,
+                              struct vm_area_struct *vma)
+{
+    struct axidma_dma_allocation *dma_alloc;
+
+    dma_alloc = dma_buf->priv;
+    if (vma->vm_end - vma->vm_start > dma_alloc->region.size) {
+        axidma_err("The exported buffer mapping can be at most %zu bytes.\n",
+                   dma_alloc->region.size);
+        return -EINVAL;
+    }
+
+    if (dma_alloc->cached) {
+        return axidma_insert_pages(dma_alloc, vma);
+    }
+    return dma_mmap_coherent(&dma_alloc->dev->pdev->dev, vma,
+            dma_alloc->kern_addr, dma_alloc->dma_addr,
+            vma->vm_end - vma->vm_start);
+}
+
+/* The operations for buffers exported to other drivers. The names of the
+ * kernel mapping operations changed in the 4.12 kernel, and the atomic one was
+ * removed in 4.19. */
+static const struct dma_buf_ops axidma_dmabuf_ops = {
+    .map_dma_buf = axidma_dmabuf_map,
+    .unmap_dma_buf = axidma_dmabuf_unmap,
+    .release = axidma_dmabuf_release,
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,12,0)
+    .kmap_atomic = axidma_dmabuf_kmap,
+    .kmap = axidma_dmabuf_kmap,
+#elif LINUX_VERSION_CODE < KERNEL_VERSION(4,19,0)
+    .map_atomic = axidma_dmabuf_kmap,
+    .map = axidma_dmabuf_kmap,
+#else
+    .map = axidma_dmabuf_kmap,
+#endif
+    .mmap = axidma_dmabuf_mmap,
+};
+
+/* Exports the DMA buffer at the given address as a DMA buffer sharing file
+ * descriptor, so that it can be used by other drivers without a copy. */
+static int axidma_export_buffer(struct axidma_file *file,
+                                struct axidma_export_buffer *export)
+{
+    int rc;
+    struct dma_buf *dma_buf;
+    struct axidma_region *region;
+    struct axidma_dma_allocation *dma_alloc;
+    DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+
+    if ((export->flags & ~(O_RDWR | O_CLOEXEC)) != 0) {
+        axidma_err("Invalid export flags 0x%x.\n", export->flags);
+        return -EINVAL;
+    }
+
+    /* Find the buffer, and take a reference to it under the lock, so that it
+     * can't be freed if it is concurrently unmapped. */
+    read_lock(&file->dmabuf_lock);
+    region = axidma_find_region(file, export->user_addr, 0);
+    if (region == NULL || region->external ||
+            region->user_addr != export->user_addr) {
+        read_unlock(&file->dmabuf_lock);
+        axidma_err("Address %p is not the start of a DMA buffer allocated by "
+                   "the driver.\n", export->user_addr);
+        return -EINVAL;
+    }
+    dma_alloc = container_of(region, struct axidma_dma_allocation, region);
+    kref_get(&dma_alloc->ref);
+    read_unlock(&file->dmabuf_lock);
+
+    // Buffers from the reserved region are not backed by pages
+    if (dma_alloc->reserved) {
+        axidma_err("Buffers from the reserved memory region can't be "
+                   "exported.\n");
+        rc = -EINVAL;
+        goto put_alloc;
+    }
+
+    // The exported buffer takes over our reference to the allocation
+    exp_info.ops = &axidma_dmabuf_ops;
+    exp_info.size = dma_alloc->region.size;
+    exp_info.flags = O_RDWR;
+    exp_info.priv = dma_alloc;
+    dma_buf = dma_buf_export(&exp_info);
+    if (IS_ERR(dma_buf)) {
+        axidma_err("Unable to export the DMA buffer at %p.\n",
+                   export->user_addr);
+        rc = PTR_ERR(dma_buf);
+        goto put_alloc;
+    }
+
+    export->dmabuf_fd = dma_buf_fd(dma_buf, export->flags & O_CLOEXEC);
+    if (export->dmabuf_fd < 0) {
+        axidma_err("Unable to get a file descriptor for the exported "
+                   "buffer.\n");
+        rc = export->dmabuf_fd;
+        dma_buf_put(dma_buf);
+        return rc;
+    }
+
+    return 0;
+
+put_alloc:
+    kref_put(&dma_alloc->ref, axidma_release_alloc);
+    return rc;
+}
+
 /*----------------------------------------------------------------------------
  * File Operations
  *----------------------------------------------------------------------------*/
 
-static int axidma_open(struct inode *inode, struct file *file)
+static int axidma_open(struct inode *inode, struct file *filp)
 {
-    // Only the root user can open this device, and it must be exclusive
+    int rc;
+    struct axidma_file *file;
+
+    // Only the root user can open this device
     if (!capable(CAP_SYS_ADMIN)) {
         axidma_err("Only root can open this device.");
         return -EACCES;
-    } else if (!(file->f_flags & O_EXCL)) {
-        axidma_err("O_EXCL must be specified for open()\n");
-        return -EINVAL;
     }
 
-    // Place the axidma structure in the private data of the file
-    file->private_data = (void *)axidma_dev;
+    /* Allocate the state for this open file. The device may be opened any
+     * number of times, with each file owning different channels. */
+    file = kzalloc(sizeof(*file), GFP_KERNEL);
+    if (file == NULL) {
+        axidma_err("Unable to allocate the open file structure.\n");
+        return -ENOMEM;
+    }
+    file->dev = container_of(inode->i_cdev, struct axidma_device, chrdev);
+    INIT_LIST_HEAD(&file->async_transfers);
+    spin_lock_init(&file->async_lock);
+    rwlock_init(&file->dmabuf_lock);
+    file->dmabuf_tree = RB_ROOT;
+    idr_init(&file->prepared);
+    spin_lock_init(&file->prepared_lock);
+
+    // Initialize the queue for the file's transfer completion events
+    rc = axidma_event_init(file);
+    if (rc < 0) {
+        goto free_file;
+    }
+
+    // Allocate the status shared with userspace for cyclic and video transfers
+    rc = axidma_cyclic_init(file);
+    if (rc < 0) {
+        goto exit_event;
+    }
+
+    // Place the file structure in the private data of the file
+    filp->private_data = file;
     return 0;
+
+exit_event:
+    axidma_event_exit(file);
+free_file:
+    kfree(file);
+    return rc;
 }
 
-static int axidma_release(struct inode *inode, struct file *file)
+static int axidma_release(struct inode *inode, struct file *filp)
 {
-    file->private_data = NULL;
+    struct axidma_file *file;
+
+    file = filp->private_data;
+
+    /* Stop submitting transfers from the SQ, hand the channels with BD rings
+     * back to the DMA engine, and then stop all transfers on the file's
+     * channels, so that nothing references the file anymore. */
+    axidma_ring_stop(file);
+    axidma_bdring_exit(file);
+    axidma_release_channels(file);
+
+    /* Tear down the event queue first, which waits for any wakeups steered to
+     * other CPUs, and then the rings, prepared transfers, external buffers,
+     * and cyclic status. */
+    axidma_event_exit(file);
+    axidma_ring_destroy(file);
+    axidma_prepared_exit(file);
+    axidma_put_all_external(file);
+    axidma_cyclic_exit(file);
+
+    kfree(file);
+    filp->private_data = NULL;
     return 0;
 }
 
-static int axidma_mmap(struct file *file, struct vm_area_struct *vma)
+static int axidma_mmap(struct file *filp, struct vm_area_struct *vma)
 {
     int rc;
+    struct axidma_file *file;
     struct axidma_device *dev;
     struct axidma_dma_allocation *dma_alloc;
 
-    // Get the axidma device structure
-    dev = file->private_data;
+    // Get the axidma file and device structures
+    file = filp->private_data;
+    dev = file->dev;
+
+    /* The shared submission and completion rings, and the cyclic transfer
+     * status, are each mapped at a fixed offset. The BD rings are mapped at
+     * the offsets above theirs. */
+    if (vma->vm_pgoff == (AXIDMA_MMAP_RING_OFFSET >> PAGE_SHIFT)) {
+        return axidma_ring_mmap(file, vma);
+    } else if (vma->vm_pgoff == (AXIDMA_MMAP_CYCLIC_OFFSET >> PAGE_SHIFT)) {
+        return axidma_cyclic_mmap(file, vma);
+    } else if (vma->vm_pgoff >= (AXIDMA_MMAP_BDRING_OFFSET >> PAGE_SHIFT)) {
+        return axidma_bdring_mmap(file, vma);
+    }
 
     // Allocate a structure to store data about the DMA mapping
     dma_alloc = kmalloc(sizeof(*dma_alloc), GFP_KERNEL);
@@ -270,31 +1032,38 @@ static int axidma_mmap(struct file *file, struct vm_area_struct *vma)
     }
 
     // Set the user virtual address and the size
-    dma_alloc->size = vma->vm_end - vma->vm_start;
-    dma_alloc->user_addr = (void *)vma->vm_start;
+    dma_alloc->region.size = vma->vm_end - vma->vm_start;
+    dma_alloc->region.user_addr = (void *)vma->vm_start;
+    dma_alloc->region.external = false;
+    dma_alloc->dev = dev;
+    kref_init(&dma_alloc->ref);
+
+    /* Cached buffers are requested with a fixed offset. All others come from
+     * the reserved memory region if there is one, or are coherent otherwise. */
+    dma_alloc->cached = (vma->vm_pgoff ==
+                         (AXIDMA_MMAP_CACHED_OFFSET >> PAGE_SHIFT));
+    dma_alloc->reserved = !dma_alloc->cached && dev->mem_pool != NULL;
 
     // Configure the DMA device
     of_dma_configure(dev->device, NULL);
 
-    // Allocate the requested region a contiguous and uncached for DMA
-    dma_alloc->kern_addr = dma_alloc_coherent(&dev->pdev->dev, dma_alloc->size,
-                                              &dma_alloc->dma_addr, GFP_KERNEL);
-    if (dma_alloc->kern_addr == NULL) {
-        axidma_err("Unable to allocate contiguous DMA memory region of size "
-                   "%zu.\n", dma_alloc->size);
-        axidma_err("Please make sure that you specified cma=<size> on the "
-                   "kernel command line, and the size is large enough.\n");
-        rc = -ENOMEM;
+    // Allocate the DMA buffer, and map it into userspace
+    if (dma_alloc->cached) {
+        rc = axidma_alloc_cached(dev, dma_alloc, vma);
+    } else if (dma_alloc->reserved) {
+        rc = axidma_alloc_reserved(dev, dma_alloc, vma);
+    } else {
+        rc = axidma_alloc_coherent(dev, dma_alloc, vma);
+    }
+    if (rc < 0) {
         goto free_vma_data;
     }
 
-    // Map the region into userspace
-    rc = dma_mmap_coherent(&dev->pdev->dev, vma, dma_alloc->kern_addr,
-                           dma_alloc->dma_addr, dma_alloc->size);
+    // Add the allocation to the file's tree of DMA buffers
+    rc = axidma_insert_region(file, &dma_alloc->region);
     if (rc < 0) {
-        axidma_err("Unable to remap address %p to userspace address %p, size "
-                   "%zu.\n", dma_alloc->kern_addr, dma_alloc->user_addr,
-                   dma_alloc->size);
+        axidma_err("DMA buffer at address %p overlaps a previously registered "
+                   "DMA buffer.\n", dma_alloc->region.user_addr);
         goto free_dma_region;
     }
 
@@ -307,20 +1076,30 @@ static int axidma_mmap(struct file *file, struct vm_area_struct *vma)
     /* TODO: Figure out the proper way to actually handle multiple processes
      * referring to the DMA buffer. */
     vma->vm_flags |= VM_DONTCOPY;
-
-    // Add the allocation to the driver's list of DMA buffers
-    list_add(&dma_alloc->list, &dev->dmabuf_list);
     return 0;
 
 free_dma_region:
-    dma_free_coherent(&dev->pdev->dev, dma_alloc->size, dma_alloc->kern_addr,
-                      dma_alloc->dma_addr);
+    axidma_free_buffer(dev, dma_alloc);
 free_vma_data:
     kfree(dma_alloc);
 ret:
     return rc;
 }
 
+static ssize_t axidma_read(struct file *filp, char __user *buf, size_t count,
+                           loff_t *ppos)
+{
+    // Read the completion events for asynchronous transfers
+    return axidma_event_read(filp->private_data, buf, count,
+                             (filp->f_flags & O_NONBLOCK) != 0);
+}
+
+static unsigned int axidma_poll(struct file *filp, poll_table *wait)
+{
+    // The device is readable when there are completions for userspace
+    return axidma_event_poll(filp->private_data, filp, wait);
+}
+
 /* Verifies that the pointer can be read and/or written to with the given size.
  * The user specifies the mode, either readonly, or not (read-write). */
 static bool axidma_access_ok(const void __user *arg, size_t size, bool readonly)
@@ -339,18 +1118,44 @@ static bool axidma_access_ok(const void __user *arg, size_t size, bool readonly)
     return true;
 }
 
-static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+static long axidma_do_ioctl(struct file *filp, unsigned int cmd,
+                            unsigned long arg)
 {
     long rc;
     size_t size;
     void *__user arg_ptr;
+    struct axidma_file *file;
     struct axidma_device *dev;
     struct axidma_num_channels num_chans;
     struct axidma_channel_info usr_chans, kern_chans;
+    struct axidma_signal_info sig_info;
+    struct axidma_notify notify;
     struct axidma_register_buffer ext_buf;
     struct axidma_transaction trans;
     struct axidma_inout_transaction inout_trans;
+    struct axidma_vec_transaction vec_trans;
+    struct iovec *__user user_vecs;
     struct axidma_video_transaction video_trans, *__user user_video_trans;
+    struct axidma_batch_transaction batch_trans;
+    struct axidma_batch_entry *__user user_batch_entries;
+    struct axidma_ring_setup ring_setup;
+    struct axidma_ring_enter ring_enter;
+    struct axidma_sync sync;
+    struct axidma_mem_info mem_info;
+    struct axidma_claim claim;
+    struct axidma_cyclic_transaction cyclic_trans;
+    struct axidma_export_buffer export;
+    struct axidma_stats stats;
+    struct axidma_poll_budget poll;
+    struct axidma_prepared_transfer prepared;
+    struct axidma_prepared_submit submit;
+    struct axidma_coalesce coalesce;
+    struct axidma_video_park park;
+    struct axidma_residue residue;
+    struct axidma_dma_addr dma_addr;
+    struct axidma_bdring_setup bdring_setup;
+    struct axidma_bdring_kick bdring_kick;
+    struct axidma_affinity affinity;
     struct axidma_chan chan_info;
 
     // Coerce the arguement as a userspace pointer
@@ -376,8 +1181,9 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
         }
     }
 
-    // Get the axidma device from the file
-    dev = file->private_data;
+    // Get the axidma file and device structures
+    file = filp->private_data;
+    dev = file->dev;
 
     // Perform the specified command
     switch (cmd) {
@@ -412,7 +1218,12 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
             break;
 
         case AXIDMA_SET_DMA_SIGNAL:
-            rc = axidma_set_signal(dev, arg);
+            if (copy_from_user(&sig_info, arg_ptr, sizeof(sig_info)) != 0) {
+                axidma_err("Unable to copy signal info from userspace for "
+                           "AXIDMA_SET_DMA_SIGNAL.\n");
+                return -EFAULT;
+            }
+            rc = axidma_set_signal(file, &sig_info);
             break;
 
         case AXIDMA_REGISTER_BUFFER:
@@ -421,7 +1232,7 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                            "for AXIDMA_REGISTER_BUFFER.\n");
                 return -EFAULT;
             }
-            rc = axidma_get_external(dev, &ext_buf);
+            rc = axidma_get_external(file, &ext_buf);
             break;
 
         case AXIDMA_DMA_READ:
@@ -430,7 +1241,13 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                            "AXIDMA_DMA_READ.\n");
                 return -EFAULT;
             }
-            rc = axidma_read_transfer(dev, &trans);
+            rc = axidma_read_transfer(file, &trans);
+            if ((rc == 0 || rc == -ETIME) && trans.wait &&
+                    copy_to_user(arg_ptr, &trans, sizeof(trans)) != 0) {
+                axidma_err("Unable to copy the transfer length to userspace "
+                           "for AXIDMA_DMA_READ.\n");
+                return -EFAULT;
+            }
             break;
 
         case AXIDMA_DMA_WRITE:
@@ -439,7 +1256,13 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                            "AXIDMA_DMA_WRITE.\n");
                 return -EFAULT;
             }
-            rc = axidma_write_transfer(dev, &trans);
+            rc = axidma_write_transfer(file, &trans);
+            if ((rc == 0 || rc == -ETIME) && trans.wait &&
+                    copy_to_user(arg_ptr, &trans, sizeof(trans)) != 0) {
+                axidma_err("Unable to copy the transfer length to userspace "
+                           "for AXIDMA_DMA_WRITE.\n");
+                return -EFAULT;
+            }
             break;
 
         case AXIDMA_DMA_READWRITE:
@@ -449,7 +1272,14 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                            "AXIDMA_DMA_READWRITE.\n");
                 return -EFAULT;
             }
-            rc = axidma_rw_transfer(dev, &inout_trans);
+            rc = axidma_rw_transfer(file, &inout_trans);
+            if ((rc == 0 || rc == -ETIME) && inout_trans.wait &&
+                    copy_to_user(arg_ptr, &inout_trans,
+                                 sizeof(inout_trans)) != 0) {
+                axidma_err("Unable to copy the transfer length to userspace "
+                           "for AXIDMA_DMA_READWRITE.\n");
+                return -EFAULT;
+            }
             break;
 
         case AXIDMA_DMA_VIDEO_READ:
@@ -479,8 +1309,18 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                 return -EFAULT;
             }
 
-            rc = axidma_video_transfer(dev, &video_trans, AXIDMA_READ);
+            rc = axidma_video_transfer(file, &video_trans, AXIDMA_READ);
             kfree(video_trans.frame_buffers);
+
+            // Return the status location to userspace
+            if (rc == 0 && (copy_to_user(&user_video_trans->mmap_size,
+                    &video_trans.mmap_size, sizeof(size_t)) != 0 ||
+                    copy_to_user(&user_video_trans->status_offset,
+                    &video_trans.status_offset, sizeof(size_t)) != 0)) {
+                axidma_err("Unable to copy the video status location to "
+                           "userspace for AXIDMA_DMA_VIDEO_READ.\n");
+                return -EFAULT;
+            }
             break;
 
         case AXIDMA_DMA_VIDEO_WRITE:
@@ -510,20 +1350,407 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                 return -EFAULT;
             }
 
-            rc = axidma_video_transfer(dev, &video_trans, AXIDMA_WRITE);
+            rc = axidma_video_transfer(file, &video_trans, AXIDMA_WRITE);
             kfree(video_trans.frame_buffers);
+
+            // Return the status location to userspace
+            if (rc == 0 && (copy_to_user(&user_video_trans->mmap_size,
+                    &video_trans.mmap_size, sizeof(size_t)) != 0 ||
+                    copy_to_user(&user_video_trans->status_offset,
+                    &video_trans.status_offset, sizeof(size_t)) != 0)) {
+                axidma_err("Unable to copy the video status location to "
+                           "userspace for AXIDMA_DMA_VIDEO_WRITE.\n");
+                return -EFAULT;
+            }
             break;
 
         case AXIDMA_STOP_DMA_CHANNEL:
             if (copy_from_user(&chan_info, arg_ptr, sizeof(chan_info)) != 0) {
-                axidma_err("Unable to channel info from userspace for "
+                axidma_err("Unable to copy channel info from userspace for "
                            "AXIDMA_STOP_DMA_CHANNEL.\n");
+                return -EFAULT;
             }
-            rc = axidma_stop_channel(dev, &chan_info);
+            rc = axidma_stop_channel(file, &chan_info);
             break;
 
         case AXIDMA_UNREGISTER_BUFFER:
-            rc = axidma_put_external(dev, (void *)arg);
+            rc = axidma_put_external(file, (void *)arg);
+            break;
+
+        case AXIDMA_DMA_SUBMIT_BATCH:
+            if (copy_from_user(&batch_trans, arg_ptr,
+                               sizeof(batch_trans)) != 0) {
+                axidma_err("Unable to copy transfer info from userspace for "
+                           "AXIDMA_DMA_SUBMIT_BATCH.\n");
+                return -EFAULT;
+            }
+
+            // Check that the batch has a valid number of transfers
+            if (batch_trans.num_entries <= 0 ||
+                    batch_trans.num_entries > AXIDMA_MAX_BATCH_ENTRIES) {
+                axidma_err("Invalid number of transfers %d for "
+                           "AXIDMA_DMA_SUBMIT_BATCH.\n",
+                           batch_trans.num_entries);
+                return -EINVAL;
+            }
+
+            // Allocate a kernel-space array for the batch entries
+            user_batch_entries = batch_trans.entries;
+            size = batch_trans.num_entries * sizeof(batch_trans.entries[0]);
+            batch_trans.entries = kmalloc(size, GFP_KERNEL);
+            if (batch_trans.entries == NULL) {
+                axidma_err("Unable to allocate array for the batch entries.\n");
+                return -ENOMEM;
+            }
+
+            // Copy the batch entry array from user space to kernel space
+            if (copy_from_user(batch_trans.entries, user_batch_entries,
+                               size) != 0) {
+                axidma_err("Unable to copy the batch entry array from "
+                           "userspace for AXIDMA_DMA_SUBMIT_BATCH.\n");
+                kfree(batch_trans.entries);
+                return -EFAULT;
+            }
+
+            // Perform the batch, and return the cookies to userspace
+            rc = axidma_batch_transfer(file, &batch_trans);
+            if (rc == 0 && copy_to_user(user_batch_entries,
+                    batch_trans.entries, size) != 0) {
+                axidma_err("Unable to copy the batch cookies to userspace for "
+                           "AXIDMA_DMA_SUBMIT_BATCH.\n");
+                rc = -EFAULT;
+            }
+            kfree(batch_trans.entries);
+            break;
+
+        case AXIDMA_RING_SETUP:
+            if (copy_from_user(&ring_setup, arg_ptr, sizeof(ring_setup)) != 0) {
+                axidma_err("Unable to copy ring setup info from userspace for "
+                           "AXIDMA_RING_SETUP.\n");
+                return -EFAULT;
+            }
+
+            // Setup the rings, and return their layout to userspace
+            rc = axidma_ring_setup(file, &ring_setup);
+            if (rc == 0 && copy_to_user(arg_ptr, &ring_setup,
+                                        sizeof(ring_setup)) != 0) {
+                axidma_err("Unable to copy ring layout to userspace for "
+                           "AXIDMA_RING_SETUP.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_RING_ENTER:
+            if (copy_from_user(&ring_enter, arg_ptr, sizeof(ring_enter)) != 0) {
+                axidma_err("Unable to copy ring enter info from userspace for "
+                           "AXIDMA_RING_ENTER.\n");
+                return -EFAULT;
+            }
+            rc = axidma_ring_enter(file, &ring_enter);
+            break;
+
+        case AXIDMA_DMA_READ_V:
+        case AXIDMA_DMA_WRITE_V:
+            if (copy_from_user(&vec_trans, arg_ptr, sizeof(vec_trans)) != 0) {
+                axidma_err("Unable to copy transfer info from userspace for "
+                           "AXIDMA_DMA_%s_V.\n",
+                           (cmd == AXIDMA_DMA_READ_V) ? "READ" : "WRITE");
+                return -EFAULT;
+            }
+
+            // Check that the transfer has a valid number of buffers
+            if (vec_trans.num_vecs <= 0 ||
+                    vec_trans.num_vecs > AXIDMA_MAX_TRANSFER_VECS) {
+                axidma_err("Invalid number of buffers %d for vectored "
+                           "transfer.\n", vec_trans.num_vecs);
+                return -EINVAL;
+            }
+
+            // Allocate a kernel-space array for the buffer vector
+            user_vecs = vec_trans.vecs;
+            size = vec_trans.num_vecs * sizeof(vec_trans.vecs[0]);
+            vec_trans.vecs = kmalloc(size, GFP_KERNEL);
+            if (vec_trans.vecs == NULL) {
+                axidma_err("Unable to allocate array for the buffer vector.\n");
+                return -ENOMEM;
+            }
+
+            // Copy the buffer vector from user space to kernel space
+            if (copy_from_user(vec_trans.vecs, user_vecs, size) != 0) {
+                axidma_err("Unable to copy the buffer vector from userspace "
+                           "for vectored transfer.\n");
+                kfree(vec_trans.vecs);
+                return -EFAULT;
+            }
+
+            rc = axidma_vec_transfer(file, &vec_trans,
+                    (cmd == AXIDMA_DMA_READ_V) ? AXIDMA_READ : AXIDMA_WRITE);
+            kfree(vec_trans.vecs);
+
+            // Return the transfer length, with the user's vector unchanged
+            vec_trans.vecs = user_vecs;
+            if ((rc == 0 || rc == -ETIME) && vec_trans.wait &&
+                    copy_to_user(arg_ptr, &vec_trans, sizeof(vec_trans)) != 0) {
+                axidma_err("Unable to copy the transfer length to userspace "
+                           "for vectored transfer.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_SET_NOTIFY:
+            if (copy_from_user(&notify, arg_ptr, sizeof(notify)) != 0) {
+                axidma_err("Unable to copy notification info from userspace "
+                           "for AXIDMA_SET_NOTIFY.\n");
+                return -EFAULT;
+            }
+            rc = axidma_set_notify(file, &notify);
+            break;
+
+        case AXIDMA_SYNC_FOR_CPU:
+        case AXIDMA_SYNC_FOR_DEVICE:
+            if (copy_from_user(&sync, arg_ptr, sizeof(sync)) != 0) {
+                axidma_err("Unable to copy sync info from userspace for "
+                           "AXIDMA_SYNC_FOR_%s.\n",
+                           (cmd == AXIDMA_SYNC_FOR_CPU) ? "CPU" : "DEVICE");
+                return -EFAULT;
+            }
+            rc = axidma_sync_buffer(file, &sync, cmd == AXIDMA_SYNC_FOR_CPU);
+            break;
+
+        case AXIDMA_GET_MEM_INFO:
+            axidma_get_mem_info(dev, &mem_info);
+            if (copy_to_user(arg_ptr, &mem_info, sizeof(mem_info)) != 0) {
+                axidma_err("Unable to copy memory info to userspace for "
+                           "AXIDMA_GET_MEM_INFO.\n");
+                return -EFAULT;
+            }
+            rc = 0;
+            break;
+
+        case AXIDMA_CLAIM_CHANNEL:
+        case AXIDMA_RELEASE_CHANNEL:
+            if (copy_from_user(&claim, arg_ptr, sizeof(claim)) != 0) {
+                axidma_err("Unable to copy channel info from userspace for "
+                           "AXIDMA_%s_CHANNEL.\n",
+                           (cmd == AXIDMA_CLAIM_CHANNEL) ? "CLAIM" : "RELEASE");
+                return -EFAULT;
+            }
+            rc = (cmd == AXIDMA_CLAIM_CHANNEL) ?
+                    axidma_claim_channel(file, claim.channel_id) :
+                    axidma_release_channel(file, claim.channel_id);
+            break;
+
+        case AXIDMA_DMA_CYCLIC:
+            if (copy_from_user(&cyclic_trans, arg_ptr,
+                               sizeof(cyclic_trans)) != 0) {
+                axidma_err("Unable to copy transfer info from userspace for "
+                           "AXIDMA_DMA_CYCLIC.\n");
+                return -EFAULT;
+            }
+
+            // Start the transfer, and return the status location to userspace
+            rc = axidma_cyclic_transfer(file, &cyclic_trans);
+            if (rc == 0 && copy_to_user(arg_ptr, &cyclic_trans,
+                                        sizeof(cyclic_trans)) != 0) {
+                axidma_err("Unable to copy the cyclic status location to "
+                           "userspace for AXIDMA_DMA_CYCLIC.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_EXPORT_BUFFER:
+            if (copy_from_user(&export, arg_ptr, sizeof(export)) != 0) {
+                axidma_err("Unable to copy export info from userspace for "
+                           "AXIDMA_EXPORT_BUFFER.\n");
+                return -EFAULT;
+            }
+
+            // Export the buffer, and return its file descriptor to userspace
+            rc = axidma_export_buffer(file, &export);
+            if (rc == 0 && copy_to_user(arg_ptr, &export,
+                                        sizeof(export)) != 0) {
+                axidma_err("Unable to copy the file descriptor to userspace "
+                           "for AXIDMA_EXPORT_BUFFER.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_GET_STATS:
+            if (copy_from_user(&stats, arg_ptr, sizeof(stats)) != 0) {
+                axidma_err("Unable to copy channel info from userspace for "
+                           "AXIDMA_GET_STATS.\n");
+                return -EFAULT;
+            }
+
+            rc = axidma_read_stats(dev, &stats);
+            if (rc == 0 && copy_to_user(arg_ptr, &stats, sizeof(stats)) != 0) {
+                axidma_err("Unable to copy the channel statistics to userspace "
+                           "for AXIDMA_GET_STATS.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_SET_POLL_BUDGET:
+            if (copy_from_user(&poll, arg_ptr, sizeof(poll)) != 0) {
+                axidma_err("Unable to copy the poll budget from userspace for "
+                           "AXIDMA_SET_POLL_BUDGET.\n");
+                return -EFAULT;
+            }
+            rc = axidma_set_poll_budget(file, &poll);
+            break;
+
+        case AXIDMA_PREPARE_TRANSFER:
+            if (copy_from_user(&prepared, arg_ptr, sizeof(prepared)) != 0) {
+                axidma_err("Unable to copy transfer info from userspace for "
+                           "AXIDMA_PREPARE_TRANSFER.\n");
+                return -EFAULT;
+            }
+
+            // Prepare the transfer, and return its handle to userspace
+            rc = axidma_prepare_transfer(file, &prepared);
+            if (rc == 0 && copy_to_user(arg_ptr, &prepared,
+                                        sizeof(prepared)) != 0) {
+                axidma_err("Unable to copy the transfer handle to userspace "
+                           "for AXIDMA_PREPARE_TRANSFER.\n");
+                axidma_unprepare_transfer(file, prepared.handle);
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_SUBMIT_PREPARED:
+            if (copy_from_user(&submit, arg_ptr, sizeof(submit)) != 0) {
+                axidma_err("Unable to copy transfer info from userspace for "
+                           "AXIDMA_SUBMIT_PREPARED.\n");
+                return -EFAULT;
+            }
+            rc = axidma_submit_prepared(file, &submit);
+            if ((rc == 0 || rc == -ETIME) &&
+                    copy_to_user(arg_ptr, &submit, sizeof(submit)) != 0) {
+                axidma_err("Unable to copy the transfer result to userspace "
+                           "for AXIDMA_SUBMIT_PREPARED.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_UNPREPARE_TRANSFER:
+            if (copy_from_user(&prepared, arg_ptr, sizeof(prepared)) != 0) {
+                axidma_err("Unable to copy the transfer handle from userspace "
+                           "for AXIDMA_UNPREPARE_TRANSFER.\n");
+                return -EFAULT;
+            }
+            rc = axidma_unprepare_transfer(file, prepared.handle);
+            break;
+
+        case AXIDMA_SET_COALESCE:
+            if (copy_from_user(&coalesce, arg_ptr, sizeof(coalesce)) != 0) {
+                axidma_err("Unable to copy the coalescing settings from "
+                           "userspace for AXIDMA_SET_COALESCE.\n");
+                return -EFAULT;
+            }
+            rc = axidma_set_coalesce(file, &coalesce);
+            break;
+
+        case AXIDMA_VIDEO_PARK:
+            if (copy_from_user(&park, arg_ptr, sizeof(park)) != 0) {
+                axidma_err("Unable to copy the park info from userspace for "
+                           "AXIDMA_VIDEO_PARK.\n");
+                return -EFAULT;
+            }
+            rc = axidma_video_park(file, &park);
+            break;
+
+        case AXIDMA_DMA_RESIDUE:
+            if (copy_from_user(&residue, arg_ptr, sizeof(residue)) != 0) {
+                axidma_err("Unable to copy the channel id from userspace for "
+                           "AXIDMA_DMA_RESIDUE.\n");
+                return -EFAULT;
+            }
+
+            rc = axidma_get_residue(dev, &residue);
+            if (rc == 0 &&
+                copy_to_user(arg_ptr, &residue, sizeof(residue)) != 0) {
+                axidma_err("Unable to copy the residue to userspace for "
+                           "AXIDMA_DMA_RESIDUE.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_GET_DMA_ADDR:
+            if (copy_from_user(&dma_addr, arg_ptr, sizeof(dma_addr)) != 0) {
+                axidma_err("Unable to copy the address from userspace for "
+                           "AXIDMA_GET_DMA_ADDR.\n");
+                return -EFAULT;
+            }
+
+            rc = axidma_get_dma_addr(file, &dma_addr);
+            if (rc == 0 &&
+                copy_to_user(arg_ptr, &dma_addr, sizeof(dma_addr)) != 0) {
+                axidma_err("Unable to copy the bus address to userspace for "
+                           "AXIDMA_GET_DMA_ADDR.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_BDRING_SETUP:
+            if (copy_from_user(&bdring_setup, arg_ptr,
+                               sizeof(bdring_setup)) != 0) {
+                axidma_err("Unable to copy BD ring setup info from userspace "
+                           "for AXIDMA_BDRING_SETUP.\n");
+                return -EFAULT;
+            }
+
+            // Setup the BD ring, and return its layout to userspace
+            rc = axidma_bdring_setup(file, &bdring_setup);
+            if (rc == 0 && copy_to_user(arg_ptr, &bdring_setup,
+                                        sizeof(bdring_setup)) != 0) {
+                axidma_err("Unable to copy BD ring layout to userspace for "
+                           "AXIDMA_BDRING_SETUP.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_BDRING_DESTROY:
+            if (copy_from_user(&claim, arg_ptr, sizeof(claim)) != 0) {
+                axidma_err("Unable to copy channel info from userspace for "
+                           "AXIDMA_BDRING_DESTROY.\n");
+                return -EFAULT;
+            }
+            rc = axidma_bdring_destroy(file, claim.channel_id);
+            break;
+
+        case AXIDMA_GET_AFFINITY:
+            if (copy_from_user(&affinity, arg_ptr, sizeof(affinity)) != 0) {
+                axidma_err("Unable to copy the channel id from userspace for "
+                           "AXIDMA_GET_AFFINITY.\n");
+                return -EFAULT;
+            }
+
+            rc = axidma_get_affinity(dev, &affinity);
+            if (rc == 0 &&
+                copy_to_user(arg_ptr, &affinity, sizeof(affinity)) != 0) {
+                axidma_err("Unable to copy the affinity to userspace for "
+                           "AXIDMA_GET_AFFINITY.\n");
+                return -EFAULT;
+            }
+            break;
+
+        case AXIDMA_SET_AFFINITY:
+            if (copy_from_user(&affinity, arg_ptr, sizeof(affinity)) != 0) {
+                axidma_err("Unable to copy the affinity from userspace for "
+                           "AXIDMA_SET_AFFINITY.\n");
+                return -EFAULT;
+            }
+            rc = axidma_set_affinity(file, &affinity);
+            break;
+
+        case AXIDMA_BDRING_KICK:
+            if (copy_from_user(&bdring_kick, arg_ptr,
+                               sizeof(bdring_kick)) != 0) {
+                axidma_err("Unable to copy the BD ring tail from userspace "
+                           "for AXIDMA_BDRING_KICK.\n");
+                return -EFAULT;
+            }
+            rc = axidma_bdring_kick(file, &bdring_kick);
             break;
 
         // Invalid command (already handled in preamble)
@@ -534,11 +1761,24 @@ static long axidma_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
     return rc;
 }
 
+// Handles an ioctl, tracing its entry and exit to measure the time it takes
+static long axidma_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+    long rc;
+
+    trace_axidma_ioctl_enter(cmd);
+    rc = axidma_do_ioctl(filp, cmd, arg);
+    trace_axidma_ioctl_exit(cmd, rc);
+    return rc;
+}
+
 // The file operations for the AXI DMA device
 static const struct file_operations axidma_fops = {
     .owner = THIS_MODULE,
     .open = axidma_open,
     .release = axidma_release,
+    .read = axidma_read,
+    .poll = axidma_poll,
     .mmap = axidma_mmap,
     .unlocked_ioctl = axidma_ioctl,
 };
@@ -551,9 +1791,6 @@ int axidma_chrdev_init(struct axidma_device *dev)
 {
     int rc;
 
-    // Store a global pointer to the axidma device
-    axidma_dev = dev;
-
     // Allocate a major and minor number region for the character device
     rc = alloc_chrdev_region(&dev->dev_num, dev->minor_num, dev->num_devices,
                              dev->chrdev_name);
@@ -588,10 +1825,6 @@ int axidma_chrdev_init(struct axidma_device *dev)
         goto device_cleanup;
     }
 
-    // Initialize the list for DMA mmap'ed allocations
-    INIT_LIST_HEAD(&dev->dmabuf_list);
-    INIT_LIST_HEAD(&dev->external_dmabufs);
-
     return 0;
 
 device_cleanup:
@@ -26,6 +26,17 @@
 #include <linux/errno.h>            // Linux error codes
 #include <linux/platform_device.h>  // Platform device definitions
 #include <linux/device.h>           // Device definitions and functions
+#include <linux/uio.h>              // I/O vector definitions
+#include <linux/mm.h>               // Memory types and remapping functions
+#include <linux/vmalloc.h>          // Virtual memory allocation functions
+#include <linux/ktime.h>            // Monotonic clock functions
+#include <linux/idr.h>              // ID allocation functions
+#include <linux/mutex.h>            // Mutex definitions and functions
+#include <linux/workqueue.h>        // Work queue definitions and functions
+#include <linux/interrupt.h>        // Interrupt affinity functions
+#include <linux/irq.h>              // Interrupt descriptor functions
+#include <linux/cpumask.h>          // CPU mask definitions and functions
+#include <linux/bitops.h>           // Atomic bit operations
 
 /* Between 3.x and 4.x, the path to Xilinx's DMA include file changes. However,
  * in some 4.x kernels, the path is still the old one from 3.x. The macro is
@@ -39,19 +50,36 @@
 // Local dependencies
 #include "axidma.h"                 // Internal definitions
 #include "axidma_ioctl.h"           // IOCTL interface definition and types
+#include "axidma_trace.h"           // Tracepoint definitions
 
 /*----------------------------------------------------------------------------
  * Internal Definitions
  *----------------------------------------------------------------------------*/
 
-// The default timeout for DMA is 10 seconds
-#define AXIDMA_DMA_TIMEOUT      10000
+/* The data to pass to the DMA transfer completion callback function. For
+ * synchronous transfers, this is part of the transfer on the caller's stack,
+ * while for asynchronous transfers it is allocated for each transfer. */
+struct axidma_cb_data {
+    int channel_id;                 // The id of the channel used
+    struct axidma_chan *chan;       // The channel used
+    int notify_signal;              // For async, signal to send
+    void *notify_data;              // For async, user data sent with signal
+    struct task_struct *process;    // The process to send the signal to
+    struct completion *comp;        // For sync, the notification to kernel
+    struct axidma_file *file;       // The file the transfer belongs to
+    dma_cookie_t cookie;            // For async, the DMA cookie for transfer
+    size_t buf_len;                 // The length of the transfer
+    size_t bytes;                   // For sync, the bytes transferred
+    struct list_head list;          // For async, node in the in-flight list
+};
 
 // A convenient structure to pass between prep and start transfer functions
 struct axidma_transfer {
     int sg_len;                     // The length of the BD array
     struct scatterlist *sg_list;    // List of buffer descriptors
     bool wait;                      // Indicates if we should wait
+    int timeout;                    // For sync, the time to wait in ms
+    size_t bytes;                   // For sync, the bytes transferred
     dma_cookie_t cookie;            // The DMA cookie for the transfer
     struct completion comp;         // A completion to use for waiting
     enum axidma_dir dir;            // The direction of the transfer
@@ -59,7 +87,7 @@ struct axidma_transfer {
     int channel_id;                 // The ID of the channel
     int notify_signal;              // The signal to use for async transfers
     struct task_struct *process;    // The process requesting the transfer
-    struct axidma_cb_data *cb_data; // The callback data struct
+    struct axidma_cb_data sync_cb_data; // The callback data, for sync
 
     // VDMA specific fields (kept as union for extensability)
     union {
@@ -67,12 +95,32 @@ struct axidma_transfer {
     };
 };
 
-// The data to pass to the DMA transfer completion callback function
-struct axidma_cb_data {
-    int channel_id;                 // The id of the channel used
-    int notify_signal;              // For async, signal to send
-    struct task_struct *process;    // The process to send the signal to
-    struct completion *comp;        // For sync, the notification to kernel
+// A frame buffer of a video transfer, which is queued again once it is done
+struct axidma_video_fb {
+    struct axidma_video_stream *stream; // The video transfer it belongs to
+    int index;                      // The index of the frame buffer
+    void *user_addr;                // The frame buffer's address in userspace
+    dma_addr_t dma_addr;            // The frame buffer's DMA address
+    dma_cookie_t cookie;            // The DMA cookie for its latest transfer
+    bool queued;                    // Indicates if it is queued to the engine
+    struct work_struct work;        // Work to queue it again once it is done
+};
+
+/* A continuous video transfer on a VDMA channel. Each frame buffer is queued
+ * to the engine on its own, so that each frame completes separately. They are
+ * queued again from a work queue, since the engine's callback can't sleep. */
+struct axidma_video_stream {
+    struct axidma_file *file;       // The file the transfer belongs to
+    struct axidma_chan *chan;       // The VDMA channel used
+    struct axidma_cyclic_status *status;    // The status shared with userspace
+    struct dma_interleaved_template *dma_template;  // Template for each frame
+    size_t image_size;              // The number of bytes in a frame
+    struct axidma_video_sync sync;  // The synchronization settings
+    struct mutex lock;              // Protects the fields below, and queuing
+    bool stopping;                  // Indicates the transfer is being stopped
+    int park_frame;                 // The frame buffer parked on, or -1
+    int num_fbs;                    // The number of frame buffers
+    struct axidma_video_fb fbs[];   // The frame buffers
 };
 
 /*----------------------------------------------------------------------------
@@ -102,16 +150,18 @@ static enum dma_transfer_direction axidma_to_dma_dir(enum axidma_dir dma_dir)
  * DMA Operations Helper Functions
  *----------------------------------------------------------------------------*/
 
-static int axidma_init_sg_entry(struct axidma_device *dev,
-        struct scatterlist *sg_list, int index, void *buf, size_t buf_len)
+static int axidma_init_sg_entry(struct axidma_file *file,
+        struct axidma_chan *chan, struct scatterlist *sg_list, int index,
+        void *buf, size_t buf_len)
 {
     dma_addr_t dma_addr;
 
     // Get the DMA address from the user virtual address
-    dma_addr = axidma_uservirt_to_dma(dev, buf, buf_len);
+    dma_addr = axidma_uservirt_to_dma(file, buf, buf_len);
     if (dma_addr == (dma_addr_t)NULL) {
         axidma_err("Requested transfer address %p does not fall within a "
                    "previously allocated DMA buffer.\n", buf);
+        axidma_stats_error(file->dev, chan, AXIDMA_STATS_LOOKUP_MISS);
         return -EFAULT;
     }
 
@@ -122,8 +172,7 @@ static int axidma_init_sg_entry(struct axidma_device *dev,
     return 0;
 }
 
-static struct axidma_chan *axidma_get_chan(struct axidma_device *dev,
-        int channel_id)
+struct axidma_chan *axidma_get_chan(struct axidma_device *dev, int channel_id)
 {
     int i;
     struct axidma_chan *chan;
@@ -140,28 +189,182 @@ static struct axidma_chan *axidma_get_chan(struct axidma_device *dev,
     return NULL;
 }
 
-static void axidma_dma_callback(void *data)
+/* Checks that the file owns the channel, claiming it for the file if no file
+ * owns it yet. Only the file that owns a channel can transfer on it. */
+static int axidma_own_chan(struct axidma_file *file, struct axidma_chan *chan)
+{
+    struct axidma_device *dev;
+    struct axidma_file **owner;
+
+    dev = file->dev;
+    owner = &dev->chan_owners[chan - dev->channels];
+    if (READ_ONCE(*owner) != file && cmpxchg(owner, NULL, file) != NULL) {
+        axidma_err("Channel %d is owned by another open file of the device.\n",
+                   chan->channel_id);
+        return -EBUSY;
+    }
+
+    /* A BD ring dedicates its whole engine to userspace, so none of the
+     * engine's channels can be used through the DMA engine. */
+    if (axidma_bdring_engine_used(dev, chan - dev->channels)) {
+        axidma_err("Channel %d's engine is dedicated to a userspace BD ring.\n",
+                   chan->channel_id);
+        return -EBUSY;
+    }
+
+    return 0;
+}
+
+// Returns the total number of bytes in the given transfer
+static size_t axidma_transfer_len(struct axidma_transfer *dma_tfr)
+{
+    int i;
+    size_t len;
+
+    // VDMA transfers only use the first frame buffer
+    if (dma_tfr->type == AXIDMA_VDMA) {
+        return dma_tfr->frame.width * dma_tfr->frame.height *
+               dma_tfr->frame.depth;
+    }
+
+    len = 0;
+    for (i = 0; i < dma_tfr->sg_len; i++)
+    {
+        len += sg_dma_len(&dma_tfr->sg_list[i]);
+    }
+    return len;
+}
+
+// Sends the completion signal for an asynchronous transfer to userspace
+static void axidma_send_signal(struct axidma_cb_data *cb_data)
 {
-    struct axidma_cb_data *cb_data;
     struct siginfo sig_info;
 
-    /* For synchronous transfers, notify the kernel thread waiting. For
-     * asynchronous transfers, send a signal to userspace if requested. */
+    memset(&sig_info, 0, sizeof(sig_info));
+    sig_info.si_signo = cb_data->notify_signal;
+    sig_info.si_code = SI_QUEUE;
+    sig_info.si_errno = cb_data->channel_id;
+    sig_info.si_ptr = cb_data->notify_data;
+    trace_axidma_signal(cb_data->channel_id, cb_data->cookie,
+                        cb_data->notify_signal, task_pid_nr(cb_data->process));
+    send_sig_info(cb_data->notify_signal, &sig_info, cb_data->process);
+}
+
+/* Completes an asynchronous transfer, posting its completion event and sending
+ * the signal to userspace, if requested. This frees the callback data. */
+static void axidma_async_complete(struct axidma_cb_data *cb_data, size_t bytes,
+                                  int status)
+{
+    struct axidma_cqe event;
+
+    event.user_data = NULL;
+    event.channel_id = cb_data->channel_id;
+    event.cookie = cb_data->cookie;
+    event.bytes = bytes;
+    event.status = status;
+    axidma_event_post(cb_data->file, &event);
+    trace_axidma_complete(cb_data->channel_id, cb_data->cookie, bytes, status);
+
+    if (VALID_NOTIFY_SIGNAL(cb_data->notify_signal)) {
+        axidma_send_signal(cb_data);
+    }
+    kfree(cb_data);
+}
+
+static void axidma_dma_callback(void *data,
+                                const struct dmaengine_result *result)
+{
+    int status;
+    size_t bytes;
+    unsigned long flags;
+    struct axidma_cb_data *cb_data;
+    struct axidma_file *file;
+
+    // Determine the number of bytes transferred, and count the transfer
     cb_data = data;
+    file = cb_data->file;
+    status = 0;
+    bytes = cb_data->buf_len;
+    if (result != NULL && result->result != DMA_TRANS_NOERROR) {
+        status = -EIO;
+    }
+    if (result != NULL && result->residue <= bytes) {
+        bytes -= result->residue;
+    }
+    trace_axidma_callback(cb_data->channel_id, cb_data->cookie, bytes, status);
+    axidma_stats_complete(file->dev, cb_data->chan, bytes, status);
+    axidma_set_residue(file->dev, cb_data->chan, cb_data->buf_len - bytes);
+
+    /* For synchronous transfers, notify the kernel thread waiting. The callback
+     * data is on its stack, so it can't be used after this. */
     if (cb_data->comp != NULL) {
+        trace_axidma_complete(cb_data->channel_id, cb_data->cookie, bytes,
+                              status);
+        cb_data->bytes = bytes;
         complete(cb_data->comp);
-    } else if (VALID_NOTIFY_SIGNAL(cb_data->notify_signal)) {
-        memset(&sig_info, 0, sizeof(sig_info));
-        sig_info.si_signo = cb_data->notify_signal;
-        sig_info.si_code = SI_QUEUE;
-        sig_info.si_int = cb_data->channel_id;
-        send_sig_info(cb_data->notify_signal, &sig_info, cb_data->process);
+        return;
+    }
+
+    // Remove the transfer from the in-flight list, and notify userspace
+    spin_lock_irqsave(&file->async_lock, flags);
+    list_del(&cb_data->list);
+    spin_unlock_irqrestore(&file->async_lock, flags);
+    axidma_async_complete(cb_data, bytes, status);
+}
+
+/* Completes all in-flight asynchronous transfers on the given channel as
+ * canceled. This is called after the transfers on a channel are terminated,
+ * since the DMA engine discards them without invoking their callbacks. */
+static void axidma_async_cancel(struct axidma_file *file, int channel_id)
+{
+    unsigned long flags;
+    struct axidma_cb_data *cb_data, *tmp;
+    LIST_HEAD(canceled);
+
+    spin_lock_irqsave(&file->async_lock, flags);
+    list_for_each_entry_safe(cb_data, tmp, &file->async_transfers, list)
+    {
+        if (cb_data->channel_id == channel_id) {
+            list_move_tail(&cb_data->list, &canceled);
+        }
+    }
+    spin_unlock_irqrestore(&file->async_lock, flags);
+
+    list_for_each_entry_safe(cb_data, tmp, &canceled, list)
+    {
+        axidma_async_complete(cb_data, 0, -ECANCELED);
     }
 }
 
-// Setup the config structure for VDMA
-static void axidma_setup_vdma_config(struct xilinx_vdma_config *dma_config)
+/* Terminates all transactions on the channel, and waits for any running
+ * callbacks to finish. The file's asynchronous and ring transfers that the
+ * engine discarded are then completed as canceled, so that none are lost. */
+static int axidma_terminate_chan(struct axidma_file *file,
+                                 struct axidma_chan *chan)
+{
+    int rc;
+
+    rc = dmaengine_terminate_all(chan->chan);
+    dmaengine_synchronize(chan->chan);
+    axidma_stats_stop(file->dev, chan);
+    clear_bit(chan - file->dev->channels, file->cyclic_active);
+
+    axidma_async_cancel(file, chan->channel_id);
+    axidma_ring_cancel(file, chan->channel_id);
+    return rc;
+}
+
+/* Setup the config structure for VDMA, with the channel's coalescing settings,
+ * and the given synchronization settings, if any. */
+static void axidma_setup_vdma_config(struct axidma_device *dev,
+                                     struct axidma_chan *chan,
+                                     struct axidma_video_sync *sync,
+                                     struct xilinx_vdma_config *dma_config)
 {
+    unsigned int threshold, delay;
+
+    threshold = READ_ONCE(dev->coalesce[chan - dev->channels].threshold);
+    delay = READ_ONCE(dev->coalesce[chan - dev->channels].delay);
     memset(dma_config, 0, sizeof(*dma_config));
     dma_config->frm_dly = 0;            // Number of frames to delay
     dma_config->gen_lock = 0;           // Genlock, VDMA runs on fsyncs
@@ -169,14 +372,124 @@ static void axidma_setup_vdma_config(struct xilinx_vdma_config *dma_config)
     dma_config->frm_cnt_en = 1;         // Interrupt based on frame count
     dma_config->park = 0;               // Continuously process all frames
     dma_config->park_frm = 0;           // Frame to stop (park) at (N/A)
-    dma_config->coalesc = 1;            // Interrupt after one frame completion
-    dma_config->delay = 0;              // Disable the delay counter interrupt
+    dma_config->coalesc = threshold;    // Interrupt after this many frames
+    dma_config->delay = delay;          // Delay counter timeout (0 to disable)
     dma_config->reset = 0;              // Don't reset the channel
     dma_config->ext_fsync = 0;          // VDMA handles synchronizes itself
+
+    // A genlock slave follows the master it is given, some frames behind
+    if (sync != NULL) {
+        dma_config->gen_lock = sync->gen_lock;
+        dma_config->master = (sync->gen_lock && !sync->master) ?
+                             sync->master_num : 0;
+        dma_config->frm_dly = (sync->gen_lock && !sync->master) ?
+                              sync->frame_delay : 0;
+        dma_config->ext_fsync = sync->fsync;
+    }
     return;
 }
 
-static int axidma_prep_transfer(struct axidma_chan *axidma_chan,
+// Checks that the synchronization settings for a VDMA channel are valid
+static int axidma_check_video_sync(struct axidma_video_sync *sync)
+{
+    if (sync->master_num < 0 || sync->master_num > AXIDMA_MAX_GENLOCK_MASTER) {
+        axidma_err("Invalid genlock master number %d.\n", sync->master_num);
+        return -EINVAL;
+    } else if (sync->frame_delay < 0 ||
+               sync->frame_delay > AXIDMA_MAX_FRAME_DELAY) {
+        axidma_err("Invalid frame delay %d.\n", sync->frame_delay);
+        return -EINVAL;
+    } else if (sync->fsync != AXIDMA_FSYNC_NONE &&
+               sync->fsync != AXIDMA_FSYNC_EXTERNAL &&
+               sync->fsync != AXIDMA_FSYNC_TUSER) {
+        axidma_err("Invalid frame sync source %d.\n", sync->fsync);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+/* Returns the number of bytes the frame spans in memory, from the start of its
+ * first line to the end of its last line. */
+static size_t axidma_frame_span(struct axidma_video_frame *frame)
+{
+    size_t line_len;
+
+    line_len = (size_t)frame->width * frame->depth;
+    if (frame->stride <= 0 || frame->height <= 0) {
+        return line_len * frame->height;
+    }
+
+    return (size_t)frame->stride * (frame->height - 1) + line_len;
+}
+
+/* Allocates the interleaved template for a transfer of the frame, with each
+ * line as a chunk, followed by a gap up to the start of the next line. Only
+ * the start address is left for the caller to fill in. */
+static struct dma_interleaved_template *axidma_alloc_video_template(
+        struct axidma_video_frame *frame, enum axidma_dir dir)
+{
+    size_t line_len;
+    struct dma_interleaved_template *dma_template;
+
+    line_len = (size_t)frame->width * frame->depth;
+    if (frame->stride > 0 && frame->stride < line_len) {
+        axidma_err("The frame stride %d is less than the line length %zu.\n",
+                   frame->stride, line_len);
+        return ERR_PTR(-EINVAL);
+    }
+
+    // The template ends with an array of chunks, which has one for the lines
+    dma_template = kzalloc(sizeof(*dma_template) +
+                           sizeof(dma_template->sgl[0]), GFP_KERNEL);
+    if (dma_template == NULL) {
+        axidma_err("Unable to allocate the interleaved transfer template.\n");
+        return ERR_PTR(-ENOMEM);
+    }
+
+    dma_template->dir = axidma_to_dma_dir(dir);
+    dma_template->numf = frame->height;
+    dma_template->frame_size = 1;
+    dma_template->sgl[0].size = line_len;
+    dma_template->sgl[0].icg = (frame->stride > 0) ?
+                               frame->stride - line_len : 0;
+    return dma_template;
+}
+
+/* Resets the channel's completion CPU, and its interrupt's affinity, if it was
+ * set, when it is released, so that the next owner doesn't inherit them. The
+ * interrupt may then be handled on any online CPU again. */
+static void axidma_reset_affinity(struct axidma_device *dev,
+                                  struct axidma_chan *chan)
+{
+    int idx;
+
+    idx = chan - dev->channels;
+    WRITE_ONCE(dev->notify_cpus[idx], AXIDMA_NOTIFY_ANY_CPU);
+    if (cpumask_empty(&dev->irq_masks[idx])) {
+        return;
+    }
+
+    irq_set_affinity_hint(dev->chan_irqs[idx], cpu_online_mask);
+    irq_set_affinity_hint(dev->chan_irqs[idx], NULL);
+    cpumask_clear(&dev->irq_masks[idx]);
+}
+
+/* Resets the channel's interrupt coalescing to the default, of one interrupt
+ * for each transfer, when it is released. This only applies to VDMA channels,
+ * which are configured when each transfer is prepared. */
+static void axidma_reset_coalesce(struct axidma_device *dev,
+                                  struct axidma_chan *chan)
+{
+    struct axidma_coalesce *coalesce;
+
+    coalesce = &dev->coalesce[chan - dev->channels];
+    WRITE_ONCE(coalesce->threshold, 1);
+    WRITE_ONCE(coalesce->delay, 0);
+}
+
+static int axidma_prep_transfer(struct axidma_file *file,
+                                struct axidma_chan *axidma_chan,
                                 struct axidma_transfer *dma_tfr)
 {
     struct dma_chan *chan;
@@ -185,12 +498,13 @@ static int axidma_prep_transfer(struct axidma_chan *axidma_chan,
     struct completion *dma_comp;
     struct xilinx_vdma_config vdma_config;
     struct axidma_cb_data *cb_data;
-    struct dma_interleaved_template dma_template;
+    struct dma_interleaved_template *dma_template;
     enum dma_transfer_direction dma_dir;
     enum dma_ctrl_flags dma_flags;
     struct scatterlist *sg_list;
     int sg_len;
     dma_cookie_t dma_cookie;
+    unsigned long flags;
     char *direction, *type;
     int rc;
 
@@ -203,7 +517,27 @@ static int axidma_prep_transfer(struct axidma_chan *axidma_chan,
     sg_len = dma_tfr->sg_len;
     direction = axidma_dir_to_string(dma_tfr->dir);
     type = axidma_type_to_string(dma_tfr->type);
-    cb_data = dma_tfr->cb_data;
+
+    /* A blocking transfer with a timeout of 0 doesn't wait, so it is left
+     * running, and completes like an asynchronous transfer. */
+    if (dma_tfr->wait && dma_tfr->timeout == 0) {
+        dma_tfr->wait = false;
+    }
+
+    /* Synchronous transfers use the callback data in the transfer, since the
+     * caller waits for it to complete, so no two threads ever share it, even on
+     * the same channel. Asynchronous transfers need their own, so that each
+     * completion can be reported separately. */
+    if (dma_tfr->wait) {
+        cb_data = &dma_tfr->sync_cb_data;
+        cb_data->bytes = 0;
+    } else {
+        cb_data = kmalloc(sizeof(*cb_data), GFP_KERNEL);
+        if (cb_data == NULL) {
+            axidma_err("Unable to allocate the transfer callback data.\n");
+            return -ENOMEM;
+        }
+    }
 
     /* For VDMA transfers, we configure the channel, then prepare an interlaved
      * transfer. For DMA, we simply prepare a slave scatter-gather transfer. */
@@ -212,74 +546,145 @@ static int axidma_prep_transfer(struct axidma_chan *axidma_chan,
         dma_txnd = dmaengine_prep_slave_sg(chan, sg_list, sg_len, dma_dir,
                                            dma_flags);
     } else {
-        axidma_setup_vdma_config(&vdma_config);
+        dma_template = axidma_alloc_video_template(&dma_tfr->frame,
+                                                   dma_tfr->dir);
+        if (IS_ERR(dma_template)) {
+            rc = PTR_ERR(dma_template);
+            goto free_cb_data;
+        }
+
+        axidma_setup_vdma_config(file->dev, axidma_chan, NULL, &vdma_config);
         rc = xilinx_vdma_channel_set_config(chan, &vdma_config);
         if (rc < 0) {
             axidma_err("Unable to set the config for channel.\n");
+            kfree(dma_template);
             goto stop_dma;
         }
 
-        memset(&dma_template, 0, sizeof(dma_template));
-        dma_template.dst_start = sg_dma_address(&sg_list[0]);
-        dma_template.src_start = sg_dma_address(&sg_list[0]);
-        dma_template.dir = dma_dir;
-        dma_template.numf = dma_tfr->frame.height;
-        dma_template.frame_size = 1;
-        dma_template.sgl[0].size = dma_tfr->frame.width *
-                dma_tfr->frame.depth;
-        dma_template.sgl[0].icg = 0;
-        dma_txnd = dmaengine_prep_interleaved_dma(chan, &dma_template,
+        dma_template->dst_start = sg_dma_address(&sg_list[0]);
+        dma_template->src_start = sg_dma_address(&sg_list[0]);
+        dma_txnd = dmaengine_prep_interleaved_dma(chan, dma_template,
                 dma_flags);
+        kfree(dma_template);
     }
     if (dma_txnd == NULL) {
         axidma_err("Unable to prepare the dma engine for the %s %s buffer.\n",
                    type, direction);
+        axidma_stats_error(file->dev, axidma_chan, AXIDMA_STATS_PREP_FAILURE);
         rc = -EBUSY;
-        goto stop_dma;
+        goto free_cb_data;
     }
 
     /* If we're going to wait for this channel, initialize the completion for
      * the channel, and setup the callback to complete it. */
     cb_data->channel_id = dma_tfr->channel_id;
+    cb_data->chan = axidma_chan;
+    cb_data->file = file;
+    cb_data->buf_len = axidma_transfer_len(dma_tfr);
     if (dma_tfr->wait) {
         cb_data->comp = dma_comp;
         cb_data->notify_signal = -1;
         cb_data->process = NULL;
         init_completion(cb_data->comp);
-        dma_txnd->callback_param = cb_data;
-        dma_txnd->callback = axidma_dma_callback;
     } else {
         cb_data->comp = NULL;
-        cb_data->notify_signal = dma_tfr->notify_signal;
+        cb_data->notify_signal = axidma_notify_signal(file) ?
+                dma_tfr->notify_signal : -1;
+        cb_data->notify_data = file->notify_data;
         cb_data->process = dma_tfr->process;
-        dma_txnd->callback_param = cb_data;
-        dma_txnd->callback = axidma_dma_callback;
     }
+    dma_txnd->callback_param = cb_data;
+    dma_txnd->callback_result = axidma_dma_callback;
+
+    /* Track the asynchronous transfer before submitting it, since it may
+     * complete as soon as it is submitted. */
+    spin_lock_irqsave(&file->async_lock, flags);
     dma_cookie = dmaengine_submit(dma_txnd);
+    cb_data->cookie = dma_cookie;
+    if (!dma_tfr->wait && !dma_submit_error(dma_cookie)) {
+        list_add_tail(&cb_data->list, &file->async_transfers);
+    }
+    spin_unlock_irqrestore(&file->async_lock, flags);
     if (dma_submit_error(dma_cookie)) {
         axidma_err("Unable to submit the %s %s transaction to the engine.\n",
                    direction, type);
+        axidma_stats_error(file->dev, axidma_chan,
+                           AXIDMA_STATS_SUBMIT_FAILURE);
         rc = -EBUSY;
         goto stop_dma;
     }
 
     // Return the DMA cookie for the transaction
+    trace_axidma_prep(dma_tfr->channel_id, dma_cookie, cb_data->buf_len, 0);
+    axidma_stats_submit(file->dev, axidma_chan);
     dma_tfr->cookie = dma_cookie;
     return 0;
 
 stop_dma:
-    dmaengine_terminate_all(chan);
+    axidma_terminate_chan(file, axidma_chan);
+free_cb_data:
+    if (!dma_tfr->wait) {
+        kfree(cb_data);
+    }
     return rc;
 }
 
-static int axidma_start_transfer(struct axidma_chan *chan,
+/* Returns the number of bytes that the transfer has moved so far. This is zero
+ * if it hasn't completed, and the engine can't report its progress. */
+static size_t axidma_transfer_progress(struct axidma_chan *chan,
+                                       struct axidma_transfer *dma_tfr,
+                                       enum dma_status status,
+                                       struct dma_tx_state *tx_state)
+{
+    size_t len;
+    struct dma_slave_caps caps;
+
+    len = axidma_transfer_len(dma_tfr);
+    if (status == DMA_COMPLETE) {
+        return len;
+    } else if (dma_get_slave_caps(chan->chan, &caps) < 0 ||
+               caps.residue_granularity == DMA_RESIDUE_GRANULARITY_DESCRIPTOR ||
+               tx_state->residue > len) {
+        return 0;
+    }
+
+    return len - tx_state->residue;
+}
+
+/* Spins waiting for the completion, for up to the given time. Returns true if
+ * it completed, and false if the time ran out, or the CPU is needed. */
+static bool axidma_poll_completion(struct completion *comp,
+                                   unsigned int budget_us)
+{
+    u64 deadline;
+
+    if (budget_us == 0) {
+        return false;
+    }
+
+    deadline = ktime_get_ns() + (u64)budget_us * NSEC_PER_USEC;
+    do {
+        if (try_wait_for_completion(comp)) {
+            return true;
+        }
+        cpu_relax();
+    } while (ktime_get_ns() < deadline && !need_resched());
+
+    return false;
+}
+
+static int axidma_start_transfer(struct axidma_file *file,
+                                 struct axidma_chan *chan,
                                  struct axidma_transfer *dma_tfr)
 {
     struct completion *dma_comp;
     dma_cookie_t dma_cookie;
     enum dma_status status;
+    struct dma_tx_state tx_state;
     char *direction, *type;
-    unsigned long timeout, time_remain;
+    unsigned long timeout;
+    unsigned int budget;
+    bool done;
     int rc;
 
     // Get the fields from the structures
@@ -287,18 +692,30 @@ static int axidma_start_transfer(struct axidma_chan *chan,
     dma_cookie = dma_tfr->cookie;
     direction = axidma_dir_to_string(dma_tfr->dir);
     type = axidma_type_to_string(dma_tfr->type);
+    dma_tfr->bytes = 0;
 
     // Flush all pending transaction in the dma engine for this channel
+    trace_axidma_issue(dma_tfr->channel_id, dma_cookie,
+                       axidma_transfer_len(dma_tfr), 0);
     dma_async_issue_pending(chan->chan);
 
-    // Wait for the completion timeout or the DMA to complete
+    /* Wait for the completion timeout or the DMA to complete. If the channel
+     * has a poll budget, spin first, to avoid the latency of being woken up. */
     if (dma_tfr->wait) {
-        timeout = msecs_to_jiffies(AXIDMA_DMA_TIMEOUT);
-        time_remain = wait_for_completion_timeout(dma_comp, timeout);
-        status = dma_async_is_tx_complete(chan->chan, dma_cookie, NULL, NULL);
-
-        if (time_remain == 0) {
+        timeout = (dma_tfr->timeout < 0) ? MAX_SCHEDULE_TIMEOUT :
+                  msecs_to_jiffies(dma_tfr->timeout);
+        budget = READ_ONCE(file->dev->poll_budgets[chan - file->dev->channels]);
+        done = axidma_poll_completion(dma_comp, budget) ||
+               wait_for_completion_timeout(dma_comp, timeout) != 0;
+
+        // Find out how much was transferred, before the transfer is stopped
+        status = dmaengine_tx_status(chan->chan, dma_cookie, &tx_state);
+        dma_tfr->bytes = axidma_transfer_progress(chan, dma_tfr, status,
+                                                  &tx_state);
+
+        if (!done) {
             axidma_err("%s %s transaction timed out.\n", type, direction);
+            axidma_stats_error(file->dev, chan, AXIDMA_STATS_TIMEOUT);
             rc = -ETIME;
             goto stop_dma;
         } else if (status != DMA_COMPLETE) {
@@ -307,12 +724,20 @@ static int axidma_start_transfer(struct axidma_chan *chan,
             rc = -EBUSY;
             goto stop_dma;
         }
+
+        /* The engine only reports that the transfer is complete, so use the
+         * length from the callback, which is short for a packet ended early by
+         * the stream, for instance by TLAST on a receive. */
+        dma_tfr->bytes = dma_tfr->sync_cb_data.bytes;
     }
 
     return 0;
 
 stop_dma:
-    dmaengine_terminate_all(chan->chan);
+    /* The callback data is on the caller's stack, so wait for the callback to
+     * finish, in case the transfer completed late. This also discards the
+     * other transfers on the channel, which are completed as canceled. */
+    axidma_terminate_chan(file, chan);
     return rc;
 }
 
@@ -338,39 +763,47 @@ void axidma_get_channel_info(struct axidma_device *dev,
     return;
 }
 
-int axidma_set_signal(struct axidma_device *dev, int signal)
+int axidma_set_signal(struct axidma_file *file,
+                      struct axidma_signal_info *sig_info)
 {
     // Verify the signal is a real-time one
-    if (!VALID_NOTIFY_SIGNAL(signal)) {
+    if (!VALID_NOTIFY_SIGNAL(sig_info->signal)) {
         axidma_err("Invalid signal %d requested for DMA notification.\n",
-                   signal);
+                   sig_info->signal);
         axidma_err("You must specify one of the POSIX real-time signals.\n");
         return -EINVAL;
     }
 
-    dev->notify_signal = signal;
+    file->notify_signal = sig_info->signal;
+    file->notify_data = sig_info->user_data;
     return 0;
 }
 
-int axidma_read_transfer(struct axidma_device *dev,
+int axidma_read_transfer(struct axidma_file *file,
                          struct axidma_transaction *trans)
 {
     int rc;
+    struct axidma_device *dev;
     struct axidma_chan *rx_chan;
     struct scatterlist sg_list;
     struct axidma_transfer rx_tfr;
 
     // Get the channel with the given channel id
+    dev = file->dev;
     rx_chan = axidma_get_chan(dev, trans->channel_id);
     if (rx_chan == NULL || rx_chan->dir != AXIDMA_READ) {
         axidma_err("Invalid device id %d for DMA receive channel.\n",
                    trans->channel_id);
         return -ENODEV;
     }
+    rc = axidma_own_chan(file, rx_chan);
+    if (rc < 0) {
+        return rc;
+    }
 
     // Setup the scatter-gather list for the transfer (only one entry)
     sg_init_table(&sg_list, 1);
-    rc = axidma_init_sg_entry(dev, &sg_list, 0, trans->buf,
+    rc = axidma_init_sg_entry(file, rx_chan, &sg_list, 0, trans->buf,
                               trans->buf_len);
     if (rc < 0) {
         return rc;
@@ -382,19 +815,20 @@ int axidma_read_transfer(struct axidma_device *dev,
     rx_tfr.dir = rx_chan->dir;
     rx_tfr.type = rx_chan->type;
     rx_tfr.wait = trans->wait;
+    rx_tfr.timeout = trans->timeout;
     rx_tfr.channel_id = trans->channel_id;
-    rx_tfr.notify_signal = dev->notify_signal;
+    rx_tfr.notify_signal = file->notify_signal;
     rx_tfr.process = get_current();
-    rx_tfr.cb_data = &dev->cb_data[trans->channel_id];
 
     // Prepare the receive transfer
-    rc = axidma_prep_transfer(rx_chan, &rx_tfr);
+    rc = axidma_prep_transfer(file, rx_chan, &rx_tfr);
     if (rc < 0) {
         return rc;
     }
 
     // Submit the receive transfer, and wait for it to complete
-    rc = axidma_start_transfer(rx_chan, &rx_tfr);
+    rc = axidma_start_transfer(file, rx_chan, &rx_tfr);
+    trans->bytes = rx_tfr.bytes;
     if (rc < 0) {
         return rc;
     }
@@ -402,25 +836,31 @@ int axidma_read_transfer(struct axidma_device *dev,
     return 0;
 }
 
-int axidma_write_transfer(struct axidma_device *dev,
+int axidma_write_transfer(struct axidma_file *file,
                           struct axidma_transaction *trans)
 {
     int rc;
+    struct axidma_device *dev;
     struct axidma_chan *tx_chan;
     struct scatterlist sg_list;
     struct axidma_transfer tx_tfr;
 
     // Get the channel with the given id
+    dev = file->dev;
     tx_chan = axidma_get_chan(dev, trans->channel_id);
     if (tx_chan == NULL || tx_chan->dir != AXIDMA_WRITE) {
         axidma_err("Invalid device id %d for DMA transmit channel.\n",
                    trans->channel_id);
         return -ENODEV;
     }
+    rc = axidma_own_chan(file, tx_chan);
+    if (rc < 0) {
+        return rc;
+    }
 
     // Setup the scatter-gather list for the transfer (only one entry)
     sg_init_table(&sg_list, 1);
-    rc = axidma_init_sg_entry(dev, &sg_list, 0, trans->buf,
+    rc = axidma_init_sg_entry(file, tx_chan, &sg_list, 0, trans->buf,
                               trans->buf_len);
     if (rc < 0) {
         return rc;
@@ -432,19 +872,20 @@ int axidma_write_transfer(struct axidma_device *dev,
     tx_tfr.dir = tx_chan->dir;
     tx_tfr.type = tx_chan->type;
     tx_tfr.wait = trans->wait;
+    tx_tfr.timeout = trans->timeout;
     tx_tfr.channel_id = trans->channel_id;
-    tx_tfr.notify_signal = dev->notify_signal;
+    tx_tfr.notify_signal = file->notify_signal;
     tx_tfr.process = get_current();
-    tx_tfr.cb_data = &dev->cb_data[trans->channel_id];
 
     // Prepare the transmit transfer
-    rc = axidma_prep_transfer(tx_chan, &tx_tfr);
+    rc = axidma_prep_transfer(file, tx_chan, &tx_tfr);
     if (rc < 0) {
         return rc;
     }
 
     // Submit the transmit transfer, and wait for it to complete
-    rc = axidma_start_transfer(tx_chan, &tx_tfr);
+    rc = axidma_start_transfer(file, tx_chan, &tx_tfr);
+    trans->bytes = tx_tfr.bytes;
     if (rc < 0) {
         return rc;
     }
@@ -452,17 +893,117 @@ int axidma_write_transfer(struct axidma_device *dev,
     return 0;
 }
 
+/* Performs a transfer in the given direction between the DMA channel and a
+ * vector of buffers, using a scatter-gather list with an entry for each
+ * physically contiguous segment of the buffers. */
+int axidma_vec_transfer(struct axidma_file *file,
+                        struct axidma_vec_transaction *trans,
+                        enum axidma_dir dir)
+{
+    int rc, i, nents, total;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct iovec *vec;
+    struct axidma_transfer dma_tfr;
+
+    // Get the channel with the given channel id
+    dev = file->dev;
+    chan = axidma_get_chan(dev, trans->channel_id);
+    if (chan == NULL || chan->dir != dir || chan->type != AXIDMA_DMA) {
+        axidma_err("Invalid device id %d for DMA %s channel.\n",
+                   trans->channel_id, axidma_dir_to_string(dir));
+        return -ENODEV;
+    }
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Count the number of scatter-gather entries needed for the buffers
+    dma_tfr.sg_len = 0;
+    for (i = 0; i < trans->num_vecs; i++)
+    {
+        vec = &trans->vecs[i];
+        nents = (vec->iov_len == 0) ? -EINVAL :
+                axidma_uservirt_to_sg(file, vec->iov_base, vec->iov_len,
+                                      NULL, 0);
+        if (nents < 0) {
+            axidma_err("Requested transfer address %p, size %zu does not fall "
+                       "within a previously allocated DMA buffer.\n",
+                       vec->iov_base, vec->iov_len);
+            axidma_stats_error(dev, chan, AXIDMA_STATS_LOOKUP_MISS);
+            return nents;
+        }
+        dma_tfr.sg_len += nents;
+    }
+
+    // Allocate the scatter-gather list, and fill in the entries for each buffer
+    dma_tfr.sg_list = kmalloc(dma_tfr.sg_len * sizeof(*dma_tfr.sg_list),
+                              GFP_KERNEL);
+    if (dma_tfr.sg_list == NULL) {
+        axidma_err("Unable to allocate memory for the scatter-gather list.\n");
+        return -ENOMEM;
+    }
+    sg_init_table(dma_tfr.sg_list, dma_tfr.sg_len);
+    for (i = 0, total = 0; i < trans->num_vecs; i++)
+    {
+        /* The buffers may have been unmapped or unregistered since they were
+         * counted, so the entries must still fit in the list. */
+        vec = &trans->vecs[i];
+        nents = axidma_uservirt_to_sg(file, vec->iov_base, vec->iov_len,
+                                      &dma_tfr.sg_list[total],
+                                      dma_tfr.sg_len - total);
+        if (nents < 0) {
+            axidma_err("Transfer buffer %p, size %zu changed while the "
+                       "transfer was being setup.\n", vec->iov_base,
+                       vec->iov_len);
+            rc = (nents == -ENOSPC) ? -EFAULT : nents;
+            goto free_sg_list;
+        }
+        total += nents;
+    }
+    if (total != dma_tfr.sg_len) {
+        axidma_err("Transfer buffers changed while the transfer was being "
+                   "setup.\n");
+        rc = -EFAULT;
+        goto free_sg_list;
+    }
+
+    // Setup the transfer structure for DMA
+    dma_tfr.dir = chan->dir;
+    dma_tfr.type = chan->type;
+    dma_tfr.wait = trans->wait;
+    dma_tfr.timeout = trans->timeout;
+    dma_tfr.channel_id = trans->channel_id;
+    dma_tfr.notify_signal = file->notify_signal;
+    dma_tfr.process = get_current();
+
+    // Prepare the transfer, and submit it, waiting for it to complete
+    rc = axidma_prep_transfer(file, chan, &dma_tfr);
+    if (rc < 0) {
+        goto free_sg_list;
+    }
+    rc = axidma_start_transfer(file, chan, &dma_tfr);
+    trans->bytes = dma_tfr.bytes;
+
+free_sg_list:
+    kfree(dma_tfr.sg_list);
+    return rc;
+}
+
 /* Transfers data from the given source buffer out to the AXI DMA device, and
  * places the data received into the receive buffer. */
-int axidma_rw_transfer(struct axidma_device *dev,
+int axidma_rw_transfer(struct axidma_file *file,
                        struct axidma_inout_transaction *trans)
 {
     int rc;
+    struct axidma_device *dev;
     struct axidma_chan *tx_chan, *rx_chan;
     struct scatterlist tx_sg_list, rx_sg_list;
     struct axidma_transfer tx_tfr, rx_tfr;
 
     // Get the transmit and receive channels with the given ids.
+    dev = file->dev;
     tx_chan = axidma_get_chan(dev, trans->tx_channel_id);
     if (tx_chan == NULL || tx_chan->dir != AXIDMA_WRITE) {
         axidma_err("Invalid device id %d for DMA transmit channel.\n",
@@ -477,15 +1018,25 @@ int axidma_rw_transfer(struct axidma_device *dev,
         return -ENODEV;
     }
 
+    // Both channels must be owned by the file
+    rc = axidma_own_chan(file, tx_chan);
+    if (rc < 0) {
+        return rc;
+    }
+    rc = axidma_own_chan(file, rx_chan);
+    if (rc < 0) {
+        return rc;
+    }
+
     // Setup the scatter-gather list for the transfers (only one entry)
     sg_init_table(&tx_sg_list, 1);
-    rc = axidma_init_sg_entry(dev, &tx_sg_list, 0, trans->tx_buf,
+    rc = axidma_init_sg_entry(file, tx_chan, &tx_sg_list, 0, trans->tx_buf,
                               trans->tx_buf_len);
     if (rc < 0) {
         return rc;
     }
     sg_init_table(&rx_sg_list, 1);
-    rc = axidma_init_sg_entry(dev, &rx_sg_list, 0, trans->rx_buf,
+    rc = axidma_init_sg_entry(file, rx_chan, &rx_sg_list, 0, trans->rx_buf,
                               trans->rx_buf_len);
     if (rc < 0) {
         return rc;
@@ -498,9 +1049,8 @@ int axidma_rw_transfer(struct axidma_device *dev,
     tx_tfr.type = tx_chan->type,
     tx_tfr.wait = false,
     tx_tfr.channel_id = trans->tx_channel_id,
-    tx_tfr.notify_signal = dev->notify_signal,
+    tx_tfr.notify_signal = file->notify_signal,
     tx_tfr.process = get_current(),
-    tx_tfr.cb_data = &dev->cb_data[trans->tx_channel_id];
 
     // Add in the frame information for VDMA transfers
     if (tx_chan->type == AXIDMA_VDMA) {
@@ -512,10 +1062,10 @@ int axidma_rw_transfer(struct axidma_device *dev,
     rx_tfr.dir = rx_chan->dir,
     rx_tfr.type = rx_chan->type,
     rx_tfr.wait = trans->wait,
+    rx_tfr.timeout = trans->timeout,
     rx_tfr.channel_id = trans->rx_channel_id,
-    rx_tfr.notify_signal = dev->notify_signal,
+    rx_tfr.notify_signal = file->notify_signal,
     rx_tfr.process = get_current(),
-    rx_tfr.cb_data = &dev->cb_data[trans->rx_channel_id];
 
     // Add in the frame information for VDMA transfers
     if (tx_chan->type == AXIDMA_VDMA) {
@@ -523,21 +1073,22 @@ int axidma_rw_transfer(struct axidma_device *dev,
     }
 
     // Prep both the receive and transmit transfers
-    rc = axidma_prep_transfer(tx_chan, &tx_tfr);
+    rc = axidma_prep_transfer(file, tx_chan, &tx_tfr);
     if (rc < 0) {
         return rc;
     }
-    rc = axidma_prep_transfer(rx_chan, &rx_tfr);
+    rc = axidma_prep_transfer(file, rx_chan, &rx_tfr);
     if (rc < 0) {
         return rc;
     }
 
     // Submit both transfers to the DMA engine, and wait on the receive transfer
-    rc = axidma_start_transfer(tx_chan, &tx_tfr);
+    rc = axidma_start_transfer(file, tx_chan, &tx_tfr);
     if (rc < 0) {
         return rc;
     }
-    rc = axidma_start_transfer(rx_chan, &rx_tfr);
+    rc = axidma_start_transfer(file, rx_chan, &rx_tfr);
+    trans->rx_bytes = rx_tfr.bytes;
     if (rc < 0) {
         return rc;
     }
@@ -545,105 +1096,1214 @@ int axidma_rw_transfer(struct axidma_device *dev,
     return 0;
 }
 
-int axidma_video_transfer(struct axidma_device *dev,
-                          struct axidma_video_transaction *trans,
-                          enum axidma_dir dir)
+/* Submits a batch of asynchronous transfers, only flushing the pending
+ * transactions on each channel to the DMA engine once all are submitted. */
+int axidma_batch_transfer(struct axidma_file *file,
+                          struct axidma_batch_transaction *trans)
 {
     int rc, i;
-    size_t image_size;
-    struct axidma_chan *chan;
-    struct scatterlist *sg_list;
-
-    // Setup transmit transfer structure for DMA
-    struct axidma_transfer transfer = {
-        .sg_len = trans->num_frame_buffers,
-        .dir = dir,
-        .type = AXIDMA_VDMA,
-        .wait = false,
-        .channel_id = trans->channel_id,
-        .notify_signal = dev->notify_signal,
-        .process = get_current(),
-        .frame = trans->frame,
-    };
-
-    // Allocate an array to store the scatter list structures for the buffers
-    transfer.sg_list = kmalloc(transfer.sg_len * sizeof(*sg_list), GFP_KERNEL);
-    if (transfer.sg_list == NULL) {
-        axidma_err("Unable to allocate memory for the scatter-gather list.\n");
+    struct axidma_device *dev;
+    struct axidma_batch_entry *entry;
+    struct axidma_chan **chans;
+    struct scatterlist *sg_lists;
+    bool *chan_used;
+    struct axidma_transfer dma_tfr;
+
+    // Allocate the per-transfer channels and scatter-gather lists
+    dev = file->dev;
+    chans = kmalloc(trans->num_entries * sizeof(*chans), GFP_KERNEL);
+    if (chans == NULL) {
+        axidma_err("Unable to allocate memory for the batch channels.\n");
         rc = -ENOMEM;
         goto ret;
     }
+    sg_lists = kmalloc(trans->num_entries * sizeof(*sg_lists), GFP_KERNEL);
+    if (sg_lists == NULL) {
+        axidma_err("Unable to allocate memory for the scatter-gather list.\n");
+        rc = -ENOMEM;
+        goto free_chans;
+    }
+    chan_used = kcalloc(dev->num_chans, sizeof(*chan_used), GFP_KERNEL);
+    if (chan_used == NULL) {
+        axidma_err("Unable to allocate memory for the batch channel flags.\n");
+        rc = -ENOMEM;
+        goto free_sg_lists;
+    }
 
-    // For each frame, setup a scatter-gather entry
-    image_size = trans->frame.width * trans->frame.height * trans->frame.depth;
-    for (i = 0; i < transfer.sg_len; i++)
+    /* Validate all of the transfers before submitting any of them, so that an
+     * invalid transfer doesn't leave the batch partially submitted. */
+    for (i = 0; i < trans->num_entries; i++)
     {
-        rc = axidma_init_sg_entry(dev, transfer.sg_list, i,
-                                  trans->frame_buffers[i], image_size);
+        entry = &trans->entries[i];
+        chans[i] = axidma_get_chan(dev, entry->channel_id);
+        if (chans[i] == NULL || chans[i]->type != AXIDMA_DMA) {
+            axidma_err("Invalid device id %d for DMA channel in batch entry "
+                       "%d.\n", entry->channel_id, i);
+            rc = -ENODEV;
+            goto free_chan_used;
+        }
+        rc = axidma_own_chan(file, chans[i]);
         if (rc < 0) {
-            goto free_sg_list;
+            goto free_chan_used;
+        }
+
+        // Setup the scatter-gather list for the transfer (only one entry)
+        sg_init_table(&sg_lists[i], 1);
+        rc = axidma_init_sg_entry(file, chans[i], &sg_lists[i], 0,
+                                  entry->buf, entry->buf_len);
+        if (rc < 0) {
+            goto free_chan_used;
         }
     }
 
-    // Get the channel with the given id
-    chan = axidma_get_chan(dev, trans->channel_id);
-    if (chan == NULL && chan->dir != dir &&
-            chan->type != AXIDMA_VDMA) {
-        axidma_err("Invalid device id %d for VDMA %s channel.\n",
-                   trans->channel_id, axidma_dir_to_string(chan->dir));
-        rc = -ENODEV;
-        goto free_sg_list;
+    // Prepare and submit each transfer, without starting the channels
+    for (i = 0; i < trans->num_entries; i++)
+    {
+        entry = &trans->entries[i];
+        dma_tfr.sg_list = &sg_lists[i];
+        dma_tfr.sg_len = 1;
+        dma_tfr.dir = chans[i]->dir;
+        dma_tfr.type = chans[i]->type;
+        dma_tfr.wait = false;
+        dma_tfr.channel_id = entry->channel_id;
+        dma_tfr.notify_signal = file->notify_signal;
+        dma_tfr.process = get_current();
+
+        rc = axidma_prep_transfer(file, chans[i], &dma_tfr);
+        if (rc < 0) {
+            goto stop_dma;
+        }
+        entry->cookie = dma_tfr.cookie;
+        chan_used[chans[i] - dev->channels] = true;
     }
-    transfer.cb_data = &dev->cb_data[trans->channel_id];
 
-    // Prepare the transmit transfer
-    rc = axidma_prep_transfer(chan, &transfer);
-    if (rc < 0) {
-        goto free_sg_list;
+    // Flush the pending transactions on every channel used by the batch
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        if (chan_used[i]) {
+            trace_axidma_issue(dev->channels[i].channel_id,
+                               dev->channels[i].chan->cookie, 0, 0);
+            dma_async_issue_pending(dev->channels[i].chan);
+        }
     }
 
-    // Submit the transfer, and immediately return
-    rc = axidma_start_transfer(chan, &transfer);
+    rc = 0;
+    goto free_chan_used;
 
-free_sg_list:
-    kfree(transfer.sg_list);
+stop_dma:
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        if (chan_used[i]) {
+            axidma_terminate_chan(file, &dev->channels[i]);
+        }
+    }
+free_chan_used:
+    kfree(chan_used);
+free_sg_lists:
+    kfree(sg_lists);
+free_chans:
+    kfree(chans);
 ret:
-    return 0;
+    return rc;
 }
 
-int axidma_stop_channel(struct axidma_device *dev,
-                        struct axidma_chan *chan_info)
+/* Prepares and submits an asynchronous transfer on the given DMA channel,
+ * which invokes the given callback upon completion. The pending transfers in
+ * the channel are not flushed, so the caller must issue them to the engine. */
+int axidma_queue_transfer(struct axidma_file *file, int channel_id, void *buf,
+        size_t buf_len, dma_async_tx_callback_result callback,
+        void *callback_param, dma_cookie_t *cookie)
 {
+    int rc;
     struct axidma_chan *chan;
+    struct scatterlist sg_list;
+    struct dma_async_tx_descriptor *dma_txnd;
+    enum dma_ctrl_flags dma_flags;
 
-    // Get the transmit and receive channels with the given ids.
-    chan = axidma_get_chan(dev, chan_info->channel_id);
-    if (chan == NULL && chan->type != chan_info->type &&
-            chan->dir != chan_info->dir) {
-        axidma_err("Invalid channel id %d for %s %s channel.\n",
-            chan_info->channel_id, axidma_type_to_string(chan_info->type),
-            axidma_dir_to_string(chan_info->dir));
+    // Get the channel with the given id
+    chan = axidma_get_chan(file->dev, channel_id);
+    if (chan == NULL || chan->type != AXIDMA_DMA) {
+        axidma_err("Invalid device id %d for DMA channel.\n", channel_id);
         return -ENODEV;
     }
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Setup the scatter-gather list for the transfer (only one entry)
+    sg_init_table(&sg_list, 1);
+    rc = axidma_init_sg_entry(file, chan, &sg_list, 0, buf, buf_len);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Prepare the transfer, and submit it to the channel's pending queue
+    dma_flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT;
+    dma_txnd = dmaengine_prep_slave_sg(chan->chan, &sg_list, 1,
+                                       axidma_to_dma_dir(chan->dir), dma_flags);
+    if (dma_txnd == NULL) {
+        axidma_err("Unable to prepare the dma engine for the DMA %s buffer.\n",
+                   axidma_dir_to_string(chan->dir));
+        axidma_stats_error(file->dev, chan, AXIDMA_STATS_PREP_FAILURE);
+        return -EBUSY;
+    }
+
+    dma_txnd->callback_result = callback;
+    dma_txnd->callback_param = callback_param;
+    *cookie = dmaengine_submit(dma_txnd);
+    if (dma_submit_error(*cookie)) {
+        axidma_err("Unable to submit the DMA %s transaction to the engine.\n",
+                   axidma_dir_to_string(chan->dir));
+        axidma_stats_error(file->dev, chan, AXIDMA_STATS_SUBMIT_FAILURE);
+        return -EBUSY;
+    }
 
-    // Terminate all DMA transactions on the given channel
-    return dmaengine_terminate_all(chan->chan);
+    trace_axidma_prep(channel_id, *cookie, buf_len, 0);
+    axidma_stats_submit(file->dev, chan);
+    return 0;
 }
 
-/*----------------------------------------------------------------------------
- * Initialization and Cleanup
- *----------------------------------------------------------------------------*/
+/* The callback for each frame of a video transfer. This publishes the frame to
+ * userspace, after the frame's data, and has the frame buffer queued again. */
+static void axidma_video_callback(void *data)
+{
+    struct axidma_video_fb *fb;
+    struct axidma_video_stream *stream;
+    struct axidma_cyclic_status *status;
+    struct axidma_cqe event;
+
+    fb = data;
+    stream = fb->stream;
+    status = stream->status;
+    WRITE_ONCE(status->last_period, fb->index);
+    smp_store_release(&status->period_count, status->period_count + 1);
+
+    event.user_data = fb->user_addr;
+    event.channel_id = stream->chan->channel_id;
+    event.cookie = fb->cookie;
+    event.bytes = stream->image_size;
+    event.status = 0;
+    axidma_event_post(stream->file, &event);
+    trace_axidma_complete(event.channel_id, event.cookie, event.bytes, 0);
+
+    schedule_work(&fb->work);
+}
 
-static int axidma_request_channels(struct platform_device *pdev,
-                                   struct axidma_device *dev)
+/* Queues the frame buffer to the engine, to be transferred after those already
+ * queued. The stream's lock must be held, and the caller issues it. */
+static int axidma_video_queue(struct axidma_video_fb *fb)
 {
-    int rc, i;
-    int num_reserved_chans;
+    int rc;
+    dma_cookie_t dma_cookie;
+    struct axidma_video_stream *stream;
     struct axidma_chan *chan;
+    struct dma_async_tx_descriptor *dma_txnd;
+    struct xilinx_vdma_config vdma_config;
 
-    // For each channel, request exclusive access to the channel
-    num_reserved_chans = 0;
-    for (i = 0; i < dev->num_chans; i++)
+    stream = fb->stream;
+    chan = stream->chan;
+    axidma_setup_vdma_config(stream->file->dev, chan, &stream->sync,
+                             &vdma_config);
+    rc = xilinx_vdma_channel_set_config(chan->chan, &vdma_config);
+    if (rc < 0) {
+        axidma_err("Unable to set the config for channel.\n");
+        return rc;
+    }
+
+    // Prepare an interleaved transfer of the frame, from the common template
+    stream->dma_template->src_start = fb->dma_addr;
+    stream->dma_template->dst_start = fb->dma_addr;
+    dma_txnd = dmaengine_prep_interleaved_dma(chan->chan, stream->dma_template,
+            DMA_CTRL_ACK | DMA_PREP_INTERRUPT);
+    if (dma_txnd == NULL) {
+        axidma_err("Unable to prepare the VDMA %s transaction for frame %d.\n",
+                   axidma_dir_to_string(chan->dir), fb->index);
+        axidma_stats_error(stream->file->dev, chan, AXIDMA_STATS_PREP_FAILURE);
+        return -EBUSY;
+    }
+    dma_txnd->callback = axidma_video_callback;
+    dma_txnd->callback_param = fb;
+
+    dma_cookie = dmaengine_submit(dma_txnd);
+    if (dma_submit_error(dma_cookie)) {
+        axidma_err("Unable to submit the VDMA %s transaction for frame %d.\n",
+                   axidma_dir_to_string(chan->dir), fb->index);
+        axidma_stats_error(stream->file->dev, chan,
+                           AXIDMA_STATS_SUBMIT_FAILURE);
+        return -EBUSY;
+    }
+    trace_axidma_prep(chan->channel_id, dma_cookie, stream->image_size, 0);
+
+    fb->cookie = dma_cookie;
+    fb->queued = true;
+    return 0;
+}
+
+/* Queues the frame buffer again once its frame is done, unless the transfer
+ * is stopping, or parked on another frame buffer. */
+static void axidma_video_requeue(struct work_struct *work)
+{
+    struct axidma_video_fb *fb;
+    struct axidma_video_stream *stream;
+
+    fb = container_of(work, struct axidma_video_fb, work);
+    stream = fb->stream;
+
+    mutex_lock(&stream->lock);
+    fb->queued = false;
+    if (!stream->stopping && (stream->park_frame < 0 ||
+                              stream->park_frame == fb->index)) {
+        if (axidma_video_queue(fb) == 0) {
+            trace_axidma_issue(stream->chan->channel_id, fb->cookie,
+                               stream->image_size, 0);
+            dma_async_issue_pending(stream->chan->chan);
+        }
+    }
+    mutex_unlock(&stream->lock);
+}
+
+/* Stops the video transfer on the channel, if the file has one, and frees it.
+ * No frame buffers are queued again once this begins. */
+static void axidma_video_stop(struct axidma_file *file,
+                              struct axidma_chan *chan)
+{
+    int i;
+    struct axidma_video_stream *stream;
+
+    // Take the transfer, so that it can't be parked while it is stopped
+    mutex_lock(&file->video_lock);
+    stream = file->video_streams[chan - file->dev->channels];
+    file->video_streams[chan - file->dev->channels] = NULL;
+    mutex_unlock(&file->video_lock);
+    if (stream == NULL) {
+        return;
+    }
+
+    /* Stop queuing frames, and then stop the channel. A frame may complete
+     * before it is stopped, so wait for its work to finish after that. */
+    mutex_lock(&stream->lock);
+    stream->stopping = true;
+    mutex_unlock(&stream->lock);
+    dmaengine_terminate_all(chan->chan);
+    dmaengine_synchronize(chan->chan);
+    for (i = 0; i < stream->num_fbs; i++)
+    {
+        cancel_work_sync(&stream->fbs[i].work);
+    }
+
+    kfree(stream->dma_template);
+    kfree(stream);
+}
+
+int axidma_video_transfer(struct axidma_file *file,
+                          struct axidma_video_transaction *trans,
+                          enum axidma_dir dir)
+{
+    int rc, i;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct axidma_video_stream *stream;
+    struct axidma_video_fb *fb;
+    struct dma_interleaved_template *dma_template;
+
+    // Get the channel with the given id
+    dev = file->dev;
+    chan = axidma_get_chan(dev, trans->channel_id);
+    if (chan == NULL || chan->dir != dir || chan->type != AXIDMA_VDMA) {
+        axidma_err("Invalid device id %d for VDMA %s channel.\n",
+                   trans->channel_id, axidma_dir_to_string(dir));
+        return -ENODEV;
+    } else if (trans->num_frame_buffers <= 0) {
+        axidma_err("A video transfer needs at least one frame buffer.\n");
+        return -EINVAL;
+    }
+    rc = axidma_check_video_sync(&trans->sync);
+    if (rc < 0) {
+        return rc;
+    }
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Allocate the transfer, and the template for each frame's transfer
+    stream = kzalloc(sizeof(*stream) + trans->num_frame_buffers *
+                     sizeof(stream->fbs[0]), GFP_KERNEL);
+    if (stream == NULL) {
+        axidma_err("Unable to allocate memory for the video transfer.\n");
+        return -ENOMEM;
+    }
+
+    // Every frame is transferred with the same template, at its own address
+    dma_template = axidma_alloc_video_template(&trans->frame, dir);
+    if (IS_ERR(dma_template)) {
+        rc = PTR_ERR(dma_template);
+        goto free_stream;
+    }
+
+    stream->file = file;
+    stream->chan = chan;
+    stream->status = &file->cyclic_status[chan - dev->channels];
+    stream->dma_template = dma_template;
+    stream->image_size = trans->frame.width * trans->frame.height *
+                         trans->frame.depth;
+    stream->sync = trans->sync;
+    mutex_init(&stream->lock);
+    stream->park_frame = -1;
+    stream->num_fbs = trans->num_frame_buffers;
+
+    // For each frame buffer, find its DMA address
+    for (i = 0; i < stream->num_fbs; i++)
+    {
+        fb = &stream->fbs[i];
+        fb->stream = stream;
+        fb->index = i;
+        fb->user_addr = trans->frame_buffers[i];
+        INIT_WORK(&fb->work, axidma_video_requeue);
+        fb->dma_addr = axidma_uservirt_to_dma(file, fb->user_addr,
+                                              axidma_frame_span(&trans->frame));
+        if (fb->dma_addr == (dma_addr_t)NULL) {
+            axidma_err("Requested frame buffer %p does not fall within a "
+                       "previously allocated DMA buffer.\n", fb->user_addr);
+            axidma_stats_error(dev, chan, AXIDMA_STATS_LOOKUP_MISS);
+            rc = -EFAULT;
+            goto free_template;
+        }
+    }
+
+    /* Replace the channel's current video transfer, if any. Another thread
+     * may have started one in the meantime, in which case this one fails. */
+    axidma_video_stop(file, chan);
+    mutex_lock(&file->video_lock);
+    if (file->video_streams[chan - dev->channels] != NULL) {
+        mutex_unlock(&file->video_lock);
+        axidma_err("A video transfer was started on channel %d meanwhile.\n",
+                   chan->channel_id);
+        rc = -EBUSY;
+        goto free_template;
+    }
+    file->video_streams[chan - dev->channels] = stream;
+    mutex_unlock(&file->video_lock);
+
+    // Reset the channel's status before the first frame can complete
+    WRITE_ONCE(stream->status->num_periods, stream->num_fbs);
+    WRITE_ONCE(stream->status->last_period, 0);
+    WRITE_ONCE(stream->status->period_count, 0);
+
+    // Queue all of the frame buffers, and start the transfer
+    mutex_lock(&stream->lock);
+    for (i = 0; i < stream->num_fbs; i++)
+    {
+        rc = axidma_video_queue(&stream->fbs[i]);
+        if (rc < 0) {
+            break;
+        }
+    }
+    mutex_unlock(&stream->lock);
+    if (rc < 0) {
+        axidma_video_stop(file, chan);
+        return rc;
+    }
+    trace_axidma_issue(chan->channel_id, stream->fbs[i - 1].cookie, 0, 0);
+    dma_async_issue_pending(chan->chan);
+
+    // Tell userspace where to find the channel's status
+    trans->mmap_size = file->cyclic_size;
+    trans->status_offset = (chan - dev->channels) * sizeof(*stream->status);
+    return 0;
+
+free_template:
+    kfree(dma_template);
+free_stream:
+    kfree(stream);
+    return rc;
+}
+
+/* Parks the video transfer on the channel on one of its frame buffers, so that
+ * only it is queued again, or resumes queuing all of them. */
+int axidma_video_park(struct axidma_file *file, struct axidma_video_park *park)
+{
+    int rc, i;
+    struct axidma_chan *chan;
+    struct axidma_video_stream *stream;
+    struct axidma_video_fb *fb;
+
+    chan = axidma_get_chan(file->dev, park->channel_id);
+    if (chan == NULL || chan->type != AXIDMA_VDMA) {
+        axidma_err("Invalid device id %d for VDMA channel.\n",
+                   park->channel_id);
+        return -ENODEV;
+    }
+
+    mutex_lock(&file->video_lock);
+    stream = file->video_streams[chan - file->dev->channels];
+    if (stream == NULL) {
+        axidma_err("No video transfer is running on channel %d.\n",
+                   park->channel_id);
+        rc = -EINVAL;
+        goto unlock_video;
+    } else if (park->frame < -1 || park->frame >= stream->num_fbs) {
+        axidma_err("Invalid frame buffer %d to park on.\n", park->frame);
+        rc = -EINVAL;
+        goto unlock_video;
+    }
+
+    /* Queue the frame buffers that were held back, but are now allowed. Those
+     * that are done, but not queued yet, are left to their work. */
+    mutex_lock(&stream->lock);
+    stream->park_frame = park->frame;
+    rc = 0;
+    for (i = 0; i < stream->num_fbs; i++)
+    {
+        fb = &stream->fbs[i];
+        if (fb->queued || (park->frame >= 0 && park->frame != i)) {
+            continue;
+        }
+
+        rc = axidma_video_queue(fb);
+        if (rc < 0) {
+            break;
+        }
+        trace_axidma_issue(chan->channel_id, fb->cookie, stream->image_size,
+                           0);
+    }
+    dma_async_issue_pending(chan->chan);
+    mutex_unlock(&stream->lock);
+
+unlock_video:
+    mutex_unlock(&file->video_lock);
+    return rc;
+}
+
+/* The callback for each period of a cyclic transfer. This publishes the new
+ * period count to userspace, after the period's data. */
+static void axidma_cyclic_callback(void *data)
+{
+    struct axidma_cyclic_status *status;
+
+    status = data;
+    WRITE_ONCE(status->last_period, status->period_count % status->num_periods);
+    smp_store_release(&status->period_count, status->period_count + 1);
+}
+
+int axidma_cyclic_transfer(struct axidma_file *file,
+                           struct axidma_cyclic_transaction *trans)
+{
+    int rc;
+    dma_addr_t dma_addr;
+    dma_cookie_t dma_cookie;
+    enum dma_ctrl_flags dma_flags;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct dma_async_tx_descriptor *dma_txnd;
+    struct axidma_cyclic_status *status;
+
+    // Get the channel with the given id
+    dev = file->dev;
+    chan = axidma_get_chan(dev, trans->channel_id);
+    if (chan == NULL || chan->type != AXIDMA_DMA) {
+        axidma_err("Invalid device id %d for DMA channel.\n",
+                   trans->channel_id);
+        return -ENODEV;
+    }
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // The buffer must be split evenly into periods
+    if (trans->period_len == 0 || trans->buf_len % trans->period_len != 0) {
+        axidma_err("Buffer length %zu is not a multiple of the period length "
+                   "%zu.\n", trans->buf_len, trans->period_len);
+        return -EINVAL;
+    }
+
+    // Cyclic transfers can only use a physically contiguous buffer
+    dma_addr = axidma_uservirt_to_dma(file, trans->buf, trans->buf_len);
+    if (dma_addr == (dma_addr_t)NULL) {
+        axidma_err("Requested transfer address %p does not fall within a "
+                   "previously allocated DMA buffer.\n", trans->buf);
+        axidma_stats_error(dev, chan, AXIDMA_STATS_LOOKUP_MISS);
+        return -EFAULT;
+    }
+
+    /* Only one cyclic transfer can run on the channel, since the running one
+     * and userspace are still using the channel's status. */
+    if (test_and_set_bit(chan - dev->channels, file->cyclic_active)) {
+        axidma_err("Channel %d already has a cyclic transfer running.\n",
+                   trans->channel_id);
+        return -EBUSY;
+    }
+
+    status = &file->cyclic_status[chan - dev->channels];
+    dma_flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT;
+    dma_txnd = dmaengine_prep_dma_cyclic(chan->chan, dma_addr, trans->buf_len,
+            trans->period_len, axidma_to_dma_dir(chan->dir), dma_flags);
+    if (dma_txnd == NULL) {
+        axidma_err("Unable to prepare the cyclic DMA %s transaction.\n",
+                   axidma_dir_to_string(chan->dir));
+        axidma_stats_error(dev, chan, AXIDMA_STATS_PREP_FAILURE);
+        clear_bit(chan - dev->channels, file->cyclic_active);
+        return -EBUSY;
+    }
+    dma_txnd->callback = axidma_cyclic_callback;
+    dma_txnd->callback_param = status;
+
+    /* Submit the transfer. If that fails, terminate the channel, so that the
+     * descriptor that was prepared for it is freed. */
+    dma_cookie = dmaengine_submit(dma_txnd);
+    if (dma_submit_error(dma_cookie)) {
+        axidma_err("Unable to submit the cyclic DMA %s transaction.\n",
+                   axidma_dir_to_string(chan->dir));
+        axidma_stats_error(dev, chan, AXIDMA_STATS_SUBMIT_FAILURE);
+        axidma_terminate_chan(file, chan);
+        return -EBUSY;
+    }
+
+    /* Reset the channel's status, now that the transfer is queued, but before
+     * it is started, so that no period has completed yet. */
+    WRITE_ONCE(status->num_periods, trans->buf_len / trans->period_len);
+    WRITE_ONCE(status->last_period, 0);
+    WRITE_ONCE(status->period_count, 0);
+
+    // Start the transfer right away
+    trace_axidma_prep(trans->channel_id, dma_cookie, trans->buf_len, 0);
+    trace_axidma_issue(trans->channel_id, dma_cookie, trans->buf_len, 0);
+    dma_async_issue_pending(chan->chan);
+
+    // Tell userspace where to find the channel's status
+    trans->mmap_size = file->cyclic_size;
+    trans->status_offset = (chan - dev->channels) * sizeof(*status);
+    return 0;
+}
+
+int axidma_cyclic_mmap(struct axidma_file *file, struct vm_area_struct *vma)
+{
+    int rc;
+
+    // The status region must be mapped read-only, in its entirety
+    if (vma->vm_end - vma->vm_start != file->cyclic_size) {
+        axidma_err("The cyclic status mapping must be exactly %zu bytes.\n",
+                   file->cyclic_size);
+        return -EINVAL;
+    } else if (vma->vm_flags & VM_WRITE) {
+        axidma_err("The cyclic status mapping must be read-only.\n");
+        return -EPERM;
+    }
+
+    rc = remap_vmalloc_range(vma, file->cyclic_status, 0);
+    if (rc < 0) {
+        axidma_err("Unable to map the cyclic status into userspace.\n");
+        return rc;
+    }
+
+    vma->vm_flags &= ~VM_MAYWRITE;
+    vma->vm_flags |= VM_DONTCOPY;
+    return 0;
+}
+
+int axidma_cyclic_init(struct axidma_file *file)
+{
+    size_t size;
+
+    // Allocate a zeroed status for each channel, to be shared with userspace
+    size = file->dev->num_chans * sizeof(file->cyclic_status[0]);
+    file->cyclic_size = PAGE_ALIGN(size);
+    file->cyclic_status = vmalloc_user(file->cyclic_size);
+    if (file->cyclic_status == NULL) {
+        axidma_err("Unable to allocate the cyclic transfer status.\n");
+        return -ENOMEM;
+    }
+
+    /* Allocate an array for the video transfer on each channel, which also
+     * reports its frames through the status. */
+    file->video_streams = kcalloc(file->dev->num_chans,
+                                  sizeof(file->video_streams[0]), GFP_KERNEL);
+    if (file->video_streams == NULL) {
+        axidma_err("Unable to allocate the video transfer array.\n");
+        goto free_status;
+    }
+    mutex_init(&file->video_lock);
+
+    // Allocate the flags for the channels that have a cyclic transfer running
+    file->cyclic_active = kcalloc(BITS_TO_LONGS(file->dev->num_chans),
+                                  sizeof(file->cyclic_active[0]), GFP_KERNEL);
+    if (file->cyclic_active == NULL) {
+        axidma_err("Unable to allocate the cyclic transfer flags.\n");
+        goto free_video_streams;
+    }
+
+    return 0;
+
+free_video_streams:
+    kfree(file->video_streams);
+free_status:
+    vfree(file->cyclic_status);
+    return -ENOMEM;
+}
+
+// The file's channels must be stopped, so no more periods can complete
+void axidma_cyclic_exit(struct axidma_file *file)
+{
+    kfree(file->cyclic_active);
+    file->cyclic_active = NULL;
+    kfree(file->video_streams);
+    file->video_streams = NULL;
+    vfree(file->cyclic_status);
+    file->cyclic_status = NULL;
+}
+
+/* Stops all transfers on the channel, and completes the file's asynchronous
+ * transfers on it as canceled. */
+static int axidma_stop_chan(struct axidma_file *file, struct axidma_chan *chan)
+{
+    /* Stop the video transfer first, if any, so that its frame buffers aren't
+     * queued again. Then terminate all DMA transactions on the given channel,
+     * completing the asynchronous transfers that were discarded as canceled. */
+    axidma_video_stop(file, chan);
+    return axidma_terminate_chan(file, chan);
+}
+
+int axidma_stop_channel(struct axidma_file *file,
+                        struct axidma_chan *chan_info)
+{
+    int rc;
+    struct axidma_chan *chan;
+
+    // Get the transmit and receive channels with the given ids.
+    chan = axidma_get_chan(file->dev, chan_info->channel_id);
+    if (chan == NULL || chan->type != chan_info->type ||
+            chan->dir != chan_info->dir) {
+        axidma_err("Invalid channel id %d for %s %s channel.\n",
+            chan_info->channel_id, axidma_type_to_string(chan_info->type),
+            axidma_dir_to_string(chan_info->dir));
+        return -ENODEV;
+    }
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    return axidma_stop_chan(file, chan);
+}
+
+/* Claims the channel for exclusive use by the file. This only fails if another
+ * file already owns it. */
+int axidma_claim_channel(struct axidma_file *file, int channel_id)
+{
+    struct axidma_chan *chan;
+
+    chan = axidma_get_chan(file->dev, channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", channel_id);
+        return -ENODEV;
+    }
+
+    return axidma_own_chan(file, chan);
+}
+
+/* Releases the file's ownership of the channel, so that another file can use
+ * it. All transfers on the channel are stopped first. */
+int axidma_release_channel(struct axidma_file *file, int channel_id)
+{
+    int rc;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct axidma_file **owner;
+
+    dev = file->dev;
+    chan = axidma_get_chan(dev, channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", channel_id);
+        return -ENODEV;
+    }
+
+    owner = &dev->chan_owners[chan - dev->channels];
+    if (READ_ONCE(*owner) != file) {
+        axidma_err("Channel %d is not owned by this open file.\n", channel_id);
+        return -EINVAL;
+    }
+
+    // Hand the channel back to the DMA engine, if it has a BD ring
+    rc = axidma_bdring_release(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    rc = axidma_stop_chan(file, chan);
+    WRITE_ONCE(dev->poll_budgets[chan - dev->channels], 0);
+    axidma_reset_coalesce(dev, chan);
+    axidma_reset_affinity(dev, chan);
+    WRITE_ONCE(*owner, NULL);
+    return rc;
+}
+
+/* Checks if the file has any transfers on the channel that the DMA engine
+ * hasn't completed yet, including a cyclic transfer. */
+bool axidma_chan_pending(struct axidma_file *file, struct axidma_chan *chan)
+{
+    struct axidma_device *dev;
+
+    dev = file->dev;
+    return axidma_stats_inflight(dev, chan) > 0 ||
+           test_bit(chan - dev->channels, file->cyclic_active);
+}
+
+/* Drops anything the DMA engine has queued for the channel, and then resets
+ * it through the Xilinx driver, which also enables the channel's interrupts
+ * again. For AXI DMA, this resets the whole engine, so both of its channels
+ * must be reset. Only the reset flag of the config is used, so this is safe
+ * for AXI DMA channels, unlike the rest of the VDMA config. */
+int axidma_reset_chan(struct axidma_device *dev, struct axidma_chan *chan)
+{
+    int rc;
+    struct xilinx_vdma_config dma_config;
+
+    dmaengine_terminate_all(chan->chan);
+    dmaengine_synchronize(chan->chan);
+    axidma_stats_stop(dev, chan);
+
+    memset(&dma_config, 0, sizeof(dma_config));
+    dma_config.reset = 1;
+    rc = xilinx_vdma_channel_set_config(chan->chan, &dma_config);
+    if (rc < 0) {
+        axidma_err("Unable to reset channel %d.\n", chan->channel_id);
+        return rc;
+    }
+
+    return 0;
+}
+
+/* Sets how long synchronous transfers on the channel spin waiting for their
+ * completion, before sleeping. Only the file that owns the channel can. */
+int axidma_set_poll_budget(struct axidma_file *file,
+                           struct axidma_poll_budget *poll)
+{
+    int rc;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+
+    dev = file->dev;
+    chan = axidma_get_chan(dev, poll->channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", poll->channel_id);
+        return -ENODEV;
+    } else if (poll->budget_us > AXIDMA_MAX_POLL_BUDGET) {
+        axidma_err("Poll budget %u us is larger than the maximum of %d us.\n",
+                   poll->budget_us, AXIDMA_MAX_POLL_BUDGET);
+        return -EINVAL;
+    }
+
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    WRITE_ONCE(dev->poll_budgets[chan - dev->channels], poll->budget_us);
+    return 0;
+}
+
+/* Records the residue of the transfer that completed last on the channel. This
+ * may be called from the DMA engine's callback. */
+void axidma_set_residue(struct axidma_device *dev, struct axidma_chan *chan,
+                        size_t residue)
+{
+    WRITE_ONCE(dev->residues[chan - dev->channels], residue);
+}
+
+/* Gets the residue of the transfer that completed last on the channel, which
+ * is the number of bytes of its buffer that weren't transferred. */
+int axidma_get_residue(struct axidma_device *dev, struct axidma_residue *res)
+{
+    struct axidma_chan *chan;
+
+    chan = axidma_get_chan(dev, res->channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", res->channel_id);
+        return -ENODEV;
+    }
+
+    res->residue = READ_ONCE(dev->residues[chan - dev->channels]);
+    return 0;
+}
+
+/* Sets the interrupt threshold and delay timeout of the channel, so that its
+ * completions are delivered in groups. Only the file that owns the channel
+ * can. This is only supported for VDMA channels, which are configured when
+ * each transfer is prepared. */
+int axidma_set_coalesce(struct axidma_file *file,
+                        struct axidma_coalesce *coalesce)
+{
+    int rc;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct axidma_coalesce *chan_coalesce;
+
+    dev = file->dev;
+    chan = axidma_get_chan(dev, coalesce->channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", coalesce->channel_id);
+        return -ENODEV;
+    } else if (coalesce->threshold == 0 ||
+               coalesce->threshold > AXIDMA_MAX_COALESCE) {
+        axidma_err("Interrupt threshold %u is not between 1 and %d.\n",
+                   coalesce->threshold, AXIDMA_MAX_COALESCE);
+        return -EINVAL;
+    } else if (coalesce->delay > AXIDMA_MAX_COALESCE_DELAY) {
+        axidma_err("Interrupt delay %u is larger than the maximum of %d.\n",
+                   coalesce->delay, AXIDMA_MAX_COALESCE_DELAY);
+        return -EINVAL;
+    } else if (chan->type == AXIDMA_DMA &&
+               (coalesce->threshold != 1 || coalesce->delay != 0)) {
+        /* The Xilinx driver sets the threshold of an AXI DMA channel to the
+         * number of transfers issued together, and its only config function
+         * writes the VDMA layout of the control register, so only the default
+         * settings are accepted. */
+        axidma_err("Interrupt coalescing is only supported for VDMA "
+                   "channels.\n");
+        return -EINVAL;
+    }
+
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    chan_coalesce = &dev->coalesce[chan - dev->channels];
+    WRITE_ONCE(chan_coalesce->threshold, coalesce->threshold);
+    WRITE_ONCE(chan_coalesce->delay, coalesce->delay);
+    return 0;
+}
+
+/* Gets the CPUs that the channel's interrupt is handled on, and the CPU its
+ * completions are delivered to userspace from. Only the first 64 CPUs can be
+ * represented in the mask. */
+int axidma_get_affinity(struct axidma_device *dev,
+                        struct axidma_affinity *affinity)
+{
+    int cpu;
+    unsigned int irq;
+    const struct cpumask *mask;
+    struct axidma_chan *chan;
+
+    chan = axidma_get_chan(dev, affinity->channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", affinity->channel_id);
+        return -ENODEV;
+    }
+
+    irq = dev->chan_irqs[chan - dev->channels];
+    affinity->irq = irq;
+    affinity->irq_cpus = 0;
+    mask = (irq != 0) ? irq_get_affinity_mask(irq) : NULL;
+    if (mask != NULL) {
+        for_each_cpu(cpu, mask)
+        {
+            if (cpu < 8 * sizeof(affinity->irq_cpus)) {
+                affinity->irq_cpus |= 1ULL << cpu;
+            }
+        }
+    }
+
+    affinity->notify_cpu = READ_ONCE(dev->notify_cpus[chan - dev->channels]);
+    return 0;
+}
+
+/* Sets the CPUs that the channel's interrupt is handled on, if any are given,
+ * and the CPU its completions are delivered to userspace from. The interrupt
+ * belongs to the DMA engine's driver, so its affinity is set with a hint, which
+ * is applied right away and is also what irqbalance follows. Only the file that
+ * owns the channel can. */
+int axidma_set_affinity(struct axidma_file *file,
+                        struct axidma_affinity *affinity)
+{
+    int rc, cpu, idx;
+    unsigned int irq;
+    bool online;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct cpumask *mask;
+
+    dev = file->dev;
+    chan = axidma_get_chan(dev, affinity->channel_id);
+    cpu = affinity->notify_cpu;
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", affinity->channel_id);
+        return -ENODEV;
+    } else if (cpu != AXIDMA_NOTIFY_ANY_CPU &&
+               (cpu < 0 || cpu >= nr_cpu_ids || !cpu_online(cpu))) {
+        axidma_err("Notification CPU %d is not an online CPU.\n", cpu);
+        return -EINVAL;
+    }
+
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Steer the channel's interrupt to the given CPUs, if any
+    idx = chan - dev->channels;
+    irq = dev->chan_irqs[idx];
+    if (affinity->irq_cpus != 0) {
+        if (irq == 0) {
+            axidma_err("Channel %d has no interrupt to set the affinity of.\n",
+                       affinity->channel_id);
+            return -ENODEV;
+        }
+
+        // Check the mask before changing the hint, which the IRQ points to
+        online = false;
+        for (cpu = 0; cpu < 8 * sizeof(affinity->irq_cpus); cpu++)
+        {
+            if ((affinity->irq_cpus & (1ULL << cpu)) && cpu < nr_cpu_ids) {
+                online = online || cpu_online(cpu);
+            }
+        }
+        if (!online) {
+            axidma_err("Interrupt CPU mask 0x%llx has no online CPUs.\n",
+                       affinity->irq_cpus);
+            return -EINVAL;
+        }
+
+        mask = &dev->irq_masks[idx];
+        cpumask_clear(mask);
+        for (cpu = 0; cpu < 8 * sizeof(affinity->irq_cpus); cpu++)
+        {
+            if ((affinity->irq_cpus & (1ULL << cpu)) && cpu < nr_cpu_ids) {
+                cpumask_set_cpu(cpu, mask);
+            }
+        }
+        rc = irq_set_affinity_hint(irq, mask);
+        if (rc < 0) {
+            axidma_err("Unable to set the affinity of interrupt %u.\n", irq);
+            return rc;
+        }
+    }
+
+    WRITE_ONCE(dev->notify_cpus[idx], affinity->notify_cpu);
+    return 0;
+}
+
+/* Stops all transfers on the channels owned by the file, and releases them.
+ * This is called when the file is closed, so the asynchronous transfers that
+ * were stopped are discarded, without notifying userspace. */
+void axidma_release_channels(struct axidma_file *file)
+{
+    int i;
+    struct axidma_device *dev;
+    struct dma_chan *chan;
+    struct axidma_cb_data *cb_data, *tmp;
+
+    dev = file->dev;
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        if (READ_ONCE(dev->chan_owners[i]) != file) {
+            continue;
+        }
+
+        chan = dev->channels[i].chan;
+        axidma_video_stop(file, &dev->channels[i]);
+        dmaengine_terminate_all(chan);
+        dmaengine_synchronize(chan);
+        axidma_stats_stop(dev, &dev->channels[i]);
+        clear_bit(i, file->cyclic_active);
+        WRITE_ONCE(dev->poll_budgets[i], 0);
+        axidma_reset_coalesce(dev, &dev->channels[i]);
+        axidma_reset_affinity(dev, &dev->channels[i]);
+        WRITE_ONCE(dev->chan_owners[i], NULL);
+    }
+
+    // Free the callback data for the asynchronous transfers that were stopped
+    list_for_each_entry_safe(cb_data, tmp, &file->async_transfers, list)
+    {
+        list_del(&cb_data->list);
+        kfree(cb_data);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Prepared Transfers
+ *----------------------------------------------------------------------------*/
+
+/* A transfer of a buffer on a channel, prepared to be submitted many times.
+ * The buffer's DMA address is looked up once, and only again if one of the
+ * file's buffers was removed since, as the buffer may be gone. */
+struct axidma_prepared {
+    struct axidma_chan *chan;       // The channel to transfer on
+    void *buf;                      // The buffer used for the transfers
+    size_t buf_len;                 // The length of the buffer
+    struct scatterlist sg_entry;    // The buffer's DMA address and length
+    unsigned int dmabuf_gen;        // The buffer generation it was found in
+};
+
+int axidma_prepare_transfer(struct axidma_file *file,
+                            struct axidma_prepared_transfer *prepared)
+{
+    int rc, handle;
+    struct axidma_chan *chan;
+    struct axidma_prepared *prep;
+
+    chan = axidma_get_chan(file->dev, prepared->channel_id);
+    if (chan == NULL || chan->type != AXIDMA_DMA) {
+        axidma_err("Invalid device id %d for DMA channel.\n",
+                   prepared->channel_id);
+        return -ENODEV;
+    }
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    prep = kmalloc(sizeof(*prep), GFP_KERNEL);
+    if (prep == NULL) {
+        axidma_err("Unable to allocate the prepared transfer.\n");
+        return -ENOMEM;
+    }
+
+    /* Look up the buffer once. The generation is read first, so a buffer
+     * removed during the lookup makes the next submission look it up again. */
+    prep->chan = chan;
+    prep->buf = prepared->buf;
+    prep->buf_len = prepared->buf_len;
+    prep->dmabuf_gen = READ_ONCE(file->dmabuf_gen);
+    sg_init_table(&prep->sg_entry, 1);
+    rc = axidma_init_sg_entry(file, chan, &prep->sg_entry, 0, prep->buf,
+                              prep->buf_len);
+    if (rc < 0) {
+        goto free_prep;
+    }
+
+    // Allocate a handle for the transfer
+    idr_preload(GFP_KERNEL);
+    spin_lock(&file->prepared_lock);
+    handle = idr_alloc(&file->prepared, prep, 0, 0, GFP_NOWAIT);
+    spin_unlock(&file->prepared_lock);
+    idr_preload_end();
+    if (handle < 0) {
+        axidma_err("Unable to allocate a handle for the prepared transfer.\n");
+        rc = handle;
+        goto free_prep;
+    }
+
+    prepared->handle = handle;
+    return 0;
+
+free_prep:
+    kfree(prep);
+    return rc;
+}
+
+int axidma_submit_prepared(struct axidma_file *file,
+                           struct axidma_prepared_submit *submit)
+{
+    int rc;
+    unsigned int dmabuf_gen;
+    struct axidma_chan *chan;
+    struct axidma_prepared *prep;
+    struct scatterlist sg_list;
+    struct axidma_transfer dma_tfr;
+
+    /* Copy out the prepared transfer, first looking up its buffer again if
+     * any buffer of the file was removed since it was last looked up. */
+    spin_lock(&file->prepared_lock);
+    prep = idr_find(&file->prepared, submit->handle);
+    if (prep == NULL) {
+        spin_unlock(&file->prepared_lock);
+        axidma_err("Invalid prepared transfer handle %d.\n", submit->handle);
+        return -EINVAL;
+    }
+    dmabuf_gen = READ_ONCE(file->dmabuf_gen);
+    if (prep->dmabuf_gen != dmabuf_gen) {
+        rc = axidma_init_sg_entry(file, prep->chan, &prep->sg_entry, 0,
+                                  prep->buf, prep->buf_len);
+        if (rc < 0) {
+            spin_unlock(&file->prepared_lock);
+            return rc;
+        }
+        prep->dmabuf_gen = dmabuf_gen;
+    }
+    chan = prep->chan;
+    sg_list = prep->sg_entry;
+    spin_unlock(&file->prepared_lock);
+
+    // The channel may have been released and claimed by another file since
+    rc = axidma_own_chan(file, chan);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Setup the transfer structure for DMA
+    dma_tfr.sg_list = &sg_list;
+    dma_tfr.sg_len = 1;
+    dma_tfr.dir = chan->dir;
+    dma_tfr.type = chan->type;
+    dma_tfr.wait = submit->wait;
+    dma_tfr.timeout = submit->timeout;
+    dma_tfr.channel_id = chan->channel_id;
+    dma_tfr.notify_signal = file->notify_signal;
+    dma_tfr.process = get_current();
+
+    // Prepare the descriptor for the transfer, and submit it to the engine
+    rc = axidma_prep_transfer(file, chan, &dma_tfr);
+    if (rc < 0) {
+        return rc;
+    }
+    submit->cookie = dma_tfr.cookie;
+
+    // Start the transfer, and wait for it to complete if requested
+    rc = axidma_start_transfer(file, chan, &dma_tfr);
+    submit->bytes = dma_tfr.bytes;
+    return rc;
+}
+
+int axidma_unprepare_transfer(struct axidma_file *file, int handle)
+{
+    struct axidma_prepared *prep;
+
+    spin_lock(&file->prepared_lock);
+    prep = idr_find(&file->prepared, handle);
+    if (prep != NULL) {
+        idr_remove(&file->prepared, handle);
+    }
+    spin_unlock(&file->prepared_lock);
+
+    if (prep == NULL) {
+        axidma_err("Invalid prepared transfer handle %d.\n", handle);
+        return -EINVAL;
+    }
+
+    kfree(prep);
+    return 0;
+}
+
+// Frees all of the file's prepared transfers, when it is closed
+void axidma_prepared_exit(struct axidma_file *file)
+{
+    int handle;
+    struct axidma_prepared *prep;
+
+    idr_for_each_entry(&file->prepared, prep, handle)
+    {
+        kfree(prep);
+    }
+    idr_destroy(&file->prepared);
+}
+
+/*----------------------------------------------------------------------------
+ * Initialization and Cleanup
+ *----------------------------------------------------------------------------*/
+
+static int axidma_request_channels(struct platform_device *pdev,
+                                   struct axidma_device *dev)
+{
+    int rc, i;
+    int num_reserved_chans;
+    struct axidma_chan *chan;
+
+    // For each channel, request exclusive access to the channel
+    num_reserved_chans = 0;
+    for (i = 0; i < dev->num_chans; i++)
     {
         chan = &dev->channels[i];
         chan->chan = dma_request_slave_channel(&pdev->dev, chan->name);
@@ -668,7 +2328,7 @@ release_channels:
 
 int axidma_dma_init(struct platform_device *pdev, struct axidma_device *dev)
 {
-    int rc;
+    int rc, i;
     size_t elem_size;
     u64 dma_mask;
 
@@ -693,25 +2353,107 @@ int axidma_dma_init(struct platform_device *pdev, struct axidma_device *dev)
         return -ENOMEM;
     }
 
-    // Allocate an array to store all callback structures, for async
-    elem_size = sizeof(dev->cb_data[0]);
-    dev->cb_data = kmalloc(dev->num_chans * elem_size, GFP_KERNEL);
-    if (dev->cb_data == NULL) {
-        axidma_err("Unable to allocate memory for callback structures.\n");
+    // Allocate an array to track which file owns each channel
+    elem_size = sizeof(dev->chan_owners[0]);
+    dev->chan_owners = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->chan_owners == NULL) {
+        axidma_err("Unable to allocate memory for the channel owners.\n");
         rc = -ENOMEM;
         goto free_channels;
     }
 
+    // Allocate an array for the busy-poll budget of each channel
+    elem_size = sizeof(dev->poll_budgets[0]);
+    dev->poll_budgets = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->poll_budgets == NULL) {
+        axidma_err("Unable to allocate memory for the poll budgets.\n");
+        rc = -ENOMEM;
+        goto free_chan_owners;
+    }
+
+    // Allocate an array for the interrupt coalescing of each channel
+    elem_size = sizeof(dev->coalesce[0]);
+    dev->coalesce = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->coalesce == NULL) {
+        axidma_err("Unable to allocate memory for the channel coalescing.\n");
+        rc = -ENOMEM;
+        goto free_poll_budgets;
+    }
+
+    // Allocate an array for the residue of the last transfer on each channel
+    elem_size = sizeof(dev->residues[0]);
+    dev->residues = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->residues == NULL) {
+        axidma_err("Unable to allocate memory for the channel residues.\n");
+        rc = -ENOMEM;
+        goto free_coalesce;
+    }
+
+    // Allocate an array for the physical address of each channel's registers
+    elem_size = sizeof(dev->chan_regs[0]);
+    dev->chan_regs = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->chan_regs == NULL) {
+        axidma_err("Unable to allocate memory for the channel registers.\n");
+        rc = -ENOMEM;
+        goto free_residues;
+    }
+
+    // Allocate an array for the userspace BD ring of each channel
+    elem_size = sizeof(dev->bdrings[0]);
+    dev->bdrings = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->bdrings == NULL) {
+        axidma_err("Unable to allocate memory for the channel BD rings.\n");
+        rc = -ENOMEM;
+        goto free_chan_regs;
+    }
+    mutex_init(&dev->bdring_lock);
+
+    // Allocate an array for the interrupt number of each channel
+    elem_size = sizeof(dev->chan_irqs[0]);
+    dev->chan_irqs = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->chan_irqs == NULL) {
+        axidma_err("Unable to allocate memory for the channel interrupts.\n");
+        rc = -ENOMEM;
+        goto free_bdrings;
+    }
+
+    // Allocate an array for the interrupt affinity hint of each channel
+    elem_size = sizeof(dev->irq_masks[0]);
+    dev->irq_masks = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->irq_masks == NULL) {
+        axidma_err("Unable to allocate memory for the interrupt masks.\n");
+        rc = -ENOMEM;
+        goto free_chan_irqs;
+    }
+
+    // Allocate an array for the CPU each channel's completions notify from
+    elem_size = sizeof(dev->notify_cpus[0]);
+    dev->notify_cpus = kcalloc(dev->num_chans, elem_size, GFP_KERNEL);
+    if (dev->notify_cpus == NULL) {
+        axidma_err("Unable to allocate memory for the notification CPUs.\n");
+        rc = -ENOMEM;
+        goto free_irq_masks;
+    }
+
     // Parse the type and direction of each DMA channel from the device tree
     rc = axidma_of_parse_dma_nodes(pdev, dev);
     if (rc < 0) {
         return rc;
     }
 
+    // By default, each channel interrupts once for every transfer
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        dev->coalesce[i].channel_id = dev->channels[i].channel_id;
+        dev->coalesce[i].threshold = 1;
+        dev->coalesce[i].delay = 0;
+        dev->notify_cpus[i] = AXIDMA_NOTIFY_ANY_CPU;
+    }
+
     // Exclusively request all of the channels in the device tree entry
     rc = axidma_request_channels(pdev, dev);
     if (rc < 0) {
-        goto free_callback_data;
+        goto free_notify_cpus;
     }
 
     axidma_info("DMA: Found %d transmit channels and %d receive channels.\n",
@@ -720,8 +2462,24 @@ int axidma_dma_init(struct platform_device *pdev, struct axidma_device *dev)
                 dev->num_vdma_tx_chans, dev->num_vdma_rx_chans);
     return 0;
 
-free_callback_data:
-    kfree(dev->cb_data);
+free_notify_cpus:
+    kfree(dev->notify_cpus);
+free_irq_masks:
+    kfree(dev->irq_masks);
+free_chan_irqs:
+    kfree(dev->chan_irqs);
+free_bdrings:
+    kfree(dev->bdrings);
+free_chan_regs:
+    kfree(dev->chan_regs);
+free_residues:
+    kfree(dev->residues);
+free_coalesce:
+    kfree(dev->coalesce);
+free_poll_budgets:
+    kfree(dev->poll_budgets);
+free_chan_owners:
+    kfree(dev->chan_owners);
 free_channels:
     kfree(dev->channels);
     return rc;
@@ -737,12 +2495,28 @@ void axidma_dma_exit(struct axidma_device *dev)
     {
         chan = dev->channels[i].chan;
         dmaengine_terminate_all(chan);
+        dmaengine_synchronize(chan);
         dma_release_channel(chan);
     }
 
-    // Free the channel and callback data arrays
+    // Reset the affinity that was set on the channels' interrupts
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        axidma_reset_affinity(dev, &dev->channels[i]);
+    }
+
+    /* Free the channel, owner, poll budget, coalescing, residue, register,
+     * BD ring, interrupt, and notification arrays. */
     kfree(dev->channels);
-    kfree(dev->cb_data);
+    kfree(dev->chan_owners);
+    kfree(dev->poll_budgets);
+    kfree(dev->coalesce);
+    kfree(dev->residues);
+    kfree(dev->chan_regs);
+    kfree(dev->bdrings);
+    kfree(dev->chan_irqs);
+    kfree(dev->irq_masks);
+    kfree(dev->notify_cpus);
 
     return;
 }
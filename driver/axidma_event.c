@@ -0,0 +1,341 @@
+/**
+ * @file axidma_event.c
+ * @date Wednesday, October 14, 2026 at 01:47:05 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the implementation of the completion event queue for the
+ * AXI DMA module. This allows userspace to wait for asynchronous transfers to
+ * complete with poll() or an eventfd, and read their completions from the
+ * device, instead of receiving a signal for each one.
+ *
+ * @bug No known bugs.
+ **/
+
+// Kernel dependencies
+#include <linux/kernel.h>           // Container and min/max macros
+#include <linux/kfifo.h>            // FIFO definitions and functions
+#include <linux/eventfd.h>          // Eventfd context functions
+#include <linux/poll.h>             // Poll table definitions and functions
+#include <linux/fs.h>               // File operations and file types
+#include <linux/slab.h>             // Allocation functions
+#include <linux/spinlock.h>         // Spinlock definitions and functions
+#include <linux/mutex.h>            // Mutex definitions and functions
+#include <linux/wait.h>             // Wait queue definitions and functions
+#include <linux/sched.h>            // Signal pending functions
+#include <linux/uaccess.h>          // Userspace memory access functions
+#include <linux/err.h>              // Error pointer functions
+#include <linux/errno.h>            // Linux error codes
+#include <linux/workqueue.h>        // Work queue definitions and functions
+#include <linux/cpumask.h>          // CPU numbering and online functions
+#include <linux/printk.h>           // Ratelimited printing functions
+
+// Local dependencies
+#include "axidma.h"                 // Internal definitions
+#include "axidma_ioctl.h"           // IOCTL interface definition and types
+
+/*----------------------------------------------------------------------------
+ * Internal Definitions
+ *----------------------------------------------------------------------------*/
+
+// The number of completion events that can be queued (must be a power of 2)
+#define AXIDMA_EVENT_QUEUE_SIZE     1024
+
+// The work to notify userspace of completions from a particular CPU
+struct axidma_notify_work {
+    struct work_struct work;        // Queued on the CPU to notify from
+    struct axidma_file *file;       // The file to notify
+};
+
+// The completion events for asynchronous transfers, and how they are delivered
+struct axidma_event_queue {
+    unsigned int flags;             // The notification flags for the device
+    struct eventfd_ctx *eventfd;    // The eventfd signaled on completion
+    DECLARE_KFIFO_PTR(fifo, struct axidma_cqe); // The queued events
+    unsigned int dropped;           // Events dropped since the last read
+    spinlock_t lock;                // Serializes writers and the eventfd
+    struct mutex read_lock;         // Serializes readers of the queue
+    wait_queue_head_t wait;         // Waiters for completion events
+    struct axidma_notify_work *works;   // The notification work for each CPU
+};
+
+/*----------------------------------------------------------------------------
+ * Private Helper Functions
+ *----------------------------------------------------------------------------*/
+
+// Wakes up the waiters for completions, from the CPU the work is queued on
+static void axidma_notify_work(struct work_struct *work)
+{
+    struct axidma_notify_work *notify_work;
+
+    notify_work = container_of(work, struct axidma_notify_work, work);
+    axidma_ring_wake(notify_work->file);
+    axidma_event_notify(notify_work->file);
+}
+
+/*----------------------------------------------------------------------------
+ * Event Operations (Public Interface)
+ *----------------------------------------------------------------------------*/
+
+/* Sets how asynchronous transfer completions are reported to userspace. The
+ * eventfd, if one is given, replaces any previously registered one. */
+int axidma_set_notify(struct axidma_file *file, struct axidma_notify *notify)
+{
+    unsigned long flags;
+    struct eventfd_ctx *eventfd, *old_eventfd;
+    struct axidma_event_queue *events;
+
+    events = file->events;
+    if ((notify->flags & ~AXIDMA_NOTIFY_FLAGS) != 0) {
+        axidma_err("Invalid notification flags 0x%x.\n", notify->flags);
+        return -EINVAL;
+    }
+
+    // Get the context for the eventfd, if the user specified one
+    eventfd = NULL;
+    if (notify->eventfd >= 0) {
+        eventfd = eventfd_ctx_fdget(notify->eventfd);
+        if (IS_ERR(eventfd)) {
+            axidma_err("File descriptor %d is not an eventfd.\n",
+                       notify->eventfd);
+            return PTR_ERR(eventfd);
+        }
+    }
+
+    spin_lock_irqsave(&events->lock, flags);
+    old_eventfd = events->eventfd;
+    events->eventfd = eventfd;
+    events->flags = notify->flags;
+    spin_unlock_irqrestore(&events->lock, flags);
+
+    if (old_eventfd != NULL) {
+        eventfd_ctx_put(old_eventfd);
+    }
+    return 0;
+}
+
+// Returns true if the completions should be delivered with a signal
+bool axidma_notify_signal(struct axidma_file *file)
+{
+    return (READ_ONCE(file->events->flags) & AXIDMA_NOTIFY_SIGNAL) != 0;
+}
+
+/* Notifies userspace that completions are available, by signaling the eventfd
+ * and waking up anyone polling or reading the device. */
+void axidma_event_notify(struct axidma_file *file)
+{
+    unsigned long flags;
+    struct axidma_event_queue *events;
+
+    events = file->events;
+    spin_lock_irqsave(&events->lock, flags);
+    if (events->eventfd != NULL) {
+        eventfd_signal(events->eventfd, 1);
+    }
+    spin_unlock_irqrestore(&events->lock, flags);
+    wake_up_interruptible(&events->wait);
+}
+
+/* Notifies userspace of a completion on the channel, waking up the waiters on
+ * both the events and the CQ. If the channel's wakeups are steered to another
+ * CPU, they are done from a work item queued there, which also batches the
+ * wakeups for the completions that happen before it runs. */
+void axidma_event_complete(struct axidma_file *file, struct axidma_chan *chan)
+{
+    int cpu;
+    struct axidma_device *dev;
+
+    dev = file->dev;
+    cpu = (chan == NULL) ? AXIDMA_NOTIFY_ANY_CPU :
+          READ_ONCE(dev->notify_cpus[chan - dev->channels]);
+    if (cpu == AXIDMA_NOTIFY_ANY_CPU || cpu == raw_smp_processor_id()) {
+        axidma_ring_wake(file);
+        axidma_event_notify(file);
+        return;
+    }
+
+    queue_work_on(cpu, system_highpri_wq, &file->events->works[cpu].work);
+}
+
+/* Queues the completion event for an asynchronous transfer, if enabled, and
+ * notifies userspace. This may be called from the DMA engine's callback. */
+void axidma_event_post(struct axidma_file *file, struct axidma_cqe *event)
+{
+    unsigned long flags;
+    bool queued;
+    struct axidma_event_queue *events;
+
+    events = file->events;
+    if (!(READ_ONCE(events->flags) & AXIDMA_NOTIFY_QUEUE)) {
+        return;
+    }
+
+    /* If the queue is full, the event is counted as dropped, so that the next
+     * read reports the overflow. The waiters are still woken up for it. */
+    spin_lock_irqsave(&events->lock, flags);
+    queued = kfifo_put(&events->fifo, *event);
+    if (!queued) {
+        events->dropped++;
+    }
+    spin_unlock_irqrestore(&events->lock, flags);
+
+    if (!queued) {
+        axidma_err_ratelimited("Completion event queue is full, dropping the "
+                               "event for channel %d.\n", event->channel_id);
+    }
+    axidma_event_complete(file, axidma_get_chan(file->dev, event->channel_id));
+}
+
+// Checks if there are any queued or dropped events to read
+static bool axidma_event_pending(struct axidma_event_queue *events)
+{
+    return !kfifo_is_empty(&events->fifo) || READ_ONCE(events->dropped) != 0;
+}
+
+// Checks if there are any events to read, or completions in the CQ
+static bool axidma_event_ready(struct axidma_file *file)
+{
+    return axidma_event_pending(file->events) || axidma_ring_ready(file) > 0;
+}
+
+unsigned int axidma_event_poll(struct axidma_file *file, struct file *filp,
+                               poll_table *wait)
+{
+    unsigned int mask;
+
+    poll_wait(filp, &file->events->wait, wait);
+
+    mask = 0;
+    if (axidma_event_ready(file)) {
+        mask |= POLLIN | POLLRDNORM;
+    }
+    return mask;
+}
+
+/* Reads as many queued completion events as fit in the user's buffer. Blocks
+ * until at least one event is available, unless nonblock is specified. If any
+ * events were dropped since the last read, this fails with -EOVERFLOW instead,
+ * and the events that were queued are returned by the next read. */
+ssize_t axidma_event_read(struct axidma_file *file, char __user *buf,
+                          size_t count, bool nonblock)
+{
+    int rc;
+    unsigned long flags;
+    unsigned int copied, dropped;
+    struct axidma_event_queue *events;
+
+    events = file->events;
+    if (count < sizeof(struct axidma_cqe)) {
+        axidma_err("The read buffer must hold at least one event.\n");
+        return -EINVAL;
+    }
+    count -= count % sizeof(struct axidma_cqe);
+
+    if (mutex_lock_interruptible(&events->read_lock) != 0) {
+        return -ERESTARTSYS;
+    }
+
+    // Wait for an event to be posted or dropped, if there are none
+    while (!axidma_event_pending(events))
+    {
+        mutex_unlock(&events->read_lock);
+        if (nonblock) {
+            return -EAGAIN;
+        }
+
+        rc = wait_event_interruptible(events->wait,
+                                      axidma_event_pending(events));
+        if (rc < 0) {
+            return rc;
+        }
+        if (mutex_lock_interruptible(&events->read_lock) != 0) {
+            return -ERESTARTSYS;
+        }
+    }
+
+    // Report the overflow once, and reset the count for the next one
+    spin_lock_irqsave(&events->lock, flags);
+    dropped = events->dropped;
+    events->dropped = 0;
+    spin_unlock_irqrestore(&events->lock, flags);
+    if (dropped != 0) {
+        mutex_unlock(&events->read_lock);
+        return -EOVERFLOW;
+    }
+
+    rc = kfifo_to_user(&events->fifo, buf, count, &copied);
+    mutex_unlock(&events->read_lock);
+
+    return (rc < 0) ? rc : copied;
+}
+
+/*----------------------------------------------------------------------------
+ * Initialization and Cleanup
+ *----------------------------------------------------------------------------*/
+
+int axidma_event_init(struct axidma_file *file)
+{
+    int rc, cpu;
+    struct axidma_event_queue *events;
+
+    // Allocate the file's event queue, by default completions are signaled
+    events = kzalloc(sizeof(*events), GFP_KERNEL);
+    if (events == NULL) {
+        axidma_err("Unable to allocate the event queue structure.\n");
+        return -ENOMEM;
+    }
+    events->flags = AXIDMA_NOTIFY_SIGNAL;
+    spin_lock_init(&events->lock);
+    mutex_init(&events->read_lock);
+    init_waitqueue_head(&events->wait);
+
+    rc = kfifo_alloc(&events->fifo, AXIDMA_EVENT_QUEUE_SIZE, GFP_KERNEL);
+    if (rc < 0) {
+        axidma_err("Unable to allocate the completion event queue.\n");
+        goto free_events;
+    }
+
+    // Allocate the work to notify from each CPU, for steered completions
+    events->works = kcalloc(nr_cpu_ids, sizeof(events->works[0]), GFP_KERNEL);
+    if (events->works == NULL) {
+        axidma_err("Unable to allocate the notification work.\n");
+        rc = -ENOMEM;
+        goto free_fifo;
+    }
+    for (cpu = 0; cpu < nr_cpu_ids; cpu++)
+    {
+        INIT_WORK(&events->works[cpu].work, axidma_notify_work);
+        events->works[cpu].file = file;
+    }
+
+    file->events = events;
+    return 0;
+
+free_fifo:
+    kfifo_free(&events->fifo);
+free_events:
+    kfree(events);
+    return rc;
+}
+
+/* Frees the event queue. The file's channels must have been released, so that
+ * no more notification work is queued. */
+void axidma_event_exit(struct axidma_file *file)
+{
+    int cpu;
+    struct axidma_event_queue *events;
+
+    events = file->events;
+    for (cpu = 0; cpu < nr_cpu_ids; cpu++)
+    {
+        cancel_work_sync(&events->works[cpu].work);
+    }
+    kfree(events->works);
+
+    if (events->eventfd != NULL) {
+        eventfd_ctx_put(events->eventfd);
+    }
+    kfifo_free(&events->fifo);
+    kfree(events);
+    file->events = NULL;
+}
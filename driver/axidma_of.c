@@ -12,7 +12,11 @@
 
 // Kernel Dependencies
 #include <linux/of.h>               // Device tree parsing functions
+#include <linux/of_address.h>       // Device tree address parsing functions
+#include <linux/of_irq.h>           // Device tree interrupt parsing functions
 #include <linux/platform_device.h>  // Platform device definitions
+#include <linux/genalloc.h>         // Memory pool allocator functions
+#include <linux/ioport.h>           // Resource structure definitions
 
 // Local Dependencies
 #include "axidma.h"                 // Internal Definitions
@@ -124,6 +128,39 @@ static int axidma_of_parse_channel(struct device_node *dma_node, int channel,
         return rc;
     }
 
+    /* Find the channel's interrupt, which is requested by the DMA engine's
+     * driver, so that its affinity can be set. This is 0 if there is none. */
+    dev->chan_irqs[chan - dev->channels] = irq_of_parse_and_map(dma_chan_node,
+                                                                0);
+    return 0;
+}
+
+/* Finds the physical address of the channel's registers, for userspace BD
+ * rings. These are only supported on AXI DMA engines with scatter-gather, so
+ * for any other channel, the address is left as 0. */
+static int axidma_of_parse_regs(struct device_node *dma_node,
+        struct axidma_chan *chan, phys_addr_t *chan_regs)
+{
+    int rc;
+    struct resource res;
+
+    *chan_regs = 0;
+    if (chan->type != AXIDMA_DMA ||
+            !of_property_read_bool(dma_node, "xlnx,include-sg")) {
+        return 0;
+    }
+
+    rc = of_address_to_resource(dma_node, 0, &res);
+    if (rc < 0) {
+        axidma_node_err(dma_node, "Unable to get the 'reg' property.\n");
+        return rc;
+    }
+
+    // The receive channel's registers follow the transmit channel's
+    *chan_regs = res.start;
+    if (chan->dir == AXIDMA_READ) {
+        *chan_regs += AXIDMA_S2MM_REG_OFFSET;
+    }
     return 0;
 }
 
@@ -150,6 +187,63 @@ static int axidma_check_unique_ids(struct axidma_device *dev)
     return 0;
 }
 
+/* Parses the optional 'memory-region' property, which refers to a reserved
+ * memory node that DMA buffers are allocated from, instead of CMA. The region
+ * is managed with a memory pool, whose addresses are the physical addresses. */
+static int axidma_of_parse_memory_region(struct platform_device *pdev,
+                                         struct axidma_device *dev)
+{
+    int rc;
+    bool no_map;
+    struct resource res;
+    struct device_node *driver_node, *mem_node;
+
+    // If there is no reserved region, then buffers are allocated from CMA
+    driver_node = pdev->dev.of_node;
+    dev->mem_pool = NULL;
+    mem_node = of_parse_phandle(driver_node, "memory-region", 0);
+    if (mem_node == NULL) {
+        return 0;
+    }
+
+    // Get the physical address range of the region
+    rc = of_address_to_resource(mem_node, 0, &res);
+    no_map = of_property_read_bool(mem_node, "no-map");
+    of_node_put(mem_node);
+    if (rc < 0) {
+        axidma_node_err(driver_node, "Unable to get the address range of the "
+                        "'memory-region' node.\n");
+        return rc;
+    }
+
+    /* The region is mapped uncached into userspace, so it must not be in the
+     * kernel's linear mapping, which is cached. */
+    if (!no_map) {
+        axidma_node_err(driver_node, "The 'memory-region' node must have the "
+                        "'no-map' property.\n");
+        return -EINVAL;
+    }
+
+    // Create a pool to allocate DMA buffers from the region, in whole pages
+    dev->mem_pool = devm_gen_pool_create(&pdev->dev, PAGE_SHIFT, -1,
+                                         MODULE_NAME);
+    if (IS_ERR(dev->mem_pool)) {
+        axidma_err("Unable to create the reserved memory pool.\n");
+        rc = PTR_ERR(dev->mem_pool);
+        dev->mem_pool = NULL;
+        return rc;
+    }
+
+    rc = gen_pool_add(dev->mem_pool, res.start, resource_size(&res), -1);
+    if (rc < 0) {
+        axidma_err("Unable to add the reserved memory region to the pool.\n");
+        return rc;
+    }
+
+    axidma_info("Using reserved memory region %pR for DMA buffers.\n", &res);
+    return 0;
+}
+
 /*----------------------------------------------------------------------------
  * Public Interface
  *----------------------------------------------------------------------------*/
@@ -250,6 +344,13 @@ int axidma_of_parse_dma_nodes(struct platform_device *pdev,
             return rc;
         }
 
+        // Find the channel's registers, for userspace BD rings
+        rc = axidma_of_parse_regs(dma_node, &dev->channels[i],
+                                  &dev->chan_regs[i]);
+        if (rc < 0) {
+            return rc;
+        }
+
         // Parse the name of the channel
         rc = axidma_of_parse_dma_name(driver_node, i, &dev->channels[i]);
         if (rc < 0) {
@@ -258,5 +359,11 @@ int axidma_of_parse_dma_nodes(struct platform_device *pdev,
     }
 
     // Check that all channels have unique channel ID's
-    return axidma_check_unique_ids(dev);
+    rc = axidma_check_unique_ids(dev);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Parse the reserved memory region for DMA buffers, if there is one
+    return axidma_of_parse_memory_region(pdev, dev);
 }
@@ -0,0 +1,555 @@
+/**
+ * @file axidma_ring.c
+ * @date Wednesday, October 14, 2026 at 10:12:31 AM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the implementation of the submission and completion rings
+ * that are shared between userspace and the AXI DMA module. These allow for
+ * transfers to be submitted and completed without a system call per transfer.
+ *
+ * @bug No known bugs.
+ **/
+
+// Kernel dependencies
+#include <linux/kernel.h>           // Container and min/max macros
+#include <linux/log2.h>             // Power of two helpers
+#include <linux/cache.h>            // Cache line alignment macros
+#include <linux/list.h>             // Linked list definitions and functions
+#include <linux/mm.h>               // Memory types and remapping functions
+#include <linux/vmalloc.h>          // Allocation of user-mappable memory
+#include <linux/slab.h>             // Allocation functions
+#include <linux/spinlock.h>         // Spinlock definitions and functions
+#include <linux/mutex.h>            // Mutex definitions and functions
+#include <linux/wait.h>             // Wait queue definitions and functions
+#include <linux/kthread.h>          // Kernel thread functions
+#include <linux/sched.h>            // Scheduling functions
+#include <linux/jiffies.h>          // Jiffies conversion functions
+#include <linux/errno.h>            // Linux error codes
+#include <linux/dmaengine.h>        // DMA types and functions
+
+// Local dependencies
+#include "axidma.h"                 // Internal definitions
+#include "axidma_ioctl.h"           // IOCTL interface definition and types
+#include "axidma_trace.h"           // Tracepoint definitions
+
+/*----------------------------------------------------------------------------
+ * Internal Definitions
+ *----------------------------------------------------------------------------*/
+
+// The default time the SQ polling thread spins before going to sleep
+#define AXIDMA_SQ_IDLE_DEFAULT      1000
+
+// The state for a single transfer submitted through the rings
+struct axidma_ring_req {
+    struct axidma_ring *ring;       // The rings the transfer was submitted to
+    void *user_data;                // The user data from the SQ entry
+    int channel_id;                 // The id of the channel used
+    dma_cookie_t cookie;            // The DMA cookie for the transfer
+    size_t buf_len;                 // The length of the buffer
+    struct list_head list;          // Node for the free or in-flight list
+};
+
+// The submission and completion rings shared with userspace
+struct axidma_ring {
+    struct axidma_file *file;       // The file the rings belong to
+    void *mem;                      // The memory region shared with userspace
+    size_t mem_size;                // The size of the shared memory region
+    struct axidma_ring_header *hdr; // The header at the start of the region
+    struct axidma_sqe *sqes;        // The submission queue entries
+    struct axidma_cqe *cqes;        // The completion queue entries
+    unsigned int sq_entries;        // The driver's copy of the SQ size
+    unsigned int cq_entries;        // The driver's copy of the CQ size
+    unsigned int sq_head;           // The driver's copy of the SQ head
+    unsigned int cq_tail;           // The driver's copy of the CQ tail
+    unsigned int num_inflight;      // Number of transfers not yet completed
+    struct axidma_ring_req *reqs;   // The array of request structures
+    struct list_head free_reqs;     // The list of unused requests
+    struct list_head inflight_reqs; // The list of requests not yet completed
+    bool *chan_used;                // Channels used by the current submission
+    spinlock_t lock;                // Protects the CQ and the request lists
+    struct mutex submit_lock;       // Serializes consumption of the SQ
+    wait_queue_head_t cq_wait;      // Waiters for entries in the CQ
+    wait_queue_head_t sq_wait;      // Wakes up the SQ polling thread
+    struct task_struct *sq_thread;  // The SQ polling thread, if enabled
+    unsigned long sq_idle;          // SQ thread idle time, in jiffies
+};
+
+/*----------------------------------------------------------------------------
+ * Completion Queue Functions
+ *----------------------------------------------------------------------------*/
+
+// Returns the number of entries available in the CQ for userspace
+static unsigned int axidma_cq_ready(struct axidma_ring *ring)
+{
+    return ring->cq_tail - READ_ONCE(ring->hdr->cq_head);
+}
+
+/* Posts a completion for the request to the CQ, and returns the request to the
+ * free list. This must be called with the ring's lock held. Space in the CQ is
+ * always reserved for a request before it is submitted. */
+static void axidma_post_cqe(struct axidma_ring *ring,
+                            struct axidma_ring_req *req, size_t bytes,
+                            int status)
+{
+    unsigned int cq_mask;
+    struct axidma_cqe *cqe;
+
+    // Fill in the next entry in the CQ
+    cq_mask = ring->cq_entries - 1;
+    cqe = &ring->cqes[ring->cq_tail & cq_mask];
+    cqe->user_data = req->user_data;
+    cqe->channel_id = req->channel_id;
+    cqe->cookie = req->cookie;
+    cqe->bytes = bytes;
+    cqe->status = status;
+    trace_axidma_complete(req->channel_id, req->cookie, bytes, status);
+
+    // Publish the entry to userspace, only after it is completely written
+    ring->cq_tail += 1;
+    smp_store_release(&ring->hdr->cq_tail, ring->cq_tail);
+
+    // Return the request to the free list
+    list_move(&req->list, &ring->free_reqs);
+    ring->num_inflight -= 1;
+}
+
+// The completion callback for transfers submitted through the SQ
+static void axidma_ring_callback(void *data,
+                                 const struct dmaengine_result *result)
+{
+    int status;
+    size_t bytes;
+    unsigned long flags;
+    struct axidma_ring_req *req;
+    struct axidma_ring *ring;
+    struct axidma_chan *chan;
+
+    req = data;
+    ring = req->ring;
+
+    // Determine the status and the number of bytes actually transferred
+    status = 0;
+    bytes = req->buf_len;
+    if (result != NULL && result->result != DMA_TRANS_NOERROR) {
+        status = -EIO;
+    }
+    if (result != NULL && result->residue <= bytes) {
+        bytes -= result->residue;
+    }
+
+    // Count the transfer in the channel's statistics
+    trace_axidma_callback(req->channel_id, req->cookie, bytes, status);
+    chan = axidma_get_chan(ring->file->dev, req->channel_id);
+    axidma_stats_complete(ring->file->dev, chan, bytes, status);
+    axidma_set_residue(ring->file->dev, chan, req->buf_len - bytes);
+
+    /* Post the completion, and wake up anyone waiting on the CQ, possibly from
+     * the CPU the channel's wakeups are steered to. */
+    spin_lock_irqsave(&ring->lock, flags);
+    axidma_post_cqe(ring, req, bytes, status);
+    spin_unlock_irqrestore(&ring->lock, flags);
+    axidma_event_complete(ring->file, chan);
+}
+
+/*----------------------------------------------------------------------------
+ * Submission Queue Functions
+ *----------------------------------------------------------------------------*/
+
+/* Reserves a request for a transfer, only if there is room for its completion
+ * in the CQ. Returns NULL if the CQ could overflow. */
+static struct axidma_ring_req *axidma_ring_get_req(struct axidma_ring *ring)
+{
+    unsigned long flags;
+    unsigned int cq_pending;
+    struct axidma_ring_req *req;
+
+    req = NULL;
+    spin_lock_irqsave(&ring->lock, flags);
+    cq_pending = ring->cq_tail - READ_ONCE(ring->hdr->cq_head);
+    if (ring->num_inflight + cq_pending < ring->cq_entries &&
+            !list_empty(&ring->free_reqs)) {
+        req = list_first_entry(&ring->free_reqs, struct axidma_ring_req, list);
+        list_move_tail(&req->list, &ring->inflight_reqs);
+        ring->num_inflight += 1;
+    }
+    spin_unlock_irqrestore(&ring->lock, flags);
+
+    return req;
+}
+
+/* Consumes all of the available entries in the SQ, submitting their transfers
+ * to the DMA engine, and then starts each of the channels used. Returns the
+ * number of SQ entries consumed. */
+static int axidma_ring_consume(struct axidma_ring *ring)
+{
+    int rc, i, submitted;
+    unsigned int sq_tail, sq_mask;
+    unsigned long flags;
+    struct axidma_sqe sqe;
+    struct axidma_ring_req *req;
+    struct axidma_chan *chan;
+    struct axidma_device *dev;
+
+    dev = ring->file->dev;
+    sq_mask = ring->sq_entries - 1;
+    submitted = 0;
+
+    mutex_lock(&ring->submit_lock);
+    sq_tail = smp_load_acquire(&ring->hdr->sq_tail);
+    while (ring->sq_head != sq_tail)
+    {
+        // Make sure there is space in the CQ for the transfer's completion
+        req = axidma_ring_get_req(ring);
+        if (req == NULL) {
+            break;
+        }
+
+        /* Copy the entry out of the shared memory, so that userspace can't
+         * change it while we are using it. */
+        memcpy(&sqe, &ring->sqes[ring->sq_head & sq_mask], sizeof(sqe));
+        req->user_data = sqe.user_data;
+        req->channel_id = sqe.channel_id;
+        req->buf_len = sqe.buf_len;
+        req->cookie = -EINVAL;
+
+        // Submit the transfer; if it fails, immediately complete it
+        rc = axidma_queue_transfer(ring->file, sqe.channel_id, sqe.buf,
+                sqe.buf_len, axidma_ring_callback, req, &req->cookie);
+        if (rc < 0) {
+            spin_lock_irqsave(&ring->lock, flags);
+            axidma_post_cqe(ring, req, 0, rc);
+            spin_unlock_irqrestore(&ring->lock, flags);
+            wake_up_interruptible(&ring->cq_wait);
+            axidma_event_notify(ring->file);
+        } else {
+            chan = axidma_get_chan(dev, sqe.channel_id);
+            ring->chan_used[chan - dev->channels] = true;
+        }
+
+        ring->sq_head += 1;
+        submitted += 1;
+    }
+
+    // Let userspace know that the SQ entries can be reused
+    smp_store_release(&ring->hdr->sq_head, ring->sq_head);
+
+    // Flush the pending transactions on each channel that was used
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        if (ring->chan_used[i]) {
+            trace_axidma_issue(dev->channels[i].channel_id,
+                               dev->channels[i].chan->cookie, 0, 0);
+            dma_async_issue_pending(dev->channels[i].chan);
+            ring->chan_used[i] = false;
+        }
+    }
+    mutex_unlock(&ring->submit_lock);
+
+    return submitted;
+}
+
+// Checks if there are any entries in the SQ that have not been consumed
+static bool axidma_sq_pending(struct axidma_ring *ring)
+{
+    return smp_load_acquire(&ring->hdr->sq_tail) != ring->sq_head;
+}
+
+/* The kernel thread that polls the SQ for new entries. Once the SQ has been
+ * idle for long enough, the thread goes to sleep until woken by userspace. */
+static int axidma_sq_thread(void *data)
+{
+    unsigned long idle_start;
+    struct axidma_ring *ring;
+
+    ring = data;
+    idle_start = jiffies;
+    while (!kthread_should_stop())
+    {
+        if (axidma_ring_consume(ring) > 0) {
+            idle_start = jiffies;
+            continue;
+        } else if (time_before(jiffies, idle_start + ring->sq_idle)) {
+            cond_resched();
+            continue;
+        }
+
+        /* Tell userspace that we need to be woken up, and then check the SQ
+         * again, so that we don't miss an entry written in the meantime. */
+        WRITE_ONCE(ring->hdr->sq_flags, AXIDMA_SQ_NEED_WAKEUP);
+        smp_mb();
+        wait_event_interruptible(ring->sq_wait, axidma_sq_pending(ring) ||
+                                 kthread_should_stop());
+        WRITE_ONCE(ring->hdr->sq_flags, 0);
+        idle_start = jiffies;
+    }
+
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Ring Operations (Public Interface)
+ *----------------------------------------------------------------------------*/
+
+int axidma_ring_setup(struct axidma_file *file,
+                      struct axidma_ring_setup *setup)
+{
+    int rc, i;
+    size_t sq_size, cq_size;
+    struct axidma_ring *ring;
+    struct axidma_device *dev;
+
+    // Verify that the ring sizes are valid
+    dev = file->dev;
+    if (READ_ONCE(file->ring) != NULL) {
+        axidma_err("The submission and completion rings are already setup.\n");
+        return -EBUSY;
+    } else if (setup->sq_entries == 0 || !is_power_of_2(setup->sq_entries) ||
+               setup->sq_entries > AXIDMA_MAX_RING_ENTRIES) {
+        axidma_err("Invalid number of submission ring entries %u.\n",
+                   setup->sq_entries);
+        return -EINVAL;
+    } else if (setup->cq_entries < setup->sq_entries ||
+               !is_power_of_2(setup->cq_entries) ||
+               setup->cq_entries > AXIDMA_MAX_RING_ENTRIES) {
+        axidma_err("Invalid number of completion ring entries %u.\n",
+                   setup->cq_entries);
+        return -EINVAL;
+    }
+
+    // Allocate the structure to hold the rings' state
+    ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+    if (ring == NULL) {
+        axidma_err("Unable to allocate the ring structure.\n");
+        return -ENOMEM;
+    }
+    ring->file = file;
+    spin_lock_init(&ring->lock);
+    mutex_init(&ring->submit_lock);
+    init_waitqueue_head(&ring->cq_wait);
+    init_waitqueue_head(&ring->sq_wait);
+    INIT_LIST_HEAD(&ring->free_reqs);
+    INIT_LIST_HEAD(&ring->inflight_reqs);
+
+    // Compute the layout of the memory region shared with userspace
+    sq_size = setup->sq_entries * sizeof(ring->sqes[0]);
+    cq_size = setup->cq_entries * sizeof(ring->cqes[0]);
+    setup->sq_offset = L1_CACHE_ALIGN(sizeof(*ring->hdr));
+    setup->cq_offset = L1_CACHE_ALIGN(setup->sq_offset + sq_size);
+    setup->mmap_size = PAGE_ALIGN(setup->cq_offset + cq_size);
+
+    // Allocate the shared memory region, zeroed so that the indices start at 0
+    ring->mem_size = setup->mmap_size;
+    ring->mem = vmalloc_user(ring->mem_size);
+    if (ring->mem == NULL) {
+        axidma_err("Unable to allocate the shared ring memory region.\n");
+        rc = -ENOMEM;
+        goto free_ring;
+    }
+    ring->hdr = ring->mem;
+    ring->sqes = ring->mem + setup->sq_offset;
+    ring->cqes = ring->mem + setup->cq_offset;
+    ring->sq_entries = setup->sq_entries;
+    ring->cq_entries = setup->cq_entries;
+    ring->hdr->sq_entries = ring->sq_entries;
+    ring->hdr->cq_entries = ring->cq_entries;
+
+    // Allocate a request for each possible in-flight transfer
+    ring->reqs = kcalloc(setup->cq_entries, sizeof(ring->reqs[0]), GFP_KERNEL);
+    if (ring->reqs == NULL) {
+        axidma_err("Unable to allocate the ring request structures.\n");
+        rc = -ENOMEM;
+        goto free_ring_mem;
+    }
+    for (i = 0; i < setup->cq_entries; i++)
+    {
+        ring->reqs[i].ring = ring;
+        list_add_tail(&ring->reqs[i].list, &ring->free_reqs);
+    }
+
+    ring->chan_used = kcalloc(dev->num_chans, sizeof(ring->chan_used[0]),
+                              GFP_KERNEL);
+    if (ring->chan_used == NULL) {
+        axidma_err("Unable to allocate the ring channel flags.\n");
+        rc = -ENOMEM;
+        goto free_reqs;
+    }
+
+    // If requested, start up the kernel thread that polls the SQ
+    if (setup->flags & AXIDMA_RING_SQ_POLL) {
+        ring->sq_idle = msecs_to_jiffies((setup->sq_idle_ms == 0) ?
+                AXIDMA_SQ_IDLE_DEFAULT : setup->sq_idle_ms);
+        ring->sq_thread = kthread_run(axidma_sq_thread, ring, "axidma_sq");
+        if (IS_ERR(ring->sq_thread)) {
+            axidma_err("Unable to start the SQ polling thread.\n");
+            rc = PTR_ERR(ring->sq_thread);
+            goto free_chan_used;
+        }
+    }
+
+    /* Publish the rings, unless another thread set them up for the file in
+     * the meantime, in which case ours are torn down again. */
+    if (cmpxchg(&file->ring, NULL, ring) != NULL) {
+        axidma_err("The submission and completion rings are already setup.\n");
+        rc = -EBUSY;
+        goto stop_thread;
+    }
+    return 0;
+
+stop_thread:
+    if (ring->sq_thread != NULL) {
+        kthread_stop(ring->sq_thread);
+    }
+free_chan_used:
+    kfree(ring->chan_used);
+free_reqs:
+    kfree(ring->reqs);
+free_ring_mem:
+    vfree(ring->mem);
+free_ring:
+    kfree(ring);
+    return rc;
+}
+
+int axidma_ring_enter(struct axidma_file *file,
+                      struct axidma_ring_enter *enter)
+{
+    int rc, submitted;
+    struct axidma_ring *ring;
+
+    ring = file->ring;
+    if (ring == NULL) {
+        axidma_err("The submission and completion rings are not setup.\n");
+        return -EINVAL;
+    } else if (enter->min_complete > ring->cq_entries) {
+        axidma_err("Cannot wait for %u completions with only %u CQ entries.\n",
+                   enter->min_complete, ring->cq_entries);
+        return -EINVAL;
+    }
+
+    // Either consume the SQ ourselves, or wake up the thread polling it
+    if (ring->sq_thread == NULL) {
+        submitted = axidma_ring_consume(ring);
+    } else {
+        submitted = 0;
+        wake_up_interruptible(&ring->sq_wait);
+    }
+
+    // Wait for the requested number of completions, if any
+    if (enter->min_complete > 0) {
+        rc = wait_event_interruptible(ring->cq_wait,
+                axidma_cq_ready(ring) >= enter->min_complete);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    return submitted;
+}
+
+int axidma_ring_mmap(struct axidma_file *file, struct vm_area_struct *vma)
+{
+    int rc;
+    struct axidma_ring *ring;
+
+    // Verify that the requested region matches the rings
+    ring = file->ring;
+    if (ring == NULL) {
+        axidma_err("The submission and completion rings are not setup.\n");
+        return -EINVAL;
+    } else if (vma->vm_end - vma->vm_start != ring->mem_size) {
+        axidma_err("The ring mapping must be exactly %zu bytes.\n",
+                   ring->mem_size);
+        return -EINVAL;
+    }
+
+    // Map the shared memory region into userspace
+    rc = remap_vmalloc_range(vma, ring->mem, 0);
+    if (rc < 0) {
+        axidma_err("Unable to map the rings into userspace.\n");
+        return rc;
+    }
+
+    vma->vm_flags |= VM_DONTCOPY;
+    return 0;
+}
+
+/* Completes all in-flight ring transfers on the given channel as canceled. This
+ * is called after the transfers on a channel are terminated, since the DMA
+ * engine discards them without invoking their callbacks. */
+void axidma_ring_cancel(struct axidma_file *file, int channel_id)
+{
+    unsigned long flags;
+    struct axidma_ring *ring;
+    struct axidma_ring_req *req, *tmp;
+
+    ring = file->ring;
+    if (ring == NULL) {
+        return;
+    }
+
+    spin_lock_irqsave(&ring->lock, flags);
+    list_for_each_entry_safe(req, tmp, &ring->inflight_reqs, list)
+    {
+        if (req->channel_id == channel_id) {
+            axidma_post_cqe(ring, req, 0, -ECANCELED);
+        }
+    }
+    spin_unlock_irqrestore(&ring->lock, flags);
+    wake_up_interruptible(&ring->cq_wait);
+    axidma_event_notify(file);
+}
+
+// Wakes up anyone waiting for entries in the CQ, if the rings are setup
+void axidma_ring_wake(struct axidma_file *file)
+{
+    struct axidma_ring *ring;
+
+    ring = READ_ONCE(file->ring);
+    if (ring != NULL) {
+        wake_up_interruptible(&ring->cq_wait);
+    }
+}
+
+// Returns the number of entries in the CQ that userspace has not consumed
+unsigned int axidma_ring_ready(struct axidma_file *file)
+{
+    struct axidma_ring *ring;
+
+    ring = file->ring;
+    return (ring == NULL) ? 0 : axidma_cq_ready(ring);
+}
+
+/* Stops the SQ polling thread, if there is one, so that no more transfers are
+ * submitted from the SQ. */
+void axidma_ring_stop(struct axidma_file *file)
+{
+    struct axidma_ring *ring;
+
+    ring = file->ring;
+    if (ring == NULL || ring->sq_thread == NULL) {
+        return;
+    }
+
+    kthread_stop(ring->sq_thread);
+    ring->sq_thread = NULL;
+}
+
+/* Frees the rings. The caller must have stopped the SQ polling thread, and all
+ * the transfers on the file's channels, since in-flight transfers reference
+ * the rings. */
+void axidma_ring_destroy(struct axidma_file *file)
+{
+    struct axidma_ring *ring;
+
+    ring = file->ring;
+    if (ring == NULL) {
+        return;
+    }
+
+    kfree(ring->chan_used);
+    kfree(ring->reqs);
+    vfree(ring->mem);
+    kfree(ring);
+    file->ring = NULL;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file axidma_stats.c
+ * @date Wednesday, October 14, 2026 at 07:48:26 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the per-channel statistics for the AXI DMA module. The
+ * counters are updated with atomic operations on the transfer paths, and can
+ * be read by userspace with an ioctl, or from the stats file in debugfs. They
+ * show whether a drop in throughput comes from failed or timed out transfers,
+ * or simply from the channel sitting idle.
+ *
+ * @bug No known bugs.
+ **/
+
+// Kernel dependencies
+#include <linux/kernel.h>           // Min/max macros
+#include <linux/atomic.h>           // Atomic counter types and operations
+#include <linux/ktime.h>            // Monotonic clock functions
+#include <linux/slab.h>             // Allocation functions
+#include <linux/debugfs.h>          // Debugfs file creation functions
+#include <linux/seq_file.h>         // Sequential file printing functions
+#include <linux/errno.h>            // Linux error codes
+
+// Local dependencies
+#include "axidma.h"                 // Internal definitions
+#include "axidma_ioctl.h"           // IOCTL interface definition and types
+
+/*----------------------------------------------------------------------------
+ * Internal Definitions
+ *----------------------------------------------------------------------------*/
+
+// The counters for each channel, updated as transfers are submitted and done
+struct axidma_chan_stats {
+    atomic64_t bytes;               // Bytes transferred by completed transfers
+    atomic64_t transfers;           // Transfers that completed successfully
+    atomic64_t errors;              // Transfers that failed, or weren't issued
+    atomic64_t timeouts;            // Synchronous transfers that timed out
+    atomic64_t prep_failures;       // Times the engine couldn't prepare one
+    atomic64_t lookup_misses;       // Addresses outside of any DMA buffer
+    atomic_t inflight;              // Transfers currently submitted
+    atomic_t max_inflight;          // The high-water mark of the above
+    atomic64_t busy_start;          // When the channel last became busy (ns)
+    atomic64_t busy_time;           // Total time with transfers in flight (ns)
+};
+
+// Returns the statistics for the given channel of the device
+static struct axidma_chan_stats *axidma_chan_stats(struct axidma_device *dev,
+                                                  struct axidma_chan *chan)
+{
+    return &dev->chan_stats[chan - dev->channels];
+}
+
+// Adds the time since the channel became busy to its total busy time
+static void axidma_stats_idle(struct axidma_chan_stats *stats)
+{
+    s64 busy_start;
+
+    busy_start = atomic64_read(&stats->busy_start);
+    atomic64_add(ktime_get_ns() - busy_start, &stats->busy_time);
+}
+
+/*----------------------------------------------------------------------------
+ * Statistics Updates (Public Interface)
+ *----------------------------------------------------------------------------*/
+
+// Records that a transfer was submitted to the engine for the channel
+void axidma_stats_submit(struct axidma_device *dev, struct axidma_chan *chan)
+{
+    int inflight, max_inflight;
+    struct axidma_chan_stats *stats;
+
+    stats = axidma_chan_stats(dev, chan);
+    inflight = atomic_inc_return(&stats->inflight);
+    if (inflight == 1) {
+        atomic64_set(&stats->busy_start, ktime_get_ns());
+    }
+
+    // Raise the high-water mark, unless another submission already has
+    max_inflight = atomic_read(&stats->max_inflight);
+    while (inflight > max_inflight)
+    {
+        max_inflight = atomic_cmpxchg(&stats->max_inflight, max_inflight,
+                                      inflight);
+    }
+}
+
+/* Records that a transfer on the channel completed, with the given number of
+ * bytes transferred, and its status. This may be called from the DMA engine's
+ * callback. */
+void axidma_stats_complete(struct axidma_device *dev, struct axidma_chan *chan,
+                           size_t bytes, int status)
+{
+    struct axidma_chan_stats *stats;
+
+    stats = axidma_chan_stats(dev, chan);
+    if (status < 0) {
+        atomic64_inc(&stats->errors);
+    } else {
+        atomic64_add(bytes, &stats->bytes);
+        atomic64_inc(&stats->transfers);
+    }
+
+    if (atomic_dec_if_positive(&stats->inflight) == 0) {
+        axidma_stats_idle(stats);
+    }
+}
+
+/* Records that the transfers on the channel were stopped, so that none are in
+ * flight anymore. This must be called after the engine's callbacks for the
+ * channel have finished. */
+void axidma_stats_stop(struct axidma_device *dev, struct axidma_chan *chan)
+{
+    struct axidma_chan_stats *stats;
+
+    stats = axidma_chan_stats(dev, chan);
+    if (atomic_xchg(&stats->inflight, 0) > 0) {
+        axidma_stats_idle(stats);
+    }
+}
+
+// Returns the number of the channel's transfers that haven't completed yet
+int axidma_stats_inflight(struct axidma_device *dev, struct axidma_chan *chan)
+{
+    return atomic_read(&axidma_chan_stats(dev, chan)->inflight);
+}
+
+// Records an error on the channel that happened before it was submitted
+void axidma_stats_error(struct axidma_device *dev, struct axidma_chan *chan,
+                        enum axidma_stats_error error)
+{
+    struct axidma_chan_stats *stats;
+
+    stats = axidma_chan_stats(dev, chan);
+    switch (error)
+    {
+        case AXIDMA_STATS_TIMEOUT:
+            atomic64_inc(&stats->timeouts);
+            break;
+
+        case AXIDMA_STATS_PREP_FAILURE:
+            atomic64_inc(&stats->prep_failures);
+            break;
+
+        case AXIDMA_STATS_LOOKUP_MISS:
+            atomic64_inc(&stats->lookup_misses);
+            break;
+
+        default:
+            atomic64_inc(&stats->errors);
+            break;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Statistics Reporting
+ *----------------------------------------------------------------------------*/
+
+/* Takes a snapshot of the statistics for the channel with the given id. The
+ * busy time includes the time the channel has been busy so far. */
+int axidma_read_stats(struct axidma_device *dev, struct axidma_stats *info)
+{
+    struct axidma_chan *chan;
+    struct axidma_chan_stats *stats;
+
+    chan = axidma_get_chan(dev, info->channel_id);
+    if (chan == NULL) {
+        axidma_err("Invalid channel id %d.\n", info->channel_id);
+        return -ENODEV;
+    }
+
+    stats = axidma_chan_stats(dev, chan);
+    info->bytes = atomic64_read(&stats->bytes);
+    info->transfers = atomic64_read(&stats->transfers);
+    info->errors = atomic64_read(&stats->errors);
+    info->timeouts = atomic64_read(&stats->timeouts);
+    info->prep_failures = atomic64_read(&stats->prep_failures);
+    info->lookup_misses = atomic64_read(&stats->lookup_misses);
+    info->inflight = atomic_read(&stats->inflight);
+    info->max_inflight = atomic_read(&stats->max_inflight);
+    info->busy_time = atomic64_read(&stats->busy_time);
+    if (info->inflight > 0) {
+        info->busy_time += ktime_get_ns() - atomic64_read(&stats->busy_start);
+    }
+
+    return 0;
+}
+
+// Prints a table of the statistics for every channel to the debugfs file
+static int axidma_stats_show(struct seq_file *s, void *data)
+{
+    int i;
+    struct axidma_device *dev;
+    struct axidma_chan *chan;
+    struct axidma_stats info;
+
+    dev = s->private;
+    seq_printf(s, "%7s %5s %4s %16s %12s %8s %8s %8s %8s %8s %8s %14s\n",
+               "channel", "type", "dir", "bytes", "transfers", "errors",
+               "timeouts", "prepfail", "lookmiss", "inflight", "maxdepth",
+               "busy_us");
+    for (i = 0; i < dev->num_chans; i++)
+    {
+        chan = &dev->channels[i];
+        info.channel_id = chan->channel_id;
+        axidma_read_stats(dev, &info);
+        seq_printf(s, "%7d %5s %4s %16llu %12llu %8llu %8llu %8llu %8llu "
+                   "%8u %8u %14llu\n", chan->channel_id,
+                   (chan->type == AXIDMA_DMA) ? "DMA" : "VDMA",
+                   (chan->dir == AXIDMA_WRITE) ? "tx" : "rx", info.bytes,
+                   info.transfers, info.errors, info.timeouts,
+                   info.prep_failures, info.lookup_misses, info.inflight,
+                   info.max_inflight, info.busy_time / NSEC_PER_USEC);
+    }
+
+    return 0;
+}
+
+static int axidma_stats_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, axidma_stats_show, inode->i_private);
+}
+
+static const struct file_operations axidma_stats_fops = {
+    .owner = THIS_MODULE,
+    .open = axidma_stats_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+/*----------------------------------------------------------------------------
+ * Initialization and Cleanup
+ *----------------------------------------------------------------------------*/
+
+int axidma_stats_init(struct axidma_device *dev)
+{
+    // Allocate the zeroed counters for each channel
+    dev->chan_stats = kcalloc(dev->num_chans, sizeof(dev->chan_stats[0]),
+                              GFP_KERNEL);
+    if (dev->chan_stats == NULL) {
+        axidma_err("Unable to allocate the channel statistics.\n");
+        return -ENOMEM;
+    }
+
+    /* Expose the statistics in debugfs, under the platform device's name. The
+     * statistics are still available through the ioctl if this fails. */
+    dev->debugfs_dir = debugfs_create_dir(dev_name(&dev->pdev->dev), NULL);
+    if (IS_ERR_OR_NULL(dev->debugfs_dir)) {
+        dev->debugfs_dir = NULL;
+        return 0;
+    }
+    debugfs_create_file("stats", S_IRUGO, dev->debugfs_dir, dev,
+                        &axidma_stats_fops);
+
+    return 0;
+}
+
+void axidma_stats_exit(struct axidma_device *dev)
+{
+    debugfs_remove_recursive(dev->debugfs_dir);
+    kfree(dev->chan_stats);
+    dev->chan_stats = NULL;
+}
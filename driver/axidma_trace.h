@@ -0,0 +1,152 @@
+/**
+ * @file axidma_trace.h
+ * @date Wednesday, October 14, 2026 at 08:32:10 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the tracepoints for the AXI DMA module.
+ *
+ * The tracepoints follow a transfer from the ioctl that starts it, through
+ * being prepared, issued to the hardware, and its completion callback, to the
+ * completion being delivered to userspace. With ftrace, perf, or bpftrace, the
+ * time between them breaks down the latency of a transfer into the system
+ * call, the driver, the hardware, and the wakeup. They cost almost nothing
+ * when they are disabled, unlike the printk macros.
+ *
+ * @bug No known bugs.
+ **/
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM axidma
+
+#if !defined(AXIDMA_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define AXIDMA_TRACE_H_
+
+// Kernel dependencies
+#include <linux/tracepoint.h>       // Tracepoint definition macros
+#include <linux/dmaengine.h>        // Definition of the DMA cookie type
+
+/*----------------------------------------------------------------------------
+ * IOCTL Tracepoints
+ *----------------------------------------------------------------------------*/
+
+// Traces the entry into an ioctl for the device, by its command number
+TRACE_EVENT(axidma_ioctl_enter,
+    TP_PROTO(unsigned int cmd),
+    TP_ARGS(cmd),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, nr)
+    ),
+
+    TP_fast_assign(
+        __entry->nr = _IOC_NR(cmd);
+    ),
+
+    TP_printk("nr=%u", __entry->nr)
+);
+
+// Traces the return from an ioctl for the device, with its result
+TRACE_EVENT(axidma_ioctl_exit,
+    TP_PROTO(unsigned int cmd, long rc),
+    TP_ARGS(cmd, rc),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, nr)
+        __field(long, rc)
+    ),
+
+    TP_fast_assign(
+        __entry->nr = _IOC_NR(cmd);
+        __entry->rc = rc;
+    ),
+
+    TP_printk("nr=%u rc=%ld", __entry->nr, __entry->rc)
+);
+
+/*----------------------------------------------------------------------------
+ * Transfer Tracepoints
+ *----------------------------------------------------------------------------*/
+
+// The fields shared by each step of a transfer
+DECLARE_EVENT_CLASS(axidma_transfer,
+    TP_PROTO(int channel_id, dma_cookie_t cookie, size_t len, int status),
+    TP_ARGS(channel_id, cookie, len, status),
+
+    TP_STRUCT__entry(
+        __field(int, channel_id)
+        __field(dma_cookie_t, cookie)
+        __field(size_t, len)
+        __field(int, status)
+    ),
+
+    TP_fast_assign(
+        __entry->channel_id = channel_id;
+        __entry->cookie = cookie;
+        __entry->len = len;
+        __entry->status = status;
+    ),
+
+    TP_printk("channel=%d cookie=%d len=%zu status=%d", __entry->channel_id,
+              __entry->cookie, __entry->len, __entry->status)
+);
+
+// The transfer was prepared and submitted to the channel's pending queue
+DEFINE_EVENT(axidma_transfer, axidma_prep,
+    TP_PROTO(int channel_id, dma_cookie_t cookie, size_t len, int status),
+    TP_ARGS(channel_id, cookie, len, status)
+);
+
+/* The pending transfers on the channel were issued to the hardware. The cookie
+ * is the last one submitted, so this covers every transfer up to it. When the
+ * whole queue of a channel is flushed at once, the length is zero. */
+DEFINE_EVENT(axidma_transfer, axidma_issue,
+    TP_PROTO(int channel_id, dma_cookie_t cookie, size_t len, int status),
+    TP_ARGS(channel_id, cookie, len, status)
+);
+
+// The engine invoked the transfer's completion callback
+DEFINE_EVENT(axidma_transfer, axidma_callback,
+    TP_PROTO(int channel_id, dma_cookie_t cookie, size_t len, int status),
+    TP_ARGS(channel_id, cookie, len, status)
+);
+
+// The transfer's completion was delivered to the waiting thread or userspace
+DEFINE_EVENT(axidma_transfer, axidma_complete,
+    TP_PROTO(int channel_id, dma_cookie_t cookie, size_t len, int status),
+    TP_ARGS(channel_id, cookie, len, status)
+);
+
+// Traces the signal sent to userspace for a completed transfer
+TRACE_EVENT(axidma_signal,
+    TP_PROTO(int channel_id, dma_cookie_t cookie, int signal, pid_t pid),
+    TP_ARGS(channel_id, cookie, signal, pid),
+
+    TP_STRUCT__entry(
+        __field(int, channel_id)
+        __field(dma_cookie_t, cookie)
+        __field(int, signal)
+        __field(pid_t, pid)
+    ),
+
+    TP_fast_assign(
+        __entry->channel_id = channel_id;
+        __entry->cookie = cookie;
+        __entry->signal = signal;
+        __entry->pid = pid;
+    ),
+
+    TP_printk("channel=%d cookie=%d signal=%d pid=%d", __entry->channel_id,
+              __entry->cookie, __entry->signal, __entry->pid)
+);
+
+#endif /* AXIDMA_TRACE_H_ */
+
+// The tracepoint header lives in the driver's directory, not the kernel's
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE axidma_trace
+
+// This must be outside of the include guard, so it can be read multiple times
+#include <trace/define_trace.h>
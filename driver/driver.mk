@@ -44,7 +44,8 @@ KERNEL_SYMS = $(KBUILD_DIR)/Module.symvers
 # The list of source files for the driver. Export the names to the Kbuild file.
 DRIVER_DIR = driver
 export AXIDMA_FILES = axi_dma.c axidma_chrdev.c axidma_dma.c axidma.h \
-		axidma_of.c
+		axidma_of.c axidma_ring.c axidma_event.c axidma_stats.c \
+		axidma_bdring.c axidma_trace.h
 DRIVER_PATHS = $(addprefix $(DRIVER_DIR)/,$(AXIDMA_FILES))
 
 # The kernel object files generated by compilation
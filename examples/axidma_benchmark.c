@@ -15,6 +15,26 @@
  * the a given number of times to calculate the performance statistics. All of
  * these options are configurable from the command line.
  *
+ * By default, each transfer is only started once the previous one completes.
+ * With the -d option, the program instead keeps up to the given number of
+ * transfers in flight, and reports the throughput and latency for each queue
+ * depth up to it, doubling the depth each time.
+ *
+ * When each transfer waits for the previous one, the program also times each
+ * transfer individually, and reports the minimum, median, tail percentiles,
+ * and maximum of the latency from submission to completion. For AXI DMA, this
+ * is reported separately for the transmit, the receive, and the round trip.
+ * With the -F option, these results are also written out as CSV or JSON, so
+ * they can be compared across kernel and bitstream versions.
+ *
+ * With the -T option, the program instead runs one thread for each of the
+ * given number of transmit and receive channel pairs, each pinned to its own
+ * core, and all sharing the same device. It reports the throughput of each
+ * thread, and the aggregate throughput across all of them, which shows how
+ * the library and driver scale with concurrent transfers. The data of each
+ * transfer is filled in and checked with NEON where available, which can be
+ * turned off with -N, so that the CPU does not limit the throughput.
+ *
  * NOTE: This program assumes that there are only two DMA channels being used by
  * the PL fabric, one that consumes data and sends it to the PL fabric logic,
  * and another that sends the output of the PL fabric back to memory. If you
@@ -25,10 +45,12 @@
  * @bug No known bugs.
  **/
 
+#define _GNU_SOURCE             // CPU affinity functions for threads
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
-#include <string.h>             // Strlen function
+#include <string.h>             // Strlen and memset functions
 
 #include <fcntl.h>              // Flags for open()
 #include <sys/stat.h>           // Open() system call
@@ -37,12 +59,23 @@
 #include <sys/ioctl.h>          // IOCTL system call
 #include <unistd.h>             // Close() system call
 #include <sys/time.h>           // Timing functions and definitions
+#include <time.h>               // Clock_gettime() and clock definitions
+#include <stdint.h>             // Fixed-width integer types
 #include <getopt.h>             // Option parsing
 #include <errno.h>              // Error codes
+#include <pthread.h>            // Threads, mutexes, and conditions
+#include <sched.h>              // CPU sets for thread affinity
+
+// Use NEON to fill and check the data, if the processor has it
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>           // NEON intrinsics
+#define USE_NEON
+#endif
 
 #include "libaxidma.h"          // Interface to the AXI DMA
 #include "util.h"               // Miscellaneous utilities
 #include "conversion.h"         // Miscellaneous conversion utilities
+#include "histogram.h"          // Latency histograms
 
 /*----------------------------------------------------------------------------
  * Internal Definitons
@@ -55,10 +88,62 @@
 // The default number of transfers to benchmark
 #define DEFAULT_NUM_TRANSFERS       1000
 
-// The pattern that we fill into the buffers
-#define TEST_PATTERN(i) ((int)(0x1234ACDE ^ (i)))
+// The largest queue depth that can be used for pipelined transfers
+#define MAX_QUEUE_DEPTH             (AXIDMA_MAX_RING_ENTRIES / 2)
 
-// The DMA context passed to the helper thread, who handles remainder channels
+// The pattern that we fill into the buffers
+#define TEST_PATTERN_KEY            0x1234ACDE
+#define TEST_PATTERN(i) ((int)(TEST_PATTERN_KEY ^ (i)))
+
+// The formats that the latency report can be written out in
+enum report_format {
+    REPORT_NONE,                    // Only print the human-readable report
+    REPORT_CSV,                     // Comma-separated values, one row each
+    REPORT_JSON,                    // A single JSON object
+};
+
+// The latency of each part of the transfers, in nanoseconds
+struct latency_stats {
+    struct histogram tx;            // Submission to transmit completion
+    struct histogram rx;            // Submission to receive completion
+    struct histogram round_trip;    // Submission to both completing
+};
+
+// The timing information for each pipelined transfer, updated on completion
+struct stream_timing {
+    struct timeval *submit_times;   // When each buffer pair was last submitted
+    double total_latency;           // The sum of each transfer's latency
+    long num_completed;             // The number of completed transfers
+};
+
+// The state for each thread of the multi-threaded benchmark
+// Starts all of the benchmark threads at once, or has them all exit early
+struct bench_start {
+    pthread_mutex_t lock;           // Protects the state below
+    pthread_cond_t cond;            // Signaled whenever the state changes
+    int num_ready;                  // The threads waiting to start
+    bool started;                   // All of the threads were created
+    bool aborted;                   // A thread couldn't be created
+};
+
+struct bench_thread {
+    axidma_dev_t dev;               // The device, shared by all of the threads
+    int index;                      // The index of the thread
+    int cpu;                        // The CPU the thread is pinned to
+    int tx_channel;                 // The channel used for transmitting
+    int rx_channel;                 // The channel used for receiving
+    char *tx_buf;                   // The transmit buffer
+    char *rx_buf;                   // The receive buffer
+    size_t tx_size;                 // The size of each transmit
+    size_t rx_size;                 // The size of each receive
+    int num_transfers;              // The number of transfers to perform
+    bool check_data;                // Whether to fill and check the data
+    struct bench_start *start;      // Starts all of the threads at once
+    uint64_t elapsed_time;          // Time taken for all of its transfers (ns)
+    uint64_t check_time;            // Time spent filling and checking (ns)
+    int rc;                         // The result of the thread's transfers
+    pthread_t thread;               // The thread itself
+};
 
 /*----------------------------------------------------------------------------
  * Command-line Interface
@@ -74,7 +159,9 @@ static void print_usage(bool help)
             "[-r <(V)DMA rx channel>] [-i <Tx transfer size (MiB)>] "
             "[-b <Tx transfer size (bytes)>] [-f <Tx frame size (HxWxD)>] "
             "[-o <Rx transfer size (MiB)>] [-s <Rx transfer size (bytes)>] "
-            "[-g <Rx frame size (HxWxD)>] [-n <number transfers>]\n");
+            "[-g <Rx frame size (HxWxD)>] [-n <number transfers>] "
+            "[-d <queue depth>] [-F <csv | json> [-w <report path>]] "
+            "[-T <threads> [-N]]\n");
     if (!help) {
         return;
     }
@@ -107,6 +194,21 @@ static void print_usage(bool help)
     fprintf(stream, "\t-n <number transfers>:\t\t\tThe number of DMA transfers "
             "to perform to do the benchmark. Default is %d transfers.\n",
             DEFAULT_NUM_TRANSFERS);
+    fprintf(stream, "\t-d <queue depth>:\t\t\tThe maximum number of DMA "
+            "transfers to keep in flight at once. The benchmark is run for "
+            "each power of two depth up to this one. Default is to wait for "
+            "each transfer to complete before starting the next one.\n");
+    fprintf(stream, "\t-F <csv | json>:\t\t\tAlso write out the latency "
+            "percentiles in the given format, for tracking them across "
+            "versions. Not supported with -d.\n");
+    fprintf(stream, "\t-w <report path>:\t\t\tThe file to write the latency "
+            "report from -F to. Default is standard output.\n");
+    fprintf(stream, "\t-T <threads>:\t\t\t\tRun a thread for each of this "
+            "many transmit and receive channel pairs at once, each pinned to "
+            "its own core, and report the throughput of each thread and of "
+            "all of them together.\n");
+    fprintf(stream, "\t-N:\t\t\t\tDon't fill in and check the data of each "
+            "transfer with -T.\n");
     return;
 }
 
@@ -114,7 +216,9 @@ static void print_usage(bool help)
  * and number of transfer to use for the benchmark if specified. */
 static int parse_args(int argc, char **argv, int *tx_channel, int *rx_channel,
         size_t *tx_size, struct axidma_video_frame *tx_frame, size_t *rx_size,
-        struct axidma_video_frame *rx_frame, int *num_transfers, bool *use_vdma)
+        struct axidma_video_frame *rx_frame, int *num_transfers, int *depth,
+        bool *use_vdma, enum report_format *format, char **report_path,
+        int *num_threads, bool *check_data)
 {
     double double_arg;
     int int_arg;
@@ -129,13 +233,21 @@ static int parse_args(int argc, char **argv, int *tx_channel, int *rx_channel,
     tx_frame->height = -1;
     tx_frame->width = -1;
     tx_frame->depth = -1;
+    tx_frame->stride = 0;
     *rx_size = DEFAULT_TRANSFER_SIZE;
     rx_frame->height = -1;
     rx_frame->width = -1;
     rx_frame->depth = -1;
+    rx_frame->stride = 0;
     *num_transfers = DEFAULT_NUM_TRANSFERS;
-
-    while ((option = getopt(argc, argv, "vt:r:i:b:f:o:s:g:n:h")) != (char)-1)
+    *depth = 0;
+    *format = REPORT_NONE;
+    *report_path = NULL;
+    *num_threads = 0;
+    *check_data = true;
+
+    while ((option = getopt(argc, argv, "vt:r:i:b:f:o:s:g:n:d:F:w:T:Nh"))
+            != (char)-1)
     {
         switch (option)
         {
@@ -238,6 +350,56 @@ static int parse_args(int argc, char **argv, int *tx_channel, int *rx_channel,
                 *num_transfers = int_arg;
                 break;
 
+            // Parse the queue depth argument
+            case 'd':
+                if (parse_int(option, optarg, &int_arg) < 0) {
+                    print_usage(false);
+                    return -EINVAL;
+                } else if (int_arg < 1 || int_arg > MAX_QUEUE_DEPTH) {
+                    fprintf(stderr, "Error: The queue depth must be between 1 "
+                            "and %d.\n", MAX_QUEUE_DEPTH);
+                    return -EINVAL;
+                }
+                *depth = int_arg;
+                break;
+
+            // Parse the latency report format argument
+            case 'F':
+                if (strcmp(optarg, "csv") == 0) {
+                    *format = REPORT_CSV;
+                } else if (strcmp(optarg, "json") == 0) {
+                    *format = REPORT_JSON;
+                } else {
+                    fprintf(stderr, "Error: Unknown report format '%s'.\n",
+                            optarg);
+                    print_usage(false);
+                    return -EINVAL;
+                }
+                break;
+
+            // Parse the latency report path argument
+            case 'w':
+                *report_path = optarg;
+                break;
+
+            // Parse the number of threads argument
+            case 'T':
+                if (parse_int(option, optarg, &int_arg) < 0) {
+                    print_usage(false);
+                    return -EINVAL;
+                } else if (int_arg < 1) {
+                    fprintf(stderr, "Error: The number of threads must be at "
+                            "least 1.\n");
+                    return -EINVAL;
+                }
+                *num_threads = int_arg;
+                break;
+
+            // Skip filling and checking the data with multiple threads
+            case 'N':
+                *check_data = false;
+                break;
+
             // Print detailed usage message
             case 'h':
                 print_usage(true);
@@ -268,6 +430,33 @@ static int parse_args(int argc, char **argv, int *tx_channel, int *rx_channel,
         return -EINVAL;
     }
 
+    if (*use_vdma && *depth != 0) {
+        fprintf(stderr, "Error: Pipelined transfers with -d are not supported "
+                "with VDMA.\n");
+        return -EINVAL;
+    }
+
+    if (*format != REPORT_NONE && *depth != 0) {
+        fprintf(stderr, "Error: The latency report with -F is not supported "
+                "with -d.\n");
+        return -EINVAL;
+    } else if (*report_path != NULL && *format == REPORT_NONE) {
+        fprintf(stderr, "Error: If -w is specified, then -F must also be "
+                "specified.\n");
+        return -EINVAL;
+    }
+
+    if (*num_threads != 0 && (*use_vdma || *depth != 0 ||
+                              *format != REPORT_NONE || *tx_channel != -1)) {
+        fprintf(stderr, "Error: The multi-threaded benchmark with -T is not "
+                "supported with -v, -d, -F, or -t/-r.\n");
+        return -EINVAL;
+    } else if (!*check_data && *num_threads == 0) {
+        fprintf(stderr, "Error: If -N is specified, then -T must also be "
+                "specified.\n");
+        return -EINVAL;
+    }
+
     return 0;
 }
 
@@ -383,6 +572,75 @@ static int verify_data(char *tx_buf, char *rx_buf, size_t tx_buf_size,
     return 0;
 }
 
+/* Fills the words of the buffer with the test pattern, starting from the given
+ * index into the pattern. With NEON, four words are filled at a time. */
+static void fill_pattern(uint32_t *buf, size_t num_words, uint32_t start)
+{
+    size_t i;
+#ifdef USE_NEON
+    const uint32_t lanes[4] = {0, 1, 2, 3};
+    uint32x4_t index, step, key;
+
+    key = vdupq_n_u32(TEST_PATTERN_KEY);
+    step = vdupq_n_u32(4);
+    index = vaddq_u32(vld1q_u32(lanes), vdupq_n_u32(start));
+    for (i = 0; i + 4 <= num_words; i += 4)
+    {
+        vst1q_u32(&buf[i], veorq_u32(index, key));
+        index = vaddq_u32(index, step);
+    }
+#else
+    i = 0;
+#endif
+
+    // Fill the words left over, or all of them without NEON
+    for (; i < num_words; i++)
+    {
+        buf[i] = TEST_PATTERN_KEY ^ (uint32_t)(start + i);
+    }
+
+    return;
+}
+
+/* Counts the words of the buffer that match the test pattern, starting from
+ * the given index into the pattern. With NEON, four words are compared at a
+ * time, and each lane keeps its own count. */
+static size_t count_pattern(const uint32_t *buf, size_t num_words,
+                            uint32_t start)
+{
+    size_t i, count;
+#ifdef USE_NEON
+    const uint32_t lanes[4] = {0, 1, 2, 3};
+    uint32x4_t index, step, key, matches;
+
+    key = vdupq_n_u32(TEST_PATTERN_KEY);
+    step = vdupq_n_u32(4);
+    index = vaddq_u32(vld1q_u32(lanes), vdupq_n_u32(start));
+    matches = vdupq_n_u32(0);
+
+    // A lane of the comparison is all ones on a match, so subtracting counts it
+    for (i = 0; i + 4 <= num_words; i += 4)
+    {
+        matches = vsubq_u32(matches, vceqq_u32(vld1q_u32(&buf[i]),
+                                               veorq_u32(index, key)));
+        index = vaddq_u32(index, step);
+    }
+    count = (size_t)vgetq_lane_u32(matches, 0) + vgetq_lane_u32(matches, 1) +
+            vgetq_lane_u32(matches, 2) + vgetq_lane_u32(matches, 3);
+#else
+    i = 0;
+    count = 0;
+#endif
+
+    // Check the words left over, or all of them without NEON
+    for (; i < num_words; i++)
+    {
+        count += (buf[i] == (TEST_PATTERN_KEY ^ (uint32_t)(start + i)));
+    }
+
+    return count;
+}
+
 static int single_transfer_test(axidma_dev_t dev, int tx_channel, void *tx_buf,
         int tx_size, struct axidma_video_frame *tx_frame, int rx_channel,
         void *rx_buf, int rx_size, struct axidma_video_frame *rx_frame)
@@ -407,15 +665,202 @@ static int single_transfer_test(axidma_dev_t dev, int tx_channel, void *tx_buf,
  * Benchmarking Test
  *----------------------------------------------------------------------------*/
 
+/* Performs a single two-way transfer through the submission ring, recording
+ * the latency from submission until each direction's completion is reaped.
+ * The round trip is the latency until both directions have completed. */
+static int timed_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
+        int tx_size, int rx_channel, void *rx_buf, int rx_size,
+        struct latency_stats *stats)
+{
+    int rc, i, num_cqes, pending;
+    uint64_t latency;
+    struct timespec submit_time, complete_time;
+    struct axidma_cqe cqes[2];
+
+    // Submit the receive first, so that it's ready before the data comes back
+    clock_gettime(CLOCK_MONOTONIC_RAW, &submit_time);
+    rc = axidma_ring_submit(dev, rx_channel, rx_buf, rx_size, &stats->rx);
+    if (rc < 0) {
+        return rc;
+    }
+    rc = axidma_ring_submit(dev, tx_channel, tx_buf, tx_size, &stats->tx);
+    if (rc < 0) {
+        return rc;
+    }
+
+    // Start both transfers, and then time each completion as it is reaped
+    pending = 2;
+    latency = 0;
+    while (pending > 0)
+    {
+        if (axidma_ring_enter(dev, 1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+
+        num_cqes = axidma_ring_reap(dev, cqes, pending);
+        clock_gettime(CLOCK_MONOTONIC_RAW, &complete_time);
+        latency = TSPEC_TO_NSEC(complete_time) - TSPEC_TO_NSEC(submit_time);
+        for (i = 0; i < num_cqes; i++)
+        {
+            if (cqes[i].status < 0 && rc == 0) {
+                rc = cqes[i].status;
+            }
+            hist_record((struct histogram *)cqes[i].user_data, latency);
+        }
+        pending -= num_cqes;
+    }
+
+    if (rc == 0) {
+        hist_record(&stats->round_trip, latency);
+    }
+    return rc;
+}
+
+/* Performs a single two-way transfer, waiting for it to complete, and records
+ * its round trip latency. This is used for VDMA, which the rings don't
+ * support, so the latency of each direction can't be measured. */
+static int timed_twoway_transfer(axidma_dev_t dev, int tx_channel,
+        void *tx_buf, int tx_size, struct axidma_video_frame *tx_frame,
+        int rx_channel, void *rx_buf, int rx_size,
+        struct axidma_video_frame *rx_frame, struct latency_stats *stats)
+{
+    int rc;
+    struct timespec submit_time, complete_time;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &submit_time);
+    rc = axidma_twoway_transfer(dev, tx_channel, tx_buf, tx_size, tx_frame,
+            rx_channel, rx_buf, rx_size, rx_frame, true);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &complete_time);
+    if (rc < 0) {
+        return rc;
+    }
+
+    hist_record(&stats->round_trip, TSPEC_TO_NSEC(complete_time) -
+                TSPEC_TO_NSEC(submit_time));
+    return 0;
+}
+
+// Prints the latency percentiles for one part of the transfers, in us
+static void print_latency(const char *name, const struct histogram *hist)
+{
+    if (hist->total == 0) {
+        return;
+    }
+
+    printf("\t%-10s\t%10llu\t%10.3f\t%10.3f\t%10.3f\t%10.3f\t%10.3f\n", name,
+           (unsigned long long)hist->total, NSEC_TO_USEC(hist->min),
+           NSEC_TO_USEC(hist_percentile(hist, 50.0)),
+           NSEC_TO_USEC(hist_percentile(hist, 99.0)),
+           NSEC_TO_USEC(hist_percentile(hist, 99.9)),
+           NSEC_TO_USEC(hist->max));
+    return;
+}
+
+/* Writes the latency percentiles for one part of the transfers in the given
+ * format. For JSON, a separator is placed before every entry but the first. */
+static void write_latency(FILE *report, enum report_format format,
+        const char *name, const struct histogram *hist, size_t tx_size,
+        size_t rx_size, bool first)
+{
+    if (hist->total == 0) {
+        return;
+    }
+
+    if (format == REPORT_CSV) {
+        fprintf(report, "%s,%zu,%zu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", name,
+                tx_size, rx_size, (unsigned long long)hist->total,
+                NSEC_TO_USEC(hist->min),
+                NSEC_TO_USEC(hist_percentile(hist, 50.0)),
+                NSEC_TO_USEC(hist_percentile(hist, 99.0)),
+                NSEC_TO_USEC(hist_percentile(hist, 99.9)),
+                NSEC_TO_USEC(hist->max));
+    } else {
+        fprintf(report, "%s\n    \"%s\": {\"samples\": %llu, \"min\": %.3f, "
+                "\"p50\": %.3f, \"p99\": %.3f, \"p99.9\": %.3f, "
+                "\"max\": %.3f}", first ? "" : ",", name,
+                (unsigned long long)hist->total, NSEC_TO_USEC(hist->min),
+                NSEC_TO_USEC(hist_percentile(hist, 50.0)),
+                NSEC_TO_USEC(hist_percentile(hist, 99.0)),
+                NSEC_TO_USEC(hist_percentile(hist, 99.9)),
+                NSEC_TO_USEC(hist->max));
+    }
+    return;
+}
+
+/* Writes the latency report out to the given path, or to standard output if
+ * no path is given. All of the latencies are in microseconds. */
+static int write_report(enum report_format format, char *report_path,
+        struct latency_stats *stats, size_t tx_size, size_t rx_size)
+{
+    FILE *report;
+
+    report = stdout;
+    if (report_path != NULL) {
+        report = fopen(report_path, "w");
+        if (report == NULL) {
+            perror("Unable to open the latency report file");
+            return -errno;
+        }
+    }
+
+    if (format == REPORT_CSV) {
+        fprintf(report, "direction,tx_size,rx_size,samples,min_us,p50_us,"
+                "p99_us,p99.9_us,max_us\n");
+        write_latency(report, format, "tx", &stats->tx, tx_size, rx_size,
+                      true);
+        write_latency(report, format, "rx", &stats->rx, tx_size, rx_size,
+                      true);
+        write_latency(report, format, "round_trip", &stats->round_trip,
+                      tx_size, rx_size, true);
+    } else {
+        fprintf(report, "{\n  \"tx_size\": %zu,\n  \"rx_size\": %zu,\n"
+                "  \"latency_us\": {", tx_size, rx_size);
+        write_latency(report, format, "round_trip", &stats->round_trip,
+                      tx_size, rx_size, true);
+        write_latency(report, format, "tx", &stats->tx, tx_size, rx_size,
+                      false);
+        write_latency(report, format, "rx", &stats->rx, tx_size, rx_size,
+                      false);
+        fprintf(report, "\n  }\n}\n");
+    }
+
+    if (report != stdout) {
+        fclose(report);
+    }
+    return 0;
+}
+
 /* Profiles the transfer and receive rates for the DMA, reporting the throughput
- * of each channel in MiB/s. */
+ * of each channel in MiB/s, and the distribution of the transfer latency. */
 static int time_dma(axidma_dev_t dev, int tx_channel, void *tx_buf, int tx_size,
         struct axidma_video_frame *tx_frame, int rx_channel, void *rx_buf,
-        int rx_size, struct axidma_video_frame *rx_frame, int num_transfers)
+        int rx_size, struct axidma_video_frame *rx_frame, int num_transfers,
+        enum report_format format, char *report_path)
 {
     int i, rc;
     struct timeval start_time, end_time;
     double elapsed_time, tx_data_rate, rx_data_rate;
+    struct latency_stats *stats;
+
+    stats = malloc(sizeof(*stats));
+    if (stats == NULL) {
+        perror("Unable to allocate the latency histograms");
+        return -ENOMEM;
+    }
+    hist_init(&stats->tx);
+    hist_init(&stats->rx);
+    hist_init(&stats->round_trip);
+
+    // For AXI DMA, submit through the rings to time each direction separately
+    if (tx_frame == NULL) {
+        rc = axidma_ring_init(dev, 2, 2, false);
+        if (rc < 0) {
+            goto free_stats;
+        }
+    }
 
     // Begin timing
     gettimeofday(&start_time, NULL);
@@ -423,12 +868,17 @@ static int time_dma(axidma_dev_t dev, int tx_channel, void *tx_buf, int tx_size,
     // Perform n transfers
     for (i = 0; i < num_transfers; i++)
     {
-        rc = axidma_twoway_transfer(dev, tx_channel, tx_buf, tx_size, tx_frame,
-                rx_channel, rx_buf, rx_size, rx_frame, true);
+        if (tx_frame == NULL) {
+            rc = timed_transfer(dev, tx_channel, tx_buf, tx_size, rx_channel,
+                    rx_buf, rx_size, stats);
+        } else {
+            rc = timed_twoway_transfer(dev, tx_channel, tx_buf, tx_size,
+                    tx_frame, rx_channel, rx_buf, rx_size, rx_frame, stats);
+        }
         if (rc < 0) {
             fprintf(stderr, "DMA failed on transfer %d, not reporting timing "
                     "results.\n", i+1);
-            return rc;
+            goto free_stats;
         }
     }
 
@@ -447,9 +897,450 @@ static int time_dma(axidma_dev_t dev, int tx_channel, void *tx_buf, int tx_size,
     printf("\tReceive Throughput: %0.2f MiB/s\n", rx_data_rate);
     printf("\tTotal Throughput: %0.2f MiB/s\n", tx_data_rate + rx_data_rate);
 
+    printf("\nDMA Latency Statistics (us):\n");
+    printf("\t%-10s\t%10s\t%10s\t%10s\t%10s\t%10s\t%10s\n", "Direction",
+           "Samples", "Min", "p50", "p99", "p99.9", "Max");
+    print_latency("Transmit", &stats->tx);
+    print_latency("Receive", &stats->rx);
+    print_latency("Round Trip", &stats->round_trip);
+
+    rc = 0;
+    if (format != REPORT_NONE) {
+        rc = write_report(format, report_path, stats, tx_size, rx_size);
+    }
+
+free_stats:
+    free(stats);
+    return rc;
+}
+
+// Records the latency of a pipelined transfer, as the time since it was queued
+static void stream_callback(int slot, void *data)
+{
+    struct timeval now;
+    struct stream_timing *timing;
+
+    timing = (struct stream_timing *)data;
+    gettimeofday(&now, NULL);
+    timing->total_latency += TVAL_TO_SEC(now) -
+                             TVAL_TO_SEC(timing->submit_times[slot]);
+    timing->num_completed += 1;
+
+    // The buffer pair is submitted again right after the callback returns
+    timing->submit_times[slot] = now;
+    return;
+}
+
+/* Profiles a single queue depth for pipelined transfers, reporting the
+ * throughput of each channel in MiB/s, and the average transfer latency. */
+static int time_stream(axidma_dev_t dev, int tx_channel, void **tx_bufs,
+        int tx_size, int rx_channel, void **rx_bufs, int rx_size,
+        int num_transfers, int depth, struct timeval *submit_times)
+{
+    int i, rc;
+    axidma_stream_t stream;
+    struct stream_timing timing;
+    struct timeval start_time, end_time;
+    double elapsed_time, tx_data_rate, rx_data_rate, latency;
+
+    stream = axidma_stream_create(dev, tx_channel, tx_bufs, tx_size,
+            rx_channel, rx_bufs, rx_size, depth);
+    if (stream == NULL) {
+        return -ENOMEM;
+    }
+
+    // Begin timing, all of the buffer pairs are submitted right away
+    gettimeofday(&start_time, NULL);
+    for (i = 0; i < depth; i++)
+    {
+        submit_times[i] = start_time;
+    }
+    timing.submit_times = submit_times;
+    timing.total_latency = 0.0;
+    timing.num_completed = 0;
+
+    rc = axidma_stream_run(stream, num_transfers, stream_callback, &timing);
+    gettimeofday(&end_time, NULL);
+    axidma_stream_destroy(stream);
+    if (rc < 0) {
+        fprintf(stderr, "DMA failed with a queue depth of %d, not reporting "
+                "timing results.\n", depth);
+        return rc;
+    }
+
+    // Compute the throughput of each channel, and the average latency
+    elapsed_time = TVAL_TO_SEC(end_time) - TVAL_TO_SEC(start_time);
+    tx_data_rate = BYTE_TO_MIB(tx_size) * num_transfers / elapsed_time;
+    rx_data_rate = BYTE_TO_MIB(rx_size) * num_transfers / elapsed_time;
+    latency = timing.total_latency / timing.num_completed;
+
+    printf("\t%5d\t%10.2f\t%10.2f\t%10.2f\t%10.3f\n", depth, tx_data_rate,
+           rx_data_rate, tx_data_rate + rx_data_rate, latency * 1000.0);
     return 0;
 }
 
+/* Profiles pipelined transfers for each power of two queue depth up to the
+ * given one, allocating an additional buffer pair for each transfer in flight
+ * past the first. */
+static int time_dma_pipelined(axidma_dev_t dev, int tx_channel, char *tx_buf,
+        int tx_size, int rx_channel, char *rx_buf, int rx_size,
+        int num_transfers, int max_depth)
+{
+    int i, rc, depth, num_bufs;
+    unsigned int ring_entries;
+    void **tx_bufs, **rx_bufs;
+    struct timeval *submit_times;
+
+    // The submission ring needs room for both the transmit and receive
+    ring_entries = 1;
+    while (ring_entries < 2 * (unsigned int)max_depth)
+    {
+        ring_entries *= 2;
+    }
+    rc = axidma_ring_init(dev, ring_entries, ring_entries, false);
+    if (rc < 0) {
+        return rc;
+    }
+
+    tx_bufs = calloc(max_depth, sizeof(tx_bufs[0]));
+    rx_bufs = calloc(max_depth, sizeof(rx_bufs[0]));
+    submit_times = calloc(max_depth, sizeof(submit_times[0]));
+    if (tx_bufs == NULL || rx_bufs == NULL || submit_times == NULL) {
+        perror("Unable to allocate the buffer pair arrays");
+        rc = -ENOMEM;
+        goto free_arrays;
+    }
+
+    // Use the buffers from the single transfer test for the first pair
+    tx_bufs[0] = tx_buf;
+    rx_bufs[0] = rx_buf;
+    for (num_bufs = 1; num_bufs < max_depth; num_bufs++)
+    {
+        tx_bufs[num_bufs] = axidma_malloc(dev, tx_size);
+        rx_bufs[num_bufs] = axidma_malloc(dev, rx_size);
+        if (tx_bufs[num_bufs] == NULL || rx_bufs[num_bufs] == NULL) {
+            fprintf(stderr, "Unable to allocate buffers for a queue depth of "
+                    "%d.\n", max_depth);
+            rc = -ENOMEM;
+            num_bufs += 1;
+            goto free_bufs;
+        }
+    }
+
+    printf("Pipelined DMA Timing Statistics:\n");
+    printf("\t%5s\t%10s\t%10s\t%10s\t%10s\n", "Depth", "Tx MiB/s",
+           "Rx MiB/s", "Total MiB/s", "Latency ms");
+    // Double the depth each time, ending with the maximum one requested
+    depth = 1;
+    while (true)
+    {
+        rc = time_stream(dev, tx_channel, tx_bufs, tx_size, rx_channel,
+                rx_bufs, rx_size, num_transfers, depth, submit_times);
+        if (rc < 0 || depth == max_depth) {
+            break;
+        }
+        depth = (2 * depth < max_depth) ? 2 * depth : max_depth;
+    }
+
+free_bufs:
+    for (i = 1; i < num_bufs; i++)
+    {
+        if (tx_bufs[i] != NULL) {
+            axidma_free(dev, tx_bufs[i], tx_size);
+        }
+        if (rx_bufs[i] != NULL) {
+            axidma_free(dev, rx_bufs[i], rx_size);
+        }
+    }
+free_arrays:
+    free(submit_times);
+    free(rx_bufs);
+    free(tx_bufs);
+    return rc;
+}
+
+/*----------------------------------------------------------------------------
+ * Multi-threaded Benchmark
+ *----------------------------------------------------------------------------*/
+
+// Returns the time elapsed since the given time, in nanoseconds
+static uint64_t elapsed_since(const struct timespec *start_time)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return TSPEC_TO_NSEC(now) - TSPEC_TO_NSEC(*start_time);
+}
+
+/* Checks the data of the thread's last transfer. The transmit buffer must be
+ * unchanged, and since the channels are looped back, the receive buffer must
+ * hold the transmitted pattern, over the length of the smaller of the two.
+ * Only whole words of the buffers are checked. */
+static int check_thread_data(struct bench_thread *thread, int transfer)
+{
+    size_t tx_words, rx_words, xfer_words, matched;
+
+    tx_words = thread->tx_size / sizeof(uint32_t);
+    rx_words = thread->rx_size / sizeof(uint32_t);
+    xfer_words = (tx_words < rx_words) ? tx_words : rx_words;
+    if (count_pattern((uint32_t *)thread->tx_buf, tx_words, 0) != tx_words) {
+        fprintf(stderr, "Thread %d: The transmit buffer was overwritten on "
+                "transfer %d.\n", thread->index, transfer + 1);
+        return -EINVAL;
+    }
+
+    matched = count_pattern((uint32_t *)thread->rx_buf, xfer_words, 0);
+    if (matched != xfer_words) {
+        fprintf(stderr, "Thread %d: %zu of the %zu words received on transfer "
+                "%d don't match the transmitted data.\n", thread->index,
+                xfer_words - matched, xfer_words, transfer + 1);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+/* Waits until all of the threads have been created. Returns false if one of
+ * them couldn't be, in which case the thread must exit right away. */
+static bool wait_thread_start(struct bench_start *start)
+{
+    bool started;
+
+    pthread_mutex_lock(&start->lock);
+    start->num_ready += 1;
+    pthread_cond_broadcast(&start->cond);
+    while (!start->started && !start->aborted)
+    {
+        pthread_cond_wait(&start->cond, &start->lock);
+    }
+    started = start->started;
+    pthread_mutex_unlock(&start->lock);
+
+    return started;
+}
+
+/* Starts the threads once all of them are waiting, or has them exit if abort
+ * is specified, because not all of them could be created. */
+static void start_threads(struct bench_start *start, int num_threads,
+                          bool abort)
+{
+    pthread_mutex_lock(&start->lock);
+    while (!abort && start->num_ready < num_threads)
+    {
+        pthread_cond_wait(&start->cond, &start->lock);
+    }
+    start->started = !abort;
+    start->aborted = abort;
+    pthread_cond_broadcast(&start->cond);
+    pthread_mutex_unlock(&start->lock);
+    return;
+}
+
+/* Performs the thread's two-way transfers, once all of the other threads are
+ * ready. Before each transfer, the receive buffer is marked with a different
+ * pattern, so that the check afterwards can tell whether it was written. */
+static void *bench_thread_run(void *arg)
+{
+    int i, rc;
+    size_t tx_words, rx_words;
+    struct timespec start_time, check_start;
+    struct bench_thread *thread;
+
+    thread = (struct bench_thread *)arg;
+    tx_words = thread->tx_size / sizeof(uint32_t);
+    rx_words = thread->rx_size / sizeof(uint32_t);
+    if (thread->check_data) {
+        fill_pattern((uint32_t *)thread->tx_buf, tx_words, 0);
+    }
+
+    if (!wait_thread_start(thread->start)) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start_time);
+    for (i = 0; i < thread->num_transfers; i++)
+    {
+        if (thread->check_data) {
+            clock_gettime(CLOCK_MONOTONIC_RAW, &check_start);
+            fill_pattern((uint32_t *)thread->rx_buf, rx_words, tx_words);
+            thread->check_time += elapsed_since(&check_start);
+        }
+
+        rc = axidma_twoway_transfer(thread->dev, thread->tx_channel,
+                thread->tx_buf, thread->tx_size, NULL, thread->rx_channel,
+                thread->rx_buf, thread->rx_size, NULL, true);
+        if (rc < 0) {
+            fprintf(stderr, "Thread %d: DMA failed on transfer %d.\n",
+                    thread->index, i + 1);
+            thread->rc = rc;
+            break;
+        }
+
+        if (thread->check_data) {
+            clock_gettime(CLOCK_MONOTONIC_RAW, &check_start);
+            rc = check_thread_data(thread, i);
+            thread->check_time += elapsed_since(&check_start);
+            if (rc < 0) {
+                thread->rc = rc;
+                break;
+            }
+        }
+    }
+    thread->elapsed_time = elapsed_since(&start_time);
+
+    return NULL;
+}
+
+// Prints the throughput of a thread, or of all of them, in MiB/s
+static void print_thread_rates(const char *name, int tx_channel,
+        int rx_channel, int cpu, size_t tx_bytes, size_t rx_bytes,
+        uint64_t elapsed_time, uint64_t check_time)
+{
+    double elapsed_sec, tx_data_rate, rx_data_rate;
+
+    elapsed_sec = elapsed_time / 1e9;
+    tx_data_rate = BYTE_TO_MIB(tx_bytes) / elapsed_sec;
+    rx_data_rate = BYTE_TO_MIB(rx_bytes) / elapsed_sec;
+    if (tx_channel < 0) {
+        printf("\t%6s\t%7s\t%7s\t%4s", name, "-", "-", "-");
+    } else {
+        printf("\t%6s\t%7d\t%7d\t%4d", name, tx_channel, rx_channel, cpu);
+    }
+    printf("\t%10.2f\t%10.2f\t%11.2f\t%7.1f\n", tx_data_rate, rx_data_rate,
+           tx_data_rate + rx_data_rate, 100.0 * check_time / elapsed_time);
+    return;
+}
+
+/* Runs a thread for each of the given number of channel pairs at once, with
+ * each thread pinned to its own core, and its own buffers. All of the threads
+ * share the device, so that its concurrency is tested. The aggregate
+ * throughput is from when all of the threads start until the last finishes. */
+static int time_dma_threaded(axidma_dev_t dev, const array_t *tx_chans,
+        const array_t *rx_chans, int num_threads, size_t tx_size,
+        size_t rx_size, int num_transfers, bool check_data)
+{
+    int i, rc, num_cpus, num_started;
+    char name[16];
+    uint64_t elapsed_time, check_time;
+    pthread_attr_t attr;
+    struct bench_start start;
+    cpu_set_t cpus;
+    struct timespec start_time;
+    struct bench_thread *threads, *thread;
+
+    if (num_threads > tx_chans->len || num_threads > rx_chans->len) {
+        fprintf(stderr, "Error: There are only enough channels for %d "
+                "threads.\n", (tx_chans->len < rx_chans->len) ?
+                tx_chans->len : rx_chans->len);
+        return -ENODEV;
+    }
+
+    threads = calloc(num_threads, sizeof(threads[0]));
+    if (threads == NULL) {
+        perror("Unable to allocate the benchmark threads");
+        return -ENOMEM;
+    }
+
+    // Pair up the channels with the same index, and give each its buffers
+    num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_cpus = (num_cpus > 0) ? num_cpus : 1;
+    rc = 0;
+    for (i = 0; i < num_threads; i++)
+    {
+        thread = &threads[i];
+        thread->dev = dev;
+        thread->index = i;
+        thread->cpu = i % num_cpus;
+        thread->tx_channel = tx_chans->data[i];
+        thread->rx_channel = rx_chans->data[i];
+        thread->tx_size = tx_size;
+        thread->rx_size = rx_size;
+        thread->num_transfers = num_transfers;
+        thread->check_data = check_data;
+        thread->start = &start;
+        thread->tx_buf = axidma_malloc(dev, tx_size);
+        thread->rx_buf = axidma_malloc(dev, rx_size);
+        if (thread->tx_buf == NULL || thread->rx_buf == NULL) {
+            fprintf(stderr, "Unable to allocate the buffers for thread %d.\n",
+                    i);
+            rc = -ENOMEM;
+            goto free_bufs;
+        }
+    }
+
+    memset(&start, 0, sizeof(start));
+    pthread_mutex_init(&start.lock, NULL);
+    pthread_cond_init(&start.cond, NULL);
+
+    // Start each thread on its own core
+    pthread_attr_init(&attr);
+    for (i = 0; i < num_threads; i++)
+    {
+        CPU_ZERO(&cpus);
+        CPU_SET(threads[i].cpu, &cpus);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+        rc = -pthread_create(&threads[i].thread, &attr, bench_thread_run,
+                             &threads[i]);
+        if (rc < 0) {
+            fprintf(stderr, "Unable to create a benchmark thread: %s.\n",
+                    strerror(-rc));
+            break;
+        }
+    }
+    pthread_attr_destroy(&attr);
+    num_started = i;
+
+    // Time from when all of the threads start until the last one finishes
+    start_threads(&start, num_threads, rc < 0);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start_time);
+    check_time = 0;
+    for (i = 0; i < num_started; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+        rc = (rc < 0) ? rc : threads[i].rc;
+        check_time += threads[i].check_time;
+    }
+    elapsed_time = elapsed_since(&start_time);
+    pthread_cond_destroy(&start.cond);
+    pthread_mutex_destroy(&start.lock);
+    if (rc < 0) {
+        fprintf(stderr, "DMA failed with %d threads, not reporting timing "
+                "results.\n", num_threads);
+        goto free_bufs;
+    }
+
+    printf("Multi-threaded DMA Timing Statistics:\n");
+    printf("\t%6s\t%7s\t%7s\t%4s\t%10s\t%10s\t%11s\t%7s\n", "Thread",
+           "Tx Chan", "Rx Chan", "CPU", "Tx MiB/s", "Rx MiB/s", "Total MiB/s",
+           "Check %");
+    for (i = 0; i < num_threads; i++)
+    {
+        thread = &threads[i];
+        snprintf(name, sizeof(name), "%d", i);
+        print_thread_rates(name, thread->tx_channel, thread->rx_channel,
+                thread->cpu, tx_size * num_transfers,
+                rx_size * num_transfers, thread->elapsed_time,
+                thread->check_time);
+    }
+
+    // The check time is averaged over the threads for the aggregate
+    print_thread_rates("All", -1, -1, -1, tx_size * num_transfers *
+            num_threads, rx_size * num_transfers * num_threads,
+            elapsed_time, check_time / num_threads);
+
+free_bufs:
+    for (i = 0; i < num_threads; i++)
+    {
+        if (threads[i].rx_buf != NULL) {
+            axidma_free(dev, threads[i].rx_buf, rx_size);
+        }
+        if (threads[i].tx_buf != NULL) {
+            axidma_free(dev, threads[i].tx_buf, tx_size);
+        }
+    }
+    free(threads);
+    return rc;
+}
+
 /*----------------------------------------------------------------------------
  * Main Function
  *----------------------------------------------------------------------------*/
@@ -457,10 +1348,12 @@ static int time_dma(axidma_dev_t dev, int tx_channel, void *tx_buf, int tx_size,
 int main(int argc, char **argv)
 {
     int rc;
-    int num_transfers;
+    int num_transfers, depth, num_threads;
     int tx_channel, rx_channel;
     size_t tx_size, rx_size;
-    bool use_vdma;
+    bool use_vdma, check_data;
+    enum report_format format;
+    char *report_path;
     char *tx_buf, *rx_buf;
     axidma_dev_t axidma_dev;
     const array_t *tx_chans, *rx_chans;
@@ -468,8 +1361,9 @@ int main(int argc, char **argv)
 
     // Check if the user overrided the default transfer size and number
     if (parse_args(argc, argv, &tx_channel, &rx_channel, &tx_size,
-            &transmit_frame, &rx_size, &receive_frame, &num_transfers,
-            &use_vdma) < 0) {
+            &transmit_frame, &rx_size, &receive_frame, &num_transfers, &depth,
+            &use_vdma, &format, &report_path, &num_threads,
+            &check_data) < 0) {
         rc = 1;
         goto ret;
     }
@@ -485,7 +1379,14 @@ int main(int argc, char **argv)
                 receive_frame.height, receive_frame.width, receive_frame.depth,
                 BYTE_TO_MIB(rx_size));
     }
-    printf("\tNumber of DMA Transfers: %d transfers\n\n", num_transfers);
+    printf("\tNumber of DMA Transfers: %d transfers\n", num_transfers);
+    if (depth > 0) {
+        printf("\tMaximum Queue Depth: %d transfers\n", depth);
+    }
+    if (num_threads > 0) {
+        printf("\tNumber of Threads: %d threads\n", num_threads);
+    }
+    printf("\n");
 
     // Initialize the AXI DMA device
     axidma_dev = axidma_init();
@@ -551,8 +1452,17 @@ int main(int argc, char **argv)
 
     // Time the DMA eingine
     printf("Beginning performance analysis of the DMA engine.\n\n");
-    rc = time_dma(axidma_dev, tx_channel, tx_buf, tx_size, tx_frame,
-            rx_channel, rx_buf, rx_size, rx_frame, num_transfers);
+    if (num_threads > 0) {
+        rc = time_dma_threaded(axidma_dev, tx_chans, rx_chans, num_threads,
+                tx_size, rx_size, num_transfers, check_data);
+    } else if (depth == 0) {
+        rc = time_dma(axidma_dev, tx_channel, tx_buf, tx_size, tx_frame,
+                rx_channel, rx_buf, rx_size, rx_frame, num_transfers, format,
+                report_path);
+    } else {
+        rc = time_dma_pipelined(axidma_dev, tx_channel, tx_buf, tx_size,
+                rx_channel, rx_buf, rx_size, num_transfers, depth);
+    }
 
 free_rx_buf:
     axidma_free(axidma_dev, rx_buf, rx_size);
@@ -322,6 +322,7 @@ int main(int argc, char **argv)
     }
 
     // Initiate a video transfer to the PL fabric
+    memset(&trans, 0, sizeof(trans));
     trans.channel_id = tx_channel;
     trans.num_frame_buffers = 1;
     trans.frame_buffers = (void **)&image_buf;
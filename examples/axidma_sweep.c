@@ -0,0 +1,775 @@
+/**
+ * @file axidma_sweep.c
+ * @date Wednesday, October 14, 2026 at 07:03:51 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This program sweeps the AXI DMA transfer performance across the parameters
+ * that matter for sizing the batches of an application. It performs two-way
+ * transfers over every power of two transfer size, from 64 bytes up to the
+ * maximum size, and reports the throughput and the time per transfer for each
+ * one. This shows where the per-transfer overhead dominates, and where the
+ * bandwidth saturates.
+ *
+ * The sweep is repeated for each way of waiting for the transfers to complete:
+ * blocking in the driver, spinning in the driver, a signal for each completion,
+ * polling the queued completion events, and pipelining the transfers through
+ * the submission ring at each power of two queue depth. It is also repeated for
+ * coherent and cached buffers, and for a single pair of channels as well as all
+ * of them at once.
+ *
+ * NOTE: This program assumes that the transmit and receive channels with the
+ * same index are connected through the PL fabric, as in the AXI DMA loopback
+ * examples. Each pair of channels receives as much data as it transmits.
+ *
+ * @bug No known bugs.
+ **/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <string.h>             // Memset function
+#include <time.h>               // Clock_gettime() and clock definitions
+#include <poll.h>               // Poll() system call
+#include <getopt.h>             // Option parsing
+#include <errno.h>              // Error codes
+#include <pthread.h>            // Threads and barriers
+#include <semaphore.h>          // Semaphores for the completion signals
+
+#include "libaxidma.h"          // Interface to the AXI DMA
+#include "util.h"               // Miscellaneous utilities
+#include "conversion.h"         // Miscellaneous conversion utilities
+
+/*----------------------------------------------------------------------------
+ * Internal Definitons
+ *----------------------------------------------------------------------------*/
+
+// The smallest transfer size that is swept
+#define MIN_TRANSFER_SIZE           64
+
+// The default largest transfer size that is swept (64 MiB)
+#define DEFAULT_MAX_SIZE            (64 * 1024 * 1024)
+
+// The default largest queue depth swept for pipelined transfers
+#define DEFAULT_MAX_DEPTH           16
+
+// The largest queue depth that can be used for pipelined transfers
+#define MAX_QUEUE_DEPTH             (AXIDMA_MAX_RING_ENTRIES / 2)
+
+/* By default, the number of transfers for each size is picked so that about
+ * this much data is transmitted, within the limits below. */
+#define SWEEP_BYTES                 (256 * 1024 * 1024)
+#define MIN_TRANSFERS               8
+#define MAX_TRANSFERS               4000
+
+// How long the driver spins for each transfer in the busy-poll mode (us)
+#define SWEEP_POLL_BUDGET           1000
+
+// The ways of waiting for the transfers to complete
+enum sweep_mode {
+    MODE_SYNC,                  // Block in the driver until both complete
+    MODE_BUSYPOLL,              // Spin in the driver until both complete
+    MODE_SIGNAL,                // Wait for the signal from each completion
+    MODE_POLL,                  // Poll for the queued completion events
+    MODE_RING,                  // Pipeline through the submission ring
+    NUM_MODES,
+};
+
+// The names of each of the modes, for the table
+static const char *mode_names[NUM_MODES] = {
+    [MODE_SYNC]     = "sync",
+    [MODE_BUSYPOLL] = "busypoll",
+    [MODE_SIGNAL]   = "signal",
+    [MODE_POLL]     = "poll",
+    [MODE_RING]     = "ring",
+};
+
+// A single point in the sweep, shared by all of channel pairs' threads
+struct sweep_point {
+    enum sweep_mode mode;       // How the completions are waited for
+    bool cached;                // Whether the buffers are cached
+    size_t size;                // The size of each transfer in each direction
+    int depth;                  // The queue depth for pipelined transfers
+    long num_transfers;         // The number of transfers each pair performs
+    pthread_barrier_t barrier;  // Starts all of the pairs at the same time
+};
+
+// The state for a pair of channels, which has its own device handle
+struct sweep_worker {
+    axidma_dev_t dev;           // The device handle, for this pair only
+    int tx_channel;             // The channel used for transmitting
+    int rx_channel;             // The channel used for receiving
+    char *tx_buf;               // The transmit buffer, of the maximum size
+    char *rx_buf;               // The receive buffer, of the maximum size
+    size_t buf_size;            // The size of each buffer
+    sem_t completions;          // Posted for each signaled completion
+    struct sweep_point *point;  // The point in the sweep being run
+    axidma_stream_t stream;     // The stream for the current ring point
+    int rc;                     // The result of running the point
+    pthread_t thread;           // The thread running the point
+};
+
+/*----------------------------------------------------------------------------
+ * Command-line Interface
+ *----------------------------------------------------------------------------*/
+
+// Prints the usage for this program
+static void print_usage(bool help)
+{
+    FILE* stream = (help) ? stdout : stderr;
+
+    fprintf(stream, "Usage: axidma_sweep [-m <max transfer size (bytes)>] "
+            "[-d <max queue depth>] [-n <number transfers>]\n");
+    if (!help) {
+        return;
+    }
+
+    fprintf(stream, "\t-m <max transfer size (bytes)>:\tThe largest transfer "
+            "size to sweep up to, from %d bytes. Each pair of channels "
+            "allocates a transmit and receive buffer of this size. Default "
+            "is %d bytes.\n", MIN_TRANSFER_SIZE, DEFAULT_MAX_SIZE);
+    fprintf(stream, "\t-d <max queue depth>:\t\tThe largest queue depth to "
+            "sweep up to for pipelined transfers, from 1. Each depth is only "
+            "swept for the sizes where all of the transfers in flight fit in "
+            "the buffers. Default is %d.\n", DEFAULT_MAX_DEPTH);
+    fprintf(stream, "\t-n <number transfers>:\t\tThe number of transfers to "
+            "perform for each point in the sweep. Default is to transmit "
+            "about %d MiB, with between %d and %d transfers.\n",
+            SWEEP_BYTES / (1024 * 1024), MIN_TRANSFERS, MAX_TRANSFERS);
+    return;
+}
+
+// Parses the command line arguments overriding the default sweep parameters
+static int parse_args(int argc, char **argv, size_t *max_size, int *max_depth,
+        long *num_transfers)
+{
+    int int_arg;
+    char option;
+
+    // Set the default sweep parameters
+    *max_size = DEFAULT_MAX_SIZE;
+    *max_depth = DEFAULT_MAX_DEPTH;
+    *num_transfers = -1;
+
+    while ((option = getopt(argc, argv, "m:d:n:h")) != (char)-1)
+    {
+        switch (option)
+        {
+            // Parse the maximum transfer size argument
+            case 'm':
+                if (parse_int(option, optarg, &int_arg) < 0) {
+                    print_usage(false);
+                    return -EINVAL;
+                } else if (int_arg < MIN_TRANSFER_SIZE) {
+                    fprintf(stderr, "Error: The maximum transfer size must be "
+                            "at least %d bytes.\n", MIN_TRANSFER_SIZE);
+                    return -EINVAL;
+                }
+                *max_size = int_arg;
+                break;
+
+            // Parse the maximum queue depth argument
+            case 'd':
+                if (parse_int(option, optarg, &int_arg) < 0) {
+                    print_usage(false);
+                    return -EINVAL;
+                } else if (int_arg < 1 || int_arg > MAX_QUEUE_DEPTH) {
+                    fprintf(stderr, "Error: The queue depth must be between 1 "
+                            "and %d.\n", MAX_QUEUE_DEPTH);
+                    return -EINVAL;
+                }
+                *max_depth = int_arg;
+                break;
+
+            // Parse the number of transfers argument
+            case 'n':
+                if (parse_int(option, optarg, &int_arg) < 0) {
+                    print_usage(false);
+                    return -EINVAL;
+                } else if (int_arg < 1) {
+                    fprintf(stderr, "Error: The number of transfers must be "
+                            "positive.\n");
+                    return -EINVAL;
+                }
+                *num_transfers = int_arg;
+                break;
+
+            // Print detailed usage message
+            case 'h':
+                print_usage(true);
+                exit(0);
+
+            default:
+                print_usage(false);
+                return -EINVAL;
+        }
+    }
+
+    if (optind < argc) {
+        fprintf(stderr, "Error: Too many command line arguments.\n");
+        print_usage(false);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Transfer Functions
+ *----------------------------------------------------------------------------*/
+
+// Hands the buffers over to the device, if they're cached
+static int sync_for_device(struct sweep_worker *worker, char *tx_buf,
+                           char *rx_buf, size_t size)
+{
+    int rc;
+
+    if (!worker->point->cached) {
+        return 0;
+    }
+
+    rc = axidma_sync_for_device(worker->dev, tx_buf, size);
+    if (rc < 0) {
+        return rc;
+    }
+    return axidma_sync_for_device(worker->dev, rx_buf, size);
+}
+
+// Hands the received data back to the CPU, if the buffer is cached
+static int sync_for_cpu(struct sweep_worker *worker, char *rx_buf, size_t size)
+{
+    if (!worker->point->cached) {
+        return 0;
+    }
+
+    return axidma_sync_for_cpu(worker->dev, rx_buf, size);
+}
+
+// Posts the worker's semaphore whenever a signaled transfer completes
+static void signal_callback(int channel_id, void *data)
+{
+    struct sweep_worker *worker;
+
+    (void)channel_id;
+
+    worker = (struct sweep_worker *)data;
+    sem_post(&worker->completions);
+    return;
+}
+
+// Starts an asynchronous two-way transfer, with the receive started first
+static int start_transfer(struct sweep_worker *worker, size_t size)
+{
+    int rc;
+
+    rc = axidma_oneway_transfer(worker->dev, worker->rx_channel,
+                                worker->rx_buf, size, false);
+    if (rc < 0) {
+        return rc;
+    }
+    return axidma_oneway_transfer(worker->dev, worker->tx_channel,
+                                  worker->tx_buf, size, false);
+}
+
+// Waits for the two signals from both directions of a transfer to complete
+static int wait_signals(struct sweep_worker *worker)
+{
+    int completed;
+
+    completed = 0;
+    while (completed < 2)
+    {
+        if (sem_wait(&worker->completions) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Unable to wait for the transfer to complete");
+            return -errno;
+        }
+        completed += 1;
+    }
+
+    return 0;
+}
+
+// Polls the device until both directions of a transfer have completed
+static int wait_events(struct sweep_worker *worker)
+{
+    int i, completed, num_cqes;
+    struct pollfd pollfd;
+    struct axidma_cqe cqes[2];
+
+    pollfd.fd = axidma_get_event_fd(worker->dev);
+    pollfd.events = POLLIN;
+    completed = 0;
+    while (completed < 2)
+    {
+        if (poll(&pollfd, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Unable to poll for the transfer completions");
+            return -errno;
+        }
+
+        num_cqes = axidma_get_completions(worker->dev, cqes, 2 - completed,
+                                          false);
+        if (num_cqes < 0) {
+            return -errno;
+        }
+        for (i = 0; i < num_cqes; i++)
+        {
+            if (cqes[i].status < 0) {
+                return cqes[i].status;
+            }
+        }
+        completed += num_cqes;
+    }
+
+    return 0;
+}
+
+/* Performs a single two-way transfer, waiting for the completions in the way
+ * specified by the point's mode. */
+static int sweep_transfer(struct sweep_worker *worker)
+{
+    int rc;
+    size_t size;
+
+    size = worker->point->size;
+    rc = sync_for_device(worker, worker->tx_buf, worker->rx_buf, size);
+    if (rc < 0) {
+        return rc;
+    }
+
+    switch (worker->point->mode)
+    {
+        case MODE_SYNC:
+        case MODE_BUSYPOLL:
+            rc = axidma_twoway_transfer(worker->dev, worker->tx_channel,
+                    worker->tx_buf, size, NULL, worker->rx_channel,
+                    worker->rx_buf, size, NULL, true);
+            break;
+
+        case MODE_SIGNAL:
+            rc = start_transfer(worker, size);
+            rc = (rc < 0) ? rc : wait_signals(worker);
+            break;
+
+        case MODE_POLL:
+            rc = start_transfer(worker, size);
+            rc = (rc < 0) ? rc : wait_events(worker);
+            break;
+
+        default:
+            assert(false);
+            rc = -EINVAL;
+            break;
+    }
+    if (rc < 0) {
+        return rc;
+    }
+
+    return sync_for_cpu(worker, worker->rx_buf, size);
+}
+
+/* Syncs a pipelined buffer pair when it completes, and before the stream
+ * submits it again. */
+static void stream_callback(int slot, void *data)
+{
+    char *tx_buf, *rx_buf;
+    size_t size;
+    struct sweep_worker *worker;
+
+    worker = (struct sweep_worker *)data;
+    size = worker->point->size;
+    tx_buf = worker->tx_buf + slot * size;
+    rx_buf = worker->rx_buf + slot * size;
+    if (sync_for_cpu(worker, rx_buf, size) < 0 ||
+        sync_for_device(worker, tx_buf, rx_buf, size) < 0) {
+        worker->rc = -EIO;
+    }
+
+    return;
+}
+
+/* Creates the stream for a pipelined point, carving a buffer pair for each
+ * transfer in flight out of the worker's buffers. */
+static int create_stream(struct sweep_worker *worker)
+{
+    int i, rc, depth;
+    size_t size;
+    void *tx_bufs[MAX_QUEUE_DEPTH], *rx_bufs[MAX_QUEUE_DEPTH];
+
+    size = worker->point->size;
+    depth = worker->point->depth;
+    assert(depth * size <= worker->buf_size);
+    for (i = 0; i < depth; i++)
+    {
+        tx_bufs[i] = worker->tx_buf + i * size;
+        rx_bufs[i] = worker->rx_buf + i * size;
+        rc = sync_for_device(worker, tx_bufs[i], rx_bufs[i], size);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    worker->stream = axidma_stream_create(worker->dev, worker->tx_channel,
+            tx_bufs, size, worker->rx_channel, rx_bufs, size, depth);
+    return (worker->stream == NULL) ? -ENOMEM : 0;
+}
+
+// Runs the point's transfers, once all of the other pairs are ready
+static void *sweep_worker_run(void *arg)
+{
+    int rc;
+    long i;
+    struct sweep_worker *worker;
+    struct sweep_point *point;
+
+    worker = (struct sweep_worker *)arg;
+    point = worker->point;
+    worker->rc = 0;
+    worker->stream = NULL;
+    if (point->mode == MODE_RING) {
+        worker->rc = create_stream(worker);
+    }
+
+    // Even if setup failed, the barrier must be reached to not stall the rest
+    pthread_barrier_wait(&point->barrier);
+    if (worker->rc < 0) {
+        return NULL;
+    }
+
+    if (point->mode == MODE_RING) {
+        rc = axidma_stream_run(worker->stream, point->num_transfers,
+                               stream_callback, worker);
+        worker->rc = (worker->rc < 0) ? worker->rc : rc;
+        axidma_stream_destroy(worker->stream);
+        return NULL;
+    }
+
+    for (i = 0; i < point->num_transfers; i++)
+    {
+        rc = sweep_transfer(worker);
+        if (rc < 0) {
+            worker->rc = rc;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * Sweep Functions
+ *----------------------------------------------------------------------------*/
+
+// Prints the size in the largest unit that it is a whole number of
+static void print_size(size_t size, char *str, size_t len)
+{
+    if (size >= 1024 * 1024 && size % (1024 * 1024) == 0) {
+        snprintf(str, len, "%zu MiB", size / (1024 * 1024));
+    } else if (size >= 1024 && size % 1024 == 0) {
+        snprintf(str, len, "%zu KiB", size / 1024);
+    } else {
+        snprintf(str, len, "%zu B", size);
+    }
+    return;
+}
+
+/* Runs a single point of the sweep on all of the workers at once, and prints
+ * out its row in the table. The throughput is the total across all of the
+ * pairs, in both directions. */
+static int run_point(struct sweep_worker *workers, int num_workers,
+                     struct sweep_point *point)
+{
+    int i, rc;
+    char size_str[16];
+    struct timespec start_time, end_time;
+    double elapsed_time, data_rate, transfer_time;
+
+    rc = pthread_barrier_init(&point->barrier, NULL, num_workers + 1);
+    if (rc != 0) {
+        fprintf(stderr, "Unable to create the barrier: %s.\n", strerror(rc));
+        return -rc;
+    }
+
+    for (i = 0; i < num_workers; i++)
+    {
+        workers[i].point = point;
+        rc = pthread_create(&workers[i].thread, NULL, sweep_worker_run,
+                            &workers[i]);
+        if (rc != 0) {
+            fprintf(stderr, "Unable to create a worker thread: %s.\n",
+                    strerror(rc));
+            exit(1);
+        }
+    }
+
+    // Time from when all of the pairs start until the last one finishes
+    pthread_barrier_wait(&point->barrier);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start_time);
+    rc = 0;
+    for (i = 0; i < num_workers; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        rc = (rc < 0) ? rc : workers[i].rc;
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &end_time);
+    pthread_barrier_destroy(&point->barrier);
+
+    if (rc < 0) {
+        fprintf(stderr, "DMA failed with %s transfers of %zu bytes.\n",
+                mode_names[point->mode], point->size);
+        return rc;
+    }
+
+    elapsed_time = (TSPEC_TO_NSEC(end_time) - TSPEC_TO_NSEC(start_time)) /
+                   1e9;
+    data_rate = 2.0 * num_workers * BYTE_TO_MIB(point->size) *
+                point->num_transfers / elapsed_time;
+    transfer_time = elapsed_time * 1e6 / point->num_transfers;
+
+    print_size(point->size, size_str, sizeof(size_str));
+    printf("%-6s\t%-8s\t%5d\t%5d\t%8s\t%8ld\t%12.2f\t%12.2f\n",
+           mode_names[point->mode], point->cached ? "cached" : "coherent",
+           num_workers, point->depth, size_str, point->num_transfers,
+           data_rate, transfer_time);
+    return 0;
+}
+
+/* Opens a device handle for each pair of channels, and allocates its buffers,
+ * setting up the handle for how the mode waits for completions. Each pair
+ * has its own handle, so that its completions and rings are its own. */
+static int setup_workers(struct sweep_worker *workers, int num_workers,
+        const array_t *tx_chans, const array_t *rx_chans, enum sweep_mode mode,
+        bool cached, size_t buf_size, int max_depth)
+{
+    int i, rc;
+    unsigned int ring_entries;
+    struct sweep_worker *worker;
+
+    memset(workers, 0, num_workers * sizeof(workers[0]));
+    for (i = 0; i < num_workers; i++)
+    {
+        worker = &workers[i];
+        worker->tx_channel = tx_chans->data[i];
+        worker->rx_channel = rx_chans->data[i];
+        worker->buf_size = buf_size;
+        sem_init(&worker->completions, 0, 0);
+
+        worker->dev = axidma_init();
+        if (worker->dev == NULL) {
+            fprintf(stderr, "Failed to initialize the AXI DMA device.\n");
+            return -ENODEV;
+        }
+
+        if (cached) {
+            worker->tx_buf = axidma_malloc_cached(worker->dev, buf_size);
+            worker->rx_buf = axidma_malloc_cached(worker->dev, buf_size);
+        } else {
+            worker->tx_buf = axidma_malloc(worker->dev, buf_size);
+            worker->rx_buf = axidma_malloc(worker->dev, buf_size);
+        }
+        if (worker->tx_buf == NULL || worker->rx_buf == NULL) {
+            fprintf(stderr, "Unable to allocate the buffers for channels %d "
+                    "and %d.\n", worker->tx_channel, worker->rx_channel);
+            return -ENOMEM;
+        }
+        memset(worker->tx_buf, 0xA5, buf_size);
+        memset(worker->rx_buf, 0, buf_size);
+
+        switch (mode)
+        {
+            case MODE_BUSYPOLL:
+                rc = axidma_set_poll_budget(worker->dev, worker->rx_channel,
+                                            SWEEP_POLL_BUDGET);
+                break;
+
+            case MODE_SIGNAL:
+                axidma_set_callback(worker->dev, worker->tx_channel,
+                                    signal_callback, worker);
+                axidma_set_callback(worker->dev, worker->rx_channel,
+                                    signal_callback, worker);
+                rc = 0;
+                break;
+
+            case MODE_POLL:
+                rc = axidma_enable_events(worker->dev, -1);
+                break;
+
+            case MODE_RING:
+                ring_entries = 1;
+                while (ring_entries < 2 * (unsigned int)max_depth)
+                {
+                    ring_entries *= 2;
+                }
+                rc = axidma_ring_init(worker->dev, ring_entries, ring_entries,
+                                      false);
+                break;
+
+            default:
+                rc = 0;
+                break;
+        }
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+// Frees the buffers and closes the device handle of each pair of channels
+static void teardown_workers(struct sweep_worker *workers, int num_workers)
+{
+    int i;
+    struct sweep_worker *worker;
+
+    for (i = 0; i < num_workers; i++)
+    {
+        worker = &workers[i];
+        if (worker->dev == NULL) {
+            continue;
+        }
+
+        if (worker->rx_buf != NULL) {
+            axidma_free(worker->dev, worker->rx_buf, worker->buf_size);
+        }
+        if (worker->tx_buf != NULL) {
+            axidma_free(worker->dev, worker->tx_buf, worker->buf_size);
+        }
+        axidma_destroy(worker->dev);
+        sem_destroy(&worker->completions);
+    }
+
+    return;
+}
+
+/* Sweeps every transfer size for one mode, buffer type, and number of channel
+ * pairs. Pipelined transfers are also swept over each power of two depth, for
+ * the sizes where the transfers in flight fit in the buffers. */
+static int sweep(struct sweep_worker *workers, int num_workers,
+        const array_t *tx_chans, const array_t *rx_chans, enum sweep_mode mode,
+        bool cached, size_t max_size, int max_depth, long num_transfers)
+{
+    int rc, depth;
+    struct sweep_point point;
+
+    rc = setup_workers(workers, num_workers, tx_chans, rx_chans, mode, cached,
+                       max_size, max_depth);
+    if (rc < 0) {
+        goto teardown;
+    }
+
+    point.mode = mode;
+    point.cached = cached;
+    depth = 1;
+    while (true)
+    {
+        point.depth = depth;
+        for (point.size = MIN_TRANSFER_SIZE;
+             point.size * depth <= max_size && rc == 0; point.size *= 2)
+        {
+            point.num_transfers = num_transfers;
+            if (num_transfers < 0) {
+                point.num_transfers = SWEEP_BYTES / point.size;
+                point.num_transfers = (point.num_transfers < MIN_TRANSFERS) ?
+                    MIN_TRANSFERS : point.num_transfers;
+                point.num_transfers = (point.num_transfers > MAX_TRANSFERS) ?
+                    MAX_TRANSFERS : point.num_transfers;
+            }
+            rc = run_point(workers, num_workers, &point);
+        }
+
+        // Only pipelined transfers use a depth beyond one
+        if (rc < 0 || mode != MODE_RING || depth == max_depth) {
+            break;
+        }
+        depth = (2 * depth < max_depth) ? 2 * depth : max_depth;
+    }
+
+teardown:
+    teardown_workers(workers, num_workers);
+    return rc;
+}
+
+/*----------------------------------------------------------------------------
+ * Main Function
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    int rc, i, num_pairs, num_workers;
+    int max_depth;
+    long num_transfers;
+    size_t max_size;
+    bool cached;
+    enum sweep_mode mode;
+    axidma_dev_t axidma_dev;
+    const array_t *tx_chans, *rx_chans;
+    struct sweep_worker *workers;
+
+    if (parse_args(argc, argv, &max_size, &max_depth, &num_transfers) < 0) {
+        rc = 1;
+        goto ret;
+    }
+
+    // Find the channels, the workers open their own handles for the sweep
+    axidma_dev = axidma_init();
+    if (axidma_dev == NULL) {
+        fprintf(stderr, "Failed to initialize the AXI DMA device.\n");
+        rc = 1;
+        goto ret;
+    }
+    tx_chans = axidma_get_dma_tx(axidma_dev);
+    rx_chans = axidma_get_dma_rx(axidma_dev);
+    if (tx_chans->len < 1 || rx_chans->len < 1) {
+        fprintf(stderr, "Error: At least one transmit and receive channel are "
+                "required.\n");
+        rc = 1;
+        goto destroy_axidma;
+    }
+
+    num_pairs = (tx_chans->len < rx_chans->len) ? tx_chans->len : rx_chans->len;
+    workers = calloc(num_pairs, sizeof(workers[0]));
+    if (workers == NULL) {
+        perror("Unable to allocate the channel pairs");
+        rc = 1;
+        goto destroy_axidma;
+    }
+
+    printf("AXI DMA Sweep Parameters:\n");
+    printf("\tTransfer Sizes: %d bytes to %0.2f MiB\n", MIN_TRANSFER_SIZE,
+           BYTE_TO_MIB(max_size));
+    printf("\tMaximum Queue Depth: %d transfers\n", max_depth);
+    printf("\tChannel Pairs: %d\n\n", num_pairs);
+    printf("%-6s\t%-8s\t%5s\t%5s\t%8s\t%8s\t%12s\t%12s\n", "Mode", "Buffers",
+           "Pairs", "Depth", "Size", "Xfers", "Total MiB/s", "us/Xfer");
+
+    /* Sweep each combination of buffer type, number of channel pairs, and
+     * mode. Using all of the pairs is only different with more than one. */
+    rc = 0;
+    for (i = 0; i < 2 * 2 * NUM_MODES && rc == 0; i++)
+    {
+        cached = (i / (2 * NUM_MODES)) == 1;
+        num_workers = ((i / NUM_MODES) % 2 == 0) ? 1 : num_pairs;
+        mode = (enum sweep_mode)(i % NUM_MODES);
+        if ((i / NUM_MODES) % 2 == 1 && num_pairs == 1) {
+            continue;
+        }
+
+        rc = sweep(workers, num_workers, tx_chans, rx_chans, mode, cached,
+                   max_size, max_depth, num_transfers);
+    }
+    rc = (rc < 0) ? 1 : 0;
+
+    free(workers);
+destroy_axidma:
+    axidma_destroy(axidma_dev);
+ret:
+    return rc;
+}
@@ -17,9 +17,19 @@
  * on the PL fabric might depend on. It starts up DMA transfers for these
  * pipeline stages, and discards their results.
  *
+ * With the -z option, the program instead streams the file through the PL
+ * fabric in chunks, so that files larger than memory can be transferred. The
+ * chunks are read and written with O_DIRECT directly into cached DMA buffers,
+ * so the data is never copied by the processor. A reader thread, the DMA
+ * transfers, and a writer thread are pipelined over a ring of these buffers,
+ * so the disk reads, the processing on the fabric, and the disk writes all
+ * overlap. In this mode, the output file is the same size as the input file.
+ *
  * @bug No known bugs.
  **/
 
+#define _GNU_SOURCE             // O_DIRECT flag for open()
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -32,6 +42,7 @@
 #include <string.h>             // Memory setting and copying
 #include <getopt.h>             // Option parsing
 #include <errno.h>              // Error codes
+#include <pthread.h>            // Threads, mutexes, and condition variables
 
 #include "util.h"               // Miscellaneous utilities
 #include "conversion.h"         // Convert bytes to MiBs
@@ -41,6 +52,15 @@
  * Internal Definitions
  *----------------------------------------------------------------------------*/
 
+// The default size of each chunk of the file when streaming (1 MiB)
+#define DEFAULT_CHUNK_SIZE      (1 << 20)
+
+// The default number of chunks that are in the streaming pipeline at once
+#define DEFAULT_STREAM_DEPTH    4
+
+// The alignment required for the file offsets and lengths with O_DIRECT
+#define DIRECT_IO_ALIGN         4096
+
 // A convenient structure to carry information around about the transfer
 struct dma_transfer {
     int input_fd;           // The file descriptor for the input file
@@ -51,6 +71,34 @@ struct dma_transfer {
     int output_channel;     // The channel used to receive the data
     int output_size;        // The amount of data to receive
     void *output_buf;       // The buffer to hold the output
+    bool streaming;         // Stream the file in chunks with O_DIRECT
+    int chunk_size;         // The size of each chunk when streaming
+    int depth;              // The number of chunks in the streaming pipeline
+};
+
+// The stage of the streaming pipeline that a chunk is waiting on
+enum chunk_state {
+    CHUNK_FREE,             // Waiting to be filled from the input file
+    CHUNK_READ,             // Waiting to be sent through the PL fabric
+    CHUNK_PROCESSED,        // Waiting to be written to the output file
+};
+
+// A chunk of the file, and the pair of DMA buffers that hold it
+struct stream_chunk {
+    enum chunk_state state; // The stage that currently owns the chunk
+    int len;                // The length of the data, 0 marks the end of file
+    void *input_buf;        // The buffer holding the input data
+    void *output_buf;       // The buffer holding the output data
+};
+
+// The ring of chunks shared by the stages of the streaming pipeline
+struct stream_pipeline {
+    axidma_dev_t dev;       // The AXI DMA device used for the transfers
+    struct dma_transfer *trans;     // The files and channels being streamed
+    struct stream_chunk *chunks;    // The ring of chunks, of length depth
+    pthread_mutex_t lock;   // Protects the chunk states and the error code
+    pthread_cond_t cond;    // Signaled whenever a chunk changes state
+    int rc;                 // The first error encountered by any stage
 };
 
 /*----------------------------------------------------------------------------
@@ -64,7 +112,7 @@ static void print_usage(bool help)
 
     fprintf(stream, "Usage: axidma_transfer <input path> <output path> "
             "[-t <DMA tx channel>] [-r <DMA rx channel>] [-s <Output file size>"
-            " | -o <Output file size>].\n");
+            " | -o <Output file size> | -z [-c <chunk size>] [-d <depth>]].\n");
     if (!help) {
         return;
     }
@@ -87,13 +135,26 @@ static void print_usage(bool help)
             "Mibs. This is a floating-point value that must be at least the "
             "number of bytes received back. By default, this is the same "
             "the size of the input file.\n");
+    fprintf(stream, "\t-z:\t\t\tStream the file through the PL fabric in "
+            "chunks, reading and writing them with O_DIRECT into cached DMA "
+            "buffers, so that the data is not copied by the processor. The "
+            "files can be larger than memory, and the output file is the same "
+            "size as the input file.\n");
+    fprintf(stream, "\t-c <chunk size>:\tThe size of each chunk when "
+            "streaming, in bytes. This must be a multiple of %d. Implies -z. "
+            "Default is %d bytes.\n", DIRECT_IO_ALIGN, DEFAULT_CHUNK_SIZE);
+    fprintf(stream, "\t-d <depth>:\t\tThe number of chunks that are in the "
+            "streaming pipeline at once. The memory used is the chunk size "
+            "times the depth, for each direction. Implies -z. Default is "
+            "%d.\n", DEFAULT_STREAM_DEPTH);
     return;
 }
 
 /* Parses the command line arguments overriding the default transfer sizes,
  * and number of transfer to use for the benchmark if specified. */
 static int parse_args(int argc, char **argv, char **input_path,
-    char **output_path, int *input_channel, int *output_channel, int *output_size)
+    char **output_path, int *input_channel, int *output_channel, int *output_size,
+    bool *streaming, int *chunk_size, int *depth)
 {
     char option;
     int int_arg;
@@ -105,11 +166,14 @@ static int parse_args(int argc, char **argv, char **input_path,
     *input_channel = -1;
     *output_channel = -1;
     *output_size = -1;
+    *streaming = false;
+    *chunk_size = DEFAULT_CHUNK_SIZE;
+    *depth = DEFAULT_STREAM_DEPTH;
     o_specified = false;
     s_specified = false;
     rc = 0;
 
-    while ((option = getopt(argc, argv, "t:r:s:o:h")) != (char)-1)
+    while ((option = getopt(argc, argv, "t:r:s:o:zc:d:h")) != (char)-1)
     {
         switch (option)
         {
@@ -155,6 +219,40 @@ static int parse_args(int argc, char **argv, char **input_path,
                 o_specified = true;
                 break;
 
+            // Stream the file in chunks with O_DIRECT
+            case 'z':
+                *streaming = true;
+                break;
+
+            // Parse the chunk size for streaming (in bytes)
+            case 'c':
+                rc = parse_int(option, optarg, &int_arg);
+                if (rc < 0) {
+                    print_usage(false);
+                    return rc;
+                } else if (int_arg <= 0 || int_arg % DIRECT_IO_ALIGN != 0) {
+                    fprintf(stderr, "Error: The chunk size must be a positive "
+                            "multiple of %d.\n", DIRECT_IO_ALIGN);
+                    return -EINVAL;
+                }
+                *chunk_size = int_arg;
+                *streaming = true;
+                break;
+
+            // Parse the number of chunks in the streaming pipeline
+            case 'd':
+                rc = parse_int(option, optarg, &int_arg);
+                if (rc < 0) {
+                    print_usage(false);
+                    return rc;
+                } else if (int_arg <= 0) {
+                    fprintf(stderr, "Error: The depth must be positive.\n");
+                    return -EINVAL;
+                }
+                *depth = int_arg;
+                *streaming = true;
+                break;
+
             case 'h':
                 print_usage(true);
                 exit(0);
@@ -180,6 +278,14 @@ static int parse_args(int argc, char **argv, char **input_path,
         return -EINVAL;
     }
 
+    // The output size is fixed when streaming
+    if (*streaming && (s_specified || o_specified)) {
+        fprintf(stderr, "Error: -s and -o can't be specified with -z, -c, or "
+                "-d.\n");
+        print_usage(false);
+        return -EINVAL;
+    }
+
     // Check that there are enough command line arguments
     if (optind > argc-2) {
         fprintf(stderr, "Error: Too few command line arguments.\n");
@@ -252,13 +358,269 @@ ret:
     return rc;
 }
 
+/*----------------------------------------------------------------------------
+ * Streaming Pipeline Functions
+ *----------------------------------------------------------------------------*/
+
+/* Waits for the given chunk to reach the given state. Returns NULL if another
+ * stage of the pipeline encountered an error in the meantime. */
+static struct stream_chunk *wait_chunk(struct stream_pipeline *pipeline,
+                                       int index, enum chunk_state state)
+{
+    struct stream_chunk *chunk;
+
+    chunk = &pipeline->chunks[index];
+    pthread_mutex_lock(&pipeline->lock);
+    while (chunk->state != state && pipeline->rc == 0)
+    {
+        pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+    }
+    if (pipeline->rc < 0) {
+        chunk = NULL;
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return chunk;
+}
+
+// Hands the chunk off to the next stage of the pipeline
+static void advance_chunk(struct stream_pipeline *pipeline,
+                          struct stream_chunk *chunk, enum chunk_state state)
+{
+    pthread_mutex_lock(&pipeline->lock);
+    chunk->state = state;
+    pthread_cond_broadcast(&pipeline->cond);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+// Records the error, and wakes up the other stages so that they stop
+static void fail_pipeline(struct stream_pipeline *pipeline, int rc)
+{
+    pthread_mutex_lock(&pipeline->lock);
+    if (pipeline->rc == 0) {
+        pipeline->rc = rc;
+    }
+    pthread_cond_broadcast(&pipeline->cond);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+/* The reader stage of the pipeline. It fills each free chunk from the input
+ * file, which is only short at the end of the file. An empty chunk is passed
+ * down the pipeline to mark the end of the file. */
+static void *stream_reader(void *arg)
+{
+    int i, len;
+    struct stream_pipeline *pipeline;
+    struct stream_chunk *chunk;
+
+    pipeline = (struct stream_pipeline *)arg;
+    for (i = 0; true; i = (i + 1) % pipeline->trans->depth)
+    {
+        chunk = wait_chunk(pipeline, i, CHUNK_FREE);
+        if (chunk == NULL) {
+            break;
+        }
+
+        len = robust_read(pipeline->trans->input_fd, chunk->input_buf,
+                          pipeline->trans->chunk_size);
+        if (len < 0) {
+            perror("Unable to read from the input file");
+            fail_pipeline(pipeline, -errno);
+            break;
+        }
+
+        chunk->len = len;
+        advance_chunk(pipeline, chunk, CHUNK_READ);
+        if (len == 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/* The writer stage of the pipeline. It writes each processed chunk to the
+ * output file, and then frees it up for the reader again. */
+static void *stream_writer(void *arg)
+{
+    int i, rc, write_len;
+    off_t total_len;
+    struct stream_pipeline *pipeline;
+    struct stream_chunk *chunk;
+
+    pipeline = (struct stream_pipeline *)arg;
+    total_len = 0;
+    for (i = 0; true; i = (i + 1) % pipeline->trans->depth)
+    {
+        chunk = wait_chunk(pipeline, i, CHUNK_PROCESSED);
+        if (chunk == NULL) {
+            break;
+        }
+
+        // Once the end of the file is reached, trim off the padding
+        if (chunk->len == 0) {
+            if (ftruncate(pipeline->trans->output_fd, total_len) < 0) {
+                perror("Unable to set the size of the output file");
+                fail_pipeline(pipeline, -errno);
+            }
+            break;
+        }
+
+        /* O_DIRECT writes must be aligned, so the last chunk is padded out,
+         * and the output file is truncated to the right size at the end. */
+        write_len = (chunk->len + DIRECT_IO_ALIGN - 1) & ~(DIRECT_IO_ALIGN - 1);
+        rc = robust_write(pipeline->trans->output_fd, chunk->output_buf,
+                          write_len);
+        if (rc < 0) {
+            perror("Unable to write to the output file");
+            fail_pipeline(pipeline, -errno);
+            break;
+        }
+
+        total_len += chunk->len;
+        advance_chunk(pipeline, chunk, CHUNK_FREE);
+    }
+
+    return NULL;
+}
+
+/* The DMA stage of the pipeline. It sends each chunk that has been read
+ * through the PL fabric, and hands the result off to the writer. */
+static int stream_transfers(struct stream_pipeline *pipeline)
+{
+    int i, rc;
+    axidma_dev_t dev;
+    struct dma_transfer *trans;
+    struct stream_chunk *chunk;
+
+    dev = pipeline->dev;
+    trans = pipeline->trans;
+    for (i = 0; true; i = (i + 1) % trans->depth)
+    {
+        chunk = wait_chunk(pipeline, i, CHUNK_READ);
+        if (chunk == NULL) {
+            return 0;
+        } else if (chunk->len == 0) {
+            advance_chunk(pipeline, chunk, CHUNK_PROCESSED);
+            return 0;
+        }
+
+        // Send the chunk through the fabric, and receive the result back
+        rc = axidma_sync_for_device(dev, chunk->input_buf, chunk->len);
+        if (rc < 0) {
+            return rc;
+        }
+        rc = axidma_sync_for_device(dev, chunk->output_buf, chunk->len);
+        if (rc < 0) {
+            return rc;
+        }
+        rc = axidma_twoway_transfer(dev, trans->input_channel,
+                chunk->input_buf, chunk->len, NULL, trans->output_channel,
+                chunk->output_buf, chunk->len, NULL, true);
+        if (rc < 0) {
+            fprintf(stderr, "DMA read write transaction failed.\n");
+            return rc;
+        }
+        rc = axidma_sync_for_cpu(dev, chunk->output_buf, chunk->len);
+        if (rc < 0) {
+            return rc;
+        }
+
+        advance_chunk(pipeline, chunk, CHUNK_PROCESSED);
+    }
+}
+
+/* Streams the input file through the PL fabric to the output file in chunks.
+ * The files are opened with O_DIRECT, so the storage device reads and writes
+ * the cached DMA buffers directly, and the data is never copied by the CPU.
+ * The reader and writer run on their own threads, while this thread performs
+ * the DMA transfers, so the memory used is bounded by the pipeline depth. */
+static int stream_file(axidma_dev_t dev, struct dma_transfer *trans,
+                       char *output_path)
+{
+    int rc, i;
+    pthread_t reader, writer;
+    struct stream_pipeline pipeline;
+    struct stream_chunk *chunk;
+
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.dev = dev;
+    pipeline.trans = trans;
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.cond, NULL);
+
+    // Allocate a pair of cached buffers for each chunk, for O_DIRECT to pin
+    pipeline.chunks = calloc(trans->depth, sizeof(pipeline.chunks[0]));
+    if (pipeline.chunks == NULL) {
+        fprintf(stderr, "Failed to allocate the pipeline chunks.\n");
+        rc = -ENOMEM;
+        goto destroy_lock;
+    }
+    for (i = 0; i < trans->depth; i++)
+    {
+        chunk = &pipeline.chunks[i];
+        chunk->state = CHUNK_FREE;
+        chunk->input_buf = axidma_malloc_cached(dev, trans->chunk_size);
+        chunk->output_buf = axidma_malloc_cached(dev, trans->chunk_size);
+        if (chunk->input_buf == NULL || chunk->output_buf == NULL) {
+            fprintf(stderr, "Failed to allocate the buffers for chunk %d.\n",
+                    i);
+            rc = -ENOMEM;
+            goto free_chunks;
+        }
+    }
+
+    // Start up the reader and writer, and perform the transfers on this thread
+    printf("Streaming output data to `%s`.\n", output_path);
+    rc = -pthread_create(&reader, NULL, stream_reader, &pipeline);
+    if (rc < 0) {
+        fprintf(stderr, "Unable to create the reader thread: %s.\n",
+                strerror(-rc));
+        goto free_chunks;
+    }
+    rc = -pthread_create(&writer, NULL, stream_writer, &pipeline);
+    if (rc < 0) {
+        fprintf(stderr, "Unable to create the writer thread: %s.\n",
+                strerror(-rc));
+        fail_pipeline(&pipeline, rc);
+        goto join_reader;
+    }
+
+    rc = stream_transfers(&pipeline);
+    if (rc < 0) {
+        fail_pipeline(&pipeline, rc);
+    }
+
+    // Wait for the file to be written out, and report the first error, if any
+    pthread_join(writer, NULL);
+join_reader:
+    pthread_join(reader, NULL);
+    rc = pipeline.rc;
+free_chunks:
+    for (i = 0; i < trans->depth; i++)
+    {
+        chunk = &pipeline.chunks[i];
+        if (chunk->output_buf != NULL) {
+            axidma_free(dev, chunk->output_buf, trans->chunk_size);
+        }
+        if (chunk->input_buf != NULL) {
+            axidma_free(dev, chunk->input_buf, trans->chunk_size);
+        }
+    }
+    free(pipeline.chunks);
+destroy_lock:
+    pthread_cond_destroy(&pipeline.cond);
+    pthread_mutex_destroy(&pipeline.lock);
+    return rc;
+}
+
 /*----------------------------------------------------------------------------
  * Main
  *----------------------------------------------------------------------------*/
 
 int main(int argc, char **argv)
 {
-    int rc;
+    int rc, open_flags;
     char *input_path, *output_path;
     axidma_dev_t axidma_dev;
     struct stat input_stat;
@@ -268,19 +630,21 @@ int main(int argc, char **argv)
     // Parse the input arguments
     memset(&trans, 0, sizeof(trans));
     if (parse_args(argc, argv, &input_path, &output_path, &trans.input_channel,
-                   &trans.output_channel, &trans.output_size) < 0) {
+                   &trans.output_channel, &trans.output_size, &trans.streaming,
+                   &trans.chunk_size, &trans.depth) < 0) {
         rc = 1;
         goto ret;
     }
 
-    // Try opening the input and output images
-    trans.input_fd = open(input_path, O_RDONLY);
+    // Try opening the input and output images, bypassing the page cache
+    open_flags = trans.streaming ? O_DIRECT : 0;
+    trans.input_fd = open(input_path, O_RDONLY|open_flags);
     if (trans.input_fd < 0) {
         perror("Error opening input file");
         rc = 1;
         goto ret;
     }
-    trans.output_fd = open(output_path, O_WRONLY|O_CREAT|O_TRUNC,
+    trans.output_fd = open(output_path, O_WRONLY|O_CREAT|O_TRUNC|open_flags,
                      S_IWUSR|S_IRUSR|S_IRGRP|S_IWGRP|S_IROTH);
     if (trans.output_fd < 0) {
         perror("Error opening output file");
@@ -332,11 +696,21 @@ int main(int argc, char **argv)
     printf("AXI DMA File Transfer Info:\n");
     printf("\tTransmit Channel: %d\n", trans.input_channel);
     printf("\tReceive Channel: %d\n", trans.output_channel);
-    printf("\tInput File Size: %.2f MiB\n", BYTE_TO_MIB(trans.input_size));
-    printf("\tOutput File Size: %.2f MiB\n\n", BYTE_TO_MIB(trans.output_size));
+    printf("\tInput File Size: %.2f MiB\n", BYTE_TO_MIB(input_stat.st_size));
+    if (trans.streaming) {
+        printf("\tChunk Size: %.2f MiB\n", BYTE_TO_MIB(trans.chunk_size));
+        printf("\tPipeline Depth: %d\n\n", trans.depth);
+    } else {
+        printf("\tOutput File Size: %.2f MiB\n\n",
+               BYTE_TO_MIB(trans.output_size));
+    }
 
     // Transfer the file over the AXI DMA
-    rc = transfer_file(axidma_dev, &trans, output_path);
+    if (trans.streaming) {
+        rc = stream_file(axidma_dev, &trans, output_path);
+    } else {
+        rc = transfer_file(axidma_dev, &trans, output_path);
+    }
     rc = (rc < 0) ? -rc : 0;
 
 destroy_axidma:
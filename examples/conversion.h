@@ -13,11 +13,19 @@
 #define CONVERSION_H_
 
 #include <sys/time.h>           // Timing functions and definitions
+#include <stdint.h>             // Fixed-width integer types
 
 // Converts a tval struct to a double value of the time in seconds
 #define TVAL_TO_SEC(tval) \
     (((double)(tval).tv_sec) + (((double)(tval).tv_usec) / 1000000.0))
 
+// Converts a timespec struct to an integral value of the time in nanoseconds
+#define TSPEC_TO_NSEC(tspec) \
+    (((uint64_t)(tspec).tv_sec) * 1000000000ULL + (uint64_t)(tspec).tv_nsec)
+
+// Converts a nanosecond (integral) value to microseconds (floating-point)
+#define NSEC_TO_USEC(time) (((double)(time)) / 1000.0)
+
 // Converts a byte (integral) value to mebibytes (floating-point)
 #define BYTE_TO_MIB(size) (((double)(size)) / (1024.0 * 1024.0))
 
@@ -17,7 +17,8 @@ include library/library.mk
 
 # The list of example programs
 EXAMPLES_DIR = examples
-EXAMPLES_FILES = axidma_benchmark.c axidma_display_image.c axidma_transfer.c
+EXAMPLES_FILES = axidma_benchmark.c axidma_display_image.c axidma_sweep.c \
+				 axidma_transfer.c
 
 # The variations of specific targets for the example programs
 EXAMPLES_TARGETS = $(EXAMPLES_FILES:%.c=%)
@@ -27,7 +28,7 @@ EXAMPLES_OUTPUT_EXECUTABLES = $(addprefix $(OUTPUT_DIR)/,$(EXAMPLES_TARGETS))
 
 # The local helper function files used across the example programs.
 UTIL_DIR = $(EXAMPLES_DIR)
-UTIL_FILES = util.c
+UTIL_FILES = util.c histogram.c
 UTIL = $(addprefix $(UTIL_DIR)/,$(UTIL_FILES))
 
 # The compiler flags used to compile the examples
@@ -36,7 +37,7 @@ EXAMPLES_CFLAGS = $(GLOBAL_CFLAGS)
 # Set the example executables to link against the AXI DMA shared library in
 # the outputs directory
 EXAMPLES_LINKER_FLAGS = -Wl,-rpath,'$$ORIGIN'
-EXAMPLES_LIB_FLAGS = -L $(OUTPUT_DIR) -l $(LIBAXIDMA_NAME) \
+EXAMPLES_LIB_FLAGS = -L $(OUTPUT_DIR) -l $(LIBAXIDMA_NAME) -l pthread \
 					 $(EXAMPLES_LINKER_FLAGS)
 
 ################################################################################
@@ -0,0 +1,108 @@
+/**
+ * @file histogram.c
+ * @date Wednesday, October 14, 2026 at 06:12:40 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the implementation of the log-bucketed histogram. Each
+ * value is placed into a bucket by its most significant bit, and then into a
+ * sub-bucket by the next HIST_SUB_BUCKET_BITS bits below it.
+ *
+ * @bug No known bugs.
+ **/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include <stdint.h>             // Fixed-width integer types
+#include <string.h>             // Memset function
+
+#include "histogram.h"          // Histogram definitions
+
+/*----------------------------------------------------------------------------
+ * Private Helper Functions
+ *----------------------------------------------------------------------------*/
+
+// Finds the index of the bucket that the value belongs in
+static int hist_index(uint64_t value)
+{
+    int msb, bucket;
+
+    // Small values are recorded exactly, in the first bucket
+    if (value < HIST_SUB_BUCKETS) {
+        return value;
+    }
+
+    // Otherwise, only the most significant bits of the value are kept
+    msb = 63 - __builtin_clzll(value);
+    bucket = msb - HIST_SUB_BUCKET_BITS + 1;
+    return bucket * HIST_SUB_BUCKETS +
+           (int)(value >> (bucket - 1)) - HIST_SUB_BUCKETS;
+}
+
+// Finds the largest value that belongs in the bucket at the given index
+static uint64_t hist_value(int index)
+{
+    int bucket, sub_bucket;
+
+    bucket = index / HIST_SUB_BUCKETS;
+    sub_bucket = index % HIST_SUB_BUCKETS;
+    if (bucket == 0) {
+        return sub_bucket;
+    }
+
+    return (((uint64_t)(HIST_SUB_BUCKETS + sub_bucket + 1)) << (bucket - 1)) -
+           1;
+}
+
+/*----------------------------------------------------------------------------
+ * Histogram Operations
+ *----------------------------------------------------------------------------*/
+
+void hist_init(struct histogram *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT64_MAX;
+    return;
+}
+
+void hist_record(struct histogram *hist, uint64_t value)
+{
+    hist->counts[hist_index(value)] += 1;
+    hist->total += 1;
+    hist->min = (value < hist->min) ? value : hist->min;
+    hist->max = (value > hist->max) ? value : hist->max;
+    return;
+}
+
+/* Finds the value at the given percentile (0 to 100). This is the largest
+ * value in the bucket, limited by the largest value recorded. Returns 0 if the
+ * histogram is empty. */
+uint64_t hist_percentile(const struct histogram *hist, double percentile)
+{
+    int i;
+    uint64_t target, count, value;
+
+    assert(0.0 <= percentile && percentile <= 100.0);
+    if (hist->total == 0) {
+        return 0;
+    }
+
+    // Find the number of values at or below the percentile, at least one
+    target = (uint64_t)(percentile / 100.0 * hist->total + 0.5);
+    target = (target == 0) ? 1 : target;
+
+    count = 0;
+    for (i = 0; i < HIST_NUM_BUCKETS; i++)
+    {
+        count += hist->counts[i];
+        if (count >= target) {
+            break;
+        }
+    }
+
+    value = hist_value(i);
+    return (value < hist->max) ? value : hist->max;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file histogram.h
+ * @date Wednesday, October 14, 2026 at 06:12:40 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the interface for a log-bucketed histogram, in the style
+ * of an HDR histogram. It records values of any magnitude in constant space,
+ * with a fixed relative precision, so that percentiles of the latency can be
+ * reported without storing every sample.
+ *
+ * @bug No known bugs.
+ **/
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stdint.h>             // Fixed-width integer types
+
+// The number of significant bits kept for each value (about 3% precision)
+#define HIST_SUB_BUCKET_BITS    5
+#define HIST_SUB_BUCKETS        (1 << HIST_SUB_BUCKET_BITS)
+
+// The number of buckets needed to hold any 64-bit value
+#define HIST_NUM_BUCKETS        ((65 - HIST_SUB_BUCKET_BITS) * HIST_SUB_BUCKETS)
+
+// A histogram of values, with each power of two split into sub-buckets
+struct histogram {
+    uint64_t counts[HIST_NUM_BUCKETS];  // The number of values in each bucket
+    uint64_t total;                     // The total number of values recorded
+    uint64_t min;                       // The smallest value recorded
+    uint64_t max;                       // The largest value recorded
+};
+
+// Histogram operations
+void hist_init(struct histogram *hist);
+void hist_record(struct histogram *hist, uint64_t value);
+uint64_t hist_percentile(const struct histogram *hist, double percentile);
+
+#endif /* HISTOGRAM_H_ */
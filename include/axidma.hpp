@@ -0,0 +1,674 @@
+/**
+ * @file axidma.hpp
+ * @date Wednesday, October 14, 2026 at 11:26:48 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file defines a header-only C++ interface to the AXI DMA library.
+ *
+ * The device, its buffers, and pools are move-only objects, which release
+ * their resources when they are destroyed, so a buffer always knows its own
+ * size, and whether it goes back to a pool. A #axidma::channel is looked up and
+ * checked once, and then performs transfers on its buffers. Errors are thrown
+ * as std::system_error, with the errno reported by the library.
+ *
+ * Asynchronous transfers go through the shared submission and completion
+ * rings, instead of signals. Their completions are dispatched by
+ * #axidma::device::process_completions, in the calling thread, so an event loop
+ * can poll the file descriptor from #axidma::device::event_fd, and resume the
+ * transfers on its own executor. A transfer can be awaited from a C++20
+ * coroutine, without any allocations, or returned as a std::future.
+ *
+ * Like the rings underneath them, the asynchronous transfers and completions
+ * for a device must all be handled from one thread.
+ *
+ * @bug No known bugs.
+ **/
+
+#ifndef AXIDMA_HPP_
+#define AXIDMA_HPP_
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>                // Coroutine handles and traits
+#define AXIDMA_HAS_COROUTINES 1
+#endif
+
+#include "libaxidma.h"              // The C interface to the AXI DMA library
+
+namespace axidma {
+
+/*----------------------------------------------------------------------------
+ * Internal Definitions
+ *----------------------------------------------------------------------------*/
+
+namespace detail {
+
+// Throws the error in errno left by a failed library call
+[[noreturn]] inline void throw_errno(const char *what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Throws the error in errno if the library call failed
+inline void check(int rc, const char *what)
+{
+    if (rc < 0) {
+        throw_errno(what);
+    }
+}
+
+/* A transfer in flight on the rings. Its address is the user data of the
+ * transfer's ring entries, so that its completion can be dispatched to it. */
+struct operation {
+    void (*complete)(operation *op, const struct axidma_cqe &cqe);
+};
+
+/* Places a transfer into the submission ring, and starts it. Returns a
+ * negative number with errno set if the transfer couldn't be placed in the
+ * ring, in which case it will never complete. Otherwise, it always completes
+ * through the ring, which reports any error it failed with. */
+inline int submit(axidma_dev_t dev, int channel, void *buf, size_t len,
+                  operation *op)
+{
+    int rc;
+
+    rc = axidma_ring_submit(dev, channel, buf, len, op);
+    if (rc < 0) {
+        errno = -rc;
+        return rc;
+    }
+
+    /* The transfer is already in the ring, so it can't be failed here, since
+     * its completion still refers to the operation. If the ring can't be
+     * entered, the transfer stays in it, and is started by the next enter. */
+    do {
+        rc = axidma_ring_enter(dev, 0);
+    } while (rc < 0 && errno == EINTR);
+
+    return 0;
+}
+
+// The error a failed transfer completed with
+inline std::system_error transfer_error(int status)
+{
+    return std::system_error(-status, std::generic_category(),
+                             "AXI DMA transfer failed");
+}
+
+} // namespace detail
+
+/*----------------------------------------------------------------------------
+ * DMA Buffers
+ *----------------------------------------------------------------------------*/
+
+/**
+ * A DMA buffer, allocated from a device or from a pool.
+ *
+ * The buffer is freed when it is destroyed, returning it to its pool, if it
+ * came from one. It can be moved, but not copied.
+ **/
+class dma_buffer {
+public:
+    /// Creates an empty buffer, which owns no memory.
+    dma_buffer() noexcept = default;
+
+    dma_buffer(const dma_buffer &) = delete;
+    dma_buffer &operator=(const dma_buffer &) = delete;
+
+    dma_buffer(dma_buffer &&other) noexcept
+        : dev_(other.dev_), pool_(other.pool_),
+          data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    dma_buffer &operator=(dma_buffer &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            dev_ = other.dev_;
+            pool_ = other.pool_;
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    ~dma_buffer()
+    {
+        reset();
+    }
+
+    /// Frees the buffer, leaving it empty.
+    void reset() noexcept
+    {
+        if (data_ == nullptr) {
+            return;
+        } else if (pool_ != nullptr) {
+            axidma_pool_free(pool_, data_);
+        } else {
+            axidma_free(dev_, data_, size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    /// The address of the buffer, or NULL if it is empty.
+    void *data() const noexcept { return data_; }
+
+    /// The address of the buffer, as an array of the given type.
+    template <typename T>
+    T *as() const noexcept { return static_cast<T *>(data_); }
+
+    /// The size of the buffer in bytes.
+    size_t size() const noexcept { return size_; }
+
+    /// The pool the buffer came from, or NULL if it came from the device.
+    axidma_pool_t pool() const noexcept { return pool_; }
+
+    /// Indicates the buffer owns memory.
+    explicit operator bool() const noexcept { return data_ != nullptr; }
+
+    /// Makes the device's writes to a cached buffer visible to the CPU.
+    void sync_for_cpu() const
+    {
+        detail::check(axidma_sync_for_cpu(dev_, data_, size_),
+                      "Failed to sync the DMA buffer for the CPU");
+    }
+
+    /// Makes the CPU's writes to a cached buffer visible to the device.
+    void sync_for_device() const
+    {
+        detail::check(axidma_sync_for_device(dev_, data_, size_),
+                      "Failed to sync the DMA buffer for the device");
+    }
+
+private:
+    friend class device;
+    friend class pool;
+
+    dma_buffer(axidma_dev_t dev, axidma_pool_t pool, void *data,
+               size_t size) noexcept
+        : dev_(dev), pool_(pool), data_(data), size_(size)
+    {
+    }
+
+    axidma_dev_t dev_ = nullptr;    // The device the buffer belongs to
+    axidma_pool_t pool_ = nullptr;  // The pool the buffer came from, if any
+    void *data_ = nullptr;          // The address of the buffer
+    size_t size_ = 0;               // The size of the buffer in bytes
+};
+
+/**
+ * A pool of equally sized DMA buffers, which are allocated without a system
+ * call. See #axidma_pool_create.
+ *
+ * All of the buffers from the pool must be destroyed before the pool is.
+ **/
+class pool {
+public:
+    pool(axidma_dev_t dev, size_t block_size, size_t num_blocks)
+        : dev_(dev), pool_(axidma_pool_create(dev, block_size, num_blocks))
+    {
+        if (pool_ == nullptr) {
+            detail::throw_errno("Failed to create the DMA buffer pool");
+        }
+    }
+
+    pool(const pool &) = delete;
+    pool &operator=(const pool &) = delete;
+
+    pool(pool &&other) noexcept
+        : dev_(other.dev_), pool_(std::exchange(other.pool_, nullptr))
+    {
+    }
+
+    pool &operator=(pool &&other) noexcept
+    {
+        if (this != &other) {
+            if (pool_ != nullptr) {
+                axidma_pool_destroy(pool_);
+            }
+            dev_ = other.dev_;
+            pool_ = std::exchange(other.pool_, nullptr);
+        }
+        return *this;
+    }
+
+    ~pool()
+    {
+        if (pool_ != nullptr) {
+            axidma_pool_destroy(pool_);
+        }
+    }
+
+    /// Takes a buffer from the pool. Throws with ENOMEM if the pool is empty.
+    dma_buffer allocate()
+    {
+        void *block;
+
+        block = axidma_pool_alloc(pool_);
+        if (block == nullptr) {
+            throw std::system_error(ENOMEM, std::generic_category(),
+                                    "The DMA buffer pool is empty");
+        }
+        return dma_buffer(dev_, pool_, block, axidma_pool_block_size(pool_));
+    }
+
+    /// The size of each buffer in the pool in bytes.
+    size_t block_size() const noexcept
+    {
+        return axidma_pool_block_size(pool_);
+    }
+
+    /// The handle for the pool, for use with the C interface.
+    axidma_pool_t get() const noexcept { return pool_; }
+
+private:
+    axidma_dev_t dev_;              // The device the pool allocates from
+    axidma_pool_t pool_;            // The handle for the pool
+};
+
+/*----------------------------------------------------------------------------
+ * Transfers
+ *----------------------------------------------------------------------------*/
+
+#ifdef AXIDMA_HAS_COROUTINES
+/**
+ * An asynchronous transfer, which can be awaited from a coroutine.
+ *
+ * The transfer is started when it is awaited, and the coroutine is resumed by
+ * #axidma::device::process_completions once it completes. The result of the
+ * await is the number of bytes transferred, or a std::system_error is thrown
+ * if it failed. The state of the transfer lives in the coroutine's frame, so
+ * nothing is allocated.
+ **/
+class transfer_awaitable : private detail::operation {
+public:
+    transfer_awaitable(axidma_dev_t dev, int channel, void *buf,
+                       size_t len) noexcept
+        : operation{&transfer_awaitable::complete}, dev_(dev),
+          channel_(channel), buf_(buf), len_(len)
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        handle_ = handle;
+        if (detail::submit(dev_, channel_, buf_, len_, this) < 0) {
+            status_ = -errno;
+            return false;
+        }
+        return true;
+    }
+
+    size_t await_resume() const
+    {
+        if (status_ < 0) {
+            throw detail::transfer_error(status_);
+        }
+        return bytes_;
+    }
+
+private:
+    static void complete(detail::operation *op,
+                         const struct axidma_cqe &cqe)
+    {
+        transfer_awaitable *self;
+
+        self = static_cast<transfer_awaitable *>(op);
+        self->status_ = cqe.status;
+        self->bytes_ = cqe.bytes;
+        self->handle_.resume();
+    }
+
+    axidma_dev_t dev_;              // The device the transfer is on
+    int channel_;                   // The channel the transfer is on
+    void *buf_;                     // The buffer to transfer
+    size_t len_;                    // The number of bytes to transfer
+    std::coroutine_handle<> handle_;    // The coroutine awaiting the transfer
+    int status_ = 0;                // The status of the completed transfer
+    size_t bytes_ = 0;              // The bytes moved by the transfer
+};
+#endif // AXIDMA_HAS_COROUTINES
+
+namespace detail {
+
+// A transfer whose result is delivered through a promise
+struct future_operation : operation {
+    future_operation() : operation{&future_operation::complete} {}
+
+    static void complete(operation *op, const struct axidma_cqe &cqe)
+    {
+        std::unique_ptr<future_operation> self(
+                static_cast<future_operation *>(op));
+
+        if (cqe.status < 0) {
+            self->promise.set_exception(std::make_exception_ptr(
+                    transfer_error(cqe.status)));
+        } else {
+            self->promise.set_value(cqe.bytes);
+        }
+    }
+
+    std::promise<size_t> promise;   // The promise for the bytes transferred
+};
+
+} // namespace detail
+
+/*----------------------------------------------------------------------------
+ * Channels
+ *----------------------------------------------------------------------------*/
+
+/**
+ * A DMA channel of a device, which is checked once when it is looked up.
+ *
+ * Channels are cheap to copy, and remain valid as long as their device.
+ **/
+class channel {
+public:
+    /// The integer id of the channel.
+    int id() const noexcept { return id_; }
+
+    /// The direction of the channel.
+    enum axidma_dir dir() const noexcept { return dir_; }
+
+    /// The type of the channel, either DMA or VDMA.
+    enum axidma_type type() const noexcept { return type_; }
+
+    /**
+     * Performs a blocking transfer on the channel, of the first \p len bytes
+     * of the buffer. Returns the number of bytes transferred, which is less
+     * than \p len if the stream ended the transfer early. A negative timeout
+     * waits forever, and a timeout of 0 must not be used, since the transfer
+     * then completes asynchronously.
+     **/
+    size_t transfer(const dma_buffer &buf, size_t len, int timeout = -1) const
+    {
+        size_t bytes;
+
+        assert(len <= buf.size() && timeout != 0);
+        detail::check(axidma_oneway_transfer_timeout(dev_, id_, buf.data(),
+                                                     len, timeout, &bytes),
+                      "Failed to perform the AXI DMA transfer");
+        return bytes;
+    }
+
+    /// Performs a blocking transfer of the whole buffer.
+    size_t transfer(const dma_buffer &buf) const
+    {
+        return transfer(buf, buf.size());
+    }
+
+    /**
+     * Starts an asynchronous transfer on the channel, returning a future for
+     * the number of bytes transferred. The rings must have been set up with
+     * #axidma::device::enable_completions. Unlike #async_transfer, this
+     * allocates the state shared with the future.
+     **/
+    std::future<size_t> submit(const dma_buffer &buf, size_t len) const
+    {
+        std::unique_ptr<detail::future_operation> op;
+        std::future<size_t> result;
+
+        assert(len <= buf.size());
+        op.reset(new detail::future_operation());
+        result = op->promise.get_future();
+        detail::check(detail::submit(dev_, id_, buf.data(), len, op.get()),
+                      "Failed to submit the AXI DMA transfer");
+
+        // The operation is freed once it completes
+        op.release();
+        return result;
+    }
+
+#ifdef AXIDMA_HAS_COROUTINES
+    /**
+     * Returns an asynchronous transfer on the channel, for a coroutine to
+     * await. The rings must have been set up with
+     * #axidma::device::enable_completions. The buffer must stay alive until
+     * the transfer completes.
+     **/
+    transfer_awaitable async_transfer(const dma_buffer &buf, size_t len) const
+    {
+        assert(len <= buf.size());
+        return transfer_awaitable(dev_, id_, buf.data(), len);
+    }
+#endif // AXIDMA_HAS_COROUTINES
+
+    /// Stops all transfers on the channel. See #axidma_stop_transfer.
+    void stop() const
+    {
+        axidma_stop_transfer(dev_, id_);
+    }
+
+    /// Claims the channel for this device handle. See #axidma_claim_channel.
+    void claim() const
+    {
+        detail::check(axidma_claim_channel(dev_, id_),
+                      "Failed to claim the AXI DMA channel");
+    }
+
+    /// Releases the channel to other handles. See #axidma_release_channel.
+    void release() const
+    {
+        detail::check(axidma_release_channel(dev_, id_),
+                      "Failed to release the AXI DMA channel");
+    }
+
+    /// Gets the statistics for the channel. See #axidma_get_stats.
+    struct axidma_stats stats() const
+    {
+        struct axidma_stats stats;
+
+        detail::check(axidma_get_stats(dev_, id_, &stats),
+                      "Failed to get the AXI DMA channel statistics");
+        return stats;
+    }
+
+private:
+    friend class device;
+
+    channel(axidma_dev_t dev, int id, enum axidma_dir dir,
+            enum axidma_type type) noexcept
+        : dev_(dev), id_(id), dir_(dir), type_(type)
+    {
+    }
+
+    axidma_dev_t dev_;              // The device the channel belongs to
+    int id_;                        // The integer id of the channel
+    enum axidma_dir dir_;           // The direction of the channel
+    enum axidma_type type_;         // The type of the channel
+};
+
+/*----------------------------------------------------------------------------
+ * Devices
+ *----------------------------------------------------------------------------*/
+
+/**
+ * An AXI DMA device, which is opened when it is created, and closed when it is
+ * destroyed. It can be moved, but not copied.
+ *
+ * Its buffers, pools, and channels must not outlive it.
+ **/
+class device {
+public:
+    /// Opens the device with the given index. See #axidma_init_dev.
+    explicit device(unsigned int index = 0)
+        : dev_(axidma_init_dev(index))
+    {
+        if (dev_ == nullptr) {
+            detail::throw_errno("Failed to open the AXI DMA device");
+        }
+    }
+
+    device(const device &) = delete;
+    device &operator=(const device &) = delete;
+
+    device(device &&other) noexcept
+        : dev_(std::exchange(other.dev_, nullptr))
+    {
+    }
+
+    device &operator=(device &&other) noexcept
+    {
+        if (this != &other) {
+            if (dev_ != nullptr) {
+                axidma_destroy(dev_);
+            }
+            dev_ = std::exchange(other.dev_, nullptr);
+        }
+        return *this;
+    }
+
+    ~device()
+    {
+        if (dev_ != nullptr) {
+            axidma_destroy(dev_);
+        }
+    }
+
+    /// The handle for the device, for use with the C interface.
+    axidma_dev_t get() const noexcept { return dev_; }
+
+    /// Looks up the channel with the given id. Throws with ENODEV if invalid.
+    channel get_channel(int id) const
+    {
+        if (find(axidma_get_dma_tx(dev_), id)) {
+            return channel(dev_, id, AXIDMA_WRITE, AXIDMA_DMA);
+        } else if (find(axidma_get_dma_rx(dev_), id)) {
+            return channel(dev_, id, AXIDMA_READ, AXIDMA_DMA);
+        } else if (find(axidma_get_vdma_tx(dev_), id)) {
+            return channel(dev_, id, AXIDMA_WRITE, AXIDMA_VDMA);
+        } else if (find(axidma_get_vdma_rx(dev_), id)) {
+            return channel(dev_, id, AXIDMA_READ, AXIDMA_VDMA);
+        }
+
+        throw std::system_error(ENODEV, std::generic_category(),
+                                "Invalid AXI DMA channel id");
+    }
+
+    /// Gets the DMA transmit channel with the given index.
+    channel dma_tx_channel(int index = 0) const
+    {
+        return nth_channel(axidma_get_dma_tx(dev_), index, AXIDMA_WRITE,
+                           AXIDMA_DMA);
+    }
+
+    /// Gets the DMA receive channel with the given index.
+    channel dma_rx_channel(int index = 0) const
+    {
+        return nth_channel(axidma_get_dma_rx(dev_), index, AXIDMA_READ,
+                           AXIDMA_DMA);
+    }
+
+    /**
+     * Allocates a DMA buffer from the device. Cached buffers must be synced
+     * around each transfer. See #axidma_malloc and #axidma_malloc_cached.
+     **/
+    dma_buffer allocate(size_t size, bool cached = false) const
+    {
+        void *data;
+
+        data = cached ? axidma_malloc_cached(dev_, size) :
+                        axidma_malloc(dev_, size);
+        if (data == nullptr) {
+            detail::throw_errno("Failed to allocate the DMA buffer");
+        }
+        return dma_buffer(dev_, nullptr, data, size);
+    }
+
+    /// Creates a pool of DMA buffers. See #axidma_pool_create.
+    axidma::pool make_pool(size_t block_size, size_t num_blocks) const
+    {
+        return axidma::pool(dev_, block_size, num_blocks);
+    }
+
+    /**
+     * Sets up the rings for asynchronous transfers, with room for the given
+     * number of transfers in flight. See #axidma_ring_init.
+     **/
+    void enable_completions(unsigned int entries = 256, bool sq_poll = false)
+    {
+        detail::check(axidma_ring_init(dev_, entries, entries, sq_poll),
+                      "Failed to setup the AXI DMA rings");
+    }
+
+    /**
+     * The file descriptor that becomes readable when asynchronous transfers
+     * have completed, which an event loop can poll.
+     **/
+    int event_fd() const noexcept
+    {
+        return axidma_get_event_fd(dev_);
+    }
+
+    /**
+     * Dispatches the completed asynchronous transfers, without a system call.
+     * Their awaiting coroutines are resumed, and their futures are made ready,
+     * in the calling thread. Returns the number of transfers completed.
+     **/
+    int process_completions()
+    {
+        int i, num_cqes, total;
+        struct axidma_cqe cqes[32];
+        detail::operation *op;
+
+        total = 0;
+        do {
+            num_cqes = axidma_ring_reap(dev_, cqes,
+                                        sizeof(cqes) / sizeof(cqes[0]));
+            for (i = 0; i < num_cqes; i++)
+            {
+                op = static_cast<detail::operation *>(cqes[i].user_data);
+                op->complete(op, cqes[i]);
+            }
+            total += num_cqes;
+        } while (num_cqes == sizeof(cqes) / sizeof(cqes[0]));
+
+        return total;
+    }
+
+private:
+    // Checks whether the id is in the array of channel ids
+    static bool find(const array_t *ids, int id) noexcept
+    {
+        int i;
+
+        for (i = 0; i < ids->len; i++)
+        {
+            if (ids->data[i] == id) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Gets the channel with the given index in the array of channel ids
+    channel nth_channel(const array_t *ids, int index, enum axidma_dir dir,
+                        enum axidma_type type) const
+    {
+        if (index < 0 || index >= ids->len) {
+            throw std::system_error(ENODEV, std::generic_category(),
+                                    "No such AXI DMA channel");
+        }
+        return channel(dev_, ids->data[index], dir, type);
+    }
+
+    axidma_dev_t dev_;              // The handle for the device
+};
+
+} // namespace axidma
+
+#endif /* AXIDMA_HPP_ */
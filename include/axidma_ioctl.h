@@ -26,6 +26,18 @@
 // The standard path to the AXI DMA device
 #define AXIDMA_DEV_PATH     ("/dev/" AXIDMA_DEV_NAME)
 
+// The mmap offset used to map the shared submission/completion rings
+#define AXIDMA_MMAP_RING_OFFSET     0x10000000
+
+// The mmap offset used to allocate a cached (non-coherent) DMA buffer
+#define AXIDMA_MMAP_CACHED_OFFSET   0x20000000
+
+// The mmap offset used to map the status of each channel's cyclic transfer
+#define AXIDMA_MMAP_CYCLIC_OFFSET   0x30000000
+
+// The mmap offset of the userspace BD rings, returned by AXIDMA_BDRING_SETUP
+#define AXIDMA_MMAP_BDRING_OFFSET   0x40000000
+
 /*----------------------------------------------------------------------------
  * IOCTL Argument Definitions
  *----------------------------------------------------------------------------*/
@@ -33,6 +45,9 @@
 // Forward declaration of the kernel's DMA channel type (opaque to userspace)
 struct dma_chan;
 
+// Forward declaration of the I/O vector type (from <sys/uio.h> in userspace)
+struct iovec;
+
 // Direction from the persepctive of the processor
 /**
  * Enumeration for direction in a DMA transfer.
@@ -61,12 +76,40 @@ enum axidma_type {
  * Structure representing all of the data about a video frame.
  *
  * This has all the information needed to properly setup an AXI VDMA
- * transaction, which is simply the video dimensions.
+ * transaction, which is the video dimensions, and how the lines are laid out
+ * in memory. With a stride larger than a line, the frame can be a padded
+ * frame, or a rectangle within a larger image, starting at its first pixel.
  **/
 struct axidma_video_frame {
     int height;                     ///< Height of the image in terms of pixels.
     int width;                      ///< Width of the image in terms of pixels.
     int depth;                      ///< Depth of the image in terms of pixels.
+    int stride;                     ///< Bytes between lines, 0 if packed.
+};
+
+/**
+ * The sources of the frame sync for a VDMA channel.
+ **/
+enum axidma_fsync {
+    AXIDMA_FSYNC_NONE,              ///< The channel runs freely
+    AXIDMA_FSYNC_EXTERNAL,          ///< The channel's external fsync input
+    AXIDMA_FSYNC_TUSER,             ///< The stream's tuser signal
+};
+
+/**
+ * Structure with the synchronization settings for a VDMA channel.
+ *
+ * With genlock, a channel follows the frame buffer used by another channel,
+ * so a transmit and receive channel can share frame buffers without tearing,
+ * and without any extra buffering. The slave stays `frame_delay` frames
+ * behind the master.
+ **/
+struct axidma_video_sync {
+    bool gen_lock;                  ///< Follows or leads another channel.
+    bool master;                    ///< Is the genlock master, not a slave.
+    int master_num;                 ///< For a slave, the master to follow.
+    int frame_delay;                ///< For a slave, frames behind the master.
+    enum axidma_fsync fsync;        ///< The source of the frame sync.
 };
 
 // TODO: Channel really should not be here
@@ -91,10 +134,24 @@ struct axidma_channel_info {
 };
 
 struct axidma_signal_info {
-    int signal;
-    void *user_data;
+    int signal;                     // The real-time signal to send
+    void *user_data;                // The value to send with the signal
+};
+
+// Flags for how transfer completions are reported (axidma_notify.flags)
+#define AXIDMA_NOTIFY_SIGNAL        (1 << 0)    // Send the registered signal
+#define AXIDMA_NOTIFY_QUEUE         (1 << 1)    // Queue events for read()
+#define AXIDMA_NOTIFY_FLAGS         (AXIDMA_NOTIFY_SIGNAL | AXIDMA_NOTIFY_QUEUE)
+
+struct axidma_notify {
+    unsigned int flags;             // How to report transfer completions
+    int eventfd;                    // Eventfd to signal on completion, or -1
 };
 
+// The timeouts for synchronous transfers, in milliseconds (timeout fields)
+#define AXIDMA_DEFAULT_TIMEOUT      10000       // The default of 10 seconds
+#define AXIDMA_NO_TIMEOUT           (-1)        // Wait forever
+
 struct axidma_register_buffer {
     int fd;                         // Anonymous file descriptor for DMA buffer
     size_t size;                    // The size of the external DMA buffer
@@ -106,6 +163,8 @@ struct axidma_transaction {
     int channel_id;                 // The id of the DMA channel to use
     void *buf;                      // The buffer used for the transaction
     size_t buf_len;                 // The length of the buffer
+    int timeout;                    // Time to wait in ms, 0 to poll, -1 forever
+    size_t bytes;                   // The bytes transferred, if waited (output)
 
     // Kept as a union for extend ability.
     union {
@@ -113,6 +172,15 @@ struct axidma_transaction {
     };
 };
 
+struct axidma_vec_transaction {
+    bool wait;                      // Indicates if the call is blocking
+    int channel_id;                 // The id of the DMA channel to use
+    int num_vecs;                   // The number of buffers in the vector
+    struct iovec *vecs;             // The buffers used for the transaction
+    int timeout;                    // Time to wait in ms, 0 to poll, -1 forever
+    size_t bytes;                   // The bytes transferred, if waited (output)
+};
+
 struct axidma_inout_transaction {
     bool wait;                      // Indicates if the call is blocking
     int tx_channel_id;              // The id of the transmit DMA channel
@@ -123,6 +191,8 @@ struct axidma_inout_transaction {
     void *rx_buf;                   // The buffer to place the data in
     size_t rx_buf_len;              // The length of the receive buffer
     struct axidma_video_frame rx_frame; // Frame information for receive.
+    int timeout;                    // Time to wait in ms, 0 to poll, -1 forever
+    size_t rx_bytes;                // The bytes received, if waited (output)
 };
 
 struct axidma_video_transaction {
@@ -130,11 +200,233 @@ struct axidma_video_transaction {
     int num_frame_buffers;          // The number of frame buffers to use.
     void **frame_buffers;           // The frame buffer addresses to use for video
     struct axidma_video_frame frame;        // Information about the frame
+    struct axidma_video_sync sync;  // The synchronization settings
+    size_t mmap_size;               // The size of the status region (output)
+    size_t status_offset;           // Offset of the channel's status (output)
+};
+
+struct axidma_batch_entry {
+    int channel_id;                 // The id of the DMA channel to use
+    void *buf;                      // The buffer used for the transaction
+    size_t buf_len;                 // The length of the buffer
+    int cookie;                     // The DMA cookie for the transfer (output)
+};
+
+struct axidma_batch_transaction {
+    int num_entries;                // The number of transfers in the batch
+    struct axidma_batch_entry *entries; // The array of transfers to submit
+};
+
+/**
+ * An entry in the submission queue (SQ) of the shared submission/completion
+ * rings, describing a single asynchronous DMA transfer.
+ **/
+struct axidma_sqe {
+    int channel_id;                 ///< The id of the DMA channel to use.
+    void *buf;                      ///< The buffer used for the transfer.
+    size_t buf_len;                 ///< The length of the buffer.
+    void *user_data;                ///< Opaque value returned in the CQ entry.
+};
+
+/**
+ * An entry in the completion queue (CQ) of the shared submission/completion
+ * rings, describing the result of a single asynchronous DMA transfer.
+ **/
+struct axidma_cqe {
+    void *user_data;                ///< The value from the SQ entry.
+    int channel_id;                 ///< The id of the DMA channel used.
+    int cookie;                     ///< The DMA cookie for the transfer.
+    size_t bytes;                   ///< The number of bytes transferred.
+    int status;                     ///< 0 on success, a negative error code.
+};
+
+/**
+ * The header at the beginning of the shared submission/completion rings.
+ *
+ * The SQ tail and CQ head are written by userspace, and the SQ head and CQ
+ * tail are written by the driver. The indices are free-running, so the
+ * position in the ring is the index masked with the number of entries - 1.
+ **/
+struct axidma_ring_header {
+    unsigned int sq_head;           ///< Next SQ entry consumed by the driver.
+    unsigned int sq_tail;           ///< Next SQ entry written by userspace.
+    unsigned int sq_entries;        ///< The number of entries in the SQ.
+    unsigned int sq_flags;          ///< Flags for the SQ, set by the driver.
+    unsigned int cq_head;           ///< Next CQ entry consumed by userspace.
+    unsigned int cq_tail;           ///< Next CQ entry written by the driver.
+    unsigned int cq_entries;        ///< The number of entries in the CQ.
+};
+
+// Flags for the rings' setup (axidma_ring_setup.flags)
+#define AXIDMA_RING_SQ_POLL         (1 << 0)    // Kernel thread polls the SQ
+
+// Flags for the SQ, set by the driver (axidma_ring_header.sq_flags)
+#define AXIDMA_SQ_NEED_WAKEUP       (1 << 0)    // The SQ thread is asleep
+
+struct axidma_ring_setup {
+    unsigned int sq_entries;        // The number of SQ entries (power of 2)
+    unsigned int cq_entries;        // The number of CQ entries (power of 2)
+    unsigned int flags;             // Flags for the rings' setup
+    unsigned int sq_idle_ms;        // Time before the SQ thread goes to sleep
+    size_t mmap_size;               // The size of the region to map (output)
+    size_t sq_offset;               // Offset of the SQ entries (output)
+    size_t cq_offset;               // Offset of the CQ entries (output)
+};
+
+struct axidma_ring_enter {
+    unsigned int min_complete;      // The number of CQ entries to wait for
+};
+
+struct axidma_sync {
+    void *user_addr;            // The start of the address range to sync
+    size_t size;                // The number of bytes to sync
+};
+
+struct axidma_mem_info {
+    size_t total_size;          // The size of the reserved memory region
+    size_t avail_size;          // The number of bytes not yet allocated
+};
+
+struct axidma_claim {
+    int channel_id;             // The id of the channel to claim or release
+};
+
+struct axidma_cyclic_transaction {
+    int channel_id;             // The id of the DMA channel to use
+    void *buf;                  // The buffer split into periods
+    size_t buf_len;             // The length of the buffer
+    size_t period_len;          // The length of each period in the buffer
+    size_t mmap_size;           // The size of the status region (output)
+    size_t status_offset;       // Offset of the channel's status (output)
+};
+
+/**
+ * The status of a cyclic or video transfer on a channel, in the region shared
+ * with userspace. Only the driver writes to it. For a video transfer, each
+ * frame buffer is a period.
+ **/
+struct axidma_cyclic_status {
+    unsigned int period_count;      ///< Free-running count of periods done.
+    unsigned int num_periods;       ///< The number of periods in the buffer.
+    unsigned int last_period;       ///< The index of the last period done.
+};
+
+struct axidma_export_buffer {
+    void *user_addr;            // The start of the DMA buffer to export
+    int flags;                  // Flags for the file descriptor (O_CLOEXEC)
+    int dmabuf_fd;              // The exported buffer's descriptor (output)
+};
+
+struct axidma_stats {
+    int channel_id;             // The id of the channel to get statistics for
+    unsigned long long bytes;   // Bytes moved by completed transfers (output)
+    unsigned long long transfers;   // Transfers completed (output)
+    unsigned long long errors;  // Transfers that failed (output)
+    unsigned long long timeouts;    // Synchronous transfers timed out (output)
+    unsigned long long prep_failures;   // Transfers not prepared (output)
+    unsigned long long lookup_misses;   // Addresses not in a buffer (output)
+    unsigned int inflight;      // Transfers currently in flight (output)
+    unsigned int max_inflight;  // Most transfers ever in flight (output)
+    unsigned long long busy_time;   // Time busy in nanoseconds (output)
+};
+
+struct axidma_poll_budget {
+    int channel_id;             // The id of the channel to set the budget for
+    unsigned int budget_us;     // Time to spin before sleeping, or 0 for never
+};
+
+struct axidma_prepared_transfer {
+    int channel_id;             // The id of the channel to transfer on
+    void *buf;                  // The buffer used for the transfers
+    size_t buf_len;             // The length of the buffer
+    int handle;                 // The handle for the transfer (output)
+};
+
+struct axidma_prepared_submit {
+    int handle;                 // The handle of the prepared transfer
+    bool wait;                  // Indicates if the call is blocking
+    int timeout;                // For sync, time to wait in ms, or -1 for none
+    size_t bytes;               // For sync, the bytes transferred (output)
+    int cookie;                 // The DMA cookie for the transfer (output)
+};
+
+struct axidma_coalesce {
+    int channel_id;             // The id of the channel to configure
+    unsigned int threshold;     // Frames per interrupt (VDMA only, else 1)
+    unsigned int delay;         // Delay to interrupt anyway (VDMA only, else 0)
+};
+
+struct axidma_video_park {
+    int channel_id;             // The id of the VDMA channel
+    int frame;                  // The frame buffer to park on, or -1 for none
 };
 
 struct axidma_residue {
     int channel_id;             // The id of the DMA channel
-    unsigned int residue;       // The returned residue
+    unsigned int residue;       // The bytes not transferred (output)
+};
+
+struct axidma_dma_addr {
+    void *user_addr;            // The address in a DMA buffer to translate
+    void *seg_addr;             // Start of its contiguous segment (output)
+    size_t seg_size;            // The size of the segment (output)
+    unsigned long long dma_addr;    // Bus address of the segment (output)
+};
+
+/**
+ * A scatter-gather buffer descriptor (BD) of an AXI DMA channel, in the layout
+ * the engine reads and writes it in. Each is aligned to 64 bytes, and the BDs
+ * of a userspace BD ring are already linked together in a circle.
+ **/
+struct axidma_bd {
+    unsigned int next_desc;         ///< Bus address of the next BD.
+    unsigned int next_desc_msb;     ///< Upper 32 bits of the next BD.
+    unsigned int buf_addr;          ///< Bus address of the buffer.
+    unsigned int buf_addr_msb;      ///< Upper 32 bits of the buffer address.
+    unsigned int reserved[2];       ///< Reserved for the engine.
+    unsigned int control;           ///< The length and frame flags.
+    unsigned int status;            ///< Written by the engine on completion.
+    unsigned int app[5];            ///< The stream's application fields.
+    unsigned int padding[3];        ///< Padding to the BD's alignment.
+};
+
+// The fields of the control word of a BD (axidma_bd.control)
+#define AXIDMA_BD_LEN_MASK          0x03FFFFFF  // The length of the buffer
+#define AXIDMA_BD_CTRL_EOF          (1 << 26)   // The last BD of a packet
+#define AXIDMA_BD_CTRL_SOF          (1 << 27)   // The first BD of a packet
+
+// The fields of the status word of a BD (axidma_bd.status)
+#define AXIDMA_BD_STS_RXEOF         (1 << 26)   // Received the end of a packet
+#define AXIDMA_BD_STS_RXSOF         (1 << 27)   // Received a packet's start
+#define AXIDMA_BD_STS_INT_ERR       (1 << 28)   // Internal error of the engine
+#define AXIDMA_BD_STS_SLV_ERR       (1 << 29)   // Slave error on the buffer
+#define AXIDMA_BD_STS_DEC_ERR       (1 << 30)   // Invalid buffer address
+#define AXIDMA_BD_STS_CMPLT         (1U << 31)  // The BD has been completed
+#define AXIDMA_BD_STS_ERRORS        (AXIDMA_BD_STS_INT_ERR | \
+                                     AXIDMA_BD_STS_SLV_ERR | \
+                                     AXIDMA_BD_STS_DEC_ERR)
+
+// Steers a channel's completion wakeups to the callback's CPU (notify_cpu)
+#define AXIDMA_NOTIFY_ANY_CPU       (-1)
+
+struct axidma_affinity {
+    int channel_id;             // The id of the DMA channel
+    unsigned long long irq_cpus;    // Mask of CPUs for its IRQ, 0 to keep
+    int notify_cpu;             // CPU that wakes up completion waiters
+    int irq;                    // The channel's interrupt number (output)
+};
+
+struct axidma_bdring_setup {
+    int channel_id;             // The id of the DMA channel to dedicate
+    unsigned int num_bds;       // The number of BDs in the ring (power of 2)
+    unsigned long long bds_dma; // Bus address of the first BD (output)
+    size_t bds_offset;          // The mmap offset of the BDs (output)
+    size_t bds_size;            // The size of the BDs' mapping (output)
+};
+
+struct axidma_bdring_kick {
+    int channel_id;             // The id of the channel with the BD ring
+    unsigned long long tail_dma;    // Bus address of the last BD to start
 };
 
 /*----------------------------------------------------------------------------
@@ -145,7 +437,30 @@ struct axidma_residue {
 #define AXIDMA_IOCTL_MAGIC              'W'
 
 // The number of IOCTL's implemented, used for verification
-#define AXIDMA_NUM_IOCTLS               11
+#define AXIDMA_NUM_IOCTLS               38
+
+// The maximum number of transfers that can be submitted in a single batch
+#define AXIDMA_MAX_BATCH_ENTRIES        256
+
+// The maximum number of buffers that can be used in a vectored transfer
+#define AXIDMA_MAX_TRANSFER_VECS        256
+
+// The maximum number of entries in the submission or completion ring
+#define AXIDMA_MAX_RING_ENTRIES         4096
+
+// The maximum time a synchronous transfer can spin for, in microseconds
+#define AXIDMA_MAX_POLL_BUDGET          10000
+
+// The maximum genlock master number and frame delay for a VDMA channel
+#define AXIDMA_MAX_GENLOCK_MASTER       15
+#define AXIDMA_MAX_FRAME_DELAY          15
+
+// The maximum interrupt threshold and delay timeout for a channel
+#define AXIDMA_MAX_COALESCE             255
+#define AXIDMA_MAX_COALESCE_DELAY       255
+
+// The maximum number of BDs in a userspace BD ring
+#define AXIDMA_MAX_BDRING_BDS           4096
 
 /**
  * Returns the number of available DMA channels in the system.
@@ -200,16 +515,20 @@ struct axidma_residue {
  *
  * The signal must be one of the POSIX real time signals. So, it must be
  * between the signals SIGRTMIN and SIGRTMAX. The kernel will deliver the
- * channel id back to the userspace signal handler.
+ * user data in the `si_ptr` field, and the channel id in the `si_errno` field
+ * of the signal information to the userspace signal handler.
  *
  * This can be used to have a user callback function, effectively emulating an
  * interrupt in userspace. The user must register their signal handler for
- * the specified signal for this to happen.
+ * the specified signal for this to happen. The signal is only sent if
+ * AXIDMA_NOTIFY_SIGNAL is set with AXIDMA_SET_NOTIFY, which is the default.
  *
  * Inputs:
  *  - signal - The signal to send upon transaction completion.
+ *  - user_data - The value to send along with the signal.
  **/
-#define AXIDMA_SET_DMA_SIGNAL           _IO(AXIDMA_IOCTL_MAGIC, 2)
+#define AXIDMA_SET_DMA_SIGNAL           _IOR(AXIDMA_IOCTL_MAGIC, 2, \
+                                             struct axidma_signal_info)
 
 /**
  * Registers the external DMA buffer with the driver, making it available to be
@@ -228,6 +547,11 @@ struct axidma_residue {
  * an IOCTL. This will return a file descriptor, which the user must pass into
  * this function, along with the virtual address in userspace.
  *
+ * The buffer does not need to be physically contiguous. However, a buffer used
+ * in a AXIDMA_DMA_READ or AXIDMA_DMA_WRITE transfer must fall within one
+ * contiguous segment of it, while AXIDMA_DMA_READ_V and AXIDMA_DMA_WRITE_V
+ * transfers may span any number of segments.
+ *
  * Inputs:
  *  - fd - File descriptor corresponding to the DMA buffer share.
  *  - size - The size of the DMA buffer in bytes.
@@ -248,11 +572,23 @@ struct axidma_residue {
  * call to mmap with the AXI DMA device. Also, the buffer must be able to hold
  * at least `buf_len` bytes.
  *
+ * A blocking call waits for up to `timeout` milliseconds. If the transfer
+ * hasn't completed by then, it is stopped, and the call fails with ETIME. The
+ * number of bytes transferred before it was stopped is still returned, if the
+ * DMA engine can report it, and is zero otherwise. AXIDMA_NO_TIMEOUT waits
+ * forever. A timeout of 0 doesn't wait at all, and leaves the transfer running:
+ * the call returns with `bytes` of 0, and the transfer completes like a
+ * non-blocking one, being reported through the file's notification settings.
+ *
  * Inputs:
  *  - wait - Indicates if the call should be blocking or non-blocking
  *  - channel_id - The id for the channel you want receive data over.
  *  - buf - The address of the buffer you want to receive the data in.
  *  - buf_len - The number of bytes to receive.
+ *  - timeout - The time to wait for a blocking call, in milliseconds.
+ *
+ * Outputs:
+ *  - bytes - For a blocking call, the number of bytes transferred.
  **/
 #define AXIDMA_DMA_READ                 _IOR(AXIDMA_IOCTL_MAGIC, 4, \
                                              struct axidma_transaction)
@@ -269,11 +605,18 @@ struct axidma_residue {
  * call to mmap with the AXI DMA device. Also, the buffer must be able to hold
  * at least `buf_len` bytes.
  *
+ * A blocking call waits for up to `timeout` milliseconds, the same as for
+ * AXIDMA_DMA_READ.
+ *
  * Inputs:
  *  - wait - Indicates if the call should be blocking or non-blocking
  *  - channel_id - The id for the channel you want to send data over.
  *  - buf - The address of the data you want to send.
  *  - buf_len - The number of bytes to send.
+ *  - timeout - The time to wait for a blocking call, in milliseconds.
+ *
+ * Outputs:
+ *  - bytes - For a blocking call, the number of bytes transferred.
  **/
 #define AXIDMA_DMA_WRITE                _IOR(AXIDMA_IOCTL_MAGIC, 5, \
                                              struct axidma_transaction)
@@ -292,6 +635,9 @@ struct axidma_residue {
  * call to mmap with the AXI DMA device. Also, each buffer must be able to hold
  * at least the number of bytes that are being transfered.
  *
+ * A blocking call waits for up to `timeout` milliseconds for the receive
+ * transfer, the same as for AXIDMA_DMA_READ.
+ *
  * Inputs:
  *  - wait - Indicates if the call should be blocking or non-blocking
  *  - tx_channel_id - The id for the channel you want transmit data on.
@@ -299,6 +645,10 @@ struct axidma_residue {
  *  - tx_buf_len - The number of bytes you want to send.
  *  - rx_buf - The address of the buffer you want to receive data in.
  *  - rx_buf_len - The number of bytes you want to receive.
+ *  - timeout - The time to wait for a blocking call, in milliseconds.
+ *
+ * Outputs:
+ *  - rx_bytes - For a blocking call, the number of bytes received.
  **/
 #define AXIDMA_DMA_READWRITE            _IOR(AXIDMA_IOCTL_MAGIC, 6, \
                                              struct axidma_inout_transaction)
@@ -313,13 +663,24 @@ struct axidma_residue {
  *
  * All of the frame buffers must be within an address range that was allocated
  * by a call to mmap with the AXI DMA device. Also, each buffer must
- * be able to hold a frame of (width * height * depth) bytes. The input array of
- * buffers must be a memory location that holds `num_frame_buffers` addresses.
+ * be able to hold a frame of (width * height * depth) bytes, or of
+ * ((height - 1) * stride + width * depth) bytes with a stride. The input array
+ * of buffers must be a memory location that holds `num_frame_buffers`
+ * addresses.
  *
  * This call is always non-blocking as the VDMA engine will run forever. In
  * order to end the transaction, you must make a call to the stop dma channel
  * ioctl.
  *
+ * Each frame buffer is queued to the engine on its own, and queued again as
+ * soon as the engine is done with it. As each frame completes, the driver
+ * increments the frame count in the channel's status, and records the index
+ * of the frame buffer, so userspace can find the most recent frame without any
+ * system calls. The status is in the same region as for AXIDMA_DMA_CYCLIC,
+ * and is mapped the same way, with `mmap_size` and `status_offset`. A
+ * completion event is also queued for each frame, if events are enabled with
+ * AXIDMA_SET_NOTIFY, with the address of the frame buffer as its user data.
+ *
  * Inputs:
  *  - channel_id - The id for the channel you want to send data over.
  *  - num_frame_buffers - The number of frame buffers you're using.
@@ -327,6 +688,15 @@ struct axidma_residue {
  *  - width - The width of the frame (image) in pixels.
  *  - height - The height of the frame in lines.
  *  - depth - The size of each pixel in the frame in bytes.
+ *  - stride - The number of bytes from the start of one line of the frame
+ *             to the next, or 0 if the lines are packed.
+ *  - sync - The genlock and frame sync settings for the channel. The master
+ *           number can be up to AXIDMA_MAX_GENLOCK_MASTER, and the frame
+ *           delay up to AXIDMA_MAX_FRAME_DELAY.
+ *
+ * Outputs:
+ *  - mmap_size - The size of the status region to map.
+ *  - status_offset - The offset of the channel's status in the region.
  **/
 #define AXIDMA_DMA_VIDEO_READ           _IOR(AXIDMA_IOCTL_MAGIC, 7, \
                                              struct axidma_video_transaction)
@@ -341,13 +711,24 @@ struct axidma_residue {
  *
  * All of the frame buffers must be within an address range that was allocated
  * by a call to mmap with the AXI DMA device. Also, each buffer must
- * be able to hold a frame of (width * height * depth) bytes. The input array of
- * buffers must be a memory location that holds `num_frame_buffers` addresses.
+ * be able to hold a frame of (width * height * depth) bytes, or of
+ * ((height - 1) * stride + width * depth) bytes with a stride. The input array
+ * of buffers must be a memory location that holds `num_frame_buffers`
+ * addresses.
  *
  * This call is always non-blocking as the VDMA engine will run forever. In
  * order to end the transaction, you must make a call to the stop dma channel
  * ioctl.
  *
+ * Each frame buffer is queued to the engine on its own, and queued again as
+ * soon as the engine is done with it. As each frame completes, the driver
+ * increments the frame count in the channel's status, and records the index
+ * of the frame buffer, so userspace can find the most recent frame without any
+ * system calls. The status is in the same region as for AXIDMA_DMA_CYCLIC,
+ * and is mapped the same way, with `mmap_size` and `status_offset`. A
+ * completion event is also queued for each frame, if events are enabled with
+ * AXIDMA_SET_NOTIFY, with the address of the frame buffer as its user data.
+ *
  * Inputs:
  *  - channel_id - The id for the channel you want to send data over.
  *  - num_frame_buffers - The number of frame buffers you're using.
@@ -355,20 +736,19 @@ struct axidma_residue {
  *  - width - The width of the frame (image) in pixels.
  *  - height - The height of the frame in lines.
  *  - depth - The size of each pixel in the frame in bytes.
+ *  - stride - The number of bytes from the start of one line of the frame
+ *             to the next, or 0 if the lines are packed.
+ *  - sync - The genlock and frame sync settings for the channel. The master
+ *           number can be up to AXIDMA_MAX_GENLOCK_MASTER, and the frame
+ *           delay up to AXIDMA_MAX_FRAME_DELAY.
+ *
+ * Outputs:
+ *  - mmap_size - The size of the status region to map.
+ *  - status_offset - The offset of the channel's status in the region.
  **/
 #define AXIDMA_DMA_VIDEO_WRITE          _IOR(AXIDMA_IOCTL_MAGIC, 8, \
                                              struct axidma_video_transaction)
 
-/**
- * Get the residue of the last transaction
- *
- * Inputs:
- *  - channel_id - The id for the channel you want to get the residue.
- *  - residue - The returned residue.
- **/
-#define AXIDMA_DMA_RESIDUE              _IOR(AXIDMA_IOCTL_MAGIC, 10, \
-                                             struct axidma_residue)
-
 /**
  * Stops all transactions on the given DMA channel.
  *
@@ -399,6 +779,655 @@ struct axidma_residue {
  **/
 #define AXIDMA_UNREGISTER_BUFFER        _IO(AXIDMA_IOCTL_MAGIC, 10)
 
+/**
+ * Submits a batch of asynchronous DMA transfers with a single call.
+ *
+ * This function prepares and submits every transfer in the given array, and
+ * then flushes each channel used by the batch to the DMA engine once. This
+ * amortizes the cost of the system call and of starting the engine over all of
+ * the transfers, which matters when the transfers are small. The transfers
+ * are always non-blocking, and may be on any mix of AXI DMA channels. The
+ * transfers on a given channel are performed in the order they appear.
+ *
+ * Each buffer must be within an address range that was allocated by a call to
+ * mmap with the AXI DMA device, or registered as an external buffer. The batch
+ * may contain at most AXIDMA_MAX_BATCH_ENTRIES transfers.
+ *
+ * All of the transfers are validated before any of them are submitted, so if
+ * any transfer is invalid, none of them are performed. If the DMA engine fails
+ * to prepare one of the transfers, all channels used by the batch are stopped.
+ *
+ * Inputs:
+ *  - num_entries - The number of transfers in the batch.
+ *  - entries - An array of transfers, each with the following fields:
+ *       - channel_id - The id for the channel to perform the transfer on.
+ *       - buf - The address of the buffer to transfer.
+ *       - buf_len - The number of bytes to transfer.
+ *
+ * Outputs:
+ *  - entries - The cookie field of each transfer is set to the DMA cookie
+ *              assigned to it by the DMA engine.
+ **/
+#define AXIDMA_DMA_SUBMIT_BATCH         _IOR(AXIDMA_IOCTL_MAGIC, 11, \
+                                             struct axidma_batch_transaction)
+
+/**
+ * Sets up the shared submission and completion rings for the device.
+ *
+ * This allocates a submission queue (SQ) and completion queue (CQ) that are
+ * shared between userspace and the driver. After this call, the user maps the
+ * rings into their address space by calling mmap on the AXI DMA device with
+ * `mmap_size` bytes at offset AXIDMA_MMAP_RING_OFFSET. The mapping starts with
+ * a `struct axidma_ring_header`, and the SQ and CQ entry arrays are located at
+ * `sq_offset` and `cq_offset` bytes into the mapping, respectively.
+ *
+ * Userspace submits transfers by writing `struct axidma_sqe` entries into the
+ * SQ, and advancing the SQ tail. The driver consumes them on an
+ * AXIDMA_RING_ENTER call, or from a kernel thread if AXIDMA_RING_SQ_POLL is
+ * specified. When each transfer completes, the driver writes a
+ * `struct axidma_cqe` entry into the CQ, and advances the CQ tail. Userspace
+ * consumes these entries and advances the CQ head, without any system call.
+ *
+ * With AXIDMA_RING_SQ_POLL, a kernel thread continuously polls the SQ for new
+ * entries. After the SQ has been idle for `sq_idle_ms` milliseconds, the
+ * thread goes to sleep and sets AXIDMA_SQ_NEED_WAKEUP in the SQ flags, in which
+ * case the user must call AXIDMA_RING_ENTER to wake it.
+ *
+ * The number of entries in each ring must be a power of two, and at most
+ * AXIDMA_MAX_RING_ENTRIES. The CQ must have at least as many entries as the
+ * SQ. The rings can only be set up once per open of the device.
+ *
+ * Inputs:
+ *  - sq_entries - The number of entries in the SQ.
+ *  - cq_entries - The number of entries in the CQ.
+ *  - flags - The flags for the rings, either 0 or AXIDMA_RING_SQ_POLL.
+ *  - sq_idle_ms - The SQ thread's idle time, when AXIDMA_RING_SQ_POLL is set.
+ *
+ * Outputs:
+ *  - mmap_size - The size of the region to mmap for the rings.
+ *  - sq_offset - The offset of the SQ entry array in the mapped region.
+ *  - cq_offset - The offset of the CQ entry array in the mapped region.
+ **/
+#define AXIDMA_RING_SETUP               _IOR(AXIDMA_IOCTL_MAGIC, 12, \
+                                             struct axidma_ring_setup)
+
+/**
+ * Notifies the driver of new entries in the submission ring, and optionally
+ * waits for entries in the completion ring.
+ *
+ * This acts as the doorbell for the shared rings. The driver consumes all of
+ * the entries in the SQ, prepares the transfers, and starts each channel
+ * used once. If the SQ is polled by a kernel thread, this call instead wakes
+ * up the thread. If `min_complete` is non-zero, the call then blocks until at
+ * least that many entries are available in the CQ.
+ *
+ * The driver will not consume an SQ entry unless there is space in the CQ for
+ * its completion, so that the CQ can never overflow. Any entries left in the
+ * SQ are consumed on a later call, once userspace has consumed CQ entries.
+ *
+ * Inputs:
+ *  - min_complete - The number of CQ entries to wait for.
+ *
+ * Returns the number of SQ entries that were consumed by the call.
+ **/
+#define AXIDMA_RING_ENTER               _IOR(AXIDMA_IOCTL_MAGIC, 13, \
+                                             struct axidma_ring_enter)
+
+/**
+ * Sets how the completion of asynchronous transfers is reported to userspace.
+ *
+ * By default, the driver sends the signal registered with
+ * AXIDMA_SET_DMA_SIGNAL for each completed transfer. Signals are expensive, and
+ * interrupt whatever the process is doing, so the driver can instead queue a
+ * completion event for each transfer, which is then read from the device.
+ *
+ * With AXIDMA_NOTIFY_QUEUE, each completion is queued as a `struct axidma_cqe`,
+ * with a NULL `user_data` field. The events are consumed by calling read() on
+ * the AXI DMA device, which returns as many whole events as fit in the buffer.
+ * The read blocks until an event is available, unless the device was opened
+ * with O_NONBLOCK. Up to 1024 events are queued, after which further events
+ * are dropped, so the user should read them promptly. If any events were
+ * dropped, the next read fails with EOVERFLOW, and the events that are still
+ * queued are returned by the read after it.
+ *
+ * The device is readable with poll() or epoll whenever there are queued events,
+ * or entries in the CQ of the shared submission/completion rings. Thus, a
+ * single event loop can service all the channels, along with any other file
+ * descriptors. If `eventfd` is a valid eventfd, the driver also signals it
+ * whenever an event is queued, or an entry is posted to the CQ.
+ *
+ * These settings only apply to the open file they are set on. Each newly
+ * opened file starts with the default settings.
+ *
+ * Inputs:
+ *  - flags - Any combination of AXIDMA_NOTIFY_SIGNAL and AXIDMA_NOTIFY_QUEUE.
+ *  - eventfd - An eventfd to signal on completion, or -1 for none.
+ **/
+#define AXIDMA_SET_NOTIFY               _IOR(AXIDMA_IOCTL_MAGIC, 14, \
+                                             struct axidma_notify)
+
+/**
+ * Receives data from the logic fabric into a vector of buffers.
+ *
+ * This function behaves like AXIDMA_DMA_READ, except that the data received is
+ * scattered across the given buffers, in order, as a single DMA transfer. The
+ * buffers do not need to be physically contiguous with each other, so a large
+ * transfer can be performed out of many smaller DMA buffers, without copying.
+ *
+ * Each buffer must be within an address range that was allocated by a call to
+ * mmap with the AXI DMA device, or registered as an external buffer. Buffers
+ * in an external buffer may span multiple segments of it. The vector may
+ * contain at most AXIDMA_MAX_TRANSFER_VECS buffers.
+ *
+ * Inputs:
+ *  - wait - Indicates if the call should be blocking or non-blocking
+ *  - channel_id - The id for the channel you want receive data over.
+ *  - num_vecs - The number of buffers in the vector.
+ *  - vecs - An array of `struct iovec`, with the address and length of each
+ *           buffer to receive data into.
+ *  - timeout - The time to wait for a blocking call, in milliseconds.
+ *
+ * Outputs:
+ *  - bytes - For a blocking call, the number of bytes transferred.
+ **/
+#define AXIDMA_DMA_READ_V               _IOR(AXIDMA_IOCTL_MAGIC, 15, \
+                                             struct axidma_vec_transaction)
+
+/**
+ * Sends data from a vector of buffers to the logic fabric.
+ *
+ * This function behaves like AXIDMA_DMA_WRITE, except that the data sent is
+ * gathered from the given buffers, in order, as a single DMA transfer. This
+ * allows for a header and payload in separate buffers to be sent without
+ * copying them together.
+ *
+ * Each buffer must be within an address range that was allocated by a call to
+ * mmap with the AXI DMA device, or registered as an external buffer. Buffers
+ * in an external buffer may span multiple segments of it. The vector may
+ * contain at most AXIDMA_MAX_TRANSFER_VECS buffers.
+ *
+ * Inputs:
+ *  - wait - Indicates if the call should be blocking or non-blocking
+ *  - channel_id - The id for the channel you want to send data over.
+ *  - num_vecs - The number of buffers in the vector.
+ *  - vecs - An array of `struct iovec`, with the address and length of each
+ *           buffer to send.
+ *  - timeout - The time to wait for a blocking call, in milliseconds.
+ *
+ * Outputs:
+ *  - bytes - For a blocking call, the number of bytes transferred.
+ **/
+#define AXIDMA_DMA_WRITE_V              _IOR(AXIDMA_IOCTL_MAGIC, 16, \
+                                             struct axidma_vec_transaction)
+
+/**
+ * Makes the data written by the device to a cached DMA buffer visible to the
+ * CPU.
+ *
+ * By default, DMA buffers allocated with mmap are coherent, which on systems
+ * without a cache-coherent interconnect means they are mapped uncached, so CPU
+ * accesses to them are slow. Passing AXIDMA_MMAP_CACHED_OFFSET as the offset
+ * to mmap instead allocates a buffer that is mapped cached, and is physically
+ * contiguous. The driver does not maintain coherency for these buffers, so the
+ * user must synchronize them around each transfer.
+ *
+ * This must be called after a transfer that receives data into the range
+ * completes, and before the CPU reads the data. The range must be within a
+ * single DMA buffer. For coherent and external buffers, this is a no-op.
+ *
+ * Inputs:
+ *  - user_addr - The start of the address range to synchronize.
+ *  - size - The number of bytes to synchronize.
+ **/
+#define AXIDMA_SYNC_FOR_CPU             _IOR(AXIDMA_IOCTL_MAGIC, 17, \
+                                             struct axidma_sync)
+
+/**
+ * Makes the data written by the CPU to a cached DMA buffer visible to the
+ * device.
+ *
+ * This must be called after the CPU writes data into the range, and before a
+ * transfer that sends the data is started. See AXIDMA_SYNC_FOR_CPU for a
+ * description of cached DMA buffers.
+ *
+ * Inputs:
+ *  - user_addr - The start of the address range to synchronize.
+ *  - size - The number of bytes to synchronize.
+ **/
+#define AXIDMA_SYNC_FOR_DEVICE          _IOR(AXIDMA_IOCTL_MAGIC, 18, \
+                                             struct axidma_sync)
+
+/**
+ * Returns the size of the reserved memory region for DMA buffers, and how much
+ * of it is still available.
+ *
+ * If the driver's device tree node has a 'memory-region' property, then all
+ * DMA buffers allocated with mmap, except cached ones, come from that reserved
+ * region instead of CMA. This allows large buffers to be allocated reliably,
+ * even after memory has become fragmented. The available size is the total
+ * number of free bytes, so a single buffer of that size may not fit, if the
+ * free space is fragmented.
+ *
+ * If there is no reserved region, then both sizes are zero.
+ *
+ * Outputs:
+ *  - total_size - The size of the reserved memory region in bytes.
+ *  - avail_size - The number of bytes in the region not yet allocated.
+ **/
+#define AXIDMA_GET_MEM_INFO             _IOR(AXIDMA_IOCTL_MAGIC, 19, \
+                                             struct axidma_mem_info)
+
+/**
+ * Claims a DMA channel for exclusive use by this open file of the device.
+ *
+ * The AXI DMA device may be opened multiple times, by different processes or
+ * threads. Each open file has its own DMA buffers, notification settings, and
+ * rings, and owns the channels it uses. A channel can only be used by the file
+ * that owns it, so that separate processes can each drive their own channels,
+ * such as a transmit and a receive worker running in parallel.
+ *
+ * A channel is claimed implicitly by the first transfer on it, if it is not
+ * already owned, so this only needs to be called to reserve a channel ahead of
+ * time. Claiming a channel already owned by this file succeeds. Claiming a
+ * channel owned by another file fails with EBUSY, as does any transfer on it.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel to claim.
+ **/
+#define AXIDMA_CLAIM_CHANNEL            _IOR(AXIDMA_IOCTL_MAGIC, 20, \
+                                             struct axidma_claim)
+
+/**
+ * Releases a DMA channel owned by this open file, so that another file can use
+ * it.
+ *
+ * All transfers on the channel are stopped first, as with
+ * AXIDMA_STOP_DMA_CHANNEL. When the file is closed, all of the channels it
+ * owns are released.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel to release.
+ **/
+#define AXIDMA_RELEASE_CHANNEL          _IOR(AXIDMA_IOCTL_MAGIC, 21, \
+                                             struct axidma_claim)
+
+/**
+ * Starts a cyclic transfer on a DMA channel, which runs until it is stopped.
+ *
+ * The buffer is split into periods of `period_len` bytes, and the channel
+ * transfers each one in turn, wrapping around to the first period after the
+ * last, without any gaps between them. This is suitable for continuously
+ * capturing data from a source, such as an ADC, that can't be paused. The
+ * transfer only ends with AXIDMA_STOP_DMA_CHANNEL, and until then, starting
+ * another cyclic transfer on the channel fails with EBUSY.
+ *
+ * Each time a period completes, the driver increments the period count in the
+ * channel's status, so userspace can follow the transfer without any system
+ * calls. The status for every channel is in a region that is mapped by calling
+ * mmap for `mmap_size` bytes at offset AXIDMA_MMAP_CYCLIC_OFFSET, and the
+ * channel's status is at `status_offset` bytes into it. The count wraps
+ * around, so the period the transfer is on is the count modulo the number of
+ * periods. If userspace falls behind by more than the number of periods, then
+ * data has been overwritten.
+ *
+ * The buffer must be physically contiguous, so it must be within a single
+ * buffer allocated with mmap, and its length must be a multiple of the period
+ * length. This is only supported on AXI DMA channels.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel to use for the transfer.
+ *  - buf - The address of the buffer used for the transfer.
+ *  - buf_len - The length of the buffer.
+ *  - period_len - The length of each period in the buffer.
+ *
+ * Outputs:
+ *  - mmap_size - The size of the region holding the status of each channel.
+ *  - status_offset - The offset of the channel's status within the region.
+ **/
+#define AXIDMA_DMA_CYCLIC               _IOR(AXIDMA_IOCTL_MAGIC, 22, \
+                                             struct axidma_cyclic_transaction)
+
+/**
+ * Exports a DMA buffer allocated by the driver to other drivers, through the
+ * DMA buffer sharing interface.
+ *
+ * This is the reverse of AXIDMA_REGISTER_BUFFER. The returned file descriptor
+ * can be passed to any driver that imports DMA buffers, such as a GPU, video,
+ * or network driver, so that it can access the buffer directly, without the
+ * data being copied by the CPU. It can also be mapped with mmap by another
+ * process. The buffer stays allocated until both it is unmapped and the file
+ * descriptor is closed by every user.
+ *
+ * The address must be the start of a buffer allocated with mmap. Buffers from
+ * the reserved memory region can't be exported.
+ *
+ * Inputs:
+ *  - user_addr - The address of the DMA buffer to export.
+ *  - flags - Flags for the new file descriptor, only O_CLOEXEC is supported.
+ *
+ * Outputs:
+ *  - dmabuf_fd - The file descriptor for the exported buffer.
+ **/
+#define AXIDMA_EXPORT_BUFFER            _IOR(AXIDMA_IOCTL_MAGIC, 23, \
+                                             struct axidma_export_buffer)
+
+/**
+ * Returns the statistics for the given channel, counted since the driver was
+ * loaded.
+ *
+ * The statistics show where throughput is lost on a channel. A transfer is in
+ * flight from when it is submitted to the engine until it completes, or the
+ * channel is stopped. The channel is busy while any transfer is in flight.
+ * Cyclic transfers are not counted. The same statistics for every channel can
+ * be read from the stats file in the device's debugfs directory.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel to get the statistics for.
+ *
+ * Outputs:
+ *  - bytes - The number of bytes moved by transfers that completed.
+ *  - transfers - The number of transfers that completed successfully.
+ *  - errors - The number of transfers that failed, or couldn't be submitted.
+ *  - timeouts - The number of synchronous transfers that timed out.
+ *  - prep_failures - The number of transfers the engine couldn't prepare.
+ *  - lookup_misses - The number of transfer addresses that weren't within a
+ *                    DMA buffer.
+ *  - inflight - The number of transfers currently in flight.
+ *  - max_inflight - The most transfers that have been in flight at once.
+ *  - busy_time - The total time the channel has been busy, in nanoseconds.
+ **/
+#define AXIDMA_GET_STATS                _IOR(AXIDMA_IOCTL_MAGIC, 24, \
+                                             struct axidma_stats)
+
+/**
+ * Sets the busy-poll budget for synchronous transfers on a channel.
+ *
+ * By default, a synchronous transfer sleeps until it completes, and is woken
+ * up by the completion callback. Sleeping and being woken up adds tens of
+ * microseconds of latency and jitter to each transfer, which dominates for
+ * small transfers. With a budget, the thread first spins waiting for the
+ * transfer's completion, for up to the given time, before falling back to
+ * sleeping. The thread also stops spinning if the scheduler needs the CPU.
+ *
+ * This is meant for real-time threads on isolated cores, since the CPU is
+ * kept busy while spinning. For a transfer in both directions, the budget of
+ * the receive channel is used. The budget is reset when the channel is
+ * released.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel, which must be owned by the file.
+ *  - budget_us - The maximum time to spin for, up to AXIDMA_MAX_POLL_BUDGET
+ *                microseconds, or 0 to always sleep.
+ **/
+#define AXIDMA_SET_POLL_BUDGET          _IOR(AXIDMA_IOCTL_MAGIC, 25, \
+                                             struct axidma_poll_budget)
+
+/**
+ * Prepares a transfer of a buffer on a channel, to be submitted many times.
+ *
+ * A transfer normally looks up its buffer in the file's DMA buffers, and sets
+ * up its scatter-gather list, each time it is submitted. For a buffer that is
+ * transferred on the same channel over and over, this is done once here, and
+ * the returned handle is submitted with AXIDMA_SUBMIT_PREPARED instead. The
+ * buffer is only looked up again if one of the file's buffers was freed or
+ * unregistered since, so the submission fails once the buffer is gone.
+ *
+ * Inputs:
+ *  - channel_id - The id of the DMA channel, which is claimed for the file.
+ *  - buf - The buffer to transfer, in a DMA buffer of the file.
+ *  - buf_len - The length of the buffer.
+ *
+ * Outputs:
+ *  - handle - The handle for the prepared transfer.
+ **/
+#define AXIDMA_PREPARE_TRANSFER         _IOR(AXIDMA_IOCTL_MAGIC, 26, \
+                                             struct axidma_prepared_transfer)
+
+/**
+ * Submits a transfer prepared with AXIDMA_PREPARE_TRANSFER.
+ *
+ * The transfer behaves the same as one with AXIDMA_DMA_READ or AXIDMA_DMA_WRITE
+ * for the channel's direction. The same handle can be submitted again while
+ * earlier submissions are still in flight.
+ *
+ * Inputs:
+ *  - handle - The handle of the prepared transfer.
+ *  - wait - Indicates if the call should block until the transfer is done.
+ *  - timeout - For a synchronous transfer, how long to wait for it, in ms, the
+ *              same as for AXIDMA_DMA_READ.
+ *
+ * Outputs:
+ *  - bytes - For a synchronous transfer, the number of bytes transferred,
+ *            which is also set when it times out.
+ *  - cookie - The DMA cookie for the transfer.
+ **/
+#define AXIDMA_SUBMIT_PREPARED          _IOR(AXIDMA_IOCTL_MAGIC, 27, \
+                                             struct axidma_prepared_submit)
+
+/**
+ * Frees a transfer prepared with AXIDMA_PREPARE_TRANSFER.
+ *
+ * Submissions of it that are still in flight are unaffected. All prepared
+ * transfers are freed when the file is closed.
+ *
+ * Inputs:
+ *  - handle - The handle of the prepared transfer to free.
+ **/
+#define AXIDMA_UNPREPARE_TRANSFER       _IOR(AXIDMA_IOCTL_MAGIC, 28, \
+                                             struct axidma_prepared_transfer)
+
+/**
+ * Sets the interrupt coalescing for a VDMA channel.
+ *
+ * By default, a channel interrupts once for every frame that completes. With a
+ * higher threshold, it only interrupts once that many frames complete. The
+ * delay timer bounds the latency added by coalescing: if the channel has been
+ * idle for the delay after a frame completes, it interrupts anyway, so the
+ * last frames aren't held back. The delay is in units of the engine's delay
+ * timer, and 0 disables the timer. The settings take effect with the next
+ * transfer, and are reset when the channel is released.
+ *
+ * Coalescing can't be set for AXI DMA channels, so only the defaults, a
+ * threshold of 1 and a delay of 0, are accepted for them. The Xilinx driver
+ * sets their threshold to the number of transfers issued together, every time
+ * they are issued, and it can only configure the control register of VDMA
+ * channels. Issuing many transfers at once, with AXIDMA_DMA_SUBMIT_BATCH or
+ * the shared rings, is what completes them with a single interrupt.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel, which must be owned by the file.
+ *  - threshold - The number of frames that complete for each interrupt, from
+ *                1 to AXIDMA_MAX_COALESCE, or 1 for AXI DMA channels.
+ *  - delay - The delay timeout, up to AXIDMA_MAX_COALESCE_DELAY, or 0 for
+ *            none, which is required for AXI DMA channels.
+ **/
+#define AXIDMA_SET_COALESCE             _IOR(AXIDMA_IOCTL_MAGIC, 29, \
+                                             struct axidma_coalesce)
+
+/**
+ * Parks a video transfer on one of its frame buffers, or resumes it.
+ *
+ * While parked, only the parked frame buffer is queued again once the engine
+ * is done with it, so the channel keeps transferring that frame, and leaves
+ * the others alone. For a capture, this lets userspace process the other
+ * frame buffers in place, without them being overwritten while it does. For
+ * a display, the parked frame is shown until the transfer is resumed. The
+ * frame buffers that were held back are queued again on resuming.
+ *
+ * Inputs:
+ *  - channel_id - The id of the VDMA channel, which has a video transfer
+ *                 running.
+ *  - frame - The index of the frame buffer to park on, or -1 to resume.
+ **/
+#define AXIDMA_VIDEO_PARK               _IOR(AXIDMA_IOCTL_MAGIC, 30, \
+                                             struct axidma_video_park)
+
+/**
+ * Gets the residue of the transfer that completed last on a channel.
+ *
+ * The residue is the number of bytes of the transfer's buffer that weren't
+ * transferred, which is nonzero when a receive is ended early by the stream,
+ * such as by TLAST. This covers transfers from any process. The number of
+ * bytes transferred is also returned directly by the blocking transfer
+ * ioctls, and in each completion event, which avoids this extra call.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel to get the residue of.
+ * Outputs:
+ *  - residue - The residue of the channel's last completed transfer, or 0 if
+ *              no transfer has completed on it yet.
+ **/
+#define AXIDMA_DMA_RESIDUE              _IOR(AXIDMA_IOCTL_MAGIC, 31, \
+                                             struct axidma_residue)
+
+/**
+ * Translates an address in a DMA buffer to the bus address the engine uses.
+ *
+ * This is needed to fill in the BDs of a userspace BD ring. The result covers
+ * the whole physically contiguous segment of the buffer that the address is
+ * in, so that the translation for any other address in the segment can be
+ * computed without another call. Buffers allocated with mmap have a single
+ * segment, while an external buffer may have several. For cached buffers,
+ * the user must still synchronize the data around each transfer.
+ *
+ * Inputs:
+ *  - user_addr - An address within a DMA buffer of the file.
+ *
+ * Outputs:
+ *  - seg_addr - The user address of the start of the segment.
+ *  - seg_size - The size of the segment in bytes.
+ *  - dma_addr - The bus address of the start of the segment.
+ **/
+#define AXIDMA_GET_DMA_ADDR             _IOR(AXIDMA_IOCTL_MAGIC, 32, \
+                                             struct axidma_dma_addr)
+
+/**
+ * Dedicates an AXI DMA channel to a userspace scatter-gather BD ring, which
+ * bypasses the kernel's DMA engine framework.
+ *
+ * Each transfer through the DMA engine framework is prepared, submitted,
+ * issued, and completed through a tasklet, which takes a few microseconds,
+ * and limits the packet rate for small transfers. With a BD ring, the driver
+ * instead allocates a ring of hardware buffer descriptors in coherent memory,
+ * and points the channel at it. Userspace maps the BDs, fills them in itself,
+ * and starts the engine on them with AXIDMA_BDRING_KICK, which writes the bus
+ * address of the last one to the tail register. It then polls the completed
+ * bit in the status of each BD, so only one system call is needed for a batch
+ * of transfers, and no interrupt. The channel's interrupts are disabled while
+ * it is dedicated.
+ *
+ * The BDs are mapped with mmap for `bds_size` bytes at offset `bds_offset`.
+ * The BDs are linked together in a circle, and the engine starts at the first
+ * one, whose bus address is `bds_dma`. Buffer addresses are translated with
+ * AXIDMA_GET_DMA_ADDR.
+ *
+ * The channel must be an AXI DMA channel with scatter-gather enabled. The
+ * ring takes over the channel's whole engine, since both of its channels
+ * share a register page, and are reset together. Thus, every channel of the
+ * engine is claimed by the file, and the setup fails with EBUSY if another
+ * file owns any of them, or if any of them still has transfers that haven't
+ * completed. While the ring exists, none of the engine's channels can be used
+ * for normal transfers or released, though the engine's other channel can
+ * have a BD ring of its own.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel to dedicate to the BD ring.
+ *  - num_bds - The number of BDs, a power of two up to
+ *              AXIDMA_MAX_BDRING_BDS.
+ *
+ * Outputs:
+ *  - bds_dma - The bus address of the first BD.
+ *  - bds_offset - The mmap offset of the BDs.
+ *  - bds_size - The size of the region to map for the BDs.
+ *  - regs_offset - The mmap offset of the channel's registers.
+ *  - regs_size - The size of the region to map for the registers.
+ *  - regs_start - The offset of the channel's registers in their region.
+ **/
+#define AXIDMA_BDRING_SETUP             _IOR(AXIDMA_IOCTL_MAGIC, 33, \
+                                             struct axidma_bdring_setup)
+
+/**
+ * Returns a channel dedicated with AXIDMA_BDRING_SETUP to the driver.
+ *
+ * The channel is stopped, and any BDs still in flight are discarded. Once the
+ * engine has no BD rings left, it is reset through the DMA engine framework,
+ * which restores its channels' interrupts, so that they can be used for
+ * normal transfers again. The BDs must be unmapped first. This is done
+ * automatically when the file is closed.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel with the BD ring.
+ **/
+#define AXIDMA_BDRING_DESTROY           _IOR(AXIDMA_IOCTL_MAGIC, 34, \
+                                             struct axidma_claim)
+
+/**
+ * Gets the CPU affinity of a channel's interrupt, and of the delivery of its
+ * completions.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel to get the affinity of.
+ *
+ * Outputs:
+ *  - irq_cpus - The mask of CPUs the channel's interrupt may be handled on,
+ *               with bit N for CPU N, covering the first 64 CPUs. This is 0
+ *               if the channel's interrupt is not known.
+ *  - notify_cpu - The CPU that wakes up the waiters for its completions, or
+ *                 AXIDMA_NOTIFY_ANY_CPU if that is done where they complete.
+ *  - irq - The channel's interrupt number, or 0 if it is not known.
+ **/
+#define AXIDMA_GET_AFFINITY             _IOR(AXIDMA_IOCTL_MAGIC, 35, \
+                                             struct axidma_affinity)
+
+/**
+ * Sets the CPU affinity of a channel's interrupt, and of the delivery of its
+ * completions.
+ *
+ * The Xilinx DMA driver handles a channel's interrupt, and completes its
+ * transfers from a tasklet, on whichever CPU the interrupt is routed to. By
+ * default, the eventfd and the waiters for the completion events and the CQ
+ * are then woken up from that same CPU. Pinning the interrupt to the core that
+ * submits and consumes the channel's transfers keeps all of the channel's data
+ * in that core's cache, and keeps the interrupts off of other isolated cores.
+ *
+ * Separately, the wakeups for the channel's completions can be steered to a
+ * given CPU. They are then done from a work item on that CPU, so that the
+ * consumer thread running there doesn't need a wakeup from another core. This
+ * adds the latency of scheduling the work item, so it is most useful when the
+ * interrupt can't be moved. Signals, and synchronous transfers, are not
+ * affected by it.
+ *
+ * The interrupt's affinity is set as its affinity hint, which is shown in
+ * /proc/irq. Both are reset when the channel is released, so the interrupt may
+ * be handled on any online CPU again. The channel is claimed by the file, if
+ * it isn't already.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel, not owned by another file.
+ *  - irq_cpus - The mask for the CPUs the channel's interrupt may be
+ *               handled on, with bit N for CPU N, or 0 to leave it as is.
+ *  - notify_cpu - The online CPU to wake up the completion waiters from, or
+ *                 AXIDMA_NOTIFY_ANY_CPU for wherever they complete.
+ **/
+#define AXIDMA_SET_AFFINITY             _IOR(AXIDMA_IOCTL_MAGIC, 36, \
+                                             struct axidma_affinity)
+
+/**
+ * Starts the engine of a BD ring on the BDs up to the given one, by writing
+ * its bus address to the channel's tail register.
+ *
+ * The BDs must be filled in before this call. The tail must be the bus address
+ * of one of the ring's BDs. If the channel has halted on an error, the tail
+ * isn't written, and this fails with EIO, in which case the ring must be
+ * destroyed.
+ *
+ * Inputs:
+ *  - channel_id - The id of the channel with the BD ring.
+ *  - tail_dma - The bus address of the last BD to start the engine on.
+ **/
+#define AXIDMA_BDRING_KICK              _IOR(AXIDMA_IOCTL_MAGIC, 37, \
+                                             struct axidma_bdring_kick)
+
 #endif /* AXIDMA_IOCTL_H_ */
 
 #endif
\ No newline at end of file
@@ -6,13 +6,26 @@
  *
  * This file defines the interface to the AXI DMA device through the AXI DMA
  * library.
+ *
+ * The transfer functions, the buffer allocation functions, and the pool
+ * functions are safe to call concurrently from multiple threads, on the same
+ * or on different channels. The driver takes no device-wide lock to start a
+ * transfer, so threads driving different channels never wait on each other.
+ * The remaining functions, such as #axidma_init, #axidma_destroy,
+ * #axidma_set_callback, and the ring functions, modify the state of the
+ * device, so they must not be called while another thread is using it.
  **/
 
 #ifndef LIBAXIDMA_H_
 #define LIBAXIDMA_H_
 #ifdef LINUX_APP
+#include <sys/uio.h>        // I/O vector structure
 #include "axidma_ioctl.h"   // Video frame structure
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * The struct representing an AXI DMA device.
  *
@@ -29,6 +42,80 @@ struct axidma_dev;
  **/
 typedef struct axidma_dev* axidma_dev_t;
 
+/**
+ * The struct representing a pool of DMA buffers.
+ *
+ * This is an opaque type to the end user, so it can only be used as a pointer
+ * or handle.
+ **/
+struct axidma_pool;
+
+/**
+ * Type definition for a pool of DMA buffers.
+ *
+ * This is a pointer to an opaque struct, so the user cannot access any of the
+ * internal fields.
+ **/
+typedef struct axidma_pool* axidma_pool_t;
+
+/**
+ * The struct representing a stream of pipelined two-way transfers.
+ *
+ * This is an opaque type to the end user, so it can only be used as a pointer
+ * or handle.
+ **/
+struct axidma_stream;
+
+/**
+ * Type definition for a stream of pipelined two-way transfers.
+ *
+ * This is a pointer to an opaque struct, so the user cannot access any of the
+ * internal fields.
+ **/
+typedef struct axidma_stream* axidma_stream_t;
+
+/**
+ * The struct representing a group of AXI DMA devices, which stripes a stream
+ * across all of them.
+ *
+ * This is an opaque type to the end user, so it can only be used as a pointer
+ * or handle.
+ **/
+struct axidma_group;
+
+/**
+ * Type definition for a group of AXI DMA devices.
+ *
+ * This is a pointer to an opaque struct, so the user cannot access any of the
+ * internal fields.
+ **/
+typedef struct axidma_group* axidma_group_t;
+
+/**
+ * The struct representing a channel's userspace BD ring.
+ *
+ * This is an opaque type to the end user, so it can only be used as a pointer
+ * or handle.
+ **/
+struct axidma_bdring;
+
+/**
+ * Type definition for a channel's userspace BD ring.
+ *
+ * This is a pointer to an opaque struct, so the user cannot access any of the
+ * internal fields.
+ **/
+typedef struct axidma_bdring* axidma_bdring_t;
+
+/**
+ * The completion of a buffer posted to a userspace BD ring.
+ **/
+struct axidma_bd_completion {
+    void *buf;                  ///< The buffer given to #axidma_bdring_post.
+    size_t bytes;               ///< The number of bytes transferred.
+    int status;                 ///< 0 on success, -EIO if the engine failed.
+};
+
 /**
  * A structure that represents an integer array.
  *
@@ -48,6 +135,27 @@ typedef struct array {
  **/
 typedef void (*axidma_cb_t)(int channel_id, void *data);
 
+/**
+ * Type definition for a stream completion callback function.
+ *
+ * The callback function is invoked by #axidma_stream_run each time both the
+ * transmit and receive transfers on a buffer pair have completed. The library
+ * will pass the index of the buffer pair, and the generic data the user gave.
+ * The pair is only submitted again once the callback returns, so it is free to
+ * read the receive buffer and refill the transmit buffer.
+ **/
+typedef void (*axidma_stream_cb_t)(int slot, void *data);
+
+/**
+ * Type definition for a device group completion callback function.
+ *
+ * The callback function is invoked by #axidma_group_transfer for each chunk of
+ * the stream, in the order of the stream, once the chunk and all of the chunks
+ * before it have completed. The library will pass the index of the chunk, the
+ * number of bytes received for it, and the generic data the user gave.
+ **/
+typedef void (*axidma_group_cb_t)(long chunk, size_t rx_bytes, void *data);
+
 /**
  * Initializes the first AXI DMA device, returning a handle to the device.
  *
@@ -64,10 +172,11 @@ struct axidma_dev *axidma_init();
 /**
  * Initializes a AXI DMA device, returning a handle to the device.
  *
- * There is only one AXI DMA device per DMA, since it represents all of the
- * available channels. Thus, this function should only be invoked once for every
- * DMA, unless a call has been made to #axidma_destroy. Otherwise, this function
- * will abort.
+ * The device may be opened by several processes at the same time, or several
+ * times by the same process. Each handle has its own DMA buffers and completion
+ * notifications, and owns the channels that it transfers on, so separate
+ * processes can drive separate channels in parallel. See
+ * #axidma_claim_channel.
  *
  * @param[in] index The index of the device, specified in the device tree.
  * @return A handle to the AXI DMA device on success, NULL on failure.
@@ -125,6 +234,142 @@ const array_t *axidma_get_vdma_tx(axidma_dev_t dev);
  **/
 const array_t *axidma_get_vdma_rx(axidma_dev_t dev);
 
+/**
+ * Claims a DMA channel for exclusive use by this device handle.
+ *
+ * Each channel is owned by at most one handle at a time, and only that handle
+ * can perform transfers on it. A channel is claimed automatically by the first
+ * transfer on it, so this is only needed to reserve a channel ahead of time,
+ * for instance before handing other channels off to another process. Claiming
+ * a channel owned by another handle fails. When the handle is destroyed, all
+ * of the channels it owns are released.
+ *
+ * This function will abort if the channel is invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel to claim.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_claim_channel(axidma_dev_t dev, int channel);
+
+/**
+ * Releases a DMA channel owned by this device handle, so that another handle
+ * can use it.
+ *
+ * Any transfers still running on the channel are stopped. This function will
+ * abort if the channel is invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel to release.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_release_channel(axidma_dev_t dev, int channel);
+
+/**
+ * Sets how long synchronous transfers on the channel spin waiting for their
+ * completion, before sleeping.
+ *
+ * A synchronous transfer normally sleeps until it completes. Being woken up
+ * again adds tens of microseconds of latency and jitter, which dominates the
+ * time for small transfers. With a budget, the driver spins on the transfer's
+ * completion for up to \p budget_us microseconds first. This keeps the CPU
+ * busy, so it is meant for real-time threads on isolated cores. For
+ * #axidma_twoway_transfer, the budget of the receive channel is used.
+ *
+ * Transfers through the completion ring don't need this, since the completion
+ * ring can be polled directly with #axidma_ring_reap, without any system call.
+ *
+ * The channel is claimed by this handle if it isn't already. This function
+ * will abort if the channel is invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel to set the budget for.
+ * @param[in] budget_us The maximum time to spin for, up to
+ *                      AXIDMA_MAX_POLL_BUDGET microseconds, or 0 to always
+ *                      sleep.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_set_poll_budget(axidma_dev_t dev, int channel,
+                           unsigned int budget_us);
+
+/**
+ * Sets the interrupt coalescing for a channel, trading a bounded amount of
+ * latency for fewer interrupts.
+ *
+ * By default, a VDMA channel interrupts once for every frame. With a higher
+ * \p threshold, the channel only interrupts once that many frames complete.
+ * If the channel is idle for \p delay after a frame completes, it interrupts
+ * anyway, so the last frames aren't held back.
+ *
+ * Coalescing is only supported for VDMA channels. For an AXI DMA channel, the
+ * threshold must be 1 and the delay 0, since the Xilinx driver sets the
+ * threshold to the number of transfers issued together. Use
+ * #axidma_submit_batch or the shared rings to issue transfers together, so
+ * that they complete with a single interrupt.
+ *
+ * The channel is claimed by this handle if it isn't already, and the settings
+ * are reset when it is released. This function will abort if the channel is
+ * invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel to configure.
+ * @param[in] threshold The number of frames that complete for each interrupt
+ *                      of a VDMA channel, from 1 to AXIDMA_MAX_COALESCE. This
+ *                      must be 1 for an AXI DMA channel.
+ * @param[in] delay The delay timeout, in units of the engine's delay timer,
+ *                  up to AXIDMA_MAX_COALESCE_DELAY, or 0 for none. This must
+ *                  be 0 for an AXI DMA channel.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_set_coalesce(axidma_dev_t dev, int channel, unsigned int threshold,
+                        unsigned int delay);
+
+/**
+ * Gets the CPUs that a channel's interrupt is handled on, and the CPU that its
+ * completions are delivered to userspace from.
+ *
+ * This function will abort if the channel is invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel to query.
+ * @param[out] irq_cpus The mask of the CPUs that the channel's interrupt is
+ *                      handled on, where bit N is CPU N. This is 0 if the
+ *                      channel has no interrupt.
+ * @param[out] notify_cpu The CPU that completions are delivered from, or
+ *                        AXIDMA_NOTIFY_ANY_CPU if they are delivered from the
+ *                        CPU that handles the interrupt.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_get_affinity(axidma_dev_t dev, int channel,
+                        unsigned long long *irq_cpus, int *notify_cpu);
+
+/**
+ * Sets the CPUs that a channel's interrupt is handled on, and the CPU that its
+ * completions are delivered to userspace from.
+ *
+ * Pinning the interrupt, the completion wakeups, and the thread that waits for
+ * them to the same core keeps the completion path in that core's cache. It
+ * keeps the wakeups of a latency sensitive channel off of the cores doing
+ * other work. The wakeups of #axidma_ring_enter, and of the events enabled with
+ * #axidma_enable_events, are steered to \p notify_cpu. Signals and synchronous
+ * transfers are always completed from the CPU that handles the interrupt.
+ *
+ * The channel is claimed by this handle if it isn't already. Both settings are
+ * reset when the channel is released, so that the interrupt may be handled on
+ * any online CPU again. This function will abort if the channel is invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel to configure.
+ * @param[in] irq_cpus The mask of the CPUs to handle the channel's interrupt
+ *                     on, where bit N is CPU N, or 0 to leave it unchanged.
+ * @param[in] notify_cpu The CPU to deliver completions from, or
+ *                       AXIDMA_NOTIFY_ANY_CPU to deliver them from the CPU
+ *                       that handles the interrupt.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_set_affinity(axidma_dev_t dev, int channel,
+                        unsigned long long irq_cpus, int notify_cpu);
+
 /**
  * Allocates DMA buffer suitable for an AXI DMA/VDMA device of \p size bytes.
  *
@@ -140,7 +385,99 @@ const array_t *axidma_get_vdma_rx(axidma_dev_t dev);
 void *axidma_malloc(axidma_dev_t dev, size_t size);
 
 /**
- * Frees a DMA buffer previously allocated by #axidma_malloc.
+ * Allocates a cached DMA buffer suitable for an AXI DMA/VDMA device of \p size
+ * bytes.
+ *
+ * Buffers from #axidma_malloc are coherent, which on systems without a
+ * cache-coherent port to the FPGA means they are mapped uncached, so the
+ * processor accesses them slowly. This function instead allocates a buffer
+ * that is physically contiguous, and mapped cached. The processor can then
+ * access it at full speed, but it is not coherent with the FPGA, so the user
+ * must call #axidma_sync_for_device before each transfer that sends data from
+ * it, and #axidma_sync_for_cpu after each transfer that receives data into it.
+ *
+ * Cached buffers are allocated from the kernel's page allocator, rather than
+ * CMA, so they are limited in size, typically to 4 MiB. The buffer is freed
+ * with #axidma_free. Since the buffer is made up of normal pages, it can be
+ * used directly for O_DIRECT file I/O, so data can move between a file and the
+ * FPGA without being copied by the processor.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] size The size of the buffer in bytes.
+ * @return The address of buffer on success, NULL on failure.
+ **/
+void *axidma_malloc_cached(axidma_dev_t dev, size_t size);
+
+/**
+ * Makes data received into a cached DMA buffer visible to the processor.
+ *
+ * This must be called after a transfer that receives data into the range
+ * completes, and before the data is read. The range must be within a single
+ * DMA buffer. For buffers that are not cached, this does nothing.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] addr The start of the range, within a buffer previously allocated
+ *                 by #axidma_malloc_cached.
+ * @param[in] size The number of bytes to synchronize.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_sync_for_cpu(axidma_dev_t dev, void *addr, size_t size);
+
+/**
+ * Makes data written into a cached DMA buffer visible to the device.
+ *
+ * This must be called after the processor writes data into the range, and
+ * before a transfer that sends it is started. The range must be within a single
+ * DMA buffer. For buffers that are not cached, this does nothing.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] addr The start of the range, within a buffer previously allocated
+ *                 by #axidma_malloc_cached.
+ * @param[in] size The number of bytes to synchronize.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_sync_for_device(axidma_dev_t dev, void *addr, size_t size);
+
+/**
+ * Gets the size of the reserved memory region for DMA buffers, and how much of
+ * it is still available.
+ *
+ * If the driver's device tree node specifies a reserved memory region, then
+ * buffers from #axidma_malloc are allocated from it, instead of from CMA, so
+ * large buffers can be allocated reliably after long uptimes. This allows the
+ * application to size its buffers and pools at initialization time. The
+ * available size is the total number of free bytes, which may be fragmented.
+ *
+ * If there is no reserved region, then both sizes are zero.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[out] total_size The size of the region in bytes. May be NULL.
+ * @param[out] avail_size The number of bytes not yet allocated. May be NULL.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_get_mem_info(axidma_dev_t dev, size_t *total_size,
+                        size_t *avail_size);
+
+/**
+ * Gets the driver's statistics for the given channel.
+ *
+ * The statistics are counted by the driver since it was loaded, across every
+ * process that has used the channel. They include the number of bytes and
+ * transfers completed, the number of transfers that failed or timed out, the
+ * most transfers that were in flight at once, and the total time the channel
+ * has been busy. Comparing the busy time against the elapsed time shows whether
+ * the channel is kept fed. This function will abort if the channel is invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the statistics are for.
+ * @param[out] stats The statistics for the channel.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_get_stats(axidma_dev_t dev, int channel, struct axidma_stats *stats);
+
+/**
+ * Frees a DMA buffer previously allocated by #axidma_malloc or
+ * #axidma_malloc_cached.
  *
  * This function will abort if \p addr is not an address previously returned by
  * #axidma_malloc, or if \p size does not match the value used when the buffer
@@ -153,6 +490,69 @@ void *axidma_malloc(axidma_dev_t dev, size_t size);
  **/
 void axidma_free(axidma_dev_t dev, void *addr, size_t size);
 
+/**
+ * Creates a pool of fixed-size DMA buffers.
+ *
+ * Since #axidma_malloc is an expensive operation, this allocates one large
+ * region with it at creation time, and carves it into \p num_blocks blocks of
+ * at least \p block_size bytes each. Blocks are then allocated and freed with
+ * #axidma_pool_alloc and #axidma_pool_free in constant time, without any system
+ * calls. The blocks can be used directly in any DMA transfer. For buffers of
+ * several different sizes, create a pool for each size class.
+ *
+ * The block size is rounded up to a multiple of the cache line size, so that
+ * blocks never share cache lines.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] block_size The minimum size of each block in bytes.
+ * @param[in] num_blocks The number of blocks in the pool.
+ * @return A handle to the pool upon success, NULL on failure.
+ **/
+axidma_pool_t axidma_pool_create(axidma_dev_t dev, size_t block_size,
+        size_t num_blocks);
+
+/**
+ * Destroys a pool of DMA buffers, freeing its region.
+ *
+ * All of the blocks in the pool are freed, so none of them may be used after
+ * this call, including in transfers that are still in-progress.
+ *
+ * @param[in] pool An #axidma_pool_t returned by #axidma_pool_create.
+ **/
+void axidma_pool_destroy(axidma_pool_t pool);
+
+/**
+ * Allocates a DMA buffer from the pool.
+ *
+ * This function takes constant time, and does not make any system calls. It is
+ * lock-free, so it is safe to call from multiple threads at the same time.
+ *
+ * @param[in] pool An #axidma_pool_t returned by #axidma_pool_create.
+ * @return The address of the block upon success, NULL if the pool is empty.
+ **/
+void *axidma_pool_alloc(axidma_pool_t pool);
+
+/**
+ * Returns a DMA buffer to the pool.
+ *
+ * This function takes constant time, and does not make any system calls. It is
+ * lock-free, so it is safe to call from multiple threads at the same time.
+ * This function will abort if \p block is not an address previously returned
+ * by #axidma_pool_alloc for this pool.
+ *
+ * @param[in] pool An #axidma_pool_t returned by #axidma_pool_create.
+ * @param[in] block Address of the block returned by #axidma_pool_alloc.
+ **/
+void axidma_pool_free(axidma_pool_t pool, void *block);
+
+/**
+ * Gets the size of each block in the pool.
+ *
+ * @param[in] pool An #axidma_pool_t returned by #axidma_pool_create.
+ * @return The usable size of each block in bytes, after rounding.
+ **/
+size_t axidma_pool_block_size(axidma_pool_t pool);
+
 /**
  * Registers a DMA buffer that was allocated externally, by another driver.
  *
@@ -187,13 +587,38 @@ int axidma_register_buffer(axidma_dev_t dev, int dmabuf_fd, void *user_addr,
  **/
 void axidma_unregister_buffer(axidma_dev_t dev, void *user_addr);
 
+/**
+ * Exports a DMA buffer allocated by the driver, so that it can be shared with
+ * other drivers without copying the data.
+ *
+ * This is the reverse of #axidma_register_buffer. The returned DMA buffer
+ * sharing file descriptor can be passed to any driver that imports DMA
+ * buffers, or mapped with mmap by another process. The buffer stays allocated
+ * until it has been freed with #axidma_free, and the file descriptor has been
+ * closed by every process that has it.
+ *
+ * Buffers allocated with #axidma_malloc_cached are made up of normal pages, so
+ * they can also be used directly for I/O on other file descriptors, such as
+ * with O_DIRECT reads and writes, splice, or io_uring fixed buffers. Buffers
+ * from the reserved memory region can't be exported.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] user_addr The address of a buffer returned by #axidma_malloc or
+ *                      #axidma_malloc_cached.
+ * @return A file descriptor for the exported buffer upon success, a negative
+ *         number on failure.
+ **/
+int axidma_export_buffer(axidma_dev_t dev, void *user_addr);
+
 /**
  * Registers a user callback function to be invoked upon completion of an
  * asynchronous transfer for the specified DMA channel.
  *
  * The callback will be invoked with a POSIX real-time signal, so it will
- * happen as soon as possible to the completion. The \p data will be passed to
- * the callback function. This function can never fail.
+ * happen as soon as possible to the completion. If #axidma_enable_events was
+ * called, the callback is instead invoked by #axidma_dispatch_completions. The
+ * \p data will be passed to the callback function. This function can never
+ * fail.
  *
  * @param[in] dev An #axidma_dev_t returned by #axidma_init.
  * @param[in] channel DMA channel to register the callback for.
@@ -228,6 +653,84 @@ void axidma_set_callback(axidma_dev_t dev, int channel, axidma_cb_t callback,
 int axidma_oneway_transfer(axidma_dev_t dev, int channel, void *buf, size_t len,
         bool wait);
 
+/**
+ * Performs a single blocking DMA transfer on the DMA channel, which is stopped
+ * if it doesn't complete within the timeout.
+ *
+ * This is the same as a blocking #axidma_oneway_transfer, which waits for up
+ * to AXIDMA_DEFAULT_TIMEOUT milliseconds, but with a deadline chosen by the
+ * user. This allows a stalled channel to be detected quickly, so that the
+ * application can fail over. If the transfer times out, it fails and sets
+ * errno to ETIME. The number of bytes transferred before the transfer was
+ * stopped is still returned, if the DMA engine can report it.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the transfer is performed on.
+ * @param[in] buf Address of the DMA buffer to transfer, previously allocated by
+ *                #axidma_malloc or registered with #axidma_register_buffer.
+ * @param[in] len Number of bytes that will be transfered.
+ * @param[in] timeout The time to wait in milliseconds. If 0, this doesn't
+ *                    wait, and the transfer completes asynchronously, as
+ *                    with a non-blocking #axidma_oneway_transfer. If
+ *                    AXIDMA_NO_TIMEOUT, this waits forever.
+ * @param[out] bytes The number of bytes transferred, even on a timeout. This
+ *                   is zero if the engine can't report a partial transfer.
+ *                   May be NULL.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_oneway_transfer_timeout(axidma_dev_t dev, int channel, void *buf,
+        size_t len, int timeout, size_t *bytes);
+
+/**
+ * Performs a single DMA transfer between the DMA channel and a vector of
+ * buffers.
+ *
+ * This function behaves like #axidma_oneway_transfer, except that the data is
+ * gathered from or scattered across the buffers in \p iov, in order, as a
+ * single DMA transfer. The buffers do not need to be contiguous with each
+ * other, so a header and payload can be sent from separate buffers without
+ * copying them, and a large transfer can use many smaller buffers.
+ *
+ * Each buffer must be within a buffer that was previously allocated by
+ * #axidma_malloc or registered with #axidma_register_buffer. A buffer in a
+ * registered buffer may span multiple physically contiguous segments of it.
+ * This function will abort if the channel is invalid, or is a VDMA channel.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the transfer is performed on.
+ * @param[in] iov An array of the addresses and lengths of the DMA buffers to
+ *                transfer.
+ * @param[in] iovcnt The number of buffers in \p iov, at most
+ *                   #AXIDMA_MAX_TRANSFER_VECS.
+ * @param[in] wait Indicates if the transfer should be synchronous or
+ *                 asynchronous. If true, this function will block.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_oneway_transfer_v(axidma_dev_t dev, int channel,
+        const struct iovec *iov, int iovcnt, bool wait);
+
+/**
+ * Performs a single blocking DMA transfer between the DMA channel and a vector
+ * of buffers, which is stopped if it doesn't complete within the timeout.
+ *
+ * This is the same as a blocking #axidma_oneway_transfer_v, but with a
+ * deadline chosen by the user, as with #axidma_oneway_transfer_timeout.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the transfer is performed on.
+ * @param[in] iov An array of the addresses and lengths of the DMA buffers to
+ *                transfer.
+ * @param[in] iovcnt The number of buffers in \p iov, at most
+ *                   #AXIDMA_MAX_TRANSFER_VECS.
+ * @param[in] timeout The time to wait in milliseconds, the same as for
+ *                    #axidma_oneway_transfer_timeout.
+ * @param[out] bytes The number of bytes transferred, even on a timeout. May
+ *                   be NULL.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_oneway_transfer_v_timeout(axidma_dev_t dev, int channel,
+        const struct iovec *iov, int iovcnt, int timeout, size_t *bytes);
+
 /**
  * Performs a two coupled DMA transfers, one in the receive direction, the other
  * in the transmit direction.
@@ -263,6 +766,536 @@ int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
         void *rx_buf, size_t rx_len, struct axidma_video_frame *rx_frame,
         bool wait);
 
+/**
+ * Performs two coupled blocking DMA transfers, which are stopped if the
+ * receive transfer doesn't complete within the timeout.
+ *
+ * This is the same as a blocking #axidma_twoway_transfer, but with a deadline
+ * chosen by the user, as with #axidma_oneway_transfer_timeout. Only the
+ * receive channel is stopped on a timeout.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] tx_channel DMA channel the transmit transfer is performed on.
+ * @param[in] tx_buf Address of the DMA buffer to transmit.
+ * @param[in] tx_len Number of bytes to transmit from \p tx_buf.
+ * @param[in] tx_frame Information about the video frame for the transmit
+ *                     channel. Should be set to NULL for non-VDMA transfers.
+ * @param[in] rx_channel DMA channel the receive transfer is performed on.
+ * @param[in] rx_buf Address of the DMA buffer to receive.
+ * @param[in] rx_len Number of bytes to receive into \p rx_buf.
+ * @param[in] rx_frame Information about the video frame for the receive
+ *                     channel. Should be set to NULL for non-VDMA transfers.
+ * @param[in] timeout The time to wait in milliseconds. If 0, this doesn't
+ *                    wait, and the receive transfer completes
+ *                    asynchronously. If AXIDMA_NO_TIMEOUT, this waits
+ *                    forever.
+ * @param[out] rx_bytes The number of bytes received, even on a timeout. May be
+ *                      NULL.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_twoway_transfer_timeout(axidma_dev_t dev, int tx_channel,
+        void *tx_buf, size_t tx_len, struct axidma_video_frame *tx_frame,
+        int rx_channel, void *rx_buf, size_t rx_len,
+        struct axidma_video_frame *rx_frame, int timeout, size_t *rx_bytes);
+
+/**
+ * Submits a batch of asynchronous DMA transfers with a single call.
+ *
+ * This function prepares all of the transfers in \p entries, and then starts
+ * each of the channels they use only once, so that a single call can keep a
+ * channel busy with many transfers. This is much cheaper than calling
+ * #axidma_oneway_transfer for each one when the transfers are small. The
+ * transfers are always non-blocking, and if the user registered a callback
+ * function for a channel, it will be invoked upon completion of each transfer
+ * on that channel. Transfers on the same channel are performed in order.
+ *
+ * Each entry specifies the channel, buffer, and length of one transfer. The
+ * buffers must be within a buffer that was previously allocated by
+ * #axidma_malloc or registered with #axidma_register_buffer. Upon success, the
+ * cookie field of each entry is set to the DMA cookie of the transfer. This
+ * function will abort if any of the channels are invalid, or are VDMA channels.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in,out] entries An array of transfers to submit, at most
+ *                        #AXIDMA_MAX_BATCH_ENTRIES long.
+ * @param[in] num_entries The number of transfers in \p entries.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_submit_batch(axidma_dev_t dev, struct axidma_batch_entry *entries,
+        int num_entries);
+
+/**
+ * Prepares a transfer of a buffer on a DMA channel, to be submitted many times.
+ *
+ * Each call to #axidma_oneway_transfer makes the driver look up the buffer in
+ * the DMA buffers, and set up the transfer again. When the same buffer is
+ * transferred on the same channel over and over, such as in a polling loop,
+ * this is done once here instead, and the returned handle is submitted with
+ * #axidma_submit. The driver only looks the buffer up again after a buffer is
+ * freed or unregistered, so submitting the handle fails once \p buf is freed.
+ *
+ * The buffer must be within a buffer that was previously allocated by
+ * #axidma_malloc or registered with #axidma_register_buffer. Only DMA channels
+ * are supported. The handle is freed with #axidma_unprepare, or when the
+ * device is destroyed.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the transfer is performed on.
+ * @param[in] buf Address of the DMA buffer to transfer.
+ * @param[in] len Number of bytes to transfer.
+ * @return A non-negative handle for the transfer upon success, a negative
+ *         number on failure.
+ **/
+int axidma_prepare(axidma_dev_t dev, int channel, void *buf, size_t len);
+
+/**
+ * Submits a transfer prepared with #axidma_prepare.
+ *
+ * This behaves the same as #axidma_oneway_transfer with the prepared channel,
+ * buffer, and length. If the user registered a callback function for the
+ * channel, it will be invoked when a non-blocking transfer completes. The same
+ * handle may be submitted again before the previous transfer completes.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] handle A handle returned by #axidma_prepare.
+ * @param[in] wait Indicates if the transfer should be synchronous or
+ *                 asynchronous. If true, this function will block.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_submit(axidma_dev_t dev, int handle, bool wait);
+
+/**
+ * Submits a transfer prepared with #axidma_prepare, and waits for it, stopping
+ * it if it doesn't complete within the timeout.
+ *
+ * This behaves the same as #axidma_oneway_transfer_timeout with the prepared
+ * channel, buffer, and length.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] handle A handle returned by #axidma_prepare.
+ * @param[in] timeout The time to wait in milliseconds, the same as for
+ *                    #axidma_oneway_transfer_timeout.
+ * @param[out] bytes The number of bytes transferred, even on a timeout. May
+ *                   be NULL.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_submit_timeout(axidma_dev_t dev, int handle, int timeout,
+                          size_t *bytes);
+
+/**
+ * Frees a transfer prepared with #axidma_prepare.
+ *
+ * Transfers of it that were already submitted are unaffected.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] handle A handle returned by #axidma_prepare.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_unprepare(axidma_dev_t dev, int handle);
+
+/**
+ * Creates a stream of pipelined two-way transfers.
+ *
+ * A stream keeps up to \p depth two-way transfers in flight at once, one on
+ * each of the transmit and receive buffer pairs. As soon as both transfers on
+ * a pair complete, the pair is submitted again, so the DMA engine does not sit
+ * idle while userspace handles a completion and prepares the next transfer.
+ * With a depth of one, this behaves like calling #axidma_twoway_transfer in a
+ * loop.
+ *
+ * The transfers are submitted through the rings shared with the driver, so
+ * #axidma_ring_init must have been called with at least 2 * \p depth
+ * submission ring entries. The stream must be the only user of the rings while
+ * it is running. The buffers must be within buffers that were previously
+ * allocated by #axidma_malloc or registered with #axidma_register_buffer, and
+ * remain owned by the caller. Only DMA channels are supported.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] tx_channel DMA channel the data is transmitted on.
+ * @param[in] tx_bufs An array of \p depth transmit buffers.
+ * @param[in] tx_len Number of bytes transmitted from each buffer.
+ * @param[in] rx_channel DMA channel the data is received on.
+ * @param[in] rx_bufs An array of \p depth receive buffers.
+ * @param[in] rx_len Number of bytes received into each buffer.
+ * @param[in] depth The number of buffer pairs, and thus transfers in flight.
+ * @return A handle to the stream upon success, NULL on failure.
+ **/
+axidma_stream_t axidma_stream_create(axidma_dev_t dev, int tx_channel,
+        void **tx_bufs, size_t tx_len, int rx_channel, void **rx_bufs,
+        size_t rx_len, int depth);
+
+/**
+ * Destroys a stream of two-way transfers.
+ *
+ * The buffers given to #axidma_stream_create are not freed.
+ *
+ * @param[in] stream An #axidma_stream_t returned by #axidma_stream_create.
+ **/
+void axidma_stream_destroy(axidma_stream_t stream);
+
+/**
+ * Performs a number of two-way transfers on a stream, keeping the pipeline
+ * full.
+ *
+ * This function blocks until \p num_transfers two-way transfers have
+ * completed. The buffer pairs are used in turn, and \p callback is invoked in
+ * the calling thread each time a pair completes, before it is reused. If any
+ * transfer fails, no more are submitted, and the function returns once the
+ * ones already in flight have completed.
+ *
+ * @param[in] stream An #axidma_stream_t returned by #axidma_stream_create.
+ * @param[in] num_transfers The total number of two-way transfers to perform.
+ * @param[in] callback Function invoked when a pair completes, or NULL.
+ * @param[in] data User data passed to \p callback.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_stream_run(axidma_stream_t stream, long num_transfers,
+        axidma_stream_cb_t callback, void *data);
+
+/**
+ * Opens several AXI DMA devices as a group, to stripe transfers across them.
+ *
+ * Each device in the group is an engine, which uses its first DMA transmit and
+ * receive channels. A transfer on the group is split into chunks of
+ * \p tx_chunk bytes sent, and \p rx_chunk bytes received, and each chunk is
+ * performed as a two-way transfer on one of the engines. The chunks are
+ * balanced by the depth of each engine's queue, so each chunk goes to the
+ * engine with the fewest chunks in flight, and the aggregate bandwidth scales
+ * with the number of engines.
+ *
+ * The group sets up the rings of each device, and switches them to completion
+ * events, so they should only be used through the group. See
+ * #axidma_group_get_dev.
+ *
+ * @param[in] indices The indices of the devices, as for #axidma_init_dev.
+ * @param[in] num_devs The number of devices in \p indices.
+ * @param[in] tx_chunk The number of bytes sent for each chunk, or 0 if the
+ *                     group is only used for receiving.
+ * @param[in] rx_chunk The number of bytes received for each chunk, or 0 if the
+ *                     group is only used for transmitting.
+ * @param[in] depth The maximum number of chunks in flight on each engine. This
+ *                  must be at most AXIDMA_MAX_RING_ENTRIES / 2.
+ * @return A handle to the device group upon success, NULL on failure.
+ **/
+axidma_group_t axidma_group_init(const unsigned int *indices, int num_devs,
+        size_t tx_chunk, size_t rx_chunk, int depth);
+
+/**
+ * Closes all of the devices in a group, and destroys the group.
+ *
+ * Buffers allocated with #axidma_group_malloc must be freed beforehand.
+ *
+ * @param[in] group An #axidma_group_t returned by #axidma_group_init.
+ **/
+void axidma_group_destroy(axidma_group_t group);
+
+/**
+ * Gets one of the devices in a group.
+ *
+ * This is useful to read the statistics of each engine, with
+ * #axidma_get_stats. This function will abort if the index is invalid.
+ *
+ * @param[in] group An #axidma_group_t returned by #axidma_group_init.
+ * @param[in] index The position of the device in the indices given to
+ *                  #axidma_group_init.
+ * @return The handle for the device.
+ **/
+axidma_dev_t axidma_group_get_dev(axidma_group_t group, int index);
+
+/**
+ * Allocates a DMA buffer that every device in a group can transfer on.
+ *
+ * The buffer is allocated on the first device, with #axidma_malloc, and is
+ * shared with the other devices through #axidma_export_buffer, so each chunk
+ * is transferred in place. Buffers given to #axidma_group_transfer must be
+ * allocated with this function.
+ *
+ * @param[in] group An #axidma_group_t returned by #axidma_group_init.
+ * @param[in] size The size of the buffer in bytes.
+ * @return The address of the buffer upon success, NULL on failure.
+ **/
+void *axidma_group_malloc(axidma_group_t group, size_t size);
+
+/**
+ * Frees a DMA buffer allocated with #axidma_group_malloc.
+ *
+ * @param[in] group An #axidma_group_t returned by #axidma_group_init.
+ * @param[in] addr The address of the buffer.
+ * @param[in] size The size of the buffer in bytes.
+ **/
+void axidma_group_free(axidma_group_t group, void *addr, size_t size);
+
+/**
+ * Performs a two-way transfer striped across the devices in a group.
+ *
+ * The transmit and receive buffers are split into the same number of chunks.
+ * Chunk k sends the bytes at k * tx_chunk of \p tx_buf, and receives into the
+ * bytes at k * rx_chunk of \p rx_buf, so the received data comes out in order,
+ * whichever engine performs each chunk. Either buffer may be NULL, for a
+ * one-way transfer.
+ *
+ * This function blocks until all of the chunks have completed. The callback
+ * is invoked in the calling thread for each chunk, in order, as soon as it and
+ * all of the chunks before it have completed. The number of bytes received for
+ * the chunk may be short, if the stream ended it early, such as with TLAST. If
+ * any transfer fails, no more chunks are submitted, and the function returns
+ * once the ones already in flight have completed.
+ *
+ * @param[in] group An #axidma_group_t returned by #axidma_group_init.
+ * @param[in] tx_buf Buffer to transmit, allocated by #axidma_group_malloc, or
+ *                   NULL.
+ * @param[in] tx_len Number of bytes to transmit from \p tx_buf.
+ * @param[in] rx_buf Buffer to receive into, allocated by #axidma_group_malloc,
+ *                   or NULL.
+ * @param[in] rx_len Number of bytes to receive into \p rx_buf.
+ * @param[in] callback Function invoked when a chunk completes, or NULL.
+ * @param[in] data User data passed to \p callback.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_group_transfer(axidma_group_t group, void *tx_buf, size_t tx_len,
+        void *rx_buf, size_t rx_len, axidma_group_cb_t callback, void *data);
+
+/**
+ * Sets up the submission and completion rings shared with the driver.
+ *
+ * The rings allow for asynchronous transfers to be submitted and completed
+ * without a system call for each transfer. Transfers are placed in the
+ * submission ring with #axidma_ring_submit, and started by the driver with
+ * #axidma_ring_enter. Their completions are placed in the completion ring,
+ * and are removed with #axidma_ring_reap.
+ *
+ * If \p sq_poll is true, the driver starts a kernel thread that continuously
+ * polls the submission ring, so that transfers are started without any system
+ * calls at all. The thread goes to sleep once the ring has been idle for some
+ * time, in which case #axidma_ring_enter will wake it up.
+ *
+ * The number of entries in each ring must be a power of two, and the
+ * completion ring must be at least as large as the submission ring. This
+ * function can only be called once for a device.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] sq_entries The number of entries in the submission ring.
+ * @param[in] cq_entries The number of entries in the completion ring.
+ * @param[in] sq_poll Indicates if the driver should poll the submission ring.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_ring_init(axidma_dev_t dev, unsigned int sq_entries,
+        unsigned int cq_entries, bool sq_poll);
+
+/**
+ * Places an asynchronous DMA transfer into the submission ring.
+ *
+ * This function does not make a system call, so the transfer is only started
+ * on the next call to #axidma_ring_enter, or by the driver's polling thread.
+ * When the transfer completes, an entry with \p user_data is placed into the
+ * completion ring.
+ *
+ * The addresses \p buf and \p buf+\p len must be within a buffer that was
+ * previously allocated by #axidma_malloc or registered with
+ * #axidma_register_buffer. This function will abort if the channel is invalid,
+ * or if #axidma_ring_init has not been called.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the transfer is performed on.
+ * @param[in] buf Address of the DMA buffer to transfer.
+ * @param[in] len Number of bytes that will be transfered.
+ * @param[in] user_data Opaque value returned in the completion entry.
+ * @return 0 upon success, -EAGAIN if the submission ring is full.
+ **/
+int axidma_ring_submit(axidma_dev_t dev, int channel, void *buf, size_t len,
+        void *user_data);
+
+/**
+ * Starts the transfers in the submission ring, and optionally waits for
+ * completions.
+ *
+ * This function acts as the doorbell for the submission ring. If the driver is
+ * polling the submission ring, then this only makes a system call if the
+ * polling thread is asleep, or if it needs to wait for completions.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] min_complete The number of entries to wait for in the completion
+ *                         ring. If 0, the function does not block.
+ * @return The number of transfers started on success, a negative number on
+ *         failure.
+ **/
+int axidma_ring_enter(axidma_dev_t dev, unsigned int min_complete);
+
+/**
+ * Removes completed transfers from the completion ring.
+ *
+ * This function does not make a system call. It copies up to \p max_cqes
+ * entries out of the completion ring, in the order the transfers completed.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[out] cqes An array to store the completion entries in.
+ * @param[in] max_cqes The maximum number of entries to remove.
+ * @return The number of completion entries removed.
+ **/
+int axidma_ring_reap(axidma_dev_t dev, struct axidma_cqe *cqes, int max_cqes);
+
+/**
+ * Dedicates a DMA channel to a BD ring that is driven entirely from
+ * userspace.
+ *
+ * The driver hands the channel's scatter-gather descriptors (BDs) over to the
+ * library, so that transfers bypass the kernel's DMA engine framework.
+ * Buffers are posted with #axidma_bdring_post, started with
+ * #axidma_bdring_kick, and completed ones are found with #axidma_bdring_reap
+ * by polling the BDs. Only the kick makes a system call, once for a batch of
+ * buffers, and the channel's interrupts are disabled, so this is meant for a
+ * thread that busy-polls the ring, at very high packet rates.
+ *
+ * The channel must be an AXI DMA channel with scatter-gather enabled. The
+ * ring takes over the channel's whole engine, including the engine's other
+ * channel, since the two share their registers and are reset together. Both
+ * channels are claimed by this handle, and this fails if another process or
+ * handle owns either of them, or if either still has transfers that haven't
+ * completed. Until #axidma_bdring_destroy is called, neither channel can be
+ * used for normal transfers, though the other channel can have a ring of its
+ * own.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel to dedicate to the ring.
+ * @param[in] num_bds The number of BDs in the ring, a power of two. This is
+ *                    the most buffers that can be in flight at once.
+ * @return An #axidma_bdring_t upon success, NULL on failure.
+ **/
+axidma_bdring_t axidma_bdring_init(axidma_dev_t dev, int channel,
+        unsigned int num_bds);
+
+/**
+ * Tears down a userspace BD ring, and returns its channel to the driver.
+ *
+ * Any buffers still in flight on the ring are discarded.
+ *
+ * @param[in] ring An #axidma_bdring_t returned by #axidma_bdring_init.
+ **/
+void axidma_bdring_destroy(axidma_bdring_t ring);
+
+/**
+ * Places a buffer into the next BD of the ring.
+ *
+ * This function does not make a system call, and the buffer is only handed to
+ * the engine on the next call to #axidma_bdring_kick. For a transmit channel,
+ * each buffer is sent as a whole packet. For a receive channel, the buffer
+ * receives up to \p len bytes of a packet.
+ *
+ * The addresses \p buf and \p buf+\p len must be within a single buffer that
+ * was previously allocated by #axidma_malloc or registered with
+ * #axidma_register_buffer. The bus address of each buffer is looked up once,
+ * and then cached.
+ *
+ * @param[in] ring An #axidma_bdring_t returned by #axidma_bdring_init.
+ * @param[in] buf Address of the DMA buffer to transfer.
+ * @param[in] len Number of bytes that will be transfered.
+ * @return 0 upon success, -EAGAIN if the ring is full, or a negative number
+ *         if the buffer is invalid.
+ **/
+int axidma_bdring_post(axidma_bdring_t ring, void *buf, size_t len);
+
+/**
+ * Starts the engine on all of the buffers posted to the ring since the last
+ * call, by having the driver write the tail register.
+ *
+ * This function makes a system call, unless no buffers were posted. Kicking
+ * once for a batch of buffers avoids the cost of a system call for each one.
+ *
+ * @param[in] ring An #axidma_bdring_t returned by #axidma_bdring_init.
+ * @return 0 upon success, or -EIO if the channel has halted on an error, in
+ *         which case the ring must be destroyed.
+ **/
+int axidma_bdring_kick(axidma_bdring_t ring);
+
+/**
+ * Removes completed buffers from the ring.
+ *
+ * This function does not make a system call. It checks the BDs the engine
+ * was started on, in the order they were posted, and copies out up to
+ * \p max_comps completions, stopping at the first BD that isn't complete.
+ *
+ * @param[in] ring An #axidma_bdring_t returned by #axidma_bdring_init.
+ * @param[out] comps An array to store the completions in.
+ * @param[in] max_comps The maximum number of completions to remove.
+ * @return The number of completions removed, or -EIO if the channel has
+ *         halted on an error, in which case the ring must be destroyed.
+ **/
+int axidma_bdring_reap(axidma_bdring_t ring, struct axidma_bd_completion *comps,
+        int max_comps);
+
+/**
+ * Reports the completion of asynchronous transfers with queued completion
+ * events, instead of signals.
+ *
+ * By default, the callback registered with #axidma_set_callback is invoked
+ * from a POSIX real-time signal handler. After this call, the driver instead
+ * queues an event for each completed transfer. The events are removed with
+ * #axidma_get_completions or #axidma_dispatch_completions, so that the
+ * callbacks run in a normal thread context. The file descriptor returned by
+ * #axidma_get_event_fd becomes readable when there are events, allowing the
+ * completions to be waited for with poll or epoll, alongside other files.
+ *
+ * If \p eventfd is a valid eventfd, then the driver also signals it for each
+ * completion, including completions in the completion ring.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] eventfd An eventfd to signal upon completion, or -1 for none.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_enable_events(axidma_dev_t dev, int eventfd);
+
+/**
+ * Gets the file descriptor that can be polled for transfer completions.
+ *
+ * The file descriptor is readable with poll or epoll whenever there are
+ * completion events queued, or entries in the completion ring. The user must
+ * not close it, or read from it directly.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @return The file descriptor for the AXI DMA device.
+ **/
+int axidma_get_event_fd(axidma_dev_t dev);
+
+/**
+ * Removes queued completion events for asynchronous transfers.
+ *
+ * Each event has the channel, DMA cookie, number of bytes transferred, and
+ * status of a completed transfer, with a NULL user data field. Events are only
+ * queued after a call to #axidma_enable_events.
+ *
+ * If \p wait is true, the call blocks until the file descriptor returned by
+ * #axidma_get_event_fd is readable. If it only became readable because of
+ * entries in the completion ring, then no events are removed. If any events
+ * were dropped because the driver's queue was full, the call fails with errno
+ * set to EOVERFLOW, and the events still queued are removed by the next call.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[out] cqes An array to store the completion events in.
+ * @param[in] max_cqes The maximum number of events to remove.
+ * @param[in] wait Indicates if the call should block until at least one event
+ *                 is available.
+ * @return The number of events removed on success, a negative number on
+ *         failure.
+ **/
+int axidma_get_completions(axidma_dev_t dev, struct axidma_cqe *cqes,
+        int max_cqes, bool wait);
+
+/**
+ * Removes queued completion events, and invokes the callback registered for
+ * the channel of each one.
+ *
+ * The callbacks registered with #axidma_set_callback run in the calling
+ * thread, so they are free to call functions that are not safe to call from a
+ * signal handler. Events are only queued after a call to #axidma_enable_events.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] wait Indicates if the call should block until at least one event
+ *                 is available.
+ * @return The number of events handled on success, a negative number on
+ *         failure.
+ **/
+int axidma_dispatch_completions(axidma_dev_t dev, bool wait);
+
 /**
  * Starts a video DMA (VDMA) loop/continuous transfer on the given channel.
  *
@@ -278,6 +1311,12 @@ int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
  * non-blocking, and returns immediately. The only way to stop the transfer is
  * via a call to #axidma_stop_transfer.
  *
+ * Each frame is completed separately, so the progress of the transfer can be
+ * followed through the status from #axidma_video_get_status, without any
+ * system calls. A completion event is also queued for each frame, if events
+ * were enabled with #axidma_enable_events, with the address of the frame
+ * buffer as its user data.
+ *
  * @param[in] dev An #axidma_dev_t returned by #axidma_init.
  * @param[in] display_channel DMA channel the video transfer will take place
  *                            on. This must be a VDMA channel.
@@ -292,12 +1331,149 @@ int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
 int axidma_video_transfer(axidma_dev_t dev, int display_channel, size_t width,
         size_t height, size_t depth, void **frame_buffers, int num_buffers);
 
+/**
+ * Starts a video transfer with the given frame layout and synchronization.
+ *
+ * This behaves like #axidma_video_transfer, but the lines of each frame buffer
+ * can be padded, by setting the stride of \p frame to the number of bytes
+ * between the start of one line and the next. This allows a sub-rectangle of a
+ * larger image to be transferred, or lines to be aligned for the CPU. A stride
+ * of 0 means the lines are packed together. Each frame buffer must then span
+ * `(height - 1) * stride + width * depth` bytes.
+ *
+ * The \p sync settings control how the channel is synchronized with other
+ * channels and with the video source. With genlock enabled, a slave channel
+ * follows the frames of the master it is given, staying the given number of
+ * frames behind it, while a master channel drives the other channels. The
+ * channel can also start each frame on an external frame sync, or on the
+ * tuser signal of the stream.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the video transfer will take place on. This
+ *                    must be a VDMA channel.
+ * @param[in] frame The width, height, depth, and stride of the frame buffers.
+ * @param[in] sync The genlock and frame sync settings for the channel, or NULL
+ *                 for the channel to synchronize itself, as
+ *                 #axidma_video_transfer does.
+ * @param[in] frame_buffers A list of frame buffer addresses.
+ * @param[in] num_buffers The number of buffers in \p frame_buffers. This must
+ *                        match the length of the list.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_video_transfer_config(axidma_dev_t dev, int channel,
+        const struct axidma_video_frame *frame,
+        const struct axidma_video_sync *sync, void **frame_buffers,
+        int num_buffers);
+
+/**
+ * Gets the status of the video transfer on a channel.
+ *
+ * The status is shared with the driver, which updates it as each frame
+ * completes. #axidma_cyclic_period_count gives the number of frames completed
+ * so far, and #axidma_video_latest_frame the frame buffer completed last. The
+ * status is valid until the device is destroyed. This function will abort if
+ * the channel is invalid.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel VDMA channel the video transfer was started on.
+ * @return The status of the channel's video transfer, or NULL if no video
+ *         transfer was started on it.
+ **/
+const struct axidma_cyclic_status *axidma_video_get_status(axidma_dev_t dev,
+        int channel);
+
+/**
+ * Gets the index of the frame buffer that completed last in a video transfer.
+ *
+ * For a capture, this is the most recent complete frame, which can be used in
+ * place without copying it. With three or more frame buffers, the engine is
+ * writing to a different one, so the frame is not torn as long as it's used
+ * before the engine comes back around to it. To hold on to it for longer, use
+ * #axidma_video_park to park on another frame buffer. This function does not
+ * make a system call.
+ *
+ * @param[in] status The status returned by #axidma_video_get_status.
+ * @return The index of the frame buffer, or -1 if no frame has completed yet.
+ **/
+int axidma_video_latest_frame(const struct axidma_cyclic_status *status);
+
+/**
+ * Parks a video transfer on one of its frame buffers, or resumes it.
+ *
+ * While parked, the driver only queues the parked frame buffer to the engine
+ * again, so the channel keeps transferring that frame, and leaves the other
+ * frame buffers alone. For a capture, this lets the user process the other
+ * frames in place, without them being overwritten. For a display, the parked
+ * frame is shown until the transfer is resumed. This function will abort if
+ * the channel is invalid, or is not a VDMA channel.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel VDMA channel the video transfer is running on.
+ * @param[in] frame The index of the frame buffer to park on, or -1 to resume
+ *                  transferring all of the frame buffers.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_video_park(axidma_dev_t dev, int channel, int frame);
+
+/**
+ * Starts a cyclic transfer on a DMA channel, which runs until it is stopped.
+ *
+ * The buffer is split into periods of \p period_len bytes, and the channel
+ * transfers each one in turn, wrapping around to the first period after the
+ * last. The channel never waits for userspace, so there are no gaps between
+ * the periods, which allows a source like an ADC to be captured continuously
+ * at its full rate. This function is non-blocking, and returns immediately.
+ * The only way to stop the transfer is via a call to #axidma_stop_transfer.
+ *
+ * Upon success, \p status points to the status of the transfer, which is
+ * shared with the driver. Each time a period completes, the driver increments
+ * the count returned by #axidma_cyclic_period_count, so the transfer can be
+ * followed without any system calls. When the count is c, the period being
+ * transferred is c modulo the number of periods. If the user falls behind by
+ * more than the number of periods, then data has been overwritten.
+ *
+ * The buffer must be within a single buffer that was previously allocated by
+ * #axidma_malloc, and \p len must be a multiple of \p period_len. This
+ * function will abort if the channel is invalid, or is a VDMA channel.
+ *
+ * @param[in] dev An #axidma_dev_t returned by #axidma_init.
+ * @param[in] channel DMA channel the transfer is performed on.
+ * @param[in] buf Address of the DMA buffer split into periods.
+ * @param[in] len Number of bytes in the buffer.
+ * @param[in] period_len Number of bytes in each period.
+ * @param[out] status A pointer to store the address of the transfer's status.
+ * @return 0 upon success, a negative number on failure.
+ **/
+int axidma_cyclic_transfer(axidma_dev_t dev, int channel, void *buf,
+        size_t len, size_t period_len,
+        const struct axidma_cyclic_status **status);
+
+/**
+ * Gets the number of periods completed by a cyclic transfer.
+ *
+ * This function does not make a system call. The count is free-running, and
+ * wraps around once it overflows. Once the count has advanced, the data in the
+ * periods that completed is visible to the CPU.
+ *
+ * @param[in] status The status returned by #axidma_cyclic_transfer.
+ * @return The number of periods completed since the transfer started.
+ **/
+unsigned int axidma_cyclic_period_count(
+        const struct axidma_cyclic_status *status);
+
 /**
  * Get the residue of the last transaction
  *
+ * The residue is the number of bytes of the last completed transfer's buffer
+ * that weren't transferred, such as when a receive is ended early by TLAST.
+ * The blocking transfers already return the number of bytes transferred
+ * through #axidma_oneway_transfer_timeout and
+ * #axidma_twoway_transfer_timeout, as do the completion events for
+ * asynchronous ones, so this is only needed for the other functions.
+ *
  * @param[in] dev An #axidma_dev_t returned by #axidma_init.
  * @param[in] channel DMA channel.
- * @param[in] residue A pointer to store the returned residue.
+ * @param[out] residue A pointer to store the returned residue.
  * @return 0 upon success, a negative number on failure.
  **/
 int axidma_get_residue(axidma_dev_t dev, int channel, unsigned int *residue);
@@ -315,5 +1491,9 @@ int axidma_get_residue(axidma_dev_t dev, int channel, unsigned int *residue);
  **/
 void axidma_stop_transfer(axidma_dev_t dev, int channel);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // LINUX_APP
 #endif /* LIBAXIDMA_H_ */
\ No newline at end of file
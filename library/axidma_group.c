@@ -0,0 +1,469 @@
+/**
+ * @file axidma_group.c
+ * @date Wednesday, October 14, 2026 at 10:41:05 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains the device group interface, which stripes a single
+ * logical stream across several AXI DMA devices. The stream is split into
+ * chunks, and each chunk is handed to the engine with the fewest chunks in
+ * flight, so faster engines take on more of the stream. The received chunks
+ * land at their place in the receive buffer, and are reported back to the
+ * caller in order, regardless of which engine finishes first.
+ *
+ * The buffers are allocated on the first device, and shared with the others
+ * through DMA buffer sharing, so the chunks are never copied.
+ *
+ * @bug No known bugs.
+ **/
+#ifdef LINUX_APP
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>              // Error codes
+#include <string.h>             // Strerror function
+#include <stdint.h>             // Predefined size integers
+#include <unistd.h>             // Read and close system calls
+#include <sys/eventfd.h>        // Eventfd creation function
+
+#include "libaxidma.h"          // Local definitions
+
+/*----------------------------------------------------------------------------
+ * Internal definitions
+ *----------------------------------------------------------------------------*/
+
+// The state of each chunk in flight, kept in a window in the stream's order
+struct axidma_group_chunk {
+    long index;                 ///< The index of the chunk in the stream
+    int engine;                 ///< The engine the chunk was submitted to
+    int pending;                ///< The number of its transfers in flight
+    bool done;                  ///< Indicates both of its transfers are done
+    size_t rx_bytes;            ///< The number of bytes received for it
+};
+
+// The state of each engine, which is a device and its pair of channels
+struct axidma_group_engine {
+    axidma_dev_t dev;           ///< The device for the engine
+    int tx_channel;             ///< The channel used for transmitting
+    int rx_channel;             ///< The channel used for receiving
+    int inflight;               ///< The number of chunks in flight on it
+    bool submitted;             ///< Indicates transfers wait for the doorbell
+};
+
+// The structure that represents a group of AXI DMA devices
+struct axidma_group {
+    int num_engines;            ///< The number of devices in the group
+    struct axidma_group_engine *engines;    ///< The state of each device
+    size_t tx_chunk;            ///< The number of bytes sent for each chunk
+    size_t rx_chunk;            ///< The number of bytes received for each
+    int depth;                  ///< The chunks in flight on each engine
+    int window;                 ///< The chunks in flight on the whole group
+    struct axidma_group_chunk *chunks;  ///< The chunks in flight, in order
+    struct axidma_cqe *cqes;    ///< Completions reaped from the rings
+    int event_fd;               ///< Eventfd signaled by any of the engines
+};
+
+/*----------------------------------------------------------------------------
+ * Private Helper Functions
+ *----------------------------------------------------------------------------*/
+
+// Returns the smallest power of two that is at least the given number
+static unsigned int round_pow_of_two(unsigned int n)
+{
+    unsigned int pow;
+
+    for (pow = 1; pow < n; pow *= 2);
+    return pow;
+}
+
+/* Sets up the given engine on the device with the given index, using its first
+ * DMA transmit and receive channels. Completions on its rings signal the
+ * group's eventfd, so that the group can wait on all of the engines at once. */
+static int init_engine(axidma_group_t group, struct axidma_group_engine *engine,
+                       unsigned int index)
+{
+    int rc;
+    unsigned int ring_entries;
+    const array_t *tx_chans, *rx_chans;
+
+    engine->dev = axidma_init_dev(index);
+    if (engine->dev == NULL) {
+        fprintf(stderr, "Failed to open AXI DMA device %u.\n", index);
+        return -ENODEV;
+    }
+
+    tx_chans = axidma_get_dma_tx(engine->dev);
+    rx_chans = axidma_get_dma_rx(engine->dev);
+    if (tx_chans->len < 1 || rx_chans->len < 1) {
+        fprintf(stderr, "AXI DMA device %u does not have both a transmit and "
+                "a receive channel.\n", index);
+        return -ENODEV;
+    }
+    engine->tx_channel = tx_chans->data[0];
+    engine->rx_channel = rx_chans->data[0];
+    engine->inflight = 0;
+    engine->submitted = false;
+
+    // Each chunk in flight needs two entries, one for each direction
+    ring_entries = round_pow_of_two(2 * group->depth);
+    rc = axidma_ring_init(engine->dev, ring_entries, ring_entries, false);
+    if (rc < 0) {
+        return rc;
+    }
+
+    return axidma_enable_events(engine->dev, group->event_fd);
+}
+
+/* Finds the engine with the fewest chunks in flight, which still has room for
+ * another one. Ties are broken by the index of the chunk, so that the engines
+ * are used round-robin when they all keep up. Returns NULL if all are full. */
+static struct axidma_group_engine *pick_engine(axidma_group_t group,
+                                               long index)
+{
+    int i;
+    struct axidma_group_engine *engine, *best;
+
+    best = NULL;
+    for (i = 0; i < group->num_engines; i++)
+    {
+        engine = &group->engines[(index + i) % group->num_engines];
+        if (engine->inflight >= group->depth) {
+            continue;
+        } else if (best == NULL || engine->inflight < best->inflight) {
+            best = engine;
+        }
+    }
+
+    return best;
+}
+
+/* Places the transfers for the given chunk of the stream into the engine's
+ * submission ring. The receive is submitted first, so that it is ready before
+ * the data comes back from the fabric. The chunk's pending count reflects what
+ * was submitted, even on failure, so that those transfers can be waited for. */
+static int submit_chunk(axidma_group_t group, struct axidma_group_chunk *chunk,
+                        struct axidma_group_engine *engine, char *tx_buf,
+                        size_t tx_len, char *rx_buf, size_t rx_len)
+{
+    int rc;
+    size_t offset, len;
+
+    chunk->engine = engine - group->engines;
+    chunk->pending = 0;
+    chunk->done = false;
+    chunk->rx_bytes = 0;
+    engine->inflight += 1;
+    engine->submitted = true;
+
+    if (rx_buf != NULL) {
+        offset = chunk->index * group->rx_chunk;
+        len = (rx_len - offset < group->rx_chunk) ? rx_len - offset :
+                                                     group->rx_chunk;
+        rc = axidma_ring_submit(engine->dev, engine->rx_channel,
+                                rx_buf + offset, len, chunk);
+        if (rc < 0) {
+            return rc;
+        }
+        chunk->pending += 1;
+    }
+
+    if (tx_buf != NULL) {
+        offset = chunk->index * group->tx_chunk;
+        len = (tx_len - offset < group->tx_chunk) ? tx_len - offset :
+                                                     group->tx_chunk;
+        rc = axidma_ring_submit(engine->dev, engine->tx_channel,
+                                tx_buf + offset, len, chunk);
+        if (rc < 0) {
+            return rc;
+        }
+        chunk->pending += 1;
+    }
+
+    return 0;
+}
+
+/* Rings the doorbell of each engine that has new transfers, and collects the
+ * completions from all of the engines. If none are available and wait is true,
+ * this blocks until one of the engines signals a completion. Returns the number
+ * of completions collected. */
+static int reap_engines(axidma_group_t group, bool wait)
+{
+    int i, num_cqes, max_cqes;
+    uint64_t count;
+    struct axidma_group_engine *engine;
+
+    for (i = 0; i < group->num_engines; i++)
+    {
+        engine = &group->engines[i];
+        if (engine->submitted) {
+            if (axidma_ring_enter(engine->dev, 0) < 0) {
+                return -errno;
+            }
+            engine->submitted = false;
+        }
+    }
+
+    /* The eventfd keeps count of the completions that came in meanwhile, so
+     * none are missed between reaping the rings and waiting on it. */
+    max_cqes = 2 * group->window;
+    while (true)
+    {
+        num_cqes = 0;
+        for (i = 0; i < group->num_engines && num_cqes < max_cqes; i++)
+        {
+            num_cqes += axidma_ring_reap(group->engines[i].dev,
+                    &group->cqes[num_cqes], max_cqes - num_cqes);
+        }
+        if (num_cqes > 0 || !wait) {
+            return num_cqes;
+        }
+
+        if (read(group->event_fd, &count, sizeof(count)) < 0 &&
+                errno != EINTR) {
+            perror("Failed to wait for the AXI DMA device group");
+            return -errno;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Public Interface
+ *----------------------------------------------------------------------------*/
+
+/* Opens the devices with the given indices as a group, which stripes a stream
+ * across them in chunks of the given sizes. The array of indices is copied. */
+axidma_group_t axidma_group_init(const unsigned int *indices, int num_devs,
+        size_t tx_chunk, size_t rx_chunk, int depth)
+{
+    int i;
+    struct axidma_group *group;
+
+    assert(num_devs > 0);
+    assert(0 < depth && depth <= AXIDMA_MAX_RING_ENTRIES / 2);
+    assert(tx_chunk > 0 || rx_chunk > 0);
+
+    group = (struct axidma_group *)calloc(1, sizeof(*group));
+    if (group == NULL) {
+        perror("Unable to allocate the AXI DMA device group structure");
+        return NULL;
+    }
+    group->tx_chunk = tx_chunk;
+    group->rx_chunk = rx_chunk;
+    group->depth = depth;
+    group->window = num_devs * depth;
+
+    // Allocate the engines, the window of chunks, and room for its completions
+    group->event_fd = eventfd(0, EFD_CLOEXEC);
+    group->engines = (struct axidma_group_engine *)calloc(num_devs,
+            sizeof(group->engines[0]));
+    group->chunks = (struct axidma_group_chunk *)calloc(group->window,
+            sizeof(group->chunks[0]));
+    group->cqes = (struct axidma_cqe *)malloc(2 * group->window *
+            sizeof(group->cqes[0]));
+    if (group->event_fd < 0 || group->engines == NULL ||
+        group->chunks == NULL || group->cqes == NULL) {
+        perror("Unable to allocate the AXI DMA device group");
+        axidma_group_destroy(group);
+        return NULL;
+    }
+
+    // Open each device, counting them as we go, so they can be cleaned up
+    for (i = 0; i < num_devs; i++)
+    {
+        group->num_engines += 1;
+        if (init_engine(group, &group->engines[i], indices[i]) < 0) {
+            axidma_group_destroy(group);
+            return NULL;
+        }
+    }
+
+    return group;
+}
+
+// Closes all of the devices in the group, and destroys it
+void axidma_group_destroy(axidma_group_t group)
+{
+    int i;
+
+    for (i = 0; i < group->num_engines; i++)
+    {
+        if (group->engines[i].dev != NULL) {
+            axidma_destroy(group->engines[i].dev);
+        }
+    }
+    if (group->event_fd >= 0) {
+        close(group->event_fd);
+    }
+    free(group->cqes);
+    free(group->chunks);
+    free(group->engines);
+    free(group);
+
+    return;
+}
+
+// Returns the device with the given index in the group
+axidma_dev_t axidma_group_get_dev(axidma_group_t group, int index)
+{
+    assert(0 <= index && index < group->num_engines);
+    return group->engines[index].dev;
+}
+
+/* Allocates a DMA buffer that every device in the group can use. It is
+ * allocated on the first device, and then shared with the other devices. */
+void *axidma_group_malloc(axidma_group_t group, size_t size)
+{
+    int i, dmabuf_fd;
+    void *addr;
+
+    addr = axidma_malloc(group->engines[0].dev, size);
+    if (addr == NULL) {
+        return NULL;
+    }
+
+    // The other devices hold their own reference, so the fd isn't needed
+    dmabuf_fd = axidma_export_buffer(group->engines[0].dev, addr);
+    if (dmabuf_fd < 0) {
+        goto free_buf;
+    }
+    for (i = 1; i < group->num_engines; i++)
+    {
+        if (axidma_register_buffer(group->engines[i].dev, dmabuf_fd, addr,
+                                   size) < 0) {
+            goto unregister_buf;
+        }
+    }
+    close(dmabuf_fd);
+
+    return addr;
+
+unregister_buf:
+    for (i -= 1; i > 0; i--)
+    {
+        axidma_unregister_buffer(group->engines[i].dev, addr);
+    }
+    close(dmabuf_fd);
+free_buf:
+    axidma_free(group->engines[0].dev, addr, size);
+    return NULL;
+}
+
+// Frees a DMA buffer allocated by axidma_group_malloc
+void axidma_group_free(axidma_group_t group, void *addr, size_t size)
+{
+    int i;
+
+    for (i = 1; i < group->num_engines; i++)
+    {
+        axidma_unregister_buffer(group->engines[i].dev, addr);
+    }
+    axidma_free(group->engines[0].dev, addr, size);
+
+    return;
+}
+
+/* Stripes a two-way transfer across the engines of the group, in chunks. The
+ * callback is invoked for each chunk in the order of the stream, once all of
+ * the chunks before it have completed too. */
+int axidma_group_transfer(axidma_group_t group, void *tx_buf, size_t tx_len,
+        void *rx_buf, size_t rx_len, axidma_group_cb_t callback, void *data)
+{
+    int rc, i, num_cqes, inflight;
+    long num_chunks, submitted, completed;
+    struct axidma_group_chunk *chunk;
+    struct axidma_group_engine *engine;
+
+    assert(tx_buf != NULL || rx_buf != NULL);
+    assert(tx_buf == NULL || group->tx_chunk > 0);
+    assert(rx_buf == NULL || group->rx_chunk > 0);
+
+    // Both directions must be split into the same number of chunks
+    num_chunks = (tx_buf != NULL) ?
+            (tx_len + group->tx_chunk - 1) / group->tx_chunk :
+            (rx_len + group->rx_chunk - 1) / group->rx_chunk;
+    assert(tx_buf == NULL || rx_buf == NULL || num_chunks ==
+           (long)((rx_len + group->rx_chunk - 1) / group->rx_chunk));
+
+    /* Submit chunks while there is room on an engine, and in the window of
+     * chunks that haven't been reported yet. Once a transfer fails, stop
+     * submitting, but keep going until every submitted one has completed. */
+    rc = 0;
+    inflight = 0;
+    submitted = 0;
+    completed = 0;
+    while (completed < num_chunks && (rc == 0 || inflight > 0))
+    {
+        while (rc == 0 && submitted < num_chunks &&
+               submitted < completed + group->window)
+        {
+            engine = pick_engine(group, submitted);
+            if (engine == NULL) {
+                break;
+            }
+
+            chunk = &group->chunks[submitted % group->window];
+            chunk->index = submitted;
+            rc = submit_chunk(group, chunk, engine, tx_buf, tx_len, rx_buf,
+                              rx_len);
+            if (rc < 0) {
+                fprintf(stderr, "The submission ring of device %d is full.\n",
+                        chunk->engine);
+            }
+            inflight += (chunk->pending > 0) ? 1 : 0;
+            engine->inflight -= (chunk->pending > 0) ? 0 : 1;
+            submitted += 1;
+        }
+        if (inflight == 0) {
+            break;
+        }
+
+        num_cqes = reap_engines(group, true);
+        if (num_cqes < 0) {
+            return num_cqes;
+        }
+        for (i = 0; i < num_cqes; i++)
+        {
+            chunk = (struct axidma_group_chunk *)group->cqes[i].user_data;
+            assert(group->chunks <= chunk &&
+                   chunk < group->chunks + group->window);
+            if (group->cqes[i].status < 0 && rc == 0) {
+                fprintf(stderr, "Group transfer on device %d, channel %d "
+                        "failed: %s.\n", chunk->engine,
+                        group->cqes[i].channel_id,
+                        strerror(-group->cqes[i].status));
+                rc = group->cqes[i].status;
+            }
+            if (rx_buf != NULL && group->cqes[i].channel_id ==
+                    group->engines[chunk->engine].rx_channel) {
+                chunk->rx_bytes = group->cqes[i].bytes;
+            }
+
+            // Wait until both the transmit and receive are done with the chunk
+            chunk->pending -= 1;
+            if (chunk->pending > 0) {
+                continue;
+            }
+            chunk->done = true;
+            group->engines[chunk->engine].inflight -= 1;
+            inflight -= 1;
+        }
+
+        // Report the chunks that are done, up to the first one still running
+        while (rc == 0 && completed < submitted)
+        {
+            chunk = &group->chunks[completed % group->window];
+            if (!chunk->done) {
+                break;
+            }
+            if (callback != NULL) {
+                callback(chunk->index, chunk->rx_bytes, data);
+            }
+            completed += 1;
+        }
+    }
+
+    assert(rc < 0 || completed == num_chunks);
+    return rc;
+}
+
+#endif // LINUX_APP
@@ -0,0 +1,175 @@
+/**
+ * @file axidma_pool.c
+ * @date Wednesday, October 14, 2026 at 03:21:44 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains a pool allocator for DMA buffers, which carves a single
+ * large region allocated by the AXI DMA driver into fixed-size blocks. This
+ * allows for DMA buffers to be allocated and freed in constant time, without
+ * any system calls.
+ *
+ * @bug No known bugs.
+ **/
+#ifdef LINUX_APP
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>              // Error codes
+#include <stdint.h>             // Predefined size integers
+
+#include "libaxidma.h"          // Local definitions
+
+/*----------------------------------------------------------------------------
+ * Internal definitions
+ *----------------------------------------------------------------------------*/
+
+// The alignment of each block in the pool, so blocks don't share cache lines
+#define POOL_BLOCK_ALIGN        64
+
+// The index used to mark the end of the free list
+#define POOL_NIL                UINT32_MAX
+
+/* The head of the free list packs the index of the first free block in the low
+ * 32 bits, and a tag in the high 32 bits. The tag is incremented on every
+ * update, so that a compare-and-swap fails if the head was popped and pushed
+ * back in the meantime (the ABA problem). */
+#define POOL_HEAD(tag, index)   (((uint64_t)(tag) << 32) | (uint32_t)(index))
+#define POOL_HEAD_TAG(head)     ((uint32_t)((head) >> 32))
+#define POOL_HEAD_INDEX(head)   ((uint32_t)(head))
+
+// The structure that represents a pool of DMA buffers
+struct axidma_pool {
+    axidma_dev_t dev;           ///< The device the region was allocated from
+    char *mem;                  ///< The DMA buffer region the blocks are in
+    size_t mem_size;            ///< The size of the DMA buffer region
+    size_t block_size;          ///< The size of each block, after alignment
+    uint32_t num_blocks;        ///< The number of blocks in the pool
+    uint32_t *next;             ///< The next free block after each block
+    uint64_t head __attribute__((aligned(POOL_BLOCK_ALIGN)));
+                                ///< The tagged head of the free list
+};
+
+/*----------------------------------------------------------------------------
+ * Public Interface
+ *----------------------------------------------------------------------------*/
+
+/* Creates a pool of fixed-sized DMA buffers, allocating a single region from
+ * the driver to hold all of them. */
+axidma_pool_t axidma_pool_create(axidma_dev_t dev, size_t block_size,
+        size_t num_blocks)
+{
+    uint32_t i;
+    struct axidma_pool *pool;
+
+    assert(block_size > 0);
+    assert(0 < num_blocks && num_blocks < POOL_NIL);
+
+    pool = (struct axidma_pool *)calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        perror("Unable to allocate the DMA buffer pool structure");
+        return NULL;
+    }
+
+    // Allocate the DMA buffer region that holds all of the blocks
+    pool->dev = dev;
+    pool->block_size = (block_size + POOL_BLOCK_ALIGN - 1) &
+                       ~(size_t)(POOL_BLOCK_ALIGN - 1);
+    pool->num_blocks = num_blocks;
+    pool->mem_size = pool->block_size * num_blocks;
+    pool->mem = (char *)axidma_malloc(dev, pool->mem_size);
+    if (pool->mem == NULL) {
+        fprintf(stderr, "Unable to allocate a DMA buffer region of %zu bytes "
+                "for the pool.\n", pool->mem_size);
+        free(pool);
+        return NULL;
+    }
+
+    /* The free list links are kept in normal memory, rather than in the blocks
+     * themselves, since the DMA buffer region is uncached. */
+    pool->next = (uint32_t *)malloc(num_blocks * sizeof(pool->next[0]));
+    if (pool->next == NULL) {
+        perror("Unable to allocate the DMA buffer pool free list");
+        axidma_free(dev, pool->mem, pool->mem_size);
+        free(pool);
+        return NULL;
+    }
+
+    // Initially, all blocks are free, and are allocated in order
+    for (i = 0; i < pool->num_blocks; i++)
+    {
+        pool->next[i] = (i + 1 < pool->num_blocks) ? i + 1 : POOL_NIL;
+    }
+    pool->head = POOL_HEAD(0, 0);
+
+    return pool;
+}
+
+/* Destroys the pool, freeing its DMA buffer region. All of the blocks are
+ * freed, even if they are still in use. */
+void axidma_pool_destroy(axidma_pool_t pool)
+{
+    axidma_free(pool->dev, pool->mem, pool->mem_size);
+    free(pool->next);
+    free(pool);
+
+    return;
+}
+
+/* Allocates a block from the pool, by popping the head of the free list. This
+ * is safe to call concurrently from multiple threads. */
+void *axidma_pool_alloc(axidma_pool_t pool)
+{
+    uint32_t index, next;
+    uint64_t head, new_head;
+
+    head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+    do {
+        index = POOL_HEAD_INDEX(head);
+        if (index == POOL_NIL) {
+            return NULL;
+        }
+
+        /* The block may be allocated by another thread before the exchange,
+         * in which case the tag will have changed, and we retry. */
+        next = __atomic_load_n(&pool->next[index], __ATOMIC_RELAXED);
+        new_head = POOL_HEAD(POOL_HEAD_TAG(head) + 1, next);
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, new_head, true,
+                __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    return pool->mem + (size_t)index * pool->block_size;
+}
+
+/* Returns a block to the pool, by pushing it onto the head of the free list.
+ * This is safe to call concurrently from multiple threads. */
+void axidma_pool_free(axidma_pool_t pool, void *block)
+{
+    size_t offset;
+    uint32_t index;
+    uint64_t head, new_head;
+
+    assert((char *)block >= pool->mem);
+    assert((char *)block < pool->mem + pool->mem_size);
+    assert(((char *)block - pool->mem) % pool->block_size == 0);
+
+    offset = (char *)block - pool->mem;
+    index = offset / pool->block_size;
+
+    head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&pool->next[index], POOL_HEAD_INDEX(head),
+                         __ATOMIC_RELAXED);
+        new_head = POOL_HEAD(POOL_HEAD_TAG(head) + 1, index);
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, new_head, true,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    return;
+}
+
+// Returns the usable size of each block in the pool
+size_t axidma_pool_block_size(axidma_pool_t pool)
+{
+    return pool->block_size;
+}
+
+#endif // LINUX_APP
@@ -0,0 +1,225 @@
+/**
+ * @file axidma_stream.c
+ * @date Wednesday, October 14, 2026 at 05:02:17 PM EDT
+ * @author Brandon Perez (bmperez)
+ * @author Jared Choi (jaewonch)
+ *
+ * This file contains a pipelined streaming interface for two-way transfers.
+ * The caller hands over a set of transmit and receive buffer pairs, and the
+ * library keeps a transfer in flight on each pair, recycling it as soon as it
+ * completes. This keeps the DMA engine busy while userspace handles the
+ * completed transfers, instead of leaving it idle between each one.
+ *
+ * @bug No known bugs.
+ **/
+#ifdef LINUX_APP
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>              // Error codes
+#include <string.h>             // Memcpy function
+
+#include "libaxidma.h"          // Local definitions
+
+/*----------------------------------------------------------------------------
+ * Internal definitions
+ *----------------------------------------------------------------------------*/
+
+// The state of each transmit and receive buffer pair in the stream
+struct axidma_stream_slot {
+    int index;                  ///< The index of the pair in the stream
+    int pending;                ///< The number of its transfers in flight
+};
+
+// The structure that represents a stream of two-way transfers
+struct axidma_stream {
+    axidma_dev_t dev;           ///< The device the transfers are performed on
+    int tx_channel;             ///< The channel used for transmitting
+    int rx_channel;             ///< The channel used for receiving
+    size_t tx_len;              ///< The length of each transmit buffer
+    size_t rx_len;              ///< The length of each receive buffer
+    int depth;                  ///< The number of buffer pairs in the stream
+    void **tx_bufs;             ///< The transmit buffer of each pair
+    void **rx_bufs;             ///< The receive buffer of each pair
+    struct axidma_stream_slot *slots;   ///< The state of each pair
+    struct axidma_cqe *cqes;    ///< Completions reaped from the ring
+};
+
+/*----------------------------------------------------------------------------
+ * Private Helper Functions
+ *----------------------------------------------------------------------------*/
+
+/* Places the transfers for the given slot into the submission ring. The
+ * receive is submitted first, so that it is ready before the data comes back
+ * from the fabric. The slot's pending count reflects what was submitted, even
+ * on failure, so that those transfers can still be waited for. */
+static int submit_slot(axidma_stream_t stream, struct axidma_stream_slot *slot)
+{
+    int rc;
+
+    slot->pending = 0;
+    rc = axidma_ring_submit(stream->dev, stream->rx_channel,
+            stream->rx_bufs[slot->index], stream->rx_len, slot);
+    if (rc < 0) {
+        goto ring_full;
+    }
+    slot->pending += 1;
+
+    rc = axidma_ring_submit(stream->dev, stream->tx_channel,
+            stream->tx_bufs[slot->index], stream->tx_len, slot);
+    if (rc < 0) {
+        goto ring_full;
+    }
+    slot->pending += 1;
+
+    return 0;
+
+ring_full:
+    fprintf(stderr, "The submission ring is too small for a stream depth of "
+            "%d.\n", stream->depth);
+    return rc;
+}
+
+/*----------------------------------------------------------------------------
+ * Public Interface
+ *----------------------------------------------------------------------------*/
+
+/* Creates a stream of two-way transfers over the given buffer pairs. The
+ * buffer arrays are copied, so the caller does not need to keep them. */
+axidma_stream_t axidma_stream_create(axidma_dev_t dev, int tx_channel,
+        void **tx_bufs, size_t tx_len, int rx_channel, void **rx_bufs,
+        size_t rx_len, int depth)
+{
+    int i;
+    struct axidma_stream *stream;
+
+    assert(0 < depth && depth <= AXIDMA_MAX_RING_ENTRIES / 2);
+
+    stream = (struct axidma_stream *)calloc(1, sizeof(*stream));
+    if (stream == NULL) {
+        perror("Unable to allocate the DMA stream structure");
+        return NULL;
+    }
+    stream->dev = dev;
+    stream->tx_channel = tx_channel;
+    stream->rx_channel = rx_channel;
+    stream->tx_len = tx_len;
+    stream->rx_len = rx_len;
+    stream->depth = depth;
+
+    // Allocate the buffer arrays, the slots, and room for every completion
+    stream->tx_bufs = (void **)malloc(depth * sizeof(stream->tx_bufs[0]));
+    stream->rx_bufs = (void **)malloc(depth * sizeof(stream->rx_bufs[0]));
+    stream->slots = (struct axidma_stream_slot *)malloc(depth *
+            sizeof(stream->slots[0]));
+    stream->cqes = (struct axidma_cqe *)malloc(2 * depth *
+            sizeof(stream->cqes[0]));
+    if (stream->tx_bufs == NULL || stream->rx_bufs == NULL ||
+        stream->slots == NULL || stream->cqes == NULL) {
+        perror("Unable to allocate the DMA stream slots");
+        axidma_stream_destroy(stream);
+        return NULL;
+    }
+
+    memcpy(stream->tx_bufs, tx_bufs, depth * sizeof(stream->tx_bufs[0]));
+    memcpy(stream->rx_bufs, rx_bufs, depth * sizeof(stream->rx_bufs[0]));
+    for (i = 0; i < depth; i++)
+    {
+        stream->slots[i].index = i;
+        stream->slots[i].pending = 0;
+    }
+
+    return stream;
+}
+
+// Destroys the stream. The buffers are owned by the caller, so are not freed
+void axidma_stream_destroy(axidma_stream_t stream)
+{
+    free(stream->cqes);
+    free(stream->slots);
+    free(stream->rx_bufs);
+    free(stream->tx_bufs);
+    free(stream);
+
+    return;
+}
+
+/* Performs the given number of two-way transfers, keeping one in flight on
+ * each buffer pair. Whenever both the transmit and receive of a pair have
+ * completed, the callback is invoked, and the pair is submitted again. */
+int axidma_stream_run(axidma_stream_t stream, long num_transfers,
+        axidma_stream_cb_t callback, void *data)
+{
+    int rc, i, num_cqes, inflight;
+    long submitted, completed;
+    struct axidma_stream_slot *slot;
+
+    assert(num_transfers >= 0);
+
+    // Fill the pipeline, submitting a transfer on as many pairs as needed
+    rc = 0;
+    inflight = 0;
+    submitted = 0;
+    while (rc == 0 && submitted < num_transfers && submitted < stream->depth)
+    {
+        slot = &stream->slots[submitted];
+        rc = submit_slot(stream, slot);
+        inflight += (slot->pending > 0) ? 1 : 0;
+        submitted += (rc == 0) ? 1 : 0;
+    }
+
+    /* Once a transfer fails, stop recycling the pairs, but keep going until
+     * every transfer that was submitted has completed. */
+    completed = 0;
+    while (inflight > 0)
+    {
+        // Start the submitted transfers, and wait for at least one completion
+        if (axidma_ring_enter(stream->dev, 1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+
+        num_cqes = axidma_ring_reap(stream->dev, stream->cqes,
+                                    2 * stream->depth);
+        for (i = 0; i < num_cqes; i++)
+        {
+            slot = (struct axidma_stream_slot *)stream->cqes[i].user_data;
+            assert(stream->slots <= slot &&
+                   slot < stream->slots + stream->depth);
+            if (stream->cqes[i].status < 0 && rc == 0) {
+                fprintf(stderr, "Stream transfer on channel %d failed: %s.\n",
+                        stream->cqes[i].channel_id,
+                        strerror(-stream->cqes[i].status));
+                rc = stream->cqes[i].status;
+            }
+
+            // Wait until both the transmit and receive are done with the pair
+            slot->pending -= 1;
+            if (slot->pending > 0) {
+                continue;
+            }
+            inflight -= 1;
+            if (rc < 0) {
+                continue;
+            }
+
+            // Let the user handle the pair, then recycle it, if there's more
+            completed += 1;
+            if (callback != NULL) {
+                callback(slot->index, data);
+            }
+            if (submitted < num_transfers) {
+                rc = submit_slot(stream, slot);
+                inflight += (slot->pending > 0) ? 1 : 0;
+                submitted += (rc == 0) ? 1 : 0;
+            }
+        }
+    }
+
+    assert(rc < 0 || completed == num_transfers);
+    return rc;
+}
+
+#endif // LINUX_APP
@@ -19,6 +19,7 @@
 #include <sys/types.h>          // Types for open()
 #include <sys/mman.h>           // Mmap system call
 #include <sys/ioctl.h>          // IOCTL system call
+#include <poll.h>               // Poll system call
 #include <unistd.h>             // Close() system call
 #include <errno.h>              // Error codes
 #include <signal.h>             // Signal handling functions
@@ -39,8 +40,46 @@ typedef struct dma_channel {
     uint64_t dma_addr;          ///< Physical address of the DMA device
     axidma_cb_t callback;       ///< Callback function for channel completion
     void *user_data;            ///< User data to pass to the callback
+    const struct axidma_cyclic_status *video_status;    ///< Video status
 } dma_channel_t;
 
+// A structure that holds the shared submission and completion rings
+typedef struct axidma_ring {
+    void *mem;                  ///< The shared memory region for the rings
+    size_t mem_size;            ///< The size of the shared memory region
+    struct axidma_ring_header *hdr; ///< The header at the start of the region
+    struct axidma_sqe *sqes;    ///< The submission queue entries
+    struct axidma_cqe *cqes;    ///< The completion queue entries
+    bool sq_poll;               ///< Indicates the SQ is polled by the driver
+} axidma_ring_t;
+
+// The number of buffers whose bus address is cached for each BD ring
+#define BDRING_CACHE_SIZE       8
+
+// A contiguous segment of a DMA buffer, and its bus address
+struct bdring_segment {
+    char *addr;                 ///< The user address of the segment
+    size_t size;                ///< The size of the segment
+    uint64_t dma_addr;          ///< The bus address of the segment
+};
+
+// The structure that represents a channel's userspace BD ring
+struct axidma_bdring {
+    axidma_dev_t dev;           ///< The device the channel belongs to
+    int channel;                ///< The channel dedicated to the ring
+    enum axidma_dir dir;        ///< The direction of the channel
+    struct axidma_bd *bds;      ///< The BDs, mapped from the driver
+    size_t bds_size;            ///< The size of the mapping of the BDs
+    uint64_t bds_dma;           ///< The bus address of the first BD
+    unsigned int num_bds;       ///< The number of BDs in the ring
+    unsigned int head;          ///< The next BD to check for completion
+    unsigned int tail;          ///< The next BD to post a buffer to
+    unsigned int kicked;        ///< The BDs the engine has been started on
+    void **bufs;                ///< The buffer posted to each BD
+    struct bdring_segment cache[BDRING_CACHE_SIZE]; ///< Recent segments
+    int next_cache;             ///< The next cache entry to replace
+};
+
 // The structure that represents the AXI DMA device
 struct axidma_dev {
     int fd;                     ///< File descriptor for the device
@@ -50,6 +89,11 @@ struct axidma_dev {
     array_t vdma_rx_chans;      ///< Channel id's for the VDMA receive channels
     int num_channels;           ///< The total number of DMA channels
     dma_channel_t *channels;    ///< All of the VDMA/DMA channels in the system
+    int num_channel_ids;        ///< One more than the largest channel id
+    dma_channel_t **channel_index;  ///< The channels, indexed by their id
+    axidma_ring_t ring;         ///< The shared submission/completion rings
+    void *cyclic_mem;           ///< The mapped status of cyclic transfers
+    size_t cyclic_size;         ///< The size of the cyclic status region
 };
 
 /*----------------------------------------------------------------------------
@@ -134,9 +178,34 @@ static int categorize_channels(axidma_dev_t dev,
         dma_chan->channel_id = chan->channel_id;
         dma_chan->callback = NULL;
         dma_chan->user_data = NULL;
+        dma_chan->video_status = NULL;
     }
 
-    // Assign the length of the arrays
+    // Build a table to directly lookup each channel by its id
+    dev->num_channel_ids = 0;
+    for (i = 0; i < dev->num_channels; i++)
+    {
+        if (dev->channels[i].channel_id >= dev->num_channel_ids) {
+            dev->num_channel_ids = dev->channels[i].channel_id + 1;
+        }
+    }
+    dev->channel_index = (dma_channel_t **)calloc(dev->num_channel_ids,
+            sizeof(dev->channel_index[0]));
+    if (dev->channel_index == NULL) {
+        free(dev->channels);
+        free(dev->dma_tx_chans.data);
+        free(dev->dma_rx_chans.data);
+        free(dev->vdma_tx_chans.data);
+        free(dev->vdma_rx_chans.data);
+        return -ENOMEM;
+    }
+    for (i = 0; i < dev->num_channels; i++)
+    {
+        dma_chan = &dev->channels[i];
+        if (dma_chan->channel_id >= 0) {
+            dev->channel_index[dma_chan->channel_id] = dma_chan;
+        }
+    }
 
     return 0;
 }
@@ -185,18 +254,11 @@ static int probe_channels(axidma_dev_t dev)
 // Finds the DMA channel with the given id
 static dma_channel_t *find_channel(axidma_dev_t dev, int channel_id)
 {
-    int i;
-    dma_channel_t *dma_chan;
-
-    for (i = 0; i < dev->num_channels; i++)
-    {
-        dma_chan = &dev->channels[i];
-        if (dma_chan->channel_id == channel_id) {
-            return dma_chan;
-        }
+    if (channel_id < 0 || channel_id >= dev->num_channel_ids) {
+        return NULL;
     }
 
-    return NULL;
+    return dev->channel_index[channel_id];
 }
 
 static void axidma_callback(int signal, siginfo_t *siginfo, void *context)
@@ -213,7 +275,7 @@ static void axidma_callback(int signal, siginfo_t *siginfo, void *context)
     (void)context;
 
     // If the user defined a callback for a given channel, invoke it
-    chan = &dev->channels[channel];
+    chan = find_channel(dev, channel);
     if (chan->callback != NULL) {
         chan->callback(channel, chan->user_data);
     }
@@ -253,6 +315,29 @@ static int setup_dma_callback(axidma_dev_t dev)
     return 0;
 }
 
+/* Maps the region with the status of the cyclic and video transfers, if it
+ * isn't mapped yet. It's only written by the driver. */
+static int map_cyclic_status(axidma_dev_t dev, size_t size)
+{
+    int rc;
+    void *mem;
+
+    if (dev->cyclic_mem != NULL) {
+        return 0;
+    }
+
+    mem = mmap(NULL, size, PROT_READ, MAP_SHARED, dev->fd,
+               AXIDMA_MMAP_CYCLIC_OFFSET);
+    if (mem == MAP_FAILED) {
+        rc = -errno;
+        perror("Failed to map the AXI DMA cyclic transfer status");
+        return rc;
+    }
+    dev->cyclic_mem = mem;
+    dev->cyclic_size = size;
+    return 0;
+}
+
 // Converts the AXI DMA direction to the corresponding ioctl for the transfer
 static unsigned long dir_to_ioctl(enum axidma_dir dir)
 {
@@ -291,13 +376,14 @@ struct axidma_dev *axidma_init_dev(unsigned int index)
         return NULL;
     }
 
-    // Open the AXI DMA device
+    /* Open the AXI DMA device. Reads of the completion events never block,
+     * since waiting for them is done with poll. */
     if (index) {
         snprintf(path, pathlen, "%s%d", AXIDMA_DEV_PATH, index);
-        dev->fd = open(path, O_RDWR|O_EXCL);
+        dev->fd = open(path, O_RDWR | O_NONBLOCK);
     }
     else
-        dev->fd = open(AXIDMA_DEV_PATH, O_RDWR|O_EXCL);
+        dev->fd = open(AXIDMA_DEV_PATH, O_RDWR | O_NONBLOCK);
 
     if (dev->fd < 0) {
         perror("Error opening AXI DMA device");
@@ -327,11 +413,22 @@ struct axidma_dev *axidma_init_dev(unsigned int index)
 // Tears down the given AXI DMA device structure
 void axidma_destroy(axidma_dev_t dev)
 {
+    // Unmap the shared submission and completion rings, if they were setup
+    if (dev->ring.mem != NULL) {
+        munmap(dev->ring.mem, dev->ring.mem_size);
+    }
+
+    // Unmap the status of the cyclic transfers, if any were started
+    if (dev->cyclic_mem != NULL) {
+        munmap(dev->cyclic_mem, dev->cyclic_size);
+    }
+
     // Free the arrays used for channel id's and channel metadata
     free(dev->vdma_rx_chans.data);
     free(dev->vdma_tx_chans.data);
     free(dev->dma_rx_chans.data);
     free(dev->dma_tx_chans.data);
+    free(dev->channel_index);
     free(dev->channels);
 
     // Close the AXI DMA device
@@ -367,6 +464,132 @@ const array_t *axidma_get_vdma_rx(axidma_dev_t dev)
     return &dev->vdma_rx_chans;
 }
 
+// Performs the claim or release IOCTL for the given channel
+static int claim_channel(axidma_dev_t dev, unsigned long cmd, int channel)
+{
+    struct axidma_claim claim;
+
+    assert(find_channel(dev, channel) != NULL);
+
+    claim.channel_id = channel;
+    return ioctl(dev->fd, cmd, &claim);
+}
+
+/* Claims the given channel for exclusive use by this handle, so that no other
+ * process can use it until it is released. */
+int axidma_claim_channel(axidma_dev_t dev, int channel)
+{
+    int rc;
+
+    rc = claim_channel(dev, AXIDMA_CLAIM_CHANNEL, channel);
+    if (rc < 0) {
+        perror("Failed to claim the DMA channel");
+    }
+
+    return rc;
+}
+
+/* Releases the given channel, stopping any transfers on it, so that another
+ * process can use it. */
+int axidma_release_channel(axidma_dev_t dev, int channel)
+{
+    int rc;
+
+    rc = claim_channel(dev, AXIDMA_RELEASE_CHANNEL, channel);
+    if (rc < 0) {
+        perror("Failed to release the DMA channel");
+    }
+
+    return rc;
+}
+
+/* Sets how long synchronous transfers on the channel spin for, waiting for
+ * their completion, before the driver puts the thread to sleep. */
+int axidma_set_poll_budget(axidma_dev_t dev, int channel,
+                           unsigned int budget_us)
+{
+    int rc;
+    struct axidma_poll_budget poll;
+
+    assert(find_channel(dev, channel) != NULL);
+
+    poll.channel_id = channel;
+    poll.budget_us = budget_us;
+    rc = ioctl(dev->fd, AXIDMA_SET_POLL_BUDGET, &poll);
+    if (rc < 0) {
+        perror("Failed to set the poll budget for the DMA channel");
+        return rc;
+    }
+
+    return 0;
+}
+
+/* Sets how many frames on a VDMA channel complete for each interrupt, and the
+ * delay after which the channel interrupts anyway. */
+int axidma_set_coalesce(axidma_dev_t dev, int channel, unsigned int threshold,
+                        unsigned int delay)
+{
+    int rc;
+    struct axidma_coalesce coalesce;
+
+    assert(find_channel(dev, channel) != NULL);
+
+    coalesce.channel_id = channel;
+    coalesce.threshold = threshold;
+    coalesce.delay = delay;
+    rc = ioctl(dev->fd, AXIDMA_SET_COALESCE, &coalesce);
+    if (rc < 0) {
+        perror("Failed to set the interrupt coalescing for the DMA channel");
+        return rc;
+    }
+
+    return 0;
+}
+
+/* Gets the CPUs that the channel's interrupt is handled on, and the CPU its
+ * completions are delivered from. */
+int axidma_get_affinity(axidma_dev_t dev, int channel,
+                        unsigned long long *irq_cpus, int *notify_cpu)
+{
+    int rc;
+    struct axidma_affinity affinity;
+
+    assert(find_channel(dev, channel) != NULL);
+
+    affinity.channel_id = channel;
+    rc = ioctl(dev->fd, AXIDMA_GET_AFFINITY, &affinity);
+    if (rc < 0) {
+        perror("Failed to get the affinity of the DMA channel");
+        return rc;
+    }
+
+    *irq_cpus = affinity.irq_cpus;
+    *notify_cpu = affinity.notify_cpu;
+    return 0;
+}
+
+/* Sets the CPUs that the channel's interrupt is handled on, and the CPU its
+ * completions are delivered from. */
+int axidma_set_affinity(axidma_dev_t dev, int channel,
+                        unsigned long long irq_cpus, int notify_cpu)
+{
+    int rc;
+    struct axidma_affinity affinity;
+
+    assert(find_channel(dev, channel) != NULL);
+
+    affinity.channel_id = channel;
+    affinity.irq_cpus = irq_cpus;
+    affinity.notify_cpu = notify_cpu;
+    rc = ioctl(dev->fd, AXIDMA_SET_AFFINITY, &affinity);
+    if (rc < 0) {
+        perror("Failed to set the affinity of the DMA channel");
+        return rc;
+    }
+
+    return 0;
+}
+
 /* Allocates a region of memory suitable for use with the AXI DMA driver. Note
  * that this is a quite expensive operation, and should be done at initalization
  * time. */
@@ -383,6 +606,95 @@ void *axidma_malloc(axidma_dev_t dev, size_t size)
     return addr;
 }
 
+/* Allocates a region of memory suitable for use with the AXI DMA driver, which
+ * is mapped cached. The user must synchronize it around each transfer, with
+ * axidma_sync_for_cpu and axidma_sync_for_device. */
+void *axidma_malloc_cached(axidma_dev_t dev, size_t size)
+{
+    void *addr;
+
+    // The driver allocates a cached buffer for mmaps at this offset
+    addr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, dev->fd,
+                AXIDMA_MMAP_CACHED_OFFSET);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    return addr;
+}
+
+// Synchronizes a range of a cached DMA buffer, for either the CPU or device
+static int sync_buffer(axidma_dev_t dev, unsigned long cmd, void *addr,
+                       size_t size)
+{
+    int rc;
+    struct axidma_sync sync;
+
+    sync.user_addr = addr;
+    sync.size = size;
+    rc = ioctl(dev->fd, cmd, &sync);
+    if (rc < 0) {
+        perror("Failed to synchronize the DMA buffer");
+    }
+
+    return rc;
+}
+
+/* Makes the data received by the device into a cached DMA buffer visible to the
+ * CPU. This must be called after the transfer completes. */
+int axidma_sync_for_cpu(axidma_dev_t dev, void *addr, size_t size)
+{
+    return sync_buffer(dev, AXIDMA_SYNC_FOR_CPU, addr, size);
+}
+
+/* Makes the data written by the CPU into a cached DMA buffer visible to the
+ * device. This must be called before the transfer is started. */
+int axidma_sync_for_device(axidma_dev_t dev, void *addr, size_t size)
+{
+    return sync_buffer(dev, AXIDMA_SYNC_FOR_DEVICE, addr, size);
+}
+
+/* Gets the size of the driver's reserved memory region for DMA buffers, and how
+ * much of it is still available. Both are zero if there is no such region. */
+int axidma_get_mem_info(axidma_dev_t dev, size_t *total_size,
+                        size_t *avail_size)
+{
+    int rc;
+    struct axidma_mem_info mem_info;
+
+    rc = ioctl(dev->fd, AXIDMA_GET_MEM_INFO, &mem_info);
+    if (rc < 0) {
+        perror("Failed to get the DMA memory information");
+        return rc;
+    }
+
+    if (total_size != NULL) {
+        *total_size = mem_info.total_size;
+    }
+    if (avail_size != NULL) {
+        *avail_size = mem_info.avail_size;
+    }
+    return 0;
+}
+
+/* Gets the driver's statistics for the given channel, such as the number of
+ * bytes transferred, errors, and the time the channel has spent busy. */
+int axidma_get_stats(axidma_dev_t dev, int channel, struct axidma_stats *stats)
+{
+    int rc;
+
+    assert(find_channel(dev, channel) != NULL);
+
+    stats->channel_id = channel;
+    rc = ioctl(dev->fd, AXIDMA_GET_STATS, stats);
+    if (rc < 0) {
+        perror("Failed to get the DMA channel statistics");
+        return rc;
+    }
+
+    return 0;
+}
+
 /* This frees a region of memory that was allocated with a call to
  * axidma_malloc. The size passed in here must match the one used for that
  * call, or this function will throw an exception. */
@@ -408,7 +720,7 @@ void axidma_set_callback(axidma_dev_t dev, int channel, axidma_cb_t callback,
 
     assert(find_channel(dev, channel) != NULL);
 
-    chan = &dev->channels[channel];
+    chan = find_channel(dev, channel);
     chan->callback = callback;
     chan->user_data = data;
 
@@ -455,10 +767,33 @@ void axidma_unregister_buffer(axidma_dev_t dev, void *user_addr)
     return;
 }
 
-/* This performs a one-way transfer over AXI DMA, the direction being specified
- * by the user. The user determines if this is blocking or not with `wait. */
-int axidma_oneway_transfer(axidma_dev_t dev, int channel, void *buf,
-        size_t len, bool wait)
+/* Exports a DMA buffer allocated by the driver, returning a DMA buffer sharing
+ * file descriptor that can be passed to other drivers. This is the reverse of
+ * axidma_register_buffer. */
+int axidma_export_buffer(axidma_dev_t dev, void *user_addr)
+{
+    int rc;
+    struct axidma_export_buffer export;
+
+    // Setup the argument structure to the IOCTL
+    export.user_addr = user_addr;
+    export.flags = O_CLOEXEC;
+    export.dmabuf_fd = -1;
+
+    // Have the driver export the buffer
+    rc = ioctl(dev->fd, AXIDMA_EXPORT_BUFFER, &export);
+    if (rc < 0) {
+        perror("Failed to export the DMA buffer");
+        return rc;
+    }
+
+    return export.dmabuf_fd;
+}
+
+/* Performs a one-way transfer in the direction of the channel, waiting for up
+ * to the given timeout if it is blocking. */
+static int oneway_transfer(axidma_dev_t dev, int channel, void *buf,
+        size_t len, bool wait, int timeout, size_t *bytes)
 {
     int rc;
     struct axidma_transaction trans;
@@ -473,10 +808,15 @@ int axidma_oneway_transfer(axidma_dev_t dev, int channel, void *buf,
     trans.channel_id = channel;
     trans.buf = buf;
     trans.buf_len = len;
+    trans.timeout = timeout;
+    trans.bytes = 0;
     axidma_cmd = dir_to_ioctl(dma_chan->dir);
 
-    // Perform the given transfer
+    // Perform the given transfer, a timeout still reports the partial length
     rc = ioctl(dev->fd, axidma_cmd, &trans);
+    if (bytes != NULL) {
+        *bytes = trans.bytes;
+    }
     if (rc < 0) {
         perror("Failed to perform the AXI DMA transfer");
         return rc;
@@ -485,12 +825,86 @@ int axidma_oneway_transfer(axidma_dev_t dev, int channel, void *buf,
     return 0;
 }
 
-/* This performs a two-way transfer over AXI DMA, both sending data out and
- * receiving it back over DMA. The user determines if this call is blocking. */
-int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
+/* This performs a one-way transfer over AXI DMA, the direction being specified
+ * by the user. The user determines if this is blocking or not with `wait. */
+int axidma_oneway_transfer(axidma_dev_t dev, int channel, void *buf,
+        size_t len, bool wait)
+{
+    return oneway_transfer(dev, channel, buf, len, wait,
+                           AXIDMA_DEFAULT_TIMEOUT, NULL);
+}
+
+/* This performs a blocking one-way transfer over AXI DMA, which is stopped if
+ * it doesn't complete within the timeout. */
+int axidma_oneway_transfer_timeout(axidma_dev_t dev, int channel, void *buf,
+        size_t len, int timeout, size_t *bytes)
+{
+    return oneway_transfer(dev, channel, buf, len, true, timeout, bytes);
+}
+
+/* Performs a one-way transfer between the channel and a vector of buffers,
+ * waiting for up to the given timeout if it is blocking. */
+static int oneway_transfer_v(axidma_dev_t dev, int channel,
+        const struct iovec *iov, int iovcnt, bool wait, int timeout,
+        size_t *bytes)
+{
+    int rc;
+    struct axidma_vec_transaction trans;
+    unsigned long axidma_cmd;
+    dma_channel_t *dma_chan;
+
+    assert(find_channel(dev, channel) != NULL);
+    assert(find_channel(dev, channel)->type == AXIDMA_DMA);
+    assert(0 < iovcnt && iovcnt <= AXIDMA_MAX_TRANSFER_VECS);
+
+    // Setup the argument structure to the IOCTL
+    dma_chan = find_channel(dev, channel);
+    trans.wait = wait;
+    trans.channel_id = channel;
+    trans.num_vecs = iovcnt;
+    trans.vecs = (struct iovec *)iov;
+    trans.timeout = timeout;
+    trans.bytes = 0;
+    axidma_cmd = (dma_chan->dir == AXIDMA_READ) ? AXIDMA_DMA_READ_V :
+                                                  AXIDMA_DMA_WRITE_V;
+
+    // Perform the given transfer, a timeout still reports the partial length
+    rc = ioctl(dev->fd, axidma_cmd, &trans);
+    if (bytes != NULL) {
+        *bytes = trans.bytes;
+    }
+    if (rc < 0) {
+        perror("Failed to perform the AXI DMA vectored transfer");
+        return rc;
+    }
+
+    return 0;
+}
+
+/* This performs a one-way transfer over AXI DMA between the channel and a
+ * vector of buffers, as a single scatter-gather transfer. The direction is
+ * determined by the channel. The user determines if this call is blocking. */
+int axidma_oneway_transfer_v(axidma_dev_t dev, int channel,
+        const struct iovec *iov, int iovcnt, bool wait)
+{
+    return oneway_transfer_v(dev, channel, iov, iovcnt, wait,
+                             AXIDMA_DEFAULT_TIMEOUT, NULL);
+}
+
+/* Performs a blocking vectored transfer, which is stopped if it doesn't
+ * complete within the timeout. */
+int axidma_oneway_transfer_v_timeout(axidma_dev_t dev, int channel,
+        const struct iovec *iov, int iovcnt, int timeout, size_t *bytes)
+{
+    return oneway_transfer_v(dev, channel, iov, iovcnt, true, timeout, bytes);
+}
+
+/* Performs a two-way transfer, waiting for up to the given timeout for the
+ * receive transfer if it is blocking. */
+static int twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
         size_t tx_len, struct axidma_video_frame *tx_frame, int rx_channel,
         void *rx_buf, size_t rx_len, struct axidma_video_frame *rx_frame,
-        bool wait)
+        bool wait, int timeout, size_t *rx_bytes)
 {
     int rc;
     struct axidma_inout_transaction trans;
@@ -508,6 +922,8 @@ int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
     trans.rx_channel_id = rx_channel;
     trans.rx_buf = rx_buf;
     trans.rx_buf_len = rx_len;
+    trans.timeout = timeout;
+    trans.rx_bytes = 0;
 
     // Copy in the video frame if it is specified
     if (tx_frame == NULL) {
@@ -523,6 +939,9 @@ int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
 
     // Perform the read-write transfer
     rc = ioctl(dev->fd, AXIDMA_DMA_READWRITE, &trans);
+    if (rx_bytes != NULL) {
+        *rx_bytes = trans.rx_bytes;
+    }
     if (rc < 0) {
         perror("Failed to perform the AXI DMA read-write transfer");
     }
@@ -530,38 +949,724 @@ int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
     return rc;
 }
 
-/* This function performs a video transfer over AXI DMA, setting up a VDMA
- * channel to either read from or write to given frame buffers on-demand
- * continuously. This call is always non-blocking. The transfer can only be
- * stopped with a call to axidma_stop_transfer. */
-int axidma_video_transfer(axidma_dev_t dev, int display_channel, size_t width,
-        size_t height, size_t depth, void **frame_buffers, int num_buffers)
+/* This performs a two-way transfer over AXI DMA, both sending data out and
+ * receiving it back over DMA. The user determines if this call is blocking. */
+int axidma_twoway_transfer(axidma_dev_t dev, int tx_channel, void *tx_buf,
+        size_t tx_len, struct axidma_video_frame *tx_frame, int rx_channel,
+        void *rx_buf, size_t rx_len, struct axidma_video_frame *rx_frame,
+        bool wait)
+{
+    return twoway_transfer(dev, tx_channel, tx_buf, tx_len, tx_frame,
+            rx_channel, rx_buf, rx_len, rx_frame, wait, AXIDMA_DEFAULT_TIMEOUT,
+            NULL);
+}
+
+/* This performs a blocking two-way transfer over AXI DMA, which is stopped if
+ * the receive transfer doesn't complete within the timeout. */
+int axidma_twoway_transfer_timeout(axidma_dev_t dev, int tx_channel,
+        void *tx_buf, size_t tx_len, struct axidma_video_frame *tx_frame,
+        int rx_channel, void *rx_buf, size_t rx_len,
+        struct axidma_video_frame *rx_frame, int timeout, size_t *rx_bytes)
+{
+    return twoway_transfer(dev, tx_channel, tx_buf, tx_len, tx_frame,
+            rx_channel, rx_buf, rx_len, rx_frame, true, timeout, rx_bytes);
+}
+
+/* This submits a batch of non-blocking transfers over AXI DMA with a single
+ * call, so that the channels can be kept busy with many small transfers. */
+int axidma_submit_batch(axidma_dev_t dev, struct axidma_batch_entry *entries,
+        int num_entries)
+{
+    int rc, i;
+    struct axidma_batch_transaction trans;
+
+    assert(0 < num_entries && num_entries <= AXIDMA_MAX_BATCH_ENTRIES);
+    for (i = 0; i < num_entries; i++)
+    {
+        assert(find_channel(dev, entries[i].channel_id) != NULL);
+        assert(find_channel(dev, entries[i].channel_id)->type == AXIDMA_DMA);
+    }
+
+    // Setup the argument structure for the IOCTL
+    trans.num_entries = num_entries;
+    trans.entries = entries;
+
+    // Perform the batch of transfers
+    rc = ioctl(dev->fd, AXIDMA_DMA_SUBMIT_BATCH, &trans);
+    if (rc < 0) {
+        perror("Failed to perform the AXI DMA batch transfer");
+    }
+
+    return rc;
+}
+
+/* Prepares a transfer of the buffer on the channel, so that it can be submitted
+ * many times without the driver looking up the buffer again each time. */
+int axidma_prepare(axidma_dev_t dev, int channel, void *buf, size_t len)
+{
+    int rc;
+    struct axidma_prepared_transfer prepared;
+
+    assert(find_channel(dev, channel) != NULL);
+    assert(find_channel(dev, channel)->type == AXIDMA_DMA);
+
+    prepared.channel_id = channel;
+    prepared.buf = buf;
+    prepared.buf_len = len;
+    rc = ioctl(dev->fd, AXIDMA_PREPARE_TRANSFER, &prepared);
+    if (rc < 0) {
+        perror("Failed to prepare the AXI DMA transfer");
+        return rc;
+    }
+
+    return prepared.handle;
+}
+
+/* Submits a prepared transfer, waiting for up to the given timeout if it is
+ * blocking. */
+static int submit_prepared(axidma_dev_t dev, int handle, bool wait,
+                           int timeout, size_t *bytes)
+{
+    int rc;
+    struct axidma_prepared_submit submit;
+
+    submit.handle = handle;
+    submit.wait = wait;
+    submit.timeout = timeout;
+    submit.bytes = 0;
+    rc = ioctl(dev->fd, AXIDMA_SUBMIT_PREPARED, &submit);
+    if (bytes != NULL) {
+        *bytes = submit.bytes;
+    }
+    if (rc < 0) {
+        perror("Failed to submit the prepared AXI DMA transfer");
+        return rc;
+    }
+
+    return 0;
+}
+
+/* Submits a prepared transfer. The user determines if this call is blocking
+ * with `wait`. */
+int axidma_submit(axidma_dev_t dev, int handle, bool wait)
+{
+    return submit_prepared(dev, handle, wait, AXIDMA_DEFAULT_TIMEOUT, NULL);
+}
+
+/* Submits a prepared transfer, and waits for it, stopping it if it doesn't
+ * complete within the timeout. */
+int axidma_submit_timeout(axidma_dev_t dev, int handle, int timeout,
+                          size_t *bytes)
+{
+    return submit_prepared(dev, handle, true, timeout, bytes);
+}
+
+// Frees a prepared transfer, once it won't be submitted anymore
+int axidma_unprepare(axidma_dev_t dev, int handle)
+{
+    int rc;
+    struct axidma_prepared_transfer prepared;
+
+    prepared.handle = handle;
+    rc = ioctl(dev->fd, AXIDMA_UNPREPARE_TRANSFER, &prepared);
+    if (rc < 0) {
+        perror("Failed to free the prepared AXI DMA transfer");
+        return rc;
+    }
+
+    return 0;
+}
+
+/* Sets up the submission and completion rings shared with the driver, and
+ * maps them into our address space. */
+int axidma_ring_init(axidma_dev_t dev, unsigned int sq_entries,
+        unsigned int cq_entries, bool sq_poll)
+{
+    int rc;
+    void *mem;
+    struct axidma_ring_setup setup;
+    axidma_ring_t *ring;
+
+    ring = &dev->ring;
+    assert(ring->mem == NULL);
+
+    // Have the driver allocate the rings
+    memset(&setup, 0, sizeof(setup));
+    setup.sq_entries = sq_entries;
+    setup.cq_entries = cq_entries;
+    setup.flags = sq_poll ? AXIDMA_RING_SQ_POLL : 0;
+    rc = ioctl(dev->fd, AXIDMA_RING_SETUP, &setup);
+    if (rc < 0) {
+        perror("Failed to setup the AXI DMA submission and completion rings");
+        return rc;
+    }
+
+    // Map the rings into our address space
+    mem = mmap(NULL, setup.mmap_size, PROT_READ|PROT_WRITE, MAP_SHARED,
+               dev->fd, AXIDMA_MMAP_RING_OFFSET);
+    if (mem == MAP_FAILED) {
+        perror("Failed to map the AXI DMA submission and completion rings");
+        return -errno;
+    }
+
+    ring->mem = mem;
+    ring->mem_size = setup.mmap_size;
+    ring->hdr = (struct axidma_ring_header *)mem;
+    ring->sqes = (struct axidma_sqe *)((char *)mem + setup.sq_offset);
+    ring->cqes = (struct axidma_cqe *)((char *)mem + setup.cq_offset);
+    ring->sq_poll = sq_poll;
+
+    return 0;
+}
+
+/* Places a transfer into the submission ring. This does not make a system
+ * call, the transfer is only started on the next call to axidma_ring_enter,
+ * or by the driver's polling thread. */
+int axidma_ring_submit(axidma_dev_t dev, int channel, void *buf, size_t len,
+        void *user_data)
+{
+    unsigned int sq_head, sq_tail;
+    struct axidma_sqe *sqe;
+    axidma_ring_t *ring;
+
+    ring = &dev->ring;
+    assert(ring->mem != NULL);
+    assert(find_channel(dev, channel) != NULL);
+    assert(find_channel(dev, channel)->type == AXIDMA_DMA);
+
+    // Check that there is space in the SQ for the transfer
+    sq_head = __atomic_load_n(&ring->hdr->sq_head, __ATOMIC_ACQUIRE);
+    sq_tail = ring->hdr->sq_tail;
+    if (sq_tail - sq_head >= ring->hdr->sq_entries) {
+        return -EAGAIN;
+    }
+
+    // Fill in the entry, and then publish it to the driver
+    sqe = &ring->sqes[sq_tail & (ring->hdr->sq_entries - 1)];
+    sqe->channel_id = channel;
+    sqe->buf = buf;
+    sqe->buf_len = len;
+    sqe->user_data = user_data;
+    __atomic_store_n(&ring->hdr->sq_tail, sq_tail + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/* Rings the doorbell for the submission ring, and waits for the given number
+ * of completions. When the driver is polling the submission ring, the system
+ * call is skipped unless the polling thread is asleep or we need to wait. */
+int axidma_ring_enter(axidma_dev_t dev, unsigned int min_complete)
+{
+    int rc;
+    unsigned int cq_ready, sq_flags;
+    struct axidma_ring_enter enter;
+    axidma_ring_t *ring;
+
+    ring = &dev->ring;
+    assert(ring->mem != NULL);
+
+    if (ring->sq_poll) {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        sq_flags = __atomic_load_n(&ring->hdr->sq_flags, __ATOMIC_RELAXED);
+        cq_ready = __atomic_load_n(&ring->hdr->cq_tail, __ATOMIC_ACQUIRE) -
+                   ring->hdr->cq_head;
+        if (!(sq_flags & AXIDMA_SQ_NEED_WAKEUP) && cq_ready >= min_complete) {
+            return 0;
+        }
+    }
+
+    enter.min_complete = min_complete;
+    rc = ioctl(dev->fd, AXIDMA_RING_ENTER, &enter);
+    if (rc < 0) {
+        perror("Failed to enter the AXI DMA submission ring");
+    }
+
+    return rc;
+}
+
+/* Removes up to max_cqes completions from the completion ring, without making
+ * a system call. Returns the number of completions removed. */
+int axidma_ring_reap(axidma_dev_t dev, struct axidma_cqe *cqes, int max_cqes)
+{
+    int i;
+    unsigned int cq_head, cq_tail, cq_mask;
+    axidma_ring_t *ring;
+
+    ring = &dev->ring;
+    assert(ring->mem != NULL);
+
+    // Copy out the available completions, and then release their entries
+    cq_head = ring->hdr->cq_head;
+    cq_tail = __atomic_load_n(&ring->hdr->cq_tail, __ATOMIC_ACQUIRE);
+    cq_mask = ring->hdr->cq_entries - 1;
+    for (i = 0; i < max_cqes && cq_head != cq_tail; i++, cq_head++)
+    {
+        memcpy(&cqes[i], &ring->cqes[cq_head & cq_mask], sizeof(cqes[i]));
+    }
+    __atomic_store_n(&ring->hdr->cq_head, cq_head, __ATOMIC_RELEASE);
+
+    return i;
+}
+
+/*----------------------------------------------------------------------------
+ * Userspace BD Rings
+ *----------------------------------------------------------------------------*/
+
+/* Looks up the bus address of the given buffer, which must be in a single
+ * contiguous segment. The segment is cached, so most lookups don't need a
+ * system call. Returns 0 if the buffer isn't in a DMA buffer. */
+static uint64_t bdring_dma_addr(axidma_bdring_t ring, void *buf, size_t len)
+{
+    int i;
+    char *addr;
+    struct bdring_segment *seg;
+    struct axidma_dma_addr dma_addr;
+
+    addr = (char *)buf;
+    for (i = 0; i < BDRING_CACHE_SIZE; i++)
+    {
+        seg = &ring->cache[i];
+        if (seg->addr <= addr && addr + len <= seg->addr + seg->size) {
+            return seg->dma_addr + (addr - seg->addr);
+        }
+    }
+
+    // Ask the driver for the buffer's segment, replacing the oldest in cache
+    dma_addr.user_addr = buf;
+    if (ioctl(ring->dev->fd, AXIDMA_GET_DMA_ADDR, &dma_addr) < 0) {
+        return 0;
+    }
+    seg = &ring->cache[ring->next_cache];
+    seg->addr = (char *)dma_addr.seg_addr;
+    seg->size = dma_addr.seg_size;
+    seg->dma_addr = dma_addr.dma_addr;
+    ring->next_cache = (ring->next_cache + 1) % BDRING_CACHE_SIZE;
+
+    if (addr + len > seg->addr + seg->size) {
+        return 0;
+    }
+    return seg->dma_addr + (addr - seg->addr);
+}
+
+/* Dedicates the channel to a BD ring, and maps the ring's BDs into our
+ * address space. */
+axidma_bdring_t axidma_bdring_init(axidma_dev_t dev, int channel,
+        unsigned int num_bds)
+{
+    int rc;
+    void *mem;
+    dma_channel_t *dma_chan;
+    struct axidma_bdring_setup setup;
+    struct axidma_claim claim;
+    axidma_bdring_t ring;
+
+    dma_chan = find_channel(dev, channel);
+    assert(dma_chan != NULL);
+    assert(dma_chan->type == AXIDMA_DMA);
+
+    ring = calloc(1, sizeof(*ring));
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->bufs = calloc(num_bds, sizeof(ring->bufs[0]));
+    if (ring->bufs == NULL) {
+        goto free_ring;
+    }
+    ring->dev = dev;
+    ring->channel = channel;
+    ring->dir = dma_chan->dir;
+    ring->num_bds = num_bds;
+
+    // Have the driver allocate the BDs, and hand the channel over to us
+    memset(&setup, 0, sizeof(setup));
+    setup.channel_id = channel;
+    setup.num_bds = num_bds;
+    rc = ioctl(dev->fd, AXIDMA_BDRING_SETUP, &setup);
+    if (rc < 0) {
+        perror("Failed to setup the AXI DMA BD ring");
+        goto free_bufs;
+    }
+
+    // Map the BDs into our address space
+    mem = mmap(NULL, setup.bds_size, PROT_READ|PROT_WRITE, MAP_SHARED,
+               dev->fd, setup.bds_offset);
+    if (mem == MAP_FAILED) {
+        perror("Failed to map the AXI DMA BD ring");
+        goto destroy_bdring;
+    }
+    ring->bds = (struct axidma_bd *)mem;
+    ring->bds_size = setup.bds_size;
+    ring->bds_dma = setup.bds_dma;
+
+    return ring;
+
+destroy_bdring:
+    claim.channel_id = channel;
+    ioctl(dev->fd, AXIDMA_BDRING_DESTROY, &claim);
+free_bufs:
+    free(ring->bufs);
+free_ring:
+    free(ring);
+    return NULL;
+}
+
+/* Unmaps the BD ring, and then has the driver halt the channel, and return it
+ * to the DMA engine. */
+void axidma_bdring_destroy(axidma_bdring_t ring)
+{
+    struct axidma_claim claim;
+
+    munmap(ring->bds, ring->bds_size);
+
+    claim.channel_id = ring->channel;
+    if (ioctl(ring->dev->fd, AXIDMA_BDRING_DESTROY, &claim) < 0) {
+        perror("Failed to destroy the AXI DMA BD ring");
+    }
+
+    free(ring->bufs);
+    free(ring);
+    return;
+}
+
+/* Fills in the next BD of the ring with the buffer. The engine isn't started
+ * on it until the next kick. */
+int axidma_bdring_post(axidma_bdring_t ring, void *buf, size_t len)
+{
+    unsigned int index;
+    uint64_t dma_addr;
+    struct axidma_bd *bd;
+
+    if (ring->tail - ring->head >= ring->num_bds) {
+        return -EAGAIN;
+    } else if (len == 0 || len > AXIDMA_BD_LEN_MASK) {
+        return -EINVAL;
+    }
+
+    dma_addr = bdring_dma_addr(ring, buf, len);
+    if (dma_addr == 0) {
+        return -EFAULT;
+    }
+
+    // Clear the status, since the engine fails on a BD that is still complete
+    index = ring->tail & (ring->num_bds - 1);
+    bd = &ring->bds[index];
+    bd->buf_addr = (uint32_t)dma_addr;
+    bd->buf_addr_msb = (uint32_t)(dma_addr >> 32);
+    bd->status = 0;
+    bd->control = len;
+    if (ring->dir == AXIDMA_WRITE) {
+        bd->control |= AXIDMA_BD_CTRL_SOF | AXIDMA_BD_CTRL_EOF;
+    }
+    ring->bufs[index] = buf;
+    ring->tail += 1;
+
+    return 0;
+}
+
+/* Has the driver write the last posted BD to the tail register, which starts
+ * the engine on every BD up to it. The driver's register write orders the
+ * writes to the BDs before it. */
+int axidma_bdring_kick(axidma_bdring_t ring)
+{
+    struct axidma_bdring_kick kick;
+
+    if (ring->kicked == ring->tail) {
+        return 0;
+    }
+
+    kick.channel_id = ring->channel;
+    kick.tail_dma = ring->bds_dma + ((ring->tail - 1) & (ring->num_bds - 1)) *
+                    sizeof(ring->bds[0]);
+    if (ioctl(ring->dev->fd, AXIDMA_BDRING_KICK, &kick) < 0) {
+        perror("Failed to start the AXI DMA BD ring");
+        return -errno;
+    }
+
+    ring->kicked = ring->tail;
+    return 0;
+}
+
+/* Copies out the completions of the BDs the engine has finished, by checking
+ * the completed bit the engine sets in each BD's status. A BD with an error
+ * that halted the channel has its error bits set, but isn't completed. */
+int axidma_bdring_reap(axidma_bdring_t ring, struct axidma_bd_completion *comps,
+        int max_comps)
+{
+    int i;
+    unsigned int index, status;
+
+    for (i = 0; i < max_comps && ring->head != ring->kicked; i++)
+    {
+        index = ring->head & (ring->num_bds - 1);
+        status = __atomic_load_n(&ring->bds[index].status, __ATOMIC_ACQUIRE);
+        if (!(status & AXIDMA_BD_STS_CMPLT)) {
+            break;
+        }
+
+        comps[i].buf = ring->bufs[index];
+        comps[i].bytes = status & AXIDMA_BD_LEN_MASK;
+        comps[i].status = (status & AXIDMA_BD_STS_ERRORS) ? -EIO : 0;
+        ring->head += 1;
+    }
+
+    // An error halts the channel, and its remaining BDs never complete
+    index = ring->head & (ring->num_bds - 1);
+    if (i == 0 && ring->head != ring->kicked &&
+            (__atomic_load_n(&ring->bds[index].status, __ATOMIC_ACQUIRE) &
+             AXIDMA_BD_STS_ERRORS)) {
+        return -EIO;
+    }
+
+    return i;
+}
+
+/* Switches the notification for asynchronous transfers from signals to queued
+ * completion events, which can be waited for with poll or the eventfd. */
+int axidma_enable_events(axidma_dev_t dev, int eventfd)
+{
+    int rc;
+    struct axidma_notify notify;
+
+    // Queue completion events, instead of sending a signal for each one
+    notify.flags = AXIDMA_NOTIFY_QUEUE;
+    notify.eventfd = eventfd;
+    rc = ioctl(dev->fd, AXIDMA_SET_NOTIFY, &notify);
+    if (rc < 0) {
+        perror("Failed to enable the DMA completion events");
+    }
+
+    return rc;
+}
+
+// Returns the file descriptor that becomes readable when transfers complete
+int axidma_get_event_fd(axidma_dev_t dev)
+{
+    return dev->fd;
+}
+
+/* Reads up to max_cqes queued completion events from the driver. If wait is
+ * true, this first polls the device until it is readable. The device is opened
+ * non-blocking, so the file's flags are never changed, which would race with
+ * other threads using the device. */
+int axidma_get_completions(axidma_dev_t dev, struct axidma_cqe *cqes,
+        int max_cqes, bool wait)
+{
+    ssize_t rc;
+    struct pollfd pollfd;
+
+    assert(max_cqes > 0);
+
+    // Wait for the device to have events, or entries in the CQ
+    if (wait) {
+        pollfd.fd = dev->fd;
+        pollfd.events = POLLIN;
+        rc = poll(&pollfd, 1, -1);
+        if (rc < 0) {
+            perror("Failed to poll for the DMA completion events");
+            return rc;
+        }
+    }
+
+    // Read as many whole events as are available, and fit in the array
+    rc = read(dev->fd, cqes, max_cqes * sizeof(cqes[0]));
+    if (rc < 0 && errno == EAGAIN) {
+        return 0;
+    } else if (rc < 0 && errno == EOVERFLOW) {
+        fprintf(stderr, "DMA completion events were dropped, because the "
+                "event queue was full.\n");
+        return rc;
+    } else if (rc < 0) {
+        perror("Failed to read the DMA completion events");
+        return rc;
+    }
+
+    return rc / sizeof(cqes[0]);
+}
+
+/* Reads the queued completion events from the driver, and invokes the callback
+ * registered for each event's channel, in the calling thread. */
+int axidma_dispatch_completions(axidma_dev_t dev, bool wait)
+{
+    int i, num_cqes;
+    struct axidma_cqe cqes[32];
+    dma_channel_t *chan;
+
+    num_cqes = axidma_get_completions(dev, cqes,
+                                      sizeof(cqes) / sizeof(cqes[0]), wait);
+    for (i = 0; i < num_cqes; i++)
+    {
+        chan = find_channel(dev, cqes[i].channel_id);
+        if (chan != NULL && chan->callback != NULL) {
+            chan->callback(cqes[i].channel_id, chan->user_data);
+        }
+    }
+
+    return num_cqes;
+}
+
+/* Starts a video transfer on the VDMA channel, with the given frame layout and
+ * synchronization settings. No synchronization is used if sync is NULL. */
+static int start_video_transfer(axidma_dev_t dev, int channel,
+        const struct axidma_video_frame *frame,
+        const struct axidma_video_sync *sync, void **frame_buffers,
+        int num_buffers)
 {
     int rc;
     unsigned long axidma_cmd;
     struct axidma_video_transaction trans;
     dma_channel_t *dma_chan;
 
-    assert(find_channel(dev, display_channel) != NULL);
-    assert(find_channel(dev, display_channel)->type == AXIDMA_VDMA);
+    assert(find_channel(dev, channel) != NULL);
+    assert(find_channel(dev, channel)->type == AXIDMA_VDMA);
 
     // Setup the argument structure for the IOCTL
-    dma_chan = find_channel(dev, display_channel);
-    trans.channel_id = display_channel;
+    dma_chan = find_channel(dev, channel);
+    memset(&trans, 0, sizeof(trans));
+    trans.channel_id = channel;
     trans.num_frame_buffers = num_buffers;
     trans.frame_buffers = frame_buffers;
-    trans.frame.width = width;
-    trans.frame.height = height;
-    trans.frame.depth = depth;
+    trans.frame = *frame;
+    if (sync != NULL) {
+        trans.sync = *sync;
+    }
     axidma_cmd = (dma_chan->dir == AXIDMA_READ) ? AXIDMA_DMA_VIDEO_READ :
                                                   AXIDMA_DMA_VIDEO_WRITE;
     // Perform the video transfer
     rc = ioctl(dev->fd, axidma_cmd, &trans);
     if (rc < 0) {
-        perror("Failed to perform the AXI DMA video write transfer");
+        perror("Failed to perform the AXI DMA video transfer");
+        return rc;
     }
 
-    return rc;
+    // Map the status region, to follow the frames as they complete
+    rc = map_cyclic_status(dev, trans.mmap_size);
+    if (rc < 0) {
+        axidma_stop_transfer(dev, channel);
+        return rc;
+    }
+    dma_chan->video_status = (const struct axidma_cyclic_status *)
+            ((char *)dev->cyclic_mem + trans.status_offset);
+
+    return 0;
+}
+
+/* This function performs a video transfer over AXI DMA, setting up a VDMA
+ * channel to either read from or write to given frame buffers on-demand
+ * continuously. This call is always non-blocking. The transfer can only be
+ * stopped with a call to axidma_stop_transfer. */
+int axidma_video_transfer(axidma_dev_t dev, int display_channel, size_t width,
+        size_t height, size_t depth, void **frame_buffers, int num_buffers)
+{
+    struct axidma_video_frame frame;
+
+    // The lines of the frame buffers are packed together
+    frame.width = width;
+    frame.height = height;
+    frame.depth = depth;
+    frame.stride = 0;
+    return start_video_transfer(dev, display_channel, &frame, NULL,
+                                frame_buffers, num_buffers);
+}
+
+/* This function performs a video transfer like axidma_video_transfer, but with
+ * the given frame layout, and the given genlock and frame sync settings. */
+int axidma_video_transfer_config(axidma_dev_t dev, int channel,
+        const struct axidma_video_frame *frame,
+        const struct axidma_video_sync *sync, void **frame_buffers,
+        int num_buffers)
+{
+    return start_video_transfer(dev, channel, frame, sync, frame_buffers,
+                                num_buffers);
+}
+
+/* Gets the status of the video transfer on the channel, which is shared with
+ * the driver, or NULL if no video transfer was started on it. */
+const struct axidma_cyclic_status *axidma_video_get_status(axidma_dev_t dev,
+        int channel)
+{
+    assert(find_channel(dev, channel) != NULL);
+
+    return find_channel(dev, channel)->video_status;
+}
+
+/* Gets the index of the frame buffer that was completed last by the video
+ * transfer, or -1 if none has completed yet. This does not make a system
+ * call. */
+int axidma_video_latest_frame(const struct axidma_cyclic_status *status)
+{
+    if (__atomic_load_n(&status->period_count, __ATOMIC_ACQUIRE) == 0) {
+        return -1;
+    }
+
+    return __atomic_load_n(&status->last_period, __ATOMIC_RELAXED);
+}
+
+/* Parks the video transfer on the channel on one of its frame buffers, so the
+ * others are left alone, or resumes it when the frame is -1. */
+int axidma_video_park(axidma_dev_t dev, int channel, int frame)
+{
+    int rc;
+    struct axidma_video_park park;
+
+    assert(find_channel(dev, channel) != NULL);
+    assert(find_channel(dev, channel)->type == AXIDMA_VDMA);
+
+    park.channel_id = channel;
+    park.frame = frame;
+    rc = ioctl(dev->fd, AXIDMA_VIDEO_PARK, &park);
+    if (rc < 0) {
+        perror("Failed to park the AXI DMA video transfer");
+        return rc;
+    }
+
+    return 0;
+}
+
+/* Starts a cyclic transfer on the channel, which continuously transfers the
+ * buffer's periods until stopped. The status of each channel's cyclic transfer
+ * is mapped into our address space on the first call. */
+int axidma_cyclic_transfer(axidma_dev_t dev, int channel, void *buf,
+        size_t len, size_t period_len,
+        const struct axidma_cyclic_status **status)
+{
+    int rc;
+    struct axidma_cyclic_transaction trans;
+
+    assert(find_channel(dev, channel) != NULL);
+    assert(find_channel(dev, channel)->type == AXIDMA_DMA);
+
+    // Setup the argument structure to the IOCTL
+    memset(&trans, 0, sizeof(trans));
+    trans.channel_id = channel;
+    trans.buf = buf;
+    trans.buf_len = len;
+    trans.period_len = period_len;
+
+    // Start the cyclic transfer
+    rc = ioctl(dev->fd, AXIDMA_DMA_CYCLIC, &trans);
+    if (rc < 0) {
+        perror("Failed to start the AXI DMA cyclic transfer");
+        return rc;
+    }
+
+    // Map the status region, it's only written by the driver
+    rc = map_cyclic_status(dev, trans.mmap_size);
+    if (rc < 0) {
+        axidma_stop_transfer(dev, channel);
+        return rc;
+    }
+
+    *status = (const struct axidma_cyclic_status *)((char *)dev->cyclic_mem +
+            trans.status_offset);
+    return 0;
+}
+
+/* Gets the number of periods completed by a cyclic transfer. This does not make
+ * a system call, it only reads the status shared with the driver. */
+unsigned int axidma_cyclic_period_count(
+        const struct axidma_cyclic_status *status)
+{
+    return __atomic_load_n(&status->period_count, __ATOMIC_ACQUIRE);
 }
 
 /* This function gets the residue of the last transaction. */
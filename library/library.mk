@@ -20,12 +20,12 @@ LIBAXIDMA_CFLAGS = $(GLOBAL_CFLAGS) -fPIC -shared \
 
 # The files that makeup the AXI DMA library
 LIBAXIDMA_DIR = library
-LIBAXIDMA_FILES = libaxidma.c
+LIBAXIDMA_FILES = libaxidma.c axidma_pool.c axidma_stream.c axidma_group.c
 LIBAXIDMA = $(addprefix $(LIBAXIDMA_DIR)/,$(LIBAXIDMA_FILES))
 
 # The header files for the AXI DMA library interface
 LIBAXIDMA_INC_DIRS = include
-LIBAXIDMA_INC_FILES = libaxidma.h axidma_ioctl.h
+LIBAXIDMA_INC_FILES = libaxidma.h axidma_ioctl.h axidma.hpp
 LIBAXIDMA_INC = $(addprefix $(LIBAXIDMA_INC_DIRS)/,$(LIBAXIDMA_INC_FILES))
 LIBAXIDMA_INC_FLAGS = $(addprefix -I ,$(LIBAXIDMA_INC_DIRS))
 